@@ -0,0 +1,186 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "BenchmarkRecord.hpp"
+#include "BenchmarkUtils.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // returns the text following the first occurrence of the specified marker, or the empty string if not found
+    string textAfter(string line, string marker)
+    {
+        auto index = line.find(marker);
+        return index != string::npos ? line.substr(index + marker.length()) : string();
+    }
+
+    // returns the leading number in the specified text, or zero if there is no such number
+    double leadingNumber(string text)
+    {
+        auto index = text.find_first_of(" ,}");
+        return StringUtils::toDouble(text.substr(0, index));
+    }
+
+    // returns the value of the specified key in a line of JSON text, or the empty string if not found
+    string jsonValue(string line, string key)
+    {
+        string value = textAfter(line, StringUtils::toJsonString(key) + ": ");
+        if (StringUtils::startsWith(value, "\""))
+        {
+            // undo the escapes inserted by the StringUtils::toJsonString() function
+            string result;
+            for (size_t index = 1; index < value.length(); ++index)
+            {
+                char c = value[index];
+                if (c == '"') return result;
+                if (c == '\\' && ++index < value.length())
+                {
+                    c = value[index];
+                    switch (c)
+                    {
+                        case 'b': c = '\b'; break;
+                        case 'f': c = '\f'; break;
+                        case 'n': c = '\n'; break;
+                        case 'r': c = '\r'; break;
+                        case 't': c = '\t'; break;
+                        case 'u':
+                            c = static_cast<char>(std::strtol(value.substr(index + 1, 4).c_str(), nullptr, 16));
+                            index += 4;
+                            break;
+                    }
+                }
+                result += c;
+            }
+            return string();
+        }
+        return value.substr(0, value.find_first_of(",}"));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool BenchmarkRecord::loadLog(string model, int threads, string logPath)
+{
+    _model = model;
+    _threads = threads;
+    _wallTime = 0.;
+    _phases.clear();
+    _packets = 0.;
+    _peakMemory = 0.;
+
+    std::ifstream in = System::ifstream(logPath);
+    if (!in) return false;
+
+    string line;
+    while (getline(in, line))
+    {
+        // phase timing: "Finished <scope> in <seconds> s."
+        string finished = textAfter(line, " Finished ");
+        if (!finished.empty())
+        {
+            auto index = finished.rfind(" in ");
+            if (index == string::npos) continue;
+            string scope = finished.substr(0, index);
+            double seconds = leadingNumber(finished.substr(index + 4));
+
+            // the scope for the complete simulation is "simulation <name> using ..."
+            if (StringUtils::startsWith(scope, "simulation "))
+            {
+                _wallTime = seconds;
+            }
+            else
+            {
+                // accumulate phases that occur more than once, such as iterations
+                bool found = false;
+                for (auto& phase : _phases)
+                {
+                    if (phase.first == scope)
+                    {
+                        phase.second += seconds;
+                        found = true;
+                    }
+                }
+                if (!found) _phases.emplace_back(scope, seconds);
+            }
+            continue;
+        }
+
+        // packet count: "Launching <count> ... photon packets"
+        string launching = textAfter(line, " Launching ");
+        if (!launching.empty() && StringUtils::contains(launching, "photon packets"))
+        {
+            _packets += leadingNumber(launching);
+            continue;
+        }
+
+        // memory usage: "Peak memory usage: <value> <prefix>B (<percentage>%)"
+        string peak = textAfter(line, "Peak memory usage: ");
+        if (!peak.empty())
+        {
+            auto segments = StringUtils::split(peak, " ");
+            if (segments.size() < 2) continue;
+            double factor = 1.;
+            for (char prefix : string("KMGT"))
+            {
+                factor *= 1024.;
+                if (segments[1][0] == prefix) _peakMemory = StringUtils::toDouble(segments[0]) * factor;
+            }
+        }
+    }
+
+    // determine the packet throughput from the time spent in the run phase
+    double runTime = _wallTime;
+    for (const auto& phase : _phases)
+        if (phase.first == "the run") runTime = phase.second;
+    _packetsPerSecondPerThread = runTime > 0. ? _packets / runTime / _threads : 0.;
+
+    return _wallTime > 0.;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void BenchmarkRecord::setReference(double singleThreadWallTime)
+{
+    _speedup = _wallTime > 0. ? singleThreadWallTime / _wallTime : 0.;
+    _efficiency = _speedup / _threads;
+}
+
+////////////////////////////////////////////////////////////////////
+
+string BenchmarkRecord::toJson() const
+{
+    string json = "{\"model\": " + StringUtils::toJsonString(_model) + ", \"threads\": " + std::to_string(_threads)
+                  + ", \"wallTime\": " + BenchmarkUtils::jsonNumber(_wallTime) + ", \"phases\": {";
+    for (const auto& phase : _phases)
+    {
+        if (phase.first != _phases.front().first) json += ", ";
+        json += StringUtils::toJsonString(phase.first) + ": " + BenchmarkUtils::jsonNumber(phase.second);
+    }
+    json += "}, \"packets\": " + BenchmarkUtils::jsonNumber(_packets)
+            + ", \"packetsPerSecondPerThread\": " + BenchmarkUtils::jsonNumber(_packetsPerSecondPerThread)
+            + ", \"peakMemory\": " + BenchmarkUtils::jsonNumber(_peakMemory)
+            + ", \"speedup\": " + BenchmarkUtils::jsonNumber(_speedup)
+            + ", \"efficiency\": " + BenchmarkUtils::jsonNumber(_efficiency) + "}";
+    return json;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool BenchmarkRecord::loadJson(string line)
+{
+    _model = jsonValue(line, "model");
+    string threads = jsonValue(line, "threads");
+    string wallTime = jsonValue(line, "wallTime");
+    if (_model.empty() || !StringUtils::isValidInt(threads) || !StringUtils::isValidDouble(wallTime)) return false;
+
+    _threads = StringUtils::toInt(threads);
+    _wallTime = StringUtils::toDouble(wallTime);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
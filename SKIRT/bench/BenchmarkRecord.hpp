@@ -0,0 +1,86 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef BENCHMARKRECORD_HPP
+#define BENCHMARKRECORD_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** A BenchmarkRecord instance holds the performance metrics for a single benchmark run, i.e. the
+    execution of a given benchmark model using a given number of threads. The metrics are extracted
+    from the log file produced by SKIRT for the run. The class also offers functions to serialize a
+    record to a single line of JSON text and to extract the essential metrics from such a line, so
+    that the records in a previously written report can be used as a baseline for comparison.
+
+    The following metrics are recorded:
+
+    - \em wallTime: the total wall time of the simulation, in seconds.
+    - \em phases: the wall time for each simulation phase reported in the log file (e.g., "setup",
+      "primary emission", "the run", "final output"), in seconds and in order of completion.
+    - \em packets: the total number of photon packets launched during the simulation.
+    - \em packetsPerSecondPerThread: the number of packets launched per second of wall time spent
+      in the run phase, divided by the number of threads; this is the figure of merit for the
+      photon packet life cycle performance.
+    - \em peakMemory: the peak memory usage of the simulation process, in bytes.
+    - \em speedup and \em efficiency: the wall time speedup compared to the single-thread run of the
+      same model, and that speedup divided by the number of threads. These metrics are calculated
+      by the caller because they depend on the record for another run. */
+class BenchmarkRecord
+{
+public:
+    /** This function sets the model name and thread count for the record and extracts the other
+        metrics from the specified SKIRT log file. It returns false if the log file cannot be
+        opened or if it does not report a successfully completed simulation. */
+    bool loadLog(string model, int threads, string logPath);
+
+    /** This function sets the speedup and efficiency metrics given the wall time of the
+        single-thread run of the same model. */
+    void setReference(double singleThreadWallTime);
+
+    /** This function returns the record serialized to a single line of JSON text, without
+        trailing comma or newline. */
+    string toJson() const;
+
+    /** This function sets the model name, thread count and wall time of the record from the
+        specified line of JSON text, which should have been produced by the toJson() function. The
+        other metrics are left untouched. The function returns false if the line does not contain a
+        valid record. */
+    bool loadJson(string line);
+
+    /** This function returns the model name. */
+    string model() const { return _model; }
+
+    /** This function returns the number of threads. */
+    int threads() const { return _threads; }
+
+    /** This function returns the total wall time of the simulation in seconds. */
+    double wallTime() const { return _wallTime; }
+
+    /** This function returns the number of packets launched per second per thread. */
+    double packetsPerSecondPerThread() const { return _packetsPerSecondPerThread; }
+
+    /** This function returns the peak memory usage in bytes. */
+    double peakMemory() const { return _peakMemory; }
+
+    /** This function returns the wall time speedup compared to the single-thread run. */
+    double speedup() const { return _speedup; }
+
+private:
+    string _model;
+    int _threads{0};
+    double _wallTime{0.};
+    vector<std::pair<string, double>> _phases;
+    double _packets{0.};
+    double _packetsPerSecondPerThread{0.};
+    double _peakMemory{0.};
+    double _speedup{0.};
+    double _efficiency{0.};
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,243 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "SkirtBenchCommandLineHandler.hpp"
+#include "BenchmarkRecord.hpp"
+#include "BenchmarkUtils.hpp"
+#include "BuildInfo.hpp"
+#include "CommandLineArguments.hpp"
+#include "Console.hpp"
+#include "FatalError.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include <random>
+#include <thread>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the name of the synthetic particle file expected by the Voronoi galaxy benchmark model
+    const string particleFileName = "SyntheticGalaxyParticles.txt";
+
+    // the name of the report file written to the output directory
+    const string reportFileName = "skirtbench_report.json";
+
+    // writes a synthetic SPH particle file representing an exponential dust disk; a fixed seed is
+    // used and the uniform deviates are constructed by hand so that the file is identical on all platforms
+    void writeParticleFile(string path)
+    {
+        const int numParticles = 50000;
+        const double scaleLength = 4000.;        // pc
+        const double scaleHeight = 300.;         // pc
+        const double maxRadius = 18000.;         // pc
+        const double maxHeight = 4500.;          // pc
+        const double minSmoothingLength = 100.;  // pc
+        const double totalMass = 5e7;            // Msun
+
+        std::mt19937 generator(4357);
+        auto uniform = [&generator]() { return (generator() + 0.5) / 4294967296.; };
+
+        std::ofstream out = System::ofstream(path);
+        out << "# Synthetic SPH particles for the SKIRT benchmark suite\n";
+        out << "# column 1: x (pc)\n# column 2: y (pc)\n# column 3: z (pc)\n";
+        out << "# column 4: smoothing length (pc)\n# column 5: mass (Msun)\n";
+
+        int index = 0;
+        while (index != numParticles)
+        {
+            // the radius follows a gamma distribution so that the surface density falls off exponentially
+            double R = -scaleLength * std::log(uniform() * uniform());
+            double z = -scaleHeight * std::log(uniform()) * (uniform() < 0.5 ? -1. : 1.);
+            if (R > maxRadius || std::abs(z) > maxHeight) continue;
+            double phi = 2. * M_PI * uniform();
+
+            // the smoothing length scales with the mean interparticle distance
+            double h = minSmoothingLength * std::exp((R / scaleLength + std::abs(z) / scaleHeight) / 3.);
+
+            out << R * std::cos(phi) << ' ' << R * std::sin(phi) << ' ' << z << ' ' << h << ' '
+                << totalMass / numParticles << '\n';
+            index++;
+        }
+    }
+
+    // returns the specified path enclosed in single quotes for use in a shell command
+    string quoted(string path)
+    {
+        return "'" + path + "'";
+    }
+
+    // prints the usage synopsis
+    void printUsage()
+    {
+        Console::warning("skirtbench -m <models_dirpath> [-e <skirt_filepath>] [-o <output_dirpath>]");
+        Console::warning("           [-t <max_threads>] [-b <baseline_filepath>] [-r <tolerance_percent>]");
+        Console::warning("           [<model_name>] [<model_name>] ...");
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+int SkirtBenchCommandLineHandler::perform()
+{
+    // Catch and properly report any exceptions
+    try
+    {
+        Console::warning("Welcome to the SKIRT benchmark suite " + BuildInfo::projectVersion() + " "
+                         + BuildInfo::timestamp());
+
+        // Process and validate the command line arguments
+        CommandLineArguments args(System::arguments(), "-m* -e* -o* -t* -b* -r*");
+        if (!args.isValid() || !args.isPresent("-m"))
+        {
+            Console::error("Invalid command line arguments. Usage synopsis:");
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        // Get the paths and parameters, providing defaults where needed
+        string modelsPath = args.value("-m");
+        string skirtPath = args.value("-e");
+        if (skirtPath.empty())
+            skirtPath = StringUtils::joinPaths(StringUtils::dirPath(System::executablePath()), "../main/skirt");
+        string outPath = args.value("-o");
+        if (outPath.empty()) outPath = "skirtbench";
+        int maxThreads = args.intValue("-t");
+        if (maxThreads < 1) maxThreads = max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        double tolerance = args.isPresent("-r") ? args.doubleValue("-r") : 10.;
+
+        // Verify the paths
+        if (!System::isFile(skirtPath)) throw FATALERROR("Cannot find the skirt executable: " + skirtPath);
+        if (!System::isDir(modelsPath)) throw FATALERROR("Cannot find the models directory: " + modelsPath);
+        if (!System::makeDir(outPath)) throw FATALERROR("Cannot create the output directory: " + outPath);
+        outPath = System::canonicalPath(outPath);
+
+        // Make a list of the selected models
+        vector<string> models;
+        for (string name : System::filesInDirectory(modelsPath))
+        {
+            if (!StringUtils::endsWith(name, ".ski")) continue;
+            string model = StringUtils::filenameBase(name);
+            if (!args.hasFilepaths() || StringUtils::contains(args.filepaths(), model)) models.push_back(model);
+        }
+        std::sort(models.begin(), models.end());
+        if (models.empty()) throw FATALERROR("There are no matching ski files in the models directory: " + modelsPath);
+
+        // Generate the synthetic particle file
+        writeParticleFile(StringUtils::joinPaths(outPath, particleFileName));
+
+        // Run the benchmarks
+        vector<BenchmarkRecord> records;
+        bool hasFailures = false;
+        for (string model : models)
+        {
+            double singleThreadWallTime = 0.;
+            for (int threads : BenchmarkUtils::threadCounts(maxThreads))
+            {
+                Console::info("Running model " + model + " with " + std::to_string(threads) + " thread(s)...");
+
+                // run the simulation in its own output directory
+                string runPath = StringUtils::joinPaths(outPath, model + "_t" + std::to_string(threads));
+                if (!System::makeDir(runPath)) throw FATALERROR("Cannot create the output directory: " + runPath);
+                string command = quoted(skirtPath) + " -b -t " + std::to_string(threads) + " -i " + quoted(outPath)
+                                 + " -o " + quoted(runPath) + " "
+                                 + quoted(StringUtils::joinPaths(modelsPath, model + ".ski")) + " > "
+                                 + quoted(StringUtils::joinPaths(runPath, "console.txt")) + " 2>&1";
+                int status = std::system(command.c_str());
+
+                // extract the metrics from the log file
+                BenchmarkRecord record;
+                if (status != 0 || !record.loadLog(model, threads, StringUtils::joinPaths(runPath, model + "_log.txt")))
+                {
+                    Console::error("Simulation failed; see the log file in " + runPath);
+                    hasFailures = true;
+                    break;
+                }
+                if (threads == 1) singleThreadWallTime = record.wallTime();
+                record.setReference(singleThreadWallTime);
+                records.push_back(record);
+
+                Console::success("Finished in " + StringUtils::toString(record.wallTime(), 'f', 1) + " s -- "
+                                 + StringUtils::toString(record.packetsPerSecondPerThread(), 'g', 3)
+                                 + " packets/s/thread -- speedup " + StringUtils::toString(record.speedup(), 'f', 2)
+                                 + " -- peak memory "
+                                 + StringUtils::toMemSizeString(static_cast<size_t>(record.peakMemory())));
+            }
+        }
+
+        // Write the report
+        string reportPath = StringUtils::joinPaths(outPath, reportFileName);
+        {
+            std::ofstream out = System::ofstream(reportPath);
+            out << "{\n\"skirtbench\": {\"version\": " << StringUtils::toJsonString(BuildInfo::projectVersion())
+                << ", \"host\": " << StringUtils::toJsonString(System::hostname())
+                << ", \"timestamp\": " << StringUtils::toJsonString(System::timestamp(true))
+                << ", \"maxThreads\": " << maxThreads << "},\n\"results\": [\n";
+            for (size_t i = 0; i != records.size(); ++i)
+                out << records[i].toJson() << (i + 1 != records.size() ? ",\n" : "\n");
+            out << "]\n}\n";
+        }
+        Console::success("Wrote benchmark report to " + reportPath);
+
+        // Compare against the baseline, if requested
+        int numRegressions = 0;
+        if (args.isPresent("-b"))
+        {
+            string baselinePath = args.value("-b");
+            std::ifstream in = System::ifstream(baselinePath);
+            if (!in) throw FATALERROR("Cannot open the baseline report: " + baselinePath);
+
+            vector<BenchmarkRecord> baseline;
+            string line;
+            while (getline(in, line))
+            {
+                BenchmarkRecord record;
+                if (record.loadJson(line)) baseline.push_back(record);
+            }
+
+            for (const auto& record : records)
+            {
+                for (const auto& base : baseline)
+                {
+                    if (base.model() != record.model() || base.threads() != record.threads()) continue;
+                    double change = 100. * (record.wallTime() / base.wallTime() - 1.);
+                    string message = record.model() + " with " + std::to_string(record.threads())
+                                     + " thread(s): " + StringUtils::toString(record.wallTime(), 'f', 1) + " s vs "
+                                     + StringUtils::toString(base.wallTime(), 'f', 1) + " s ("
+                                     + (change > 0 ? "+" : "") + StringUtils::toString(change, 'f', 1) + "%)";
+                    if (change > tolerance)
+                    {
+                        Console::error("Regression: " + message);
+                        numRegressions++;
+                    }
+                    else
+                    {
+                        Console::info("Within tolerance: " + message);
+                    }
+                }
+            }
+            if (numRegressions)
+                Console::error(std::to_string(numRegressions) + " regression(s) compared to " + baselinePath);
+            else
+                Console::success("No regressions compared to " + baselinePath);
+        }
+
+        // Report completion
+        if (hasFailures || numRegressions) return EXIT_FAILURE;
+        Console::success("Successful completion");
+        return EXIT_SUCCESS;
+    }
+    catch (const FatalError& error)
+    {
+        for (auto line : error.message()) Console::error(line);
+    }
+    catch (const std::exception& except)
+    {
+        Console::error("Standard Library Exception: " + string(except.what()));
+    }
+    return EXIT_FAILURE;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,61 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef SKIRTBENCHCOMMANDLINEHANDLER_HPP
+#define SKIRTBENCHCOMMANDLINEHANDLER_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/**
+This class offers a static function to process the command line arguments for the skirtbench
+utility and to run the SKIRT benchmark suite accordingly. When invoked with invalid command line
+arguments, it prints a brief help message. The following command line arguments are supported:
+
+\verbatim
+    skirtbench -m <models_dirpath> [-e <skirt_filepath>] [-o <output_dirpath>]
+               [-t <max_threads>] [-b <baseline_filepath>] [-r <tolerance_percent>]
+               [<model_name>] [<model_name>] ...
+\endverbatim
+
+The models directory (the -m option) contains the ski files defining the benchmark models. The
+suite shipped with SKIRT (in the \c SKIRT/bench/models directory) includes a 2D Pascucci disk, a
+3D TRUST slab, a Voronoi tessellation of a synthetic SPH disk galaxy, a Lyman-alpha sphere and an
+AGN torus with dust self-absorption. If one or more model names are listed on the command line,
+only the ski files with those names (without the .ski extension) are used; otherwise all ski files
+in the directory are used. Most models require the SKIRT resource packs to be installed.
+
+The skirt executable (the -e option) defaults to the one in the \c ../main directory relative to
+the skirtbench executable, which corresponds to the layout of the SKIRT build tree. Each model is
+run with 1, 2, 4, ... threads up to the maximum number of threads (the -t option), which defaults
+to the number of logical cores on the computer. The maximum number of threads is always included,
+even if it is not a power of two. The simulations are run in sequence and each simulation writes
+its output to a separate subdirectory of the output directory (the -o option), which defaults to
+\c skirtbench in the current directory. The input path for all simulations is set to the output
+directory, so that the synthetic particle file generated by skirtbench before running the models
+is found by the Voronoi galaxy model.
+
+The performance metrics for each run, as described for the BenchmarkRecord class, are written to
+the file \c skirtbench_report.json in the output directory. This file contains a single JSON
+object with some general information and an array of records, with one record per line.
+
+If a baseline report is specified (the -b option), the wall time for each run is compared to the
+wall time for the run with the same model and thread count in the baseline report. A regression
+is flagged if the wall time exceeds the baseline wall time by more than the tolerance (the -r
+option, in percent, with a default value of 10). If there are any regressions, or if any of the
+simulations fails, skirtbench exits with a nonzero status.
+*/
+class SkirtBenchCommandLineHandler final
+{
+public:
+    /** This function processes the command line arguments and runs the benchmark suite
+        accordingly. The function returns an appropriate program exit value. */
+    static int perform();
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
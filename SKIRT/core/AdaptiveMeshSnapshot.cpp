@@ -5,214 +5,100 @@
 
 #include "AdaptiveMeshSnapshot.hpp"
 #include "FatalError.hpp"
+#include "FilePaths.hpp"
 #include "Log.hpp"
 #include "NR.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "ProcessManager.hpp"
 #include "Random.hpp"
 #include "SpatialGridPath.hpp"
 #include "StringUtils.hpp"
+#include "System.hpp"
 #include "TextInFile.hpp"
 #include "Units.hpp"
+#include <cstdio>
+#include <fstream>
 
 ////////////////////////////////////////////////////////////////////
 
-namespace AdaptiveMesh_Private
+// helpers for caching the adaptive mesh
+namespace
 {
-    /* The Node class is a helper class used to represent individual nodes in a tree data
-       structure. An Node instance can represent a leaf or a nonleaf node. A nonleaf node
-       maintains a list of pointers to its children. A leaf node instead keeps a list of pointers
-       to the most likely neighbor for each of the six cell walls. */
-    class Node : public Box
-    {
-    public:
-        /* The constructor receives the node's extent, and reads the other node data from the
-           following line in the specified input file. It then recursively constructs any child
-           nodes. In addition to constructing the new node(s), the constructor also adds leaf node
-           pointers to the vector held by the AdaptiveMeshSnapshot class. */
-        Node(const Box& extent, TextInFile* infile, vector<Node*>& leafnodes) : Box(extent)
-        {
-            // if this is a nonleaf line, process it
-            if (infile->readNonLeaf(_Nx, _Ny, _Nz))
-            {
-                _m = -1;
-
-                // construct and store our children, in local Morton order
-                _nodes.resize(_Nx * _Ny * _Nz);
-                int m = 0;
-                for (int k = 0; k < _Nz; k++)
-                    for (int j = 0; j < _Ny; j++)
-                        for (int i = 0; i < _Nx; i++)
-                        {
-                            Vec r0 = extent.fracPos(i, j, k, _Nx, _Ny, _Nz);
-                            Vec r1 = extent.fracPos(i + 1, j + 1, k + 1, _Nx, _Ny, _Nz);
-                            _nodes[m++] = new Node(Box(r0, r1), infile, leafnodes);
-                        }
-            }
-
-            // if this is not a nonleaf line, it should be a leaf line
-            else
-            {
-                _Nx = 0;
-                _Ny = 0;
-                _Nz = 0;
-
-                // read a leaf line and detect premature end-of file
-                if (!infile->readRow(_properties))
-                    throw FATALERROR("Reached end of file in adaptive mesh data before all nodes were read");
-
-                // add this leaf node to the list
-                _m = leafnodes.size();
-                leafnodes.push_back(this);
-            }
-        }
-
-        /* This function adds neighbor information to the receiving leaf node. Specifically, it
-           constructs a list of the node's most likely neighbor at each of its six walls. The function
-           does nothing if neighbor information has already been added, or if the node is a nonleaf
-           node. The first argument specifies the adaptive mesh root node, which is queried by this
-           function to locate the node's neighbors. The second argument specifies a very small offset
-           (relative to the domain size) used to determine a location just beyond a node wall. */
-        void addNeighbors(Node* root, double eps)
-        {
-            // skip if this node has children or if neighbors already have been added
-            if (_nodes.empty())
-            {
-                // node center
-                Vec ctr = center();
-
-                // determine the node just beyond the center of each wall (or null pointer for domain walls)
-                _nodes.resize(6);
-                _nodes[BACK] = root->leaf(ctr + Vec(-eps, 0, 0));
-                _nodes[FRONT] = root->leaf(ctr + Vec(+eps, 0, 0));
-                _nodes[LEFT] = root->leaf(ctr + Vec(0, -eps, 0));
-                _nodes[RIGHT] = root->leaf(ctr + Vec(0, +eps, 0));
-                _nodes[BOTTOM] = root->leaf(ctr + Vec(0, 0, -eps));
-                _nodes[TOP] = root->leaf(ctr + Vec(0, 0, +eps));
-            }
-        }
-
-        /* The destructor releases the node's children if it is a nonleaf node. */
-        ~Node()
-        {
-            if (!isLeaf())
-                for (auto node : _nodes) delete node;
-        }
-
-        /* For leaf nodes, this function returns the Morton order cell index of the corresponding
-           cell. For nonleaf nodes, this function returns -1. */
-        int cellIndex() const { return _m; }
-
-        /* This function returns true if the node is a leaf node, false if it is a nonleaf node. */
-        bool isLeaf() const { return _m >= 0; }
-
-        /* This function returns a pointer to the node's immediate child that contains the specified
-           point, assuming that the point is inside the node (which is not verified). This function
-           causes undefined behavior if the node is a leaf node. */
-        const Node* child(Vec r) const
-        {
-            // estimate the child node indices; this may be off by one due to rounding errors
-            int i, j, k;
-            cellIndices(i, j, k, r, _Nx, _Ny, _Nz);
-
-            // get the estimated node using local Morton order
-            const Node* node = _nodes[(k * _Ny + j) * _Nx + i];
-
-            // if the point is NOT in the node, correct the indices and get the new node
-            if (!node->contains(r))
-            {
-                if (r.x() < node->xmin())
-                    i--;
-                else if (r.x() > node->xmax())
-                    i++;
-                if (r.y() < node->ymin())
-                    j--;
-                else if (r.y() > node->ymax())
-                    j++;
-                if (r.z() < node->zmin())
-                    k--;
-                else if (r.z() > node->zmax())
-                    k++;
-                node = _nodes[(k * _Ny + j) * _Nx + i];
-                if (!node->contains(r)) throw FATALERROR("Can't locate the appropriate child node");
-            }
-            return node;
-        }
-
-        /* This function returns a pointer to the deepest node in the child hierarchy of this node
-           that contains the specified point, or null if the point is outside the node. It uses the
-           child() function repeatedly to locate the appropriate node. */
-        const Node* leaf(Vec r) const
-        {
-            if (!contains(r)) return nullptr;
-
-            const Node* node = this;
-            while (!node->isLeaf()) node = node->child(r);
-            return node;
-        }
-
-        /* This enum lists a constant for each of the walls in a node. The x-coordinate increases
-           from BACK to FRONT, the y-coordinate increases from LEFT to RIGHT, and the z-coordinate
-           increases from BOTTOM to TOP. */
-        enum Wall { BACK = 0, FRONT, LEFT, RIGHT, BOTTOM, TOP };
-
-        /* This function returns a pointer to the leaf node just beyond a given wall that contains
-           the specified position, or null if the specified position is not inside the most likely
-           neighbor for that wall, or if neighbors have not been added for the node, or if this is
-           not a leaf node. */
-        const Node* neighbor(Wall wall, Vec r) const
-        {
-            const Node* node = _nodes.size() == 6 ? _nodes[wall] : nullptr;
-            if (node && node->contains(r))
-                return node;
-            else
-                return nullptr;
-        }
-
-        /* This function returns the user properties for leaf nodes; for nonleaf nodes the
-           returned array is empty. */
-        const Array& properties() { return _properties; }
-
-    private:
-        int _Nx, _Ny, _Nz;  // number of grid cells in each direction; zero for leaf nodes
-        int _m;             // Morton order index for the cell represented by this leaf node; -1 for nonleaf nodes
-        vector<const Node*> _nodes;  // pointers to children (nonleaf nodes) or neighbors (leaf nodes)
-        Array _properties;           // user-defined properties
-    };
+    // the identifier at the start of a cache file
+    const uint64_t magic = 0x313048534D414B53;  // "SKAMSH01" in little-endian byte order
 }
 
-using namespace AdaptiveMesh_Private;
-
 ////////////////////////////////////////////////////////////////////
 
 AdaptiveMeshSnapshot::AdaptiveMeshSnapshot() {}
 
 ////////////////////////////////////////////////////////////////////
 
-AdaptiveMeshSnapshot::~AdaptiveMeshSnapshot()
-{
-    delete _root;
-}
-
-////////////////////////////////////////////////////////////////////
-
 void AdaptiveMeshSnapshot::readAndClose()
 {
-    // construct the root node, and recursively all other nodes;
-    // this also fills the _cells vector
-    _root = new Node(_extent, infile(), _cells);
+    // if a cache path has been specified, try to load the mesh from the cache;
+    // when running with multiple processes, use the cache only if all processes have access to it
+    string cacheFile;
+    uint64_t key = 0;
+    bool loaded = false;
+    if (!paths()->cachePath().empty())
+    {
+        CacheKey cacheKey = this->cacheKey();
+        key = cacheKey.value();
+        cacheFile = paths()->cache("AdaptiveMeshSnapshot_" + cacheKey.hexString() + ".bin");
+        loaded = loadCache(cacheFile, key);
+        if (ProcessManager::isMultiProc())
+        {
+            Array numLoaded(1);
+            numLoaded[0] = loaded ? 1. : 0.;
+            ProcessManager::sumToAll(numLoaded);
+            if (numLoaded[0] != ProcessManager::size()) loaded = false;
+        }
+        if (!loaded)
+        {
+            _nodev.clear();
+            clearStoredProperties();
+        }
+    }
+
+    // otherwise, read the root node and recursively all other nodes;
+    // this also fills the property storage in Morton order
+    if (!loaded)
+    {
+        _nodev.resize(1);
+        readNode(0);
 
-    // verify that all data was read and close the file
-    Array dummy;
-    if (infile()->readRow(dummy)) throw FATALERROR("Superfluous lines in adaptive mesh data after all nodes were read");
+        // verify that all data was read
+        Array dummy;
+        if (infile()->readRow(dummy))
+            throw FATALERROR("Superfluous lines in adaptive mesh data after all nodes were read");
+    }
     Snapshot::readAndClose();
 
+    // if requested, save the newly read mesh to the cache
+    if (loaded)
+    {
+        log()->info("  Loaded adaptive mesh data from " + cacheFile);
+    }
+    else if (!cacheFile.empty())
+    {
+        saveCache(cacheFile, key);
+        log()->info("  Saved adaptive mesh data to " + cacheFile);
+    }
+
+    // calculate the extent of all leaf cells
+    _cellv.resize(numStoredEntities());
+    setCellExtents(0, _extent);
+
     // log nr of cells
-    log()->info("  Number of leaf cells: " + std::to_string(_cells.size()));
+    log()->info("  Number of leaf cells: " + std::to_string(_cellv.size()));
 
     // if a mass density policy has been set, calculate masses and densities for all cells
     if (hasMassDensityPolicy())
     {
         // allocate vectors for mass and density
-        size_t n = _cells.size();
+        size_t n = _cellv.size();
         Array Mv(n);
         _rhov.resize(n);
 
@@ -228,21 +114,19 @@ void AdaptiveMeshSnapshot::readAndClose()
         int numIgnored = 0;
         for (size_t m = 0; m != n; ++m)
         {
-            const Array& prop = _cells[m]->properties();
-
             // original mass is zero if temperature is above cutoff or if imported mass/density is not positive
             double originalMass = 0.;
-            if (maxT && prop[temperatureIndex()] > maxT)
+            if (maxT && storedProperty(m, temperatureIndex()) > maxT)
                 numIgnored++;
             else
-                originalMass =
-                    max(0., massIndex() >= 0 ? prop[massIndex()] : prop[densityIndex()] * _cells[m]->volume());
+                originalMass = max(0., massIndex() >= 0 ? storedProperty(m, massIndex())
+                                                        : storedProperty(m, densityIndex()) * _cellv[m].volume());
 
-            double metallicMass = originalMass * (useMetallicity() ? prop[metallicityIndex()] : 1.);
+            double metallicMass = originalMass * (useMetallicity() ? storedProperty(m, metallicityIndex()) : 1.);
             double effectiveMass = metallicMass * multiplier();
 
             Mv[m] = effectiveMass;
-            _rhov[m] = effectiveMass / _cells[m]->volume();
+            _rhov[m] = effectiveMass / _cellv[m].volume();
 
             totalOriginalMass += originalMass;
             totalMetallicMass += metallicMass;
@@ -262,6 +146,11 @@ void AdaptiveMeshSnapshot::readAndClose()
         // remember the effective mass
         _mass = totalEffectiveMass;
 
+        // release the imported properties that are no longer needed now that the densities have been calculated
+        releaseStoredProperties(massIndex());
+        releaseStoredProperties(densityIndex());
+        releaseStoredProperties(metallicityIndex());
+
         // construct a vector with the normalized cumulative cell densities
         if (n) NR::cdf(_cumrhov, Mv);
     }
@@ -279,7 +168,175 @@ void AdaptiveMeshSnapshot::setExtent(const Box& extent)
 
 void AdaptiveMeshSnapshot::addNeighbors()
 {
-    for (auto cell : _cells) cell->addNeighbors(_root, _eps);
+    if (!_neighborv.empty()) return;
+
+    // determine the cell just beyond the center of each wall (or -1 for domain walls)
+    int numCells = _cellv.size();
+    _neighborv.resize(6 * static_cast<size_t>(numCells));
+    auto parallel = log()->find<ParallelFactory>()->parallelProcessOnly();
+    parallel->call(numCells, [this](size_t firstIndex, size_t numIndices) {
+        for (size_t m = firstIndex; m != firstIndex + numIndices; ++m)
+        {
+            Vec ctr = _cellv[m].center();
+            int* neighbors = &_neighborv[6 * m];
+            neighbors[BACK] = cellIndex(Position(ctr + Vec(-_eps, 0, 0)));
+            neighbors[FRONT] = cellIndex(Position(ctr + Vec(+_eps, 0, 0)));
+            neighbors[LEFT] = cellIndex(Position(ctr + Vec(0, -_eps, 0)));
+            neighbors[RIGHT] = cellIndex(Position(ctr + Vec(0, +_eps, 0)));
+            neighbors[BOTTOM] = cellIndex(Position(ctr + Vec(0, 0, -_eps)));
+            neighbors[TOP] = cellIndex(Position(ctr + Vec(0, 0, +_eps)));
+        }
+    });
+}
+
+////////////////////////////////////////////////////////////////////
+
+void AdaptiveMeshSnapshot::readNode(int n)
+{
+    // if this is a nonleaf line, reserve the child nodes and read them in local Morton order
+    int Nx, Ny, Nz;
+    if (infile()->readNonLeaf(Nx, Ny, Nz))
+    {
+        int first = _nodev.size();
+        int numChildren = Nx * Ny * Nz;
+        _nodev[n] = Node{Nx, Ny, Nz, first};
+        _nodev.resize(first + numChildren);
+        for (int c = 0; c != numChildren; ++c) readNode(first + c);
+    }
+
+    // if this is not a nonleaf line, it should be a leaf line
+    else
+    {
+        // read a leaf line and detect premature end-of file
+        Array properties;
+        if (!infile()->readRow(properties))
+            throw FATALERROR("Reached end of file in adaptive mesh data before all nodes were read");
+        storeProperties(properties);
+        _nodev[n] = Node{0, 0, 0, numStoredEntities() - 1};
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void AdaptiveMeshSnapshot::setCellExtents(int n, const Box& extent)
+{
+    const Node& node = _nodev[n];
+    if (node.Nx)
+    {
+        int c = node.index;
+        for (int k = 0; k < node.Nz; k++)
+            for (int j = 0; j < node.Ny; j++)
+                for (int i = 0; i < node.Nx; i++)
+                {
+                    Vec r0 = extent.fracPos(i, j, k, node.Nx, node.Ny, node.Nz);
+                    Vec r1 = extent.fracPos(i + 1, j + 1, k + 1, node.Nx, node.Ny, node.Nz);
+                    setCellExtents(c++, Box(r0, r1));
+                }
+    }
+    else
+    {
+        _cellv[node.index] = extent;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+CacheKey AdaptiveMeshSnapshot::cacheKey()
+{
+    CacheKey key;
+    key.add(infile()->columnSignature(0, numColumns()));
+    key.addFile(infile()->filePath());
+    key.addValue(_extent.xmin());
+    key.addValue(_extent.ymin());
+    key.addValue(_extent.zmin());
+    key.addValue(_extent.xmax());
+    key.addValue(_extent.ymax());
+    key.addValue(_extent.zmax());
+    return key;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool AdaptiveMeshSnapshot::loadCache(string path, uint64_t key)
+{
+    // map the file into memory
+    if (!System::isFile(path)) return false;
+    auto map = System::acquireMemoryMap(path);
+    if (!map.first) return false;
+    const char* start = static_cast<const char*>(map.first);
+
+    // verify the header and the file size
+    uint64_t header[5];
+    bool ok = map.second >= sizeof(header);
+    if (ok)
+    {
+        std::copy(start, start + sizeof(header), reinterpret_cast<char*>(header));
+        ok = header[0] == magic && header[1] == key && header[4] == static_cast<uint64_t>(numColumns())
+             && map.second == sizeof(header) + header[2] * sizeof(Node) + header[3] * header[4] * sizeof(double);
+    }
+
+    // copy the node array and verify that the indices are consistent
+    if (ok)
+    {
+        size_t numNodes = header[2];
+        size_t numCells = header[3];
+        const char* data = start + sizeof(header);
+        _nodev.resize(numNodes);
+        std::copy(data, data + numNodes * sizeof(Node), reinterpret_cast<char*>(_nodev.data()));
+        data += numNodes * sizeof(Node);
+        size_t numLeaves = 0;
+        for (size_t n = 0; n != numNodes && ok; ++n)
+        {
+            const Node& node = _nodev[n];
+            if (node.Nx)
+            {
+                size_t numChildren = static_cast<size_t>(node.Nx) * node.Ny * node.Nz;
+                ok = node.Nx > 0 && node.Ny > 0 && node.Nz > 0 && static_cast<size_t>(node.index) > n
+                     && node.index + numChildren <= numNodes;
+            }
+            else
+            {
+                ok = node.index >= 0 && static_cast<size_t>(node.index) < numCells;
+                numLeaves++;
+            }
+        }
+        ok = ok && numNodes && numLeaves == numCells;
+
+        // copy the imported properties
+        if (ok)
+        {
+            vector<vector<double>> columns(header[4], vector<double>(numCells));
+            for (auto& column : columns)
+            {
+                std::copy(data, data + numCells * sizeof(double), reinterpret_cast<char*>(column.data()));
+                data += numCells * sizeof(double);
+            }
+            setStoredProperties(columns);
+        }
+    }
+    System::releaseMemoryMap(path);
+    return ok;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void AdaptiveMeshSnapshot::saveCache(string path, uint64_t key)
+{
+    if (!ProcessManager::isRoot()) return;
+
+    // write the file under a temporary name and rename it when complete, so that concurrent simulations
+    // never see a partially written file
+    string tempPath = path + "." + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tmp";
+    {
+        std::ofstream out = System::ofstream(tempPath);
+        size_t numCells = numStoredEntities();
+        uint64_t header[5] = {magic, key, _nodev.size(), numCells, static_cast<uint64_t>(numColumns())};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(_nodev.data()), _nodev.size() * sizeof(Node));
+        for (int i = 0; i != numColumns(); ++i)
+            out.write(reinterpret_cast<const char*>(storedProperties(i).data()), numCells * sizeof(double));
+    }
+    std::rename(tempPath.c_str(), path.c_str());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -293,43 +350,42 @@ Box AdaptiveMeshSnapshot::extent() const
 
 int AdaptiveMeshSnapshot::numEntities() const
 {
-    return _cells.size();
+    return _cellv.size();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position AdaptiveMeshSnapshot::position(int m) const
 {
-    return Position(_cells[m]->center());
+    return Position(_cellv[m].center());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double AdaptiveMeshSnapshot::volume(int m) const
 {
-    return _cells[m]->volume();
+    return _cellv[m].volume();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double AdaptiveMeshSnapshot::diagonal(int m) const
 {
-    return _cells[m]->diagonal();
+    return _cellv[m].diagonal();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Box AdaptiveMeshSnapshot::extent(int m) const
 {
-    return _cells[m]->extent();
+    return _cellv[m];
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double AdaptiveMeshSnapshot::temperature(int m) const
 {
-    const Array& prop = _cells[m]->properties();
-    return prop[temperatureIndex()];
+    return storedProperty(m, temperatureIndex());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -344,8 +400,8 @@ double AdaptiveMeshSnapshot::temperature(Position bfr) const
 
 Vec AdaptiveMeshSnapshot::velocity(int m) const
 {
-    const Array& prop = _cells[m]->properties();
-    return Vec(prop[velocityIndex() + 0], prop[velocityIndex() + 1], prop[velocityIndex() + 2]);
+    return Vec(storedProperty(m, velocityIndex() + 0), storedProperty(m, velocityIndex() + 1),
+               storedProperty(m, velocityIndex() + 2));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -360,8 +416,7 @@ Vec AdaptiveMeshSnapshot::velocity(Position bfr) const
 
 double AdaptiveMeshSnapshot::velocityDispersion(int m) const
 {
-    const Array& prop = _cells[m]->properties();
-    return prop[velocityDispersionIndex()];
+    return storedProperty(m, velocityDispersionIndex());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -376,8 +431,8 @@ double AdaptiveMeshSnapshot::velocityDispersion(Position bfr) const
 
 Vec AdaptiveMeshSnapshot::magneticField(int m) const
 {
-    const Array& prop = _cells[m]->properties();
-    return Vec(prop[magneticFieldIndex() + 0], prop[magneticFieldIndex() + 1], prop[magneticFieldIndex() + 2]);
+    return Vec(storedProperty(m, magneticFieldIndex() + 0), storedProperty(m, magneticFieldIndex() + 1),
+               storedProperty(m, magneticFieldIndex() + 2));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -394,8 +449,7 @@ void AdaptiveMeshSnapshot::parameters(int m, Array& params) const
 {
     int n = numParameters();
     params.resize(n);
-    const Array& prop = _cells[m]->properties();
-    for (int i = 0; i != n; ++i) params[i] = prop[parametersIndex() + i];
+    for (int i = 0; i != n; ++i) params[i] = storedProperty(m, parametersIndex() + i);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -435,7 +489,7 @@ double AdaptiveMeshSnapshot::mass() const
 
 Position AdaptiveMeshSnapshot::generatePosition(int m) const
 {
-    return random()->position(_cells[m]->extent());
+    return random()->position(_cellv[m]);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -443,7 +497,7 @@ Position AdaptiveMeshSnapshot::generatePosition(int m) const
 Position AdaptiveMeshSnapshot::generatePosition() const
 {
     // if there are no cells, return the origin
-    if (_cells.empty()) return Position();
+    if (_cellv.empty()) return Position();
 
     // select a cell according to its mass contribution
     int m = NR::locateClip(_cumrhov, random()->uniform());
@@ -455,8 +509,46 @@ Position AdaptiveMeshSnapshot::generatePosition() const
 
 int AdaptiveMeshSnapshot::cellIndex(Position bfr) const
 {
-    const Node* cell = _root->leaf(bfr);
-    return cell ? cell->cellIndex() : -1;
+    if (!_extent.contains(bfr)) return -1;
+
+    // descend the tree, calculating the extent of each node on the path
+    Box extent = _extent;
+    const Node* node = &_nodev[0];
+    while (node->Nx)
+    {
+        int Nx = node->Nx;
+        int Ny = node->Ny;
+        int Nz = node->Nz;
+
+        // estimate the child node indices; this may be off by one due to rounding errors
+        int i, j, k;
+        extent.cellIndices(i, j, k, bfr, Nx, Ny, Nz);
+        Box child(extent.fracPos(i, j, k, Nx, Ny, Nz), extent.fracPos(i + 1, j + 1, k + 1, Nx, Ny, Nz));
+
+        // if the point is NOT in the child, correct the indices and get the new child
+        if (!child.contains(bfr))
+        {
+            if (bfr.x() < child.xmin())
+                i--;
+            else if (bfr.x() > child.xmax())
+                i++;
+            if (bfr.y() < child.ymin())
+                j--;
+            else if (bfr.y() > child.ymax())
+                j++;
+            if (bfr.z() < child.zmin())
+                k--;
+            else if (bfr.z() > child.zmax())
+                k++;
+            child = Box(extent.fracPos(i, j, k, Nx, Ny, Nz), extent.fracPos(i + 1, j + 1, k + 1, Nx, Ny, Nz));
+            if (!child.contains(bfr)) throw FATALERROR("Can't locate the appropriate child node");
+        }
+
+        // get the child node using local Morton order
+        extent = child;
+        node = &_nodev[node->index + (k * Ny + j) * Nx + i];
+    }
+    return node->index;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -464,63 +556,63 @@ int AdaptiveMeshSnapshot::cellIndex(Position bfr) const
 void AdaptiveMeshSnapshot::path(SpatialGridPath* path) const
 {
     // if the photon packet starts outside the dust grid, move it into the first grid cell that it will pass
-    Position r = path->moveInside(_root->extent(), _eps);
+    Position r = path->moveInside(_extent, _eps);
 
-    // get the node containing the current location;
+    // get the cell containing the current location;
     // if the position is not inside the grid, return an empty path
-    const Node* node = _root->leaf(r);
-    if (!node) return path->clear();
+    int m = cellIndex(r);
+    if (m < 0) return path->clear();
 
-    // start the loop over nodes/path segments until we leave the grid
+    // start the loop over cells/path segments until we leave the grid
     double kx, ky, kz;
     path->direction().cartesian(kx, ky, kz);
-    while (node)
+    while (m >= 0)
     {
-        double xnext = (kx < 0.0) ? node->xmin() : node->xmax();
-        double ynext = (ky < 0.0) ? node->ymin() : node->ymax();
-        double znext = (kz < 0.0) ? node->zmin() : node->zmax();
+        const Box& cell = _cellv[m];
+        double xnext = (kx < 0.0) ? cell.xmin() : cell.xmax();
+        double ynext = (ky < 0.0) ? cell.ymin() : cell.ymax();
+        double znext = (kz < 0.0) ? cell.zmin() : cell.zmax();
         double dsx = (fabs(kx) > 1e-15) ? (xnext - r.x()) / kx : DBL_MAX;
         double dsy = (fabs(ky) > 1e-15) ? (ynext - r.y()) / ky : DBL_MAX;
         double dsz = (fabs(kz) > 1e-15) ? (znext - r.z()) / kz : DBL_MAX;
 
         double ds;
-        Node::Wall wall;
+        Wall wall;
         if (dsx <= dsy && dsx <= dsz)
         {
             ds = dsx;
-            wall = (kx < 0.0) ? Node::BACK : Node::FRONT;
+            wall = (kx < 0.0) ? BACK : FRONT;
         }
         else if (dsy <= dsx && dsy <= dsz)
         {
             ds = dsy;
-            wall = (ky < 0.0) ? Node::LEFT : Node::RIGHT;
+            wall = (ky < 0.0) ? LEFT : RIGHT;
         }
         else
         {
             ds = dsz;
-            wall = (kz < 0.0) ? Node::BOTTOM : Node::TOP;
+            wall = (kz < 0.0) ? BOTTOM : TOP;
         }
-        path->addSegment(node->cellIndex(), ds);
+        path->addSegment(m, ds);
         r += (ds + _eps) * (path->direction());
 
-        // try the most likely neighbor of the current node, and use top-down search as a fall-back
-        const Node* oldnode = node;
-        node = node->neighbor(wall, r);
-        if (!node) node = _root->leaf(r);
+        // try the most likely neighbor of the current cell, and use top-down search as a fall-back
+        int oldm = m;
+        m = _neighborv.empty() ? -1 : _neighborv[6 * static_cast<size_t>(m) + wall];
+        if (m < 0 || !_cellv[m].contains(r)) m = cellIndex(r);
 
-        // if we're stuck in the same node...
-        if (node == oldnode)
+        // if we're stuck in the same cell...
+        if (m == oldm)
         {
             // try to escape by advancing the position to the next representable coordinates
             r.set(nextafter(r.x(), (kx < 0.0) ? -DBL_MAX : DBL_MAX), nextafter(r.y(), (ky < 0.0) ? -DBL_MAX : DBL_MAX),
                   nextafter(r.z(), (kz < 0.0) ? -DBL_MAX : DBL_MAX));
-            node = _root->leaf(r);
+            m = cellIndex(r);
 
             // if that didn't work, terminate the path
-            if (node == oldnode)
+            if (m == oldm)
             {
-                log()->warning("Photon packet is stuck in cell " + std::to_string(node->cellIndex())
-                               + " -- terminating this path");
+                log()->warning("Photon packet is stuck in cell " + std::to_string(m) + " -- terminating this path");
                 break;
             }
         }
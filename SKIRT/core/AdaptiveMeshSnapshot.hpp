@@ -7,12 +7,9 @@
 #define ADAPTIVEMESHSNAPSHOT_HPP
 
 #include "Array.hpp"
+#include "CacheKey.hpp"
 #include "Snapshot.hpp"
 class SpatialGridPath;
-namespace AdaptiveMesh_Private
-{
-    class Node;
-}
 
 ////////////////////////////////////////////////////////////////////
 
@@ -42,6 +39,22 @@ namespace AdaptiveMesh_Private
     Once an AdaptiveMeshSnapshot object has been constructed and fully configured, its data is no
     longer modified. Consequently all getters are re-entrant.
 
+    Internally, the tree is stored as a flat array of compact node records rather than as a
+    hierarchy of individually allocated node objects. The children of each nonleaf node occupy
+    consecutive elements in this array, so that a nonleaf node record holds just its number of
+    subdivisions in each direction and the index of its first child. A leaf node record holds the
+    index of the corresponding cell. The extent of each leaf cell and, if requested, the indices of
+    its most likely neighbors are kept in separate arrays indexed on cell index.
+
+    If a cache path has been specified for the simulation (see the FilePaths class), the node array
+    and the imported properties are stored in a binary file in the cache directory after reading
+    the input file. The file name includes a hash key derived from the spatial extent of the
+    domain, the input file path and its size and modification time, a hash of the first and last
+    megabyte of the file, and the imported columns and their unit conversions. Subsequent
+    simulations with a matching key read the mesh from this binary file rather than parsing the
+    text input file. When running with multiple processes, the cache file is used only if it is
+    available to all processes.
+
     Tree structure, Morton ordering, and file format
     ------------------------------------------------
 
@@ -130,9 +143,6 @@ public:
         of the required calling sequence in the Snapshot class header. */
     AdaptiveMeshSnapshot();
 
-    /** The destructor releases any data structures allocated by this class. */
-    ~AdaptiveMeshSnapshot();
-
     //========== Reading ==========
 
 public:
@@ -160,9 +170,37 @@ public:
         be called after the readAndClose() function has completed its operation, and before the
         path() function is used. Specifically, the function causes each leaf node to remember its
         most likely neighbor at each of its six walls. This information, while optional,
-        substantially accelerates the operation of the path() function. */
+        substantially accelerates the operation of the path() function. The neighbors of the
+        various cells are located in parallel by the execution threads in the current process.
+        The function does nothing if neighbor information has already been added. */
     void addNeighbors();
 
+private:
+    /** This function reads the data for the node with index \em n from the input file, and
+        recursively for its children. A nonleaf node reserves a range of consecutive nodes for its
+        children at the end of the node array before reading them. A leaf node passes the
+        properties read from the file to the property storage, and receives the index of the
+        corresponding entity in that storage as its cell index. */
+    void readNode(int n);
+
+    /** This function sets the extent of the leaf cell corresponding to the node with index \em
+        n, and recursively of the leaf cells corresponding to its children, given the extent of
+        that node. */
+    void setCellExtents(int n, const Box& extent);
+
+    /** This function returns the hash key identifying the adaptive mesh data in the cache, as
+        described in the class header. */
+    CacheKey cacheKey();
+
+    /** This function reads the node array and the imported properties from the specified cache
+        file, verifying that the file has the specified key and that the node array is consistent.
+        If the file does not exist or has improper contents, the function returns false. */
+    bool loadCache(string path, uint64_t key);
+
+    /** This function saves the node array and the imported properties to the specified cache
+        file. */
+    void saveCache(string path, uint64_t key);
+
     //=========== Interrogation ==========
 
 public:
@@ -272,8 +310,8 @@ public:
 
     /** This function returns the leaf cell index \f$0\le m \le N_{cells}-1\f$ for the cell
         containing the specified point \f${\bf{r}}\f$. If the point is outside the domain, the
-        function returns -1. The function recursively searches the adaptive mesh tree until it
-        finds the appropriate leaf cell. */
+        function returns -1. The function descends the adaptive mesh tree until it finds the
+        appropriate leaf cell, calculating the extent of the nodes along the way. */
     int cellIndex(Position bfr) const;
 
     //====================== Path construction =====================
@@ -296,9 +334,24 @@ private:
     Box _extent;      // the spatial domain of the mesh
     double _eps{0.};  // small fraction of extent
 
+    // a node in the tree; the root node has index zero, and the children of a nonleaf node are
+    // stored as a group of consecutive nodes in local Morton order
+    struct Node
+    {
+        int Nx{0}, Ny{0}, Nz{0};  // number of subdivisions in each direction; zero for leaf nodes
+        int index{0};             // for a nonleaf node: index of the first child; for a leaf node: cell index
+    };
+
+    // the walls of a cell; the x-coordinate increases from BACK to FRONT, the y-coordinate increases
+    // from LEFT to RIGHT, and the z-coordinate increases from BOTTOM to TOP
+    enum Wall { BACK = 0, FRONT, LEFT, RIGHT, BOTTOM, TOP };
+
     // data members initialized when processing snapshot input
-    AdaptiveMesh_Private::Node* _root{nullptr};  // root node representing the complete domain
-    vector<AdaptiveMesh_Private::Node*> _cells;  // leaf nodes indexed on m
+    vector<Node> _nodev;  // the nodes of the tree
+    vector<Box> _cellv;   // the extent of each leaf cell, indexed on m
+
+    // data members initialized by addNeighbors()
+    vector<int> _neighborv;  // the most likely neighbor of each cell at each of its walls, or -1, indexed on 6*m+wall
 
     // data members initialized when processing snapshot input, but only if a density policy has been set
     Array _rhov;       // density for each cell (not normalized)
@@ -113,8 +113,11 @@ void Configuration::setupSelfBefore()
                 if (medium->mix()->isDust() && !dynamic_cast<const MultiGrainDustMix*>(medium->mix()))
                     throw FATALERROR("When requesting stochastic heating, all dust mixes must be multi-grain");
             _hasStochasticDustEmission = true;
+            _precalculateEquilibriumCutoffs = ms->dustEmissionOptions()->precalculateEquilibriumCutoffs();
         }
         _includeHeatingByCMB = ms->dustEmissionOptions()->includeHeatingByCMB();
+        _emissivityTableTolerance = ms->dustEmissionOptions()->emissivityTableTolerance();
+        _cacheEmissivityTable = ms->dustEmissionOptions()->cacheEmissivityTable();
         _cellLibrary = ms->dustEmissionOptions()->cellLibrary();
         if (!_cellLibrary) _cellLibrary = new AllCellsLibrary(this);
         _radiationFieldWLG = ms->dustEmissionOptions()->radiationFieldWLG();
@@ -128,6 +131,8 @@ void Configuration::setupSelfBefore()
         _secondarySpatialBias = ms->dustEmissionOptions()->spatialBias();
         _secondaryWavelengthBias = ms->dustEmissionOptions()->wavelengthBias();
         _secondaryWavelengthBiasDistribution = ms->dustEmissionOptions()->wavelengthBiasDistribution();
+        _maxSecondarySpectraBytes = ms->dustEmissionOptions()->maxSpectraMemory() * 1e9;
+        _storeSecondarySpectraInSinglePrecision = ms->dustEmissionOptions()->storeSpectraInSinglePrecision();
     }
 
     // retrieve dust self-absorption options
@@ -162,6 +167,8 @@ void Configuration::setupSelfBefore()
                 break;
         }
         if (ms->lyaOptions()->includeHubbleFlow()) _lyaExpansionRate = sim->cosmology()->relativeExpansionRate();
+        _lyaUseTabulatedVoigtProfile = ms->lyaOptions()->useTabulatedVoigtProfile();
+        _lyaAnalyticEscapeOpticalDepth = ms->lyaOptions()->analyticEscapeOpticalDepth();
 
         // force moving media even if there are no bulk velocities (which would be exceptional anyway);
         // this automatically disables some optimizations that would not work for Lyman-alpha media
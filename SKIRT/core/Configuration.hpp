@@ -168,10 +168,23 @@ public:
         grains into account, and false otherwise. */
     bool hasStochasticDustEmission() const { return _hasStochasticDustEmission; }
 
+    /** Returns true if the equilibrium grain mass cutoffs for stochastic dust emission must be
+        precalculated as a function of the strength and hardness of the radiation field, and false
+        otherwise. */
+    bool precalculateEquilibriumCutoffs() const { return _precalculateEquilibriumCutoffs; }
+
     /** Returns true if the cosmic microwave background (CMB) must be added as a source term for
         dust heating, and false otherwise. */
     bool includeHeatingByCMB() const { return _includeHeatingByCMB; }
 
+    /** Returns the relative tolerance for interpolating the emissivity spectra of multi-grain
+        dust mixes from a precalculated table, or zero if no such table should be built. */
+    double emissivityTableTolerance() const { return _emissivityTableTolerance; }
+
+    /** Returns true if the precalculated emissivity tables must be cached in the cache directory
+        (see the FilePaths class) for use by subsequent runs, and false otherwise. */
+    bool cacheEmissivityTable() const { return _cacheEmissivityTable; }
+
     /** Returns true if dust self-absorption must be self-consistently calculated through
         iteration, and false otherwise. */
     bool hasDustSelfAbsorption() const { return _hasDustSelfAbsorption; }
@@ -200,6 +213,15 @@ public:
     /** Returns the bias distribution for sampling secondary photon packet wavelengths. */
     WavelengthDistribution* secondaryWavelengthBiasDistribution() const { return _secondaryWavelengthBiasDistribution; }
 
+    /** Returns the maximum number of bytes used for storing the secondary emission spectra
+        precalculated before each secondary emission segment, or zero if the spectra should not be
+        precalculated. */
+    double maxSecondarySpectraBytes() const { return _maxSecondarySpectraBytes; }
+
+    /** Returns true if the precalculated secondary emission spectra should be stored in single
+        precision, and false if they should be stored in double precision. */
+    bool storeSecondarySpectraInSinglePrecision() const { return _storeSecondarySpectraInSinglePrecision; }
+
     /** Returns the minimum number of self-absorption iterations. */
     int minIterations() const { return _minIterations; }
 
@@ -246,6 +268,17 @@ public:
         Lyman-alpha line, this function returns zero. */
     double lyaExpansionRate() const { return _lyaExpansionRate; }
 
+    /** Returns true if the Lyman-alpha cross section and atom velocities should be obtained from
+        precomputed tables rather than through direct calculation. The value is relevant only when
+        hasLymanAlpha() returns true. */
+    bool lyaUseTabulatedVoigtProfile() const { return _lyaUseTabulatedVoigtProfile; }
+
+    /** Returns the line-center optical depth of a spatial cell above which photon packets trapped
+        in the Lyman-alpha line core escape from the cell analytically rather than through
+        individual scattering events, or zero if this hybrid transfer scheme is disabled. The value
+        is relevant only when hasLymanAlpha() returns true. */
+    double lyaAnalyticEscapeOpticalDepth() const { return _lyaAnalyticEscapeOpticalDepth; }
+
     /** Returns the symmetry dimension of the input model, including sources and media, if present.
         A value of 1 means spherical symmetry, 2 means axial symmetry and 3 means none of these
         symmetries. */
@@ -325,7 +358,10 @@ private:
     // emission
     bool _hasDustEmission{false};
     bool _hasStochasticDustEmission{false};
+    bool _precalculateEquilibriumCutoffs{false};
     bool _includeHeatingByCMB{false};
+    double _emissivityTableTolerance{0.};
+    bool _cacheEmissivityTable{false};
     bool _hasDustSelfAbsorption{false};
     DisjointWavelengthGrid* _dustEmissionWLG{nullptr};
     SpatialCellLibrary* _cellLibrary{nullptr};
@@ -333,6 +369,8 @@ private:
     double _secondarySpatialBias{0.5};
     double _secondaryWavelengthBias{0.5};
     WavelengthDistribution* _secondaryWavelengthBiasDistribution{nullptr};
+    double _maxSecondarySpectraBytes{0.};
+    bool _storeSecondarySpectraInSinglePrecision{false};
     int _minIterations{1};
     int _maxIterations{10};
     double _maxFractionOfPrimary{0.01};
@@ -343,6 +381,8 @@ private:
     LyaAccelerationScheme _lyaAccelerationScheme{LyaAccelerationScheme::Variable};
     double _lyaAccelerationStrength{1.};
     double _lyaExpansionRate{0.};
+    bool _lyaUseTabulatedVoigtProfile{false};
+    double _lyaAnalyticEscapeOpticalDepth{0.};
 
     // properties derived from the configuration at large
     int _modelDimension{0};
@@ -48,6 +48,20 @@ double CubicSplineSmoothingKernel::density(double u) const
 
 //////////////////////////////////////////////////////////////////////
 
+void CubicSplineSmoothingKernel::densities(int n, const double* uv, double* Wv) const
+{
+    for (int k = 0; k < n; ++k)
+    {
+        double u = uv[k];
+        double inner = 8.0 / M_PI * (1.0 - 6.0 * u * u * (1.0 - u));
+        double outer = 8.0 / M_PI * 2.0 * (1.0 - u) * (1.0 - u) * (1.0 - u);
+        double W = u < 0.5 ? inner : outer;
+        Wv[k] = (u < 0.0 || u > 1.0) ? 0.0 : W;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
 double CubicSplineSmoothingKernel::generateRadius() const
 {
     double X = random()->uniform();
@@ -37,6 +37,12 @@ public:
         normalized radius \f$u\f$. Just implements the analytical formula. */
     double density(double u) const override;
 
+    /** This function stores the density \f$W(u)\f$ of the smoothing kernel for each of the \em n
+        normalized radii in the array \em uv into the corresponding element of the array \em Wv.
+        It evaluates both branches of the analytical formula and selects the result without
+        jumps, so that the compiler can vectorize the loop. */
+    void densities(int n, const double* uv, double* Wv) const override;
+
     /** This function generates a random normalized radius \f$u\f$ from the smoothing kernel, by
         drawing a number from the one-dimensional probability density \f$p(u)\,{\text{d}}u =
         4\pi\,W(u)\,u^2\, {\text{d}}u\f$. This is accomplished by generating a uniform deviate
@@ -77,82 +77,170 @@ void DensityTreePolicy::setupSelfBefore()
         for (auto medium : _gasMedia) _gasNumber += medium->number();
     }
 
+    // use direct mass or number queries for a material type if all corresponding media support them
+    auto allHaveQuery = [](const vector<Medium*>& media) {
+        for (auto medium : media)
+            if (!medium->hasMassInBox()) return false;
+        return true;
+    };
+    _hasDustQuery = (_hasDustFraction || _hasDustOpticalDepth) && allHaveQuery(_dustMedia);
+    _hasElectronQuery = _hasElectronFraction && allHaveQuery(_electronMedia);
+    _hasGasQuery = _hasGasFraction && allHaveQuery(_gasMedia);
+    if (_hasDustQuery || _hasElectronQuery || _hasGasQuery)
+        find<Log>()->info("Using direct mass queries rather than density sampling for some tree subdivision criteria");
+
     // warn user if none of the criteria were enabled
     if (!_hasAny) find<Log>()->warning("None of the tree subdivision criteria are enabled");
 }
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // number of density samples in the first batch taken for each node
+    const int numInitialSamples = 10;
+
+    // width of the confidence interval on a sampled mean density, in units of the standard error on the mean
+    const double confidence = 3.;
+
+    // accumulates density samples for a material type and compares their mean with a threshold
+    class DensitySampler
+    {
+    public:
+        // adds a sample
+        void add(double value)
+        {
+            _sum += value;
+            _sum2 += value * value;
+            _n++;
+        }
+
+        // returns the mean of the samples
+        double mean() const { return _sum / _n; }
+
+        // returns +1 if the mean clearly exceeds the threshold, -1 if it clearly stays below the threshold,
+        // and 0 if the outcome remains uncertain given the standard error estimated from the sample variance;
+        // identical samples (e.g. all zero in a node that clips a thin structure) say nothing about the
+        // uncertainty, so a zero variance is considered uncertain rather than certain
+        int compare(double threshold) const
+        {
+            double mean = _sum / _n;
+            double var = max(0., (_sum2 - _sum * mean) / (_n - 1));
+            if (var <= 0.) return 0;
+            double margin = confidence * sqrt(var / _n);
+            if (mean - margin > threshold) return 1;
+            if (mean + margin < threshold) return -1;
+            return 0;
+        }
+
+    private:
+        double _sum{0.};
+        double _sum2{0.};
+        int _n{0};
+    };
+}
+
+////////////////////////////////////////////////////////////////////
+
 bool DensityTreePolicy::needsSubdivide(TreeNode* node)
 {
-    // results for the sampled mass or number densities, if applicable
-    double rho = 0.;          // dust mass density
+    if (!_hasAny) return false;
+
+    // handle the mean density criteria that can be evaluated through a direct mass or number query
+    double V = node->volume();
+    if (_hasDustQuery)
+    {
+        double M = 0.;
+        for (auto medium : _dustMedia) M += medium->massInBox(node->extent());
+        if (_hasDustFraction && M / _dustMass > maxDustFraction()) return true;
+        if (_hasDustOpticalDepth && _dustKappa * M / V * node->diagonal() > maxDustOpticalDepth()) return true;
+    }
+    if (_hasElectronQuery)
+    {
+        double N = 0.;
+        for (auto medium : _electronMedia) N += medium->numberInBox(node->extent());
+        if (N / _electronNumber > maxElectronFraction()) return true;
+    }
+    if (_hasGasQuery)
+    {
+        double N = 0.;
+        for (auto medium : _gasMedia) N += medium->numberInBox(node->extent());
+        if (N / _gasNumber > maxGasFraction()) return true;
+    }
+
+    // determine which criteria remain to be evaluated by sampling
+    bool sampleDustMean = (_hasDustFraction || _hasDustOpticalDepth) && !_hasDustQuery;
+    bool sampleDust = sampleDustMean || _hasDustDensityDispersion;
+    bool sampleElectrons = _hasElectronFraction && !_hasElectronQuery;
+    bool sampleGas = _hasGasFraction && !_hasGasQuery;
+    if (!sampleDust && !sampleElectrons && !sampleGas) return false;
+
+    // convert the mean density criteria to a threshold on the mean density for each material type
+    double rhoMax = DBL_MAX;
+    if (_hasDustFraction) rhoMax = min(rhoMax, maxDustFraction() * _dustMass / V);
+    if (_hasDustOpticalDepth) rhoMax = min(rhoMax, maxDustOpticalDepth() / (_dustKappa * node->diagonal()));
+    double neMax = maxElectronFraction() * _electronNumber / V;
+    double ngMax = maxGasFraction() * _gasNumber / V;
+
+    // sample densities in node in batches of increasing size
+    DensitySampler rho;       // dust mass density
+    DensitySampler ne;        // electron number density
+    DensitySampler ng;        // gas number density
     double rhomin = DBL_MAX;  // smallest sample for dust mass density
     double rhomax = 0.;       // largest sample for dust mass density
-    double ne = 0;            // electron number density
-    double ng = 0.;           // gas number density
-
-    // sample densities in node
-    if (_hasAny)
+    int numSamples = 0;
+    int numTarget = min(numInitialSamples, _numSamples);
+    while (true)
     {
-        double rhosum = 0;
-        double nesum = 0;
-        double ngsum = 0;
-        for (int i = 0; i != _numSamples; ++i)
+        for (; numSamples != numTarget; ++numSamples)
         {
             Position bfr = _random->position(node->extent());
-            if (_hasDustAny)
+            if (sampleDust)
             {
                 double rhoi = 0.;
                 for (auto medium : _dustMedia) rhoi += medium->massDensity(bfr);
-                rhosum += rhoi;
+                rho.add(rhoi);
                 if (rhoi < rhomin) rhomin = rhoi;
                 if (rhoi > rhomax) rhomax = rhoi;
             }
-            if (_hasElectronFraction)
-                for (auto medium : _electronMedia) nesum += medium->numberDensity(bfr);
-            if (_hasGasFraction)
-                for (auto medium : _gasMedia) ngsum += medium->numberDensity(bfr);
+            if (sampleElectrons)
+            {
+                double nei = 0.;
+                for (auto medium : _electronMedia) nei += medium->numberDensity(bfr);
+                ne.add(nei);
+            }
+            if (sampleGas)
+            {
+                double ngi = 0.;
+                for (auto medium : _gasMedia) ngi += medium->numberDensity(bfr);
+                ng.add(ngi);
+            }
         }
-        rho = rhosum / _numSamples;
-        ne = nesum / _numSamples;
-        ng = ngsum / _numSamples;
-    }
 
-    // handle maximum dust mass fraction
-    if (_hasDustFraction)
-    {
-        double delta = rho * node->volume() / _dustMass;
-        if (delta > maxDustFraction()) return true;
-    }
+        // handle maximum dust density dispersion; additional samples can only increase the dispersion
+        if (_hasDustDensityDispersion)
+        {
+            double q = rhomax > 0 ? (rhomax - rhomin) / rhomax : 0.;
+            if (q > maxDustDensityDispersion()) return true;
+        }
 
-    // handle maximum dust optical depth
-    if (_hasDustOpticalDepth)
-    {
-        double tau = _dustKappa * rho * node->diagonal();
-        if (tau > maxDustOpticalDepth()) return true;
-    }
+        // if all samples have been taken, make the final decision below
+        if (numSamples == _numSamples) break;
 
-    // handle maximum dust density dispersion
-    if (_hasDustDensityDispersion)
-    {
-        double q = rhomax > 0 ? (rhomax - rhomin) / rhomax : 0.;
-        if (q > maxDustDensityDispersion()) return true;
-    }
+        // exit early if a mean density criterion is clearly violated or if all criteria are clearly satisfied
+        int dustStatus = sampleDustMean ? rho.compare(rhoMax) : -1;
+        int electronStatus = sampleElectrons ? ne.compare(neMax) : -1;
+        int gasStatus = sampleGas ? ng.compare(ngMax) : -1;
+        if (dustStatus > 0 || electronStatus > 0 || gasStatus > 0) return true;
+        if (dustStatus < 0 && electronStatus < 0 && gasStatus < 0 && !_hasDustDensityDispersion) return false;
 
-    // handle maximum electron number fraction
-    if (_hasElectronFraction)
-    {
-        double delta = ne * node->volume() / _electronNumber;
-        if (delta > maxElectronFraction()) return true;
+        numTarget = min(2 * numSamples, _numSamples);
     }
 
-    // handle maximum gas number fraction
-    if (_hasGasFraction)
-    {
-        double delta = ng * node->volume() / _gasNumber;
-        if (delta > maxGasFraction()) return true;
-    }
+    // handle the mean density criteria using all samples
+    if (sampleDustMean && rho.mean() > rhoMax) return true;
+    if (sampleElectrons && ne.mean() > neMax) return true;
+    if (sampleGas && ng.mean() > ngMax) return true;
 
     // if we get here, none of the criteria were violated
     return false;
@@ -167,6 +255,9 @@ namespace
 
     // maximum number of nodes subdivided between two invocations of infoIfElapsed()
     const size_t logDivideChunkSize = 5000;
+
+    // minimum number of nodes per execution thread at a given level to start constructing subtrees concurrently
+    const size_t minSubtreesPerThread = 256;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -199,10 +290,17 @@ vector<TreeNode*> DensityTreePolicy::constructTree(TreeNode* root)
         lend = nodev.size();
     }
 
-    // recursively subdivide the nodes beyond the minimum level until all nodes satisfy the configured criteria
+    // recursively subdivide the nodes beyond the minimum level until all nodes satisfy the configured criteria,
+    // or until there are sufficiently many nodes at the current level to construct the subtrees concurrently
+    size_t minSubtrees = minSubtreesPerThread * find<ParallelFactory>()->maxThreadCount() * ProcessManager::size();
     while (level != maxLevel() && lend != lbeg)
     {
         size_t numEvalNodes = lend - lbeg;
+        if (numEvalNodes >= minSubtrees)
+        {
+            constructSubtrees(nodev, level, lbeg, lend);
+            break;
+        }
         log->info("Subdividing level " + std::to_string(level) + ": " + std::to_string(numEvalNodes) + " nodes");
         log->infoSetElapsed(numEvalNodes);
 
@@ -251,6 +349,77 @@ vector<TreeNode*> DensityTreePolicy::constructTree(TreeNode* root)
 
 ////////////////////////////////////////////////////////////////////
 
+void DensityTreePolicy::constructSubtrees(vector<TreeNode*>& nodev, int level, size_t lbeg, size_t lend)
+{
+    auto log = find<Log>();
+    auto parallel = find<ParallelFactory>()->parallelDistributed();
+
+    size_t numSubtrees = lend - lbeg;
+    log->info("Constructing " + std::to_string(numSubtrees) + " subtrees starting at level " + std::to_string(level));
+    log->infoSetElapsed(numSubtrees);
+
+    // construct each subtree breadth-first, creating children without adding them to the tree, and remember
+    // the subdivision decision for each node below the maximum level in the order of evaluation;
+    // only the decisions for subtrees constructed by this process are filled in
+    vector<vector<char>> dividevv(numSubtrees);
+    parallel->call(numSubtrees, [this, log, lbeg, &nodev, &dividevv](size_t firstIndex, size_t numIndices) {
+        for (size_t s = firstIndex; s != firstIndex + numIndices; ++s)
+        {
+            vector<TreeNode*> queue{nodev[lbeg + s]};
+            for (size_t q = 0; q != queue.size(); ++q)
+            {
+                TreeNode* node = queue[q];
+                if (node->level() < maxLevel())
+                {
+                    bool divide = needsSubdivide(node);
+                    dividevv[s].push_back(divide);
+                    if (divide)
+                    {
+                        node->createChildren(0);
+                        queue.insert(queue.end(), node->children().begin(), node->children().end());
+                    }
+                }
+            }
+        }
+        log->infoIfElapsed("Constructing subtrees: ", numIndices);
+    });
+
+    // share the subdivision decisions among processes, using the number of decisions for each subtree
+    // to determine the offset of each subtree in a flattened array
+    Array sizev(numSubtrees);
+    for (size_t s = 0; s != numSubtrees; ++s) sizev[s] = dividevv[s].size();
+    ProcessManager::sumToAll(sizev);
+    vector<size_t> offsetv(numSubtrees + 1);
+    for (size_t s = 0; s != numSubtrees; ++s) offsetv[s + 1] = offsetv[s] + static_cast<size_t>(sizev[s]);
+    Array dividev(offsetv[numSubtrees]);
+    for (size_t s = 0; s != numSubtrees; ++s)
+        for (size_t q = 0; q != dividevv[s].size(); ++q) dividev[offsetv[s] + q] = dividevv[s][q];
+    dividevv.clear();
+    ProcessManager::sumToAll(dividev);
+
+    // add the new nodes to the tree in breadth-first order, which yields the same order as level-by-level
+    // construction and consumes the decisions for each subtree in the order in which they were made;
+    // nodes in subtrees constructed by another process still need to be subdivided
+    log->info("Adding subtree nodes to the tree");
+    vector<size_t> subtreev(numSubtrees);  // subtree index for each node, starting at lbeg
+    for (size_t s = 0; s != numSubtrees; ++s) subtreev[s] = s;
+    for (size_t l = lbeg; l != nodev.size(); ++l)
+    {
+        TreeNode* node = nodev[l];
+        size_t s = subtreev[l - lbeg];
+        if (node->level() < maxLevel() && dividev[offsetv[s]++])
+        {
+            if (node->isChildless())
+                node->subdivide(nodev);
+            else
+                node->attachChildren(nodev);
+            subtreev.insert(subtreev.end(), node->children().size(), s);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 Range DensityTreePolicy::wavelengthRange() const
 {
     if (maxDustOpticalDepth() > 0)
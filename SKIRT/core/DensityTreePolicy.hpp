@@ -70,6 +70,27 @@ class Random;
     mass \f$M\f$ and mass density \f$\rho\f$. Other than this, the procedure is the same as the one
     described for dust.
 
+    <b>Performance optimizations</b>
+
+    If all media of a given material type can directly determine the mass (or number) contained in
+    a box (see Medium::hasMassInBox(), currently offered by particle and Voronoi mesh media), the
+    average density \f$\rho\f$ for that material type is obtained by dividing the mass inside the
+    node by its volume, rather than by sampling the density at random positions. The density
+    dispersion criterion always requires sampling.
+
+    The densities are sampled in batches of increasing size, starting with a small number of
+    samples and doubling the number of samples up to the configured number \f$N\f$. After each
+    batch, the sampled mean density \f$\rho\f$ is compared with the value corresponding to each
+    enabled threshold, taking into account a confidence interval of three times the standard error
+    on the mean estimated from the sample variance. Sampling stops early as soon as a criterion is
+    clearly violated (in which case the node is subdivided) or all criteria are clearly satisfied
+    (in which case it is not). If all samples taken so far have the same value (e.g., zero for a
+    node that clips a thin dense sheet or filament), the sample variance carries no information on
+    the uncertainty, so the outcome is considered uncertain. Because additional samples can only
+    increase the dispersion measure \f$q\f$, a violation of the density dispersion criterion is
+    always final. If the decision remains uncertain, all \f$N\f$ samples are taken and the
+    criteria are evaluated as described above.
+
     This class implements the MaterialWavelengthRangeInterface to indicate that wavelength-dependent
     material properties will be required in case the optical depth criterion is enabled. */
 class DensityTreePolicy : public TreePolicy, public MaterialWavelengthRangeInterface
@@ -140,9 +161,23 @@ public:
         only output is a Boolean flag), while the second one cannot (the tree structure is updated
         in various ways). Parallelizing the first operation is often meaningful, because
         determining whether a node needs subdivision can be resource-intensive (for example, it may
-        require sampling densities in the source distribution). */
+        require sampling densities in the source distribution).
+
+        Once a level holds sufficiently many nodes to keep all execution threads busy, the function
+        no longer synchronizes at every level. Instead, it invokes the constructSubtrees() function
+        to construct the subtrees below each of the nodes at that level concurrently. */
     vector<TreeNode*> constructTree(TreeNode* root) override;
 
+private:
+    /** This function completes the construction of the tree by concurrently constructing the
+        subtrees below each of the nodes in the specified index range of the node list, which
+        contains all nodes at the specified level. Each subtree is handled by a single execution
+        thread, which evaluates its nodes and creates their children breadth-first, without adding
+        the children to the tree. The subdivision decisions are then shared among processes, and
+        the function adds all newly created nodes to the tree (i.e. to the node list) in the same
+        order as level-by-level construction would have. */
+    void constructSubtrees(vector<TreeNode*>& nodev, int level, size_t lbeg, size_t lend);
+
     //======================== Other Functions =======================
 
 public:
@@ -180,6 +215,12 @@ private:
     double _dustKappa{0.};
     double _electronNumber{0.};
     double _gasNumber{0.};
+
+    // flags become true if the average density for the corresponding material type is obtained
+    // through a direct mass or number query for each node rather than by sampling
+    bool _hasDustQuery{false};
+    bool _hasElectronQuery{false};
+    bool _hasGasQuery{false};
 };
 
 //////////////////////////////////////////////////////////////////////
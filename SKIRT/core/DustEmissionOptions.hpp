@@ -37,6 +37,25 @@ class DustEmissionOptions : public SimulationItem, public SourceWavelengthRangeI
         ATTRIBUTE_DEFAULT_VALUE(includeHeatingByCMB, "false")
         ATTRIBUTE_DISPLAYED_IF(includeHeatingByCMB, "NonZeroRedshift")
 
+        PROPERTY_BOOL(precalculateEquilibriumCutoffs,
+                      "precalculate the equilibrium grain mass cutoffs to speed up stochastic emission calculations")
+        ATTRIBUTE_DEFAULT_VALUE(precalculateEquilibriumCutoffs, "false")
+        ATTRIBUTE_RELEVANT_IF(precalculateEquilibriumCutoffs, "dustEmissionTypeStochastic")
+        ATTRIBUTE_DISPLAYED_IF(precalculateEquilibriumCutoffs, "Level3")
+
+        PROPERTY_DOUBLE(emissivityTableTolerance,
+                        "the relative tolerance for interpolating emissivity spectra from a table (or zero for none)")
+        ATTRIBUTE_MIN_VALUE(emissivityTableTolerance, "[0")
+        ATTRIBUTE_MAX_VALUE(emissivityTableTolerance, "0.5]")
+        ATTRIBUTE_DEFAULT_VALUE(emissivityTableTolerance, "0")
+        ATTRIBUTE_DISPLAYED_IF(emissivityTableTolerance, "Level3")
+
+        PROPERTY_BOOL(cacheEmissivityTable,
+                      "cache the emissivity table in the cache directory (option -a) for subsequent runs")
+        ATTRIBUTE_DEFAULT_VALUE(cacheEmissivityTable, "false")
+        ATTRIBUTE_RELEVANT_IF(cacheEmissivityTable, "emissivityTableTolerance")
+        ATTRIBUTE_DISPLAYED_IF(cacheEmissivityTable, "Level3")
+
         PROPERTY_ITEM(cellLibrary, SpatialCellLibrary, "the spatial cell grouping scheme for calculating dust emission")
         ATTRIBUTE_DEFAULT_VALUE(cellLibrary, "AllCellsLibrary")
         ATTRIBUTE_REQUIRED_IF(cellLibrary, "false")
@@ -82,6 +101,19 @@ class DustEmissionOptions : public SimulationItem, public SourceWavelengthRangeI
         ATTRIBUTE_RELEVANT_IF(wavelengthBiasDistribution, "wavelengthBias")
         ATTRIBUTE_DISPLAYED_IF(wavelengthBiasDistribution, "Level3")
 
+        PROPERTY_DOUBLE(maxSpectraMemory,
+                        "the maximum memory in GB for storing precalculated secondary emission spectra")
+        ATTRIBUTE_MIN_VALUE(maxSpectraMemory, "[0")
+        ATTRIBUTE_MAX_VALUE(maxSpectraMemory, "10000]")
+        ATTRIBUTE_DEFAULT_VALUE(maxSpectraMemory, "1")
+        ATTRIBUTE_DISPLAYED_IF(maxSpectraMemory, "Level3")
+
+        PROPERTY_BOOL(storeSpectraInSinglePrecision,
+                      "store the precalculated secondary emission spectra in single precision")
+        ATTRIBUTE_DEFAULT_VALUE(storeSpectraInSinglePrecision, "false")
+        ATTRIBUTE_RELEVANT_IF(storeSpectraInSinglePrecision, "maxSpectraMemory")
+        ATTRIBUTE_DISPLAYED_IF(storeSpectraInSinglePrecision, "Level3")
+
     ITEM_END()
 
     //======================== Other Functions =======================
@@ -7,6 +7,7 @@
 #include "ArrayTable.hpp"
 #include "Configuration.hpp"
 #include "DisjointWavelengthGrid.hpp"
+#include "DustEmissivityTable.hpp"
 #include "InstrumentWavelengthGridProbe.hpp"
 #include "MediumSystem.hpp"
 #include "PlanckFunction.hpp"
@@ -18,36 +19,6 @@
 
 namespace
 {
-    // This function returns the Mathis field J_lambda (Mathis et al. 1983)
-    // discretized on the simulation's radiation field wavelength grid.
-    // Note that the Mathis recipe describes the field as 4pi J_lambda,
-    // whereas this function returns the mean intensity J_lambda per steradian.
-    Array mathis(Probe* probe)
-    {
-        auto wavelengthGrid = probe->find<Configuration>()->radiationFieldWLG();
-        int numWavelengths = wavelengthGrid->numBins();
-        int ellA = max(0, wavelengthGrid->bin(0.0912e-6));
-        int ellB = max(ellA, wavelengthGrid->bin(0.110e-6));
-        int ellC = max(ellB, wavelengthGrid->bin(0.134e-6));
-        int ellD = max(ellC, wavelengthGrid->bin(0.250e-6));
-
-        const double Wv[] = {1e-14, 1e-13, 4e-13};
-        const double Tv[] = {7500, 4000, 3000};
-
-        Array Jv(numWavelengths);
-        for (int ell = ellA + 1; ell <= ellB; ell++)
-            Jv[ell] = 3069. * pow(wavelengthGrid->wavelength(ell) * 1e6, 3.4172);
-        for (int ell = ellB + 1; ell <= ellC; ell++) Jv[ell] = 1.627;
-        for (int ell = ellC + 1; ell <= ellD; ell++)
-            Jv[ell] = 0.0566 * pow(wavelengthGrid->wavelength(ell) * 1e6, -1.6678);
-        for (int i = 0; i < 3; i++)
-        {
-            PlanckFunction B(Tv[i]);
-            for (int ell = ellD + 1; ell < numWavelengths; ell++) Jv[ell] += Wv[i] * B(wavelengthGrid->wavelength(ell));
-        }
-        return Jv;
-    }
-
     // This function returns the blackbody field B_lambda(T)
     // discretized on the simulation's radiation field wavelength grid.
     Array blackbody(Probe* probe, double T)
@@ -116,7 +87,7 @@ void DustEmissivityProbe::probeSetup()
     {
         // write emissivities for a range of scaled Mathis ISRF input fields
         {
-            Array Jv = mathis(this);
+            Array Jv = DustEmissivityTable::mathisField(find<Configuration>()->radiationFieldWLG());
             for (int i = -4; i < 7; i++)
             {
                 double U = pow(10., i);
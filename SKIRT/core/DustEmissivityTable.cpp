@@ -0,0 +1,428 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "DustEmissivityTable.hpp"
+#include "CacheKey.hpp"
+#include "Configuration.hpp"
+#include "Constants.hpp"
+#include "DisjointWavelengthGrid.hpp"
+#include "FatalError.hpp"
+#include "FilePaths.hpp"
+#include "ItemUtils.hpp"
+#include "Log.hpp"
+#include "NR.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "PlanckFunction.hpp"
+#include "ProcessManager.hpp"
+#include "SimulationItemRegistry.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include <cstdio>
+#include <fstream>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the initial grid and the refinement limit
+    const double logUmin = -6.;     // the smallest strength in the table
+    const double logUmax = 8.;      // the largest strength in the table
+    const int numInitialU = 15;     // the number of initial strength grid points (one per dex)
+    const double betamin = -2.;     // the smallest spectral slope in the table
+    const double betamax = 2.;      // the largest spectral slope in the table
+    const int numInitialBeta = 5;   // the number of initial spectral slope grid points (one per unit)
+    const int maxRefinements = 5;   // the maximum number of refinement steps
+    const double lambdaV = 0.55e-6; // the pivot wavelength for the spectral slope
+
+    // the fraction of the maximum of lambda*epsilon_lambda below which errors are ignored
+    const double significant = 1e-3;
+
+    // the identifier at the start of a cache file
+    const uint64_t magic = 0x3130544D45544B53;  // "SKTEMT01" in little-endian byte order
+
+    // returns the maximum relative error of the specified interpolated spectrum compared to the exact spectrum,
+    // considering only the wavelengths where lambda*epsilon_lambda is significant
+    double relativeError(const Array& lambdav, const Array& exactv, const Array& interpolatedv)
+    {
+        double peak = (lambdav * exactv).max();
+        double error = 0.;
+        size_t n = exactv.size();
+        for (size_t ell = 0; ell != n; ++ell)
+        {
+            if (lambdav[ell] * exactv[ell] > significant * peak)
+                error = max(error, abs(interpolatedv[ell] - exactv[ell]) / exactv[ell]);
+        }
+        return error;
+    }
+
+    // adds the contents of the specified array to the cache key
+    void addArray(CacheKey& key, const Array& values) { key.add(begin(values), values.size() * sizeof(double)); }
+}
+
+////////////////////////////////////////////////////////////////////
+
+Array DustEmissivityTable::mathisField(const WavelengthGrid* wavelengthGrid)
+{
+    int numWavelengths = wavelengthGrid->numBins();
+    int ellA = max(0, wavelengthGrid->bin(0.0912e-6));
+    int ellB = max(ellA, wavelengthGrid->bin(0.110e-6));
+    int ellC = max(ellB, wavelengthGrid->bin(0.134e-6));
+    int ellD = max(ellC, wavelengthGrid->bin(0.250e-6));
+
+    const double Wv[] = {1e-14, 1e-13, 4e-13};
+    const double Tv[] = {7500, 4000, 3000};
+
+    Array Jv(numWavelengths);
+    for (int ell = ellA + 1; ell <= ellB; ell++) Jv[ell] = 3069. * pow(wavelengthGrid->wavelength(ell) * 1e6, 3.4172);
+    for (int ell = ellB + 1; ell <= ellC; ell++) Jv[ell] = 1.627;
+    for (int ell = ellC + 1; ell <= ellD; ell++) Jv[ell] = 0.0566 * pow(wavelengthGrid->wavelength(ell) * 1e6, -1.6678);
+    for (int i = 0; i < 3; i++)
+    {
+        PlanckFunction B(Tv[i]);
+        for (int ell = ellD + 1; ell < numWavelengths; ell++) Jv[ell] += Wv[i] * B(wavelengthGrid->wavelength(ell));
+    }
+    return Jv;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DustEmissivityTable::build(SimulationItem* item, string mixType, const Emissivity& emissivity, double tolerance,
+                                bool useCache)
+{
+    auto config = item->find<Configuration>();
+    auto log = item->find<Log>();
+
+    // copy the simulation's radiation field wavelength grid
+    auto radiationFieldWLG = config->radiationFieldWLG();
+    radiationFieldWLG->setup();
+    int numLambda = radiationFieldWLG->numBins();
+    _rflambdav.resize(numLambda);
+    _rfdlambdav.resize(numLambda);
+    for (int k = 0; k != numLambda; ++k)
+    {
+        _rflambdav[k] = radiationFieldWLG->wavelength(k);
+        _rfdlambdav[k] = radiationFieldWLG->effectiveWidth(k);
+    }
+
+    // get the dust emission wavelength grid
+    auto dustEmissionWLG = config->dustEmissionWLG();
+    dustEmissionWLG->setup();
+    const Array& emlambdav = dustEmissionWLG->extlambdav();
+
+    // calculate the properties of the reference field
+    Array Jmwv = mathisField(radiationFieldWLG);
+    _Jmw = (Jmwv * _rfdlambdav).sum();
+    _Emw = 1.;
+    _Emw = pow(10., hardness(Jmwv));
+
+    // construct the shape of the radiation field for a given spectral slope, normalized to U=1
+    auto shape = [this, &Jmwv](double beta) -> Array {
+        Array Jv = Jmwv * pow(_rflambdav / lambdaV, -beta);
+        return Jv * (_Jmw / (Jv * _rfdlambdav).sum());
+    };
+
+    // determine the number of wavelengths in the emissivity spectra
+    int numEm = emissivity(Jmwv).size();
+
+    // if requested and a cache path has been specified, try to load the table from the cache
+    auto paths = item->find<FilePaths>();
+    if (useCache && paths->cachePath().empty())
+    {
+        log->warning("The emissivity table for " + mixType
+                     + " is not cached because no cache path has been specified (option -a)");
+        useCache = false;
+    }
+    string path;
+    uint64_t key = 0;
+    if (useCache)
+    {
+        CacheKey cacheKey;
+        cacheKey.add(ItemUtils::hierarchyRepresentation(SimulationItemRegistry::getSchemaDef(), item));
+        paths->addInputFiles(cacheKey, item);
+        FilePaths::addResources(cacheKey);
+        addArray(cacheKey, _rflambdav);
+        addArray(cacheKey, emlambdav);
+        bool options[] = {config->hasStochasticDustEmission(), config->precalculateEquilibriumCutoffs()};
+        cacheKey.add(options, sizeof(options));
+        cacheKey.addValue(config->includeHeatingByCMB() ? config->redshift() : -1.);
+        cacheKey.addValue(tolerance);
+        key = cacheKey.value();
+        path = paths->cache(mixType + "_EmissivityTable_" + cacheKey.hexString() + ".bin");
+        // when running with multiple processes, use the cache only if all processes could load it,
+        // because building the table involves collective communication
+        if (ProcessManager::isTrueForAll(load(path, key)))
+        {
+            log->info("  Loaded emissivity table with " + std::to_string(_logUv.size()) + " x "
+                      + std::to_string(_etav.size()) + " grid points from " + path);
+            return;
+        }
+    }
+
+    // build the initial grid in strength and spectral slope; the values are stored per grid line along the strength
+    // axis so that grid lines can easily be inserted along both axes
+    vector<double> logUv(numInitialU);
+    for (int i = 0; i != numInitialU; ++i) logUv[i] = logUmin + i * (logUmax - logUmin) / (numInitialU - 1);
+    vector<double> betav(numInitialBeta);
+    for (int j = 0; j != numInitialBeta; ++j)
+        betav[j] = betamin + j * (betamax - betamin) / (numInitialBeta - 1);
+    vector<double> etav;
+    for (double beta : betav) etav.push_back(hardness(shape(beta)));
+    vector<vector<Array>> evvv(numInitialU, vector<Array>(numInitialBeta));
+
+    // calculate the emissivity spectra divided by strength for the specified list of grid points,
+    // distributing the calculation over all threads and processes
+    auto calculate = [this, item, &emissivity, &shape, numEm](const vector<std::pair<double, double>>& points) {
+        Table<2> evv(points.size(), numEm);
+        item->find<ParallelFactory>()->parallelDistributed()->call(
+            points.size(), [this, &emissivity, &shape, &points, &evv, numEm](size_t firstIndex, size_t numIndices) {
+                for (size_t p = firstIndex; p != firstIndex + numIndices; ++p)
+                {
+                    double U = pow(10., points[p].first);
+                    Array ev = emissivity(U * shape(points[p].second)) / U;
+                    for (int ell = 0; ell != numEm; ++ell) evv(p, ell) = ev[ell];
+                }
+            });
+        ProcessManager::sumToAll(evv.data());
+        vector<Array> evv2(points.size(), Array(numEm));
+        for (size_t p = 0; p != points.size(); ++p)
+            for (int ell = 0; ell != numEm; ++ell) evv2[p][ell] = evv(p, ell);
+        return evv2;
+    };
+
+    // calculate the initial grid
+    {
+        vector<std::pair<double, double>> points;
+        for (double logU : logUv)
+            for (double beta : betav) points.emplace_back(logU, beta);
+        auto evv = calculate(points);
+        for (int i = 0; i != numInitialU; ++i)
+            for (int j = 0; j != numInitialBeta; ++j) evvv[i][j] = std::move(evv[i * numInitialBeta + j]);
+    }
+
+    // refine the grid, alternating between the axes
+    vector<char> convergedU(numInitialU - 1, false);     // indexed on the interval between i and i+1
+    vector<char> convergedBeta(numInitialBeta - 1, false);  // indexed on the interval between j and j+1
+    double maxError = 0.;
+    bool converged = false;
+    for (int refinement = 0; refinement != maxRefinements && !converged; ++refinement)
+    {
+        bool refined = false;
+        maxError = 0.;
+
+        // refine the strength axis
+        {
+            // calculate the midpoints for all intervals that have not yet converged
+            vector<int> intervals;
+            for (size_t i = 0; i != convergedU.size(); ++i)
+                if (!convergedU[i]) intervals.push_back(i);
+            vector<std::pair<double, double>> points;
+            for (int i : intervals)
+                for (double beta : betav) points.emplace_back(0.5 * (logUv[i] + logUv[i + 1]), beta);
+            auto evv = calculate(points);
+
+            // insert the midpoints for intervals that do not meet the tolerance, going backwards to preserve indices
+            size_t numBeta = betav.size();
+            for (int n = intervals.size() - 1; n >= 0; --n)
+            {
+                int i = intervals[n];
+                double error = 0.;
+                for (size_t j = 0; j != numBeta; ++j)
+                {
+                    Array interpolatedv = 0.5 * (evvv[i][j] + evvv[i + 1][j]);
+                    error = max(error, relativeError(emlambdav, evv[n * numBeta + j], interpolatedv));
+                }
+                maxError = max(maxError, error);
+                if (error > tolerance)
+                {
+                    vector<Array> evv2(numBeta);
+                    for (size_t j = 0; j != numBeta; ++j) evv2[j] = std::move(evv[n * numBeta + j]);
+                    logUv.insert(logUv.begin() + i + 1, 0.5 * (logUv[i] + logUv[i + 1]));
+                    evvv.insert(evvv.begin() + i + 1, std::move(evv2));
+                    convergedU.insert(convergedU.begin() + i + 1, false);
+                    refined = true;
+                }
+                else
+                {
+                    convergedU[i] = true;
+                }
+            }
+        }
+
+        // refine the spectral slope axis
+        {
+            // calculate the midpoints for all intervals that have not yet converged
+            vector<int> intervals;
+            for (size_t j = 0; j != convergedBeta.size(); ++j)
+                if (!convergedBeta[j]) intervals.push_back(j);
+            vector<std::pair<double, double>> points;
+            for (int j : intervals)
+                for (double logU : logUv) points.emplace_back(logU, 0.5 * (betav[j] + betav[j + 1]));
+            auto evv = calculate(points);
+
+            // insert the midpoints for intervals that do not meet the tolerance, going backwards to preserve indices;
+            // the interpolation weight is determined by the hardness, just like for an arbitrary radiation field
+            size_t numU = logUv.size();
+            for (int n = intervals.size() - 1; n >= 0; --n)
+            {
+                int j = intervals[n];
+                double beta = 0.5 * (betav[j] + betav[j + 1]);
+                double eta = hardness(shape(beta));
+                double w = (eta - etav[j]) / (etav[j + 1] - etav[j]);
+                double error = 0.;
+                for (size_t i = 0; i != numU; ++i)
+                {
+                    Array interpolatedv = (1. - w) * evvv[i][j] + w * evvv[i][j + 1];
+                    error = max(error, relativeError(emlambdav, evv[n * numU + i], interpolatedv));
+                }
+                maxError = max(maxError, error);
+                if (error > tolerance)
+                {
+                    for (size_t i = 0; i != numU; ++i)
+                        evvv[i].insert(evvv[i].begin() + j + 1, std::move(evv[n * numU + i]));
+                    betav.insert(betav.begin() + j + 1, beta);
+                    etav.insert(etav.begin() + j + 1, eta);
+                    convergedBeta.insert(convergedBeta.begin() + j + 1, false);
+                    refined = true;
+                }
+                else
+                {
+                    convergedBeta[j] = true;
+                }
+            }
+        }
+
+        converged = !refined;
+    }
+
+    // verify that the hardness is strictly increasing with spectral slope
+    for (size_t j = 1; j < etav.size(); ++j)
+        if (!(etav[j] > etav[j - 1]))
+            throw FATALERROR("The radiation field wavelength grid is too coarse to build an emissivity table");
+
+    // copy the grid into the final data structures
+    int numU = logUv.size();
+    int numEta = etav.size();
+    _logUv = NR::array(logUv);
+    _etav = NR::array(etav);
+    _evvv.resize(numU, numEta, numEm);
+    for (int i = 0; i != numU; ++i)
+        for (int j = 0; j != numEta; ++j)
+            for (int ell = 0; ell != numEm; ++ell) _evvv(i, j, ell) = evvv[i][j][ell];
+
+    log->info("  Built emissivity table for " + mixType + " with " + std::to_string(numU) + " x "
+              + std::to_string(numEta) + " grid points; largest relative error in last step: "
+              + StringUtils::toString(maxError, 'e', 2));
+    if (!converged)
+        log->warning("The emissivity table for " + mixType + " did not converge within "
+                     + std::to_string(maxRefinements) + " refinement steps; the interpolation error may exceed "
+                     + StringUtils::toString(tolerance, 'e', 2) + " for some radiation fields");
+
+    // if requested, save the table to the cache
+    if (useCache && ProcessManager::isRoot())
+    {
+        save(path, key);
+        log->info("  Saved emissivity table to " + path);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t DustEmissivityTable::allocatedBytes() const
+{
+    return (_rflambdav.size() + _rfdlambdav.size() + _logUv.size() + _etav.size() + _evvv.size()) * sizeof(double);
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool DustEmissivityTable::interpolate(const Array& Jv, Array& ev) const
+{
+    if (!_logUv.size()) return false;
+
+    // locate the radiation field in the table
+    double U = (Jv * _rfdlambdav).sum() / _Jmw;
+    if (U <= 0.) return false;
+    double logU = log10(U);
+    int i = NR::locateFail(_logUv, logU);
+    if (i < 0) return false;
+    double eta = hardness(Jv);
+    int j = NR::locateFail(_etav, eta);
+    if (j < 0) return false;
+
+    // perform bilinear interpolation
+    double hU = (logU - _logUv[i]) / (_logUv[i + 1] - _logUv[i]);
+    double hE = (eta - _etav[j]) / (_etav[j + 1] - _etav[j]);
+    double w00 = U * (1. - hU) * (1. - hE);
+    double w01 = U * (1. - hU) * hE;
+    double w10 = U * hU * (1. - hE);
+    double w11 = U * hU * hE;
+    size_t numEm = _evvv.size(2);
+    if (ev.size() != numEm) ev.resize(numEm);
+    size_t numEta = _etav.size();
+    const double* e00 = begin(_evvv.data()) + (i * numEta + j) * numEm;
+    const double* e01 = e00 + numEm;
+    const double* e10 = e00 + numEta * numEm;
+    const double* e11 = e10 + numEm;
+    for (size_t ell = 0; ell != numEm; ++ell)
+        ev[ell] = w00 * e00[ell] + w01 * e01[ell] + w10 * e10[ell] + w11 * e11[ell];
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double DustEmissivityTable::hardness(const Array& Jv) const
+{
+    double photons = (Jv * _rflambdav * _rfdlambdav).sum();
+    if (photons <= 0.) return 0.;
+    double E = Constants::h() * Constants::c() * (Jv * _rfdlambdav).sum() / photons;
+    return log10(E / _Emw);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DustEmissivityTable::save(string path, uint64_t key) const
+{
+    // write the file under a temporary name and rename it when complete, so that concurrent simulations
+    // never see a partially written file
+    string tempPath = path + "." + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tmp";
+    {
+        std::ofstream out = System::ofstream(tempPath);
+        uint64_t header[] = {magic, key, _logUv.size(), _etav.size(), _evvv.size(2)};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&_Emw), sizeof(double));
+        out.write(reinterpret_cast<const char*>(begin(_logUv)), _logUv.size() * sizeof(double));
+        out.write(reinterpret_cast<const char*>(begin(_etav)), _etav.size() * sizeof(double));
+        out.write(reinterpret_cast<const char*>(begin(_evvv.data())), _evvv.size() * sizeof(double));
+    }
+    std::rename(tempPath.c_str(), path.c_str());
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool DustEmissivityTable::load(string path, uint64_t key)
+{
+    if (!System::isFile(path)) return false;
+    std::ifstream in = System::ifstream(path);
+    uint64_t header[5];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+    if (header[0] != magic || header[1] != key) return false;
+
+    double Emw;
+    Array logUv(header[2]), etav(header[3]);
+    Table<3> evvv(header[2], header[3], header[4]);
+    in.read(reinterpret_cast<char*>(&Emw), sizeof(double));
+    in.read(reinterpret_cast<char*>(begin(logUv)), logUv.size() * sizeof(double));
+    in.read(reinterpret_cast<char*>(begin(etav)), etav.size() * sizeof(double));
+    in.read(reinterpret_cast<char*>(begin(evvv.data())), evvv.size() * sizeof(double));
+    if (!in) return false;
+
+    _Emw = Emw;
+    _logUv = std::move(logUv);
+    _etav = std::move(etav);
+    _evvv = std::move(evvv);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
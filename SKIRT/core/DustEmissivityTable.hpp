@@ -0,0 +1,143 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef DUSTEMISSIVITYTABLE_HPP
+#define DUSTEMISSIVITYTABLE_HPP
+
+#include "Table.hpp"
+#include <functional>
+class SimulationItem;
+class WavelengthGrid;
+
+////////////////////////////////////////////////////////////////////
+
+/** DustEmissivityTable is a helper class to tabulate the emissivity spectrum
+    \f$\varepsilon_{\lambda}\f$ of a dust mix as a function of the strength and the hardness of the
+    embedding radiation field, and to interpolate the emissivity spectrum for a given radiation
+    field from this table. This allows replacing the expensive emissivity calculation for each
+    spatial cell (or library entry) by a cheap interpolation whose cost does not depend on the
+    number of representative grains in the dust mix.
+
+    <b>Parametrization</b>
+
+    The table is built from a two-parameter family of radiation fields derived from the local
+    interstellar radiation field in the Milky Way according to Mathis et al. (1983),
+    \f$J_\lambda^{\text{MW}}\f$, \f[ J_\lambda(U,\beta) = U\, \frac{ J_\lambda^{\text{MW}}\,
+    (\lambda/\lambda_\text{V})^{-\beta} }{ \int_0^\infty J_\lambda^{\text{MW}}\,
+    (\lambda/\lambda_\text{V})^{-\beta}\, {\text{d}}\lambda } \int_0^\infty
+    J_\lambda^{\text{MW}}\, {\text{d}}\lambda, \f] where \f$\lambda_\text{V}=0.55~\mu\text{m}\f$.
+    The strength parameter \f$U\f$ is the wavelength-integrated mean intensity relative to that of
+    the Milky Way field, and the spectral slope \f$\beta\f$ tilts the spectrum towards shorter
+    (\f$\beta>0\f$) or longer (\f$\beta<0\f$) wavelengths. Because the slope of an arbitrary
+    radiation field cannot be determined directly, the table is indexed on the hardness \f[ \eta =
+    \log_{10} \frac{\left<E\right>}{\left<E\right>^{\text{MW}}}, \f] where \f$\left<E\right>\f$ is
+    the mean photon energy of the radiation field. The hardness is a monotonic function of the
+    spectral slope, and it can be calculated for any radiation field. All integrals are evaluated
+    on the simulation's radiation field wavelength grid.
+
+    The table stores the emissivity spectrum divided by \f$U\f$ for each grid point
+    \f$(\log_{10}U, \eta)\f$. The emissivity spectrum for a given radiation field is obtained
+    through bilinear interpolation in \f$\log_{10}U\f$ and \f$\eta\f$ of these normalized values,
+    multiplied by the field strength. Radiation fields outside of the tabulated range of strengths
+    and hardnesses are not handled by the table; the client should calculate the emissivity
+    spectrum directly for these fields.
+
+    If the simulation's configuration requests the inclusion of the cosmic microwave background as
+    a dust heating source, the emissivity spectra in the table include its effect. Because the CMB
+    temperature is fixed for a given simulation, it does not need to be a parameter of the table.
+
+    <b>Error control</b>
+
+    The table is built on an initial grid with a spacing of one dex in strength and one unit in
+    spectral slope, and it is then refined adaptively. In each refinement step, and for each of the
+    two axes in turn, the emissivity spectrum is calculated at the midpoint of each grid interval
+    that has not yet converged, for each of the grid points on the other axis. These spectra are
+    compared to the values interpolated from the neighboring grid points. If the relative error at
+    any wavelength where \f$\lambda\varepsilon_\lambda\f$ exceeds \f$10^{-3}\f$ of its maximum is
+    larger than the specified tolerance, the calculated spectra are inserted into the table as a
+    new grid line. Otherwise the interval is considered to have converged. The refinement stops
+    when all intervals have converged or after five refinement steps, which limits the table to
+    at most 449 grid points in strength and 129 in spectral slope. In the latter case, the table
+    is used as is, even though the tolerance may not be met everywhere, and a warning is logged.
+
+    <b>Caching</b>
+
+    Building the table requires many emissivity calculations. If requested, and if a cache path
+    has been specified for the simulation (see the FilePaths class), the table is stored in a
+    binary file in the cache directory and loaded from this file by subsequent runs. The file name
+    includes a hash key derived from the complete configuration of the dust mix (including its
+    children in the simulation hierarchy), the input files read by the dust mix, the resource
+    files, the wavelength grids, the type of emission calculation, the CMB configuration, and the
+    tolerance. As a result, a cached table is reused only for an identically configured dust mix
+    and simulation. When running with multiple processes, the cached table is used only if all
+    processes can load it. */
+class DustEmissivityTable
+{
+public:
+    /** The type of the function that calculates the emissivity spectrum for a given radiation
+        field, discretized on the simulation's radiation field wavelength grid. The function must be
+        thread-safe. */
+    using Emissivity = std::function<Array(const Array& Jv)>;
+
+    /** This function returns the local interstellar radiation field in the Milky Way according to
+        Mathis et al. (1983), discretized on the specified wavelength grid. Note that the Mathis
+        recipe describes the field as \f$4\pi J_\lambda\f$, whereas this function returns the mean
+        intensity \f$J_\lambda\f$ per steradian. */
+    static Array mathisField(const WavelengthGrid* wavelengthGrid);
+
+    /** This function builds the table for the dust mix represented by the specified emissivity
+        function, as described in the class header, or loads the table from a cache file if
+        requested and available. The first argument specifies the dust mix; it is used to obtain
+        the simulation's configuration, to log messages, and to derive the cache key. The second
+        argument specifies a human-readable type name for the dust mix; it is used for logging and
+        as part of the cache file name. */
+    void build(SimulationItem* item, string mixType, const Emissivity& emissivity, double tolerance, bool useCache);
+
+    /** This function returns true if the table has been built or loaded, and false otherwise. */
+    bool isBuilt() const { return _logUv.size() > 0; }
+
+    /** This function returns the size of the memory, in bytes, allocated by the build() function.
+        This information can be used for logging purposes. */
+    size_t allocatedBytes() const;
+
+    /** This function interpolates the emissivity spectrum for the radiation field specified by
+        the mean intensities \f$(J_\lambda)_k\f$ from the table and stores it in the output array,
+        resizing the array only if it does not have the appropriate size. If the radiation field
+        lies outside of the tabulated range, or if the table has not been built, the function
+        returns false and leaves the output array untouched. Otherwise it returns true. */
+    bool interpolate(const Array& Jv, Array& ev) const;
+
+private:
+    /** This function returns the hardness \f$\eta\f$ of the specified radiation field, or zero if
+        the radiation field has no photons. */
+    double hardness(const Array& Jv) const;
+
+    /** This function writes the table to the specified file. The file is first written under a
+        temporary name and then renamed, so that concurrent simulations never read a partially
+        written file. */
+    void save(string path, uint64_t key) const;
+
+    /** This function loads the table from the specified file and returns true if the file exists
+        and has the specified key. Otherwise it returns false. */
+    bool load(string path, uint64_t key);
+
+    //======================== Data Members ========================
+
+private:
+    // radiation field wavelength grid and reference field
+    Array _rflambdav;   // radiation field wavelength grid -- indexed on k
+    Array _rfdlambdav;  // radiation field wavelength grid bin widths -- indexed on k
+    double _Jmw{0.};    // wavelength-integrated Milky Way radiation field
+    double _Emw{0.};    // mean photon energy of the Milky Way radiation field
+
+    // the table
+    Array _logUv;    // log10 of the strength at the grid points -- indexed on i
+    Array _etav;     // hardness at the grid points -- indexed on j
+    Table<3> _evvv;  // emissivity divided by strength -- indexed on i, j and ell
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -4,12 +4,23 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "DustMix.hpp"
+#include "CacheKey.hpp"
 #include "Configuration.hpp"
+#include "DisjointWavelengthGrid.hpp"
+#include "FilePaths.hpp"
+#include "ItemUtils.hpp"
 #include "Log.hpp"
 #include "NR.hpp"
+#include "ProcessManager.hpp"
 #include "Random.hpp"
+#include "SimulationItemRegistry.hpp"
 #include "StokesVector.hpp"
 #include "StringUtils.hpp"
+#include "System.hpp"
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -29,6 +40,114 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
+// the data structure holding the properties precalculated during setup,
+// which may be shared between dust mix instances with an identical configuration
+struct DustMix::Properties
+{
+    // wavelength grid (shifted to the left of the actually sampled points to approximate rounding)
+    Array lambdav;  // indexed on ell
+
+    // scattering angle grid
+    Array thetav;  // indexed on t
+
+    // basic optical properties
+    double mu{0.};
+    Array sigmaabsv;  // indexed on ell
+    Array sigmascav;  // indexed on ell
+    Array sigmaextv;  // indexed on ell
+    Array asymmparv;  // indexed on ell
+
+    // Mueller matrix coefficients
+    Table<2> S11vv;  // indexed on ell,t
+    Table<2> S12vv;  // indexed on ell,t
+    Table<2> S33vv;  // indexed on ell,t
+    Table<2> S34vv;  // indexed on ell,t
+
+    // precalculated discretizations of (functions of) the scattering angles
+    ArrayTable<2> thetaXvv;  // indexed on ell and t
+    Array pfnormv;           // indexed on ell
+    Array phiv;              // indexed on f
+    Array phi1v;             // indexed on f
+    Array phisv;             // indexed on f
+    Array phicv;             // indexed on f
+
+    // precalculated discretizations for spheroidal grains as a function of the emission angle
+    ArrayTable<2> sigmaabsvv;     // indexed on ell and t
+    ArrayTable<2> sigmaabspolvv;  // indexed on ell and t
+
+    // equilibrium temperature and emission calculator
+    EquilibriumDustEmissionCalculator calc;
+
+    // additional properties precalculated by the subclass, if any
+    std::shared_ptr<ExtraProperties> extra;
+};
+
+////////////////////////////////////////////////////////////////////
+
+// process-wide registry of the properties of the dust mixes that have been set up
+namespace
+{
+    // an entry in the registry for a given configuration key
+    struct RegistryEntry
+    {
+        std::mutex mutex;                // locked while the properties for this configuration are being set up
+        std::weak_ptr<void> properties;  // the properties, as long as they are in use by some dust mix
+    };
+
+    std::mutex registryMutex;
+    std::unordered_map<uint64_t, std::shared_ptr<RegistryEntry>> registry;
+
+    // returns the registry entry for the specified configuration key, creating it if needed; entries whose
+    // properties have been released and that are not being set up by some dust mix are removed on the way
+    std::shared_ptr<RegistryEntry> registryEntry(uint64_t key)
+    {
+        std::unique_lock<std::mutex> lock(registryMutex);
+        for (auto it = registry.begin(); it != registry.end();)
+        {
+            if (it->second.use_count() == 1 && it->second->properties.expired())
+                it = registry.erase(it);
+            else
+                ++it;
+        }
+        auto& entry = registry[key];
+        if (!entry) entry = std::make_shared<RegistryEntry>();
+        return entry;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+// helpers for caching the optical properties
+namespace
+{
+    // the identifier at the start of a cache file
+    const uint64_t magic = 0x3130584D54534B53;  // "SKSTMX01" in little-endian byte order
+
+    // the number of arrays holding the optical properties managed by the DustMix class
+    constexpr size_t numOwnArrays = 10;
+
+    // returns an array with the contents of the specified table, or an empty array if the table is empty
+    Array flatten(const ArrayTable<2>& table)
+    {
+        size_t numRows = table.size(0);
+        size_t rowSize = table.rowSize();
+        Array flatv(numRows * rowSize);
+        for (size_t i = 0; i != numRows; ++i) std::copy(begin(table[i]), end(table[i]), begin(flatv) + i * rowSize);
+        return flatv;
+    }
+
+    // copies the contents of the specified array into the specified table, which must have the appropriate size
+    void unflatten(const Array& flatv, ArrayTable<2>& table)
+    {
+        size_t numRows = table.size(0);
+        size_t rowSize = table.rowSize();
+        for (size_t i = 0; i != numRows; ++i)
+            std::copy(begin(flatv) + i * rowSize, begin(flatv) + (i + 1) * rowSize, begin(table[i]));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 void DustMix::setupSelfAfter()
 {
     MaterialMix::setupSelfAfter();
@@ -61,56 +180,121 @@ void DustMix::setupSelfAfter()
     Array lambdav(numLambda);
     for (int ell = 0; ell != numLambda; ++ell) lambdav[ell] = wavelengths[ell];
 
+    // get the scattering mode advertised by this dust mix
+    auto mode = scatteringMode();
+
+    // determine a key identifying the configuration of this dust mix (including its children in the simulation
+    // hierarchy), the input and resource files it may read, the wavelength grid on which the optical properties
+    // are tabulated, and the simulation options affecting the information precalculated by the subclass
+    auto paths = find<FilePaths>();
+    CacheKey cacheKey;
+    {
+        bool emission[] = {config->hasDustEmission(), config->hasStochasticDustEmission()};
+        cacheKey.add(ItemUtils::hierarchyRepresentation(SimulationItemRegistry::getSchemaDef(), this));
+        paths->addInputFiles(cacheKey, this);
+        FilePaths::addResources(cacheKey);
+        cacheKey.add(begin(lambdav), lambdav.size() * sizeof(double));
+        cacheKey.addValue(static_cast<int>(mode));
+        cacheKey.addValue(numTheta);
+        cacheKey.add(emission, sizeof(emission));
+    }
+
+    // extend the key with the simulation options affecting the emission calculators, which are not cached on disk
+    // but which are shared between dust mix instances
+    CacheKey shareKey = cacheKey;
+    {
+        bool options[] = {config->hasPanRadiationField(), config->includeHeatingByCMB(),
+                          config->precalculateEquilibriumCutoffs()};
+        double values[] = {config->includeHeatingByCMB() ? config->redshift() : 0.,
+                           config->emissivityTableTolerance()};
+        shareKey.add(options, sizeof(options));
+        shareKey.add(values, sizeof(values));
+        for (auto wavelengthGrid : {config->radiationFieldWLG(), config->dustEmissionWLG()})
+        {
+            if (wavelengthGrid)
+            {
+                wavelengthGrid->setup();
+                const Array& borderv = wavelengthGrid->extlambdav();
+                shareKey.add(begin(borderv), borderv.size() * sizeof(double));
+            }
+        }
+    }
+
+    // if a dust mix with an identical configuration has already been set up in this process and is still in use,
+    // share its properties; the lock for this configuration is held until setup completes, so that concurrent
+    // simulations wait for each other rather than duplicating the calculation
+    auto entry = registryEntry(shareKey.value());
+    std::unique_lock<std::mutex> lock(entry->mutex);
+    _p = std::static_pointer_cast<Properties>(entry->properties.lock());
+    if (_p)
+    {
+        shareExtraProperties(_p->extra);
+        find<Log>()->info(type() + " shares its properties with an identically configured dust mix");
+        return;
+    }
+    _p = std::make_shared<Properties>();
+
     // derive a wavelength grid that will be used for converting a wavelength to an index in the above array;
     // the grid points are shifted to the left of the actual sample points to approximate rounding
-    _lambdav.resize(numLambda);
-    _lambdav[0] = lambdav[0];
+    _p->lambdav.resize(numLambda);
+    _p->lambdav[0] = lambdav[0];
     for (int ell = 1; ell != numLambda; ++ell)
     {
-        _lambdav[ell] = sqrt(lambdav[ell] * lambdav[ell - 1]);
+        _p->lambdav[ell] = sqrt(lambdav[ell] * lambdav[ell - 1]);
     }
 
-    // get the scattering mode advertised by this dust mix
-    auto mode = scatteringMode();
-
     // if needed, build a scattering angle grid
     if (mode == ScatteringMode::MaterialPhaseFunction || mode == ScatteringMode::SphericalPolarization
         || mode == ScatteringMode::SpheroidalPolarization)
     {
-        _thetav.resize(numTheta);
-        for (int t = 0; t != numTheta; ++t) _thetav[t] = t * deltaTheta;
+        _p->thetav.resize(numTheta);
+        for (int t = 0; t != numTheta; ++t) _p->thetav[t] = t * deltaTheta;
     }
 
     // resize the optical property arrays and tables as needed
-    _sigmaabsv.resize(numLambda);
-    _sigmascav.resize(numLambda);
-    _sigmaextv.resize(numLambda);
-    _asymmparv.resize(numLambda);
+    _p->sigmaabsv.resize(numLambda);
+    _p->sigmascav.resize(numLambda);
+    _p->sigmaextv.resize(numLambda);
+    _p->asymmparv.resize(numLambda);
     if (mode == ScatteringMode::MaterialPhaseFunction || mode == ScatteringMode::SphericalPolarization
         || mode == ScatteringMode::SpheroidalPolarization)
     {
-        _S11vv.resize(numLambda, numTheta);
+        _p->S11vv.resize(numLambda, numTheta);
         if (mode == ScatteringMode::SphericalPolarization || mode == ScatteringMode::SpheroidalPolarization)
         {
-            _S12vv.resize(numLambda, numTheta);
-            _S33vv.resize(numLambda, numTheta);
-            _S34vv.resize(numLambda, numTheta);
+            _p->S12vv.resize(numLambda, numTheta);
+            _p->S33vv.resize(numLambda, numTheta);
+            _p->S34vv.resize(numLambda, numTheta);
         }
         if (mode == ScatteringMode::SpheroidalPolarization)
         {
-            _sigmaabsvv.resize(numLambda, numTheta);
-            _sigmaabspolvv.resize(numLambda, numTheta);
+            _p->sigmaabsvv.resize(numLambda, numTheta);
+            _p->sigmaabspolvv.resize(numLambda, numTheta);
         }
     }
 
-    // obtain the optical properties from the subclass
-    _mu = getOpticalProperties(lambdav, _thetav, _sigmaabsv, _sigmascav, _asymmparv, _S11vv, _S12vv, _S33vv, _S34vv,
-                               _sigmaabsvv, _sigmaabspolvv);
+    // if a cache path has been specified, try to load the optical properties from the cache
+    string cacheFile;
+    bool loaded = false;
+    if (!paths->cachePath().empty())
+    {
+        cacheFile = paths->cache(type() + "_" + cacheKey.hexString() + ".bin");
+        loaded = loadCachedProperties(cacheFile, cacheKey.value());
+        if (loaded) find<Log>()->info(type() + " loaded optical properties from " + cacheFile);
+        _cachesProperties = !loaded;
+    }
+
+    // otherwise obtain the optical properties from the subclass
+    if (!loaded)
+    {
+        _p->mu = getOpticalProperties(lambdav, _p->thetav, _p->sigmaabsv, _p->sigmascav, _p->asymmparv, _p->S11vv,
+                                      _p->S12vv, _p->S33vv, _p->S34vv, _p->sigmaabsvv, _p->sigmaabspolvv);
+    }
 
     // calculate derived basic optical properties
     for (int ell = 0; ell != numLambda; ++ell)
     {
-        _sigmaextv[ell] = _sigmaabsv[ell] + _sigmascav[ell];
+        _p->sigmaextv[ell] = _p->sigmaabsv[ell] + _p->sigmascav[ell];
     }
 
     // precalculate discretizations related to the scattering angles as needed
@@ -118,38 +302,39 @@ void DustMix::setupSelfAfter()
         || mode == ScatteringMode::SpheroidalPolarization)
     {
         // create a table with the normalized cumulative distribution of theta for each wavelength
-        _thetaXvv.resize(numLambda, 0);
+        _p->thetaXvv.resize(numLambda, 0);
         for (int ell = 0; ell != numLambda; ++ell)
         {
-            NR::cdf(_thetaXvv[ell], maxTheta, [this, ell](int t) { return _S11vv(ell, t + 1) * sin(_thetav[t + 1]); });
+            NR::cdf(_p->thetaXvv[ell], maxTheta,
+                    [this, ell](int t) { return _p->S11vv(ell, t + 1) * sin(_p->thetav[t + 1]); });
         }
 
         // create a table with the phase function normalization factor for each wavelength
-        _pfnormv.resize(numLambda);
+        _p->pfnormv.resize(numLambda);
         for (int ell = 0; ell != numLambda; ++ell)
         {
             double sum = 0.;
             for (int t = 0; t != numTheta; ++t)
             {
-                sum += _S11vv(ell, t) * sin(_thetav[t]) * deltaTheta;
+                sum += _p->S11vv(ell, t) * sin(_p->thetav[t]) * deltaTheta;
             }
-            _pfnormv[ell] = 2.0 / sum;
+            _p->pfnormv[ell] = 2.0 / sum;
         }
 
         // create tables listing phi, phi/(2 pi), sin(2 phi) and 1-cos(2 phi) for each phi index
         if (mode == ScatteringMode::SphericalPolarization || mode == ScatteringMode::SpheroidalPolarization)
         {
-            _phiv.resize(numPhi);
-            _phi1v.resize(numPhi);
-            _phisv.resize(numPhi);
-            _phicv.resize(numPhi);
+            _p->phiv.resize(numPhi);
+            _p->phi1v.resize(numPhi);
+            _p->phisv.resize(numPhi);
+            _p->phicv.resize(numPhi);
             for (int f = 0; f != numPhi; ++f)
             {
                 double phi = f * deltaPhi;
-                _phiv[f] = phi;
-                _phi1v[f] = phi / (2 * M_PI);
-                _phisv[f] = sin(2 * phi);
-                _phicv[f] = 1 - cos(2 * phi);
+                _p->phiv[f] = phi;
+                _p->phi1v[f] = phi / (2 * M_PI);
+                _p->phisv[f] = sin(2 * phi);
+                _p->phicv[f] = 1 - cos(2 * phi);
             }
         }
     }
@@ -158,34 +343,46 @@ void DustMix::setupSelfAfter()
     // this is relevant only if the simulation tracks the radiation field
     if (config->hasPanRadiationField())
     {
-        _calc.precalculate(this, lambdav, _sigmaabsv);
+        _p->calc.precalculate(this, lambdav, _p->sigmaabsv);
     }
 
     // give the subclass a chance to obtain additional precalculated information
     size_t allocatedBytes = initializeExtraProperties(lambdav);
 
+    // if requested, save the newly calculated properties to the cache
+    if (_cachesProperties)
+    {
+        saveCachedProperties(cacheFile, cacheKey.value());
+        find<Log>()->info(type() + " saved optical properties to " + cacheFile);
+    }
+    _cachesProperties = false;
+
     // calculate and log allocated memory size
     size_t allocatedSize = 0;
-    allocatedSize += _thetav.size();
-    allocatedSize += _sigmaabsv.size();
-    allocatedSize += _sigmascav.size();
-    allocatedSize += _sigmaextv.size();
-    allocatedSize += _asymmparv.size();
-    allocatedSize += _S11vv.size();
-    allocatedSize += _S12vv.size();
-    allocatedSize += _S33vv.size();
-    allocatedSize += _S34vv.size();
-    allocatedSize += _thetaXvv.size();
-    allocatedSize += _pfnormv.size();
-    allocatedSize += _phiv.size();
-    allocatedSize += _phi1v.size();
-    allocatedSize += _phisv.size();
-    allocatedSize += _phicv.size();
-    allocatedSize += _sigmaabsvv.size();
-    allocatedSize += _sigmaabspolvv.size();
-
-    allocatedBytes += allocatedSize * sizeof(double) + _calc.allocatedBytes();
+    allocatedSize += _p->thetav.size();
+    allocatedSize += _p->sigmaabsv.size();
+    allocatedSize += _p->sigmascav.size();
+    allocatedSize += _p->sigmaextv.size();
+    allocatedSize += _p->asymmparv.size();
+    allocatedSize += _p->S11vv.size();
+    allocatedSize += _p->S12vv.size();
+    allocatedSize += _p->S33vv.size();
+    allocatedSize += _p->S34vv.size();
+    allocatedSize += _p->thetaXvv.size();
+    allocatedSize += _p->pfnormv.size();
+    allocatedSize += _p->phiv.size();
+    allocatedSize += _p->phi1v.size();
+    allocatedSize += _p->phisv.size();
+    allocatedSize += _p->phicv.size();
+    allocatedSize += _p->sigmaabsvv.size();
+    allocatedSize += _p->sigmaabspolvv.size();
+
+    allocatedBytes += allocatedSize * sizeof(double) + _p->calc.allocatedBytes();
     find<Log>()->info(type() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory");
+
+    // publish the properties so that they can be shared with dust mixes that have an identical configuration
+    _p->extra = extraProperties();
+    entry->properties = _p;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -197,9 +394,138 @@ size_t DustMix::initializeExtraProperties(const Array& /*lambdav*/)
 
 ////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<DustMix::ExtraProperties> DustMix::extraProperties() const
+{
+    return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DustMix::shareExtraProperties(std::shared_ptr<ExtraProperties> /*extra*/) {}
+
+////////////////////////////////////////////////////////////////////
+
+void DustMix::storeCachedProperties(vector<Array>& /*arrays*/) {}
+
+////////////////////////////////////////////////////////////////////
+
+void DustMix::restoreCachedProperties(vector<Array>& /*arrays*/) {}
+
+////////////////////////////////////////////////////////////////////
+
+bool DustMix::loadCachedProperties(string path, uint64_t key)
+{
+    // read the arrays from the file, if it exists and has a proper header
+    vector<Array> arrays;
+    bool ok = false;
+    if (System::isFile(path))
+    {
+        // map the file into memory
+        auto map = System::acquireMemoryMap(path);
+        if (map.first)
+        {
+            const char* start = static_cast<const char*>(map.first);
+            const char* end = start + map.second;
+
+            // copies the specified number of bytes from the mapped file, advancing the position;
+            // returns false if past the end
+            const char* position = start;
+            auto read = [&position, end](void* destination, size_t size) {
+                if (size > static_cast<size_t>(end - position)) return false;
+                std::copy(position, position + size, static_cast<char*>(destination));
+                position += size;
+                return true;
+            };
+
+            // read and verify the header, and read the array sizes
+            uint64_t header[3];
+            ok = read(header, sizeof(header)) && header[0] == magic && header[1] == key && header[2] >= numOwnArrays;
+            if (ok)
+            {
+                vector<uint64_t> sizes(header[2]);
+                ok = read(sizes.data(), sizes.size() * sizeof(uint64_t));
+                for (size_t i = 0; ok && i != sizes.size(); ++i)
+                {
+                    arrays.emplace_back(sizes[i]);
+                    ok = read(begin(arrays.back()), sizes[i] * sizeof(double));
+                }
+            }
+            System::releaseMemoryMap(path);
+        }
+    }
+
+    // verify that the optical property arrays have the expected sizes
+    ok = ok && arrays[0].size() == 1 && arrays[1].size() == _p->sigmaabsv.size()
+         && arrays[2].size() == _p->sigmascav.size() && arrays[3].size() == _p->asymmparv.size()
+         && arrays[4].size() == _p->S11vv.size() && arrays[5].size() == _p->S12vv.size()
+         && arrays[6].size() == _p->S33vv.size() && arrays[7].size() == _p->S34vv.size()
+         && arrays[8].size() == _p->sigmaabsvv.size() && arrays[9].size() == _p->sigmaabspolvv.size();
+
+    // when running with multiple processes, use the cache only if all processes could load it, because
+    // calculating the properties (in this class or in a subclass) may involve collective communication
+    if (!ProcessManager::isTrueForAll(ok)) return false;
+
+    // copy the optical properties into our data members
+    _p->mu = arrays[0][0];
+    _p->sigmaabsv = arrays[1];
+    _p->sigmascav = arrays[2];
+    _p->asymmparv = arrays[3];
+    _p->S11vv.data() = arrays[4];
+    _p->S12vv.data() = arrays[5];
+    _p->S33vv.data() = arrays[6];
+    _p->S34vv.data() = arrays[7];
+    unflatten(arrays[8], _p->sigmaabsvv);
+    unflatten(arrays[9], _p->sigmaabspolvv);
+
+    // pass the remaining arrays to the subclass
+    arrays.erase(arrays.begin(), arrays.begin() + numOwnArrays);
+    restoreCachedProperties(arrays);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DustMix::saveCachedProperties(string path, uint64_t key)
+{
+    // gather the optical properties and the additional information from the subclass;
+    // the subclass is invoked in all processes so that it can release any information it retained for the cache
+    vector<Array> arrays;
+    arrays.reserve(numOwnArrays);
+    arrays.emplace_back(_p->mu, 1);
+    arrays.push_back(_p->sigmaabsv);
+    arrays.push_back(_p->sigmascav);
+    arrays.push_back(_p->asymmparv);
+    arrays.push_back(_p->S11vv.data());
+    arrays.push_back(_p->S12vv.data());
+    arrays.push_back(_p->S33vv.data());
+    arrays.push_back(_p->S34vv.data());
+    arrays.push_back(flatten(_p->sigmaabsvv));
+    arrays.push_back(flatten(_p->sigmaabspolvv));
+    storeCachedProperties(arrays);
+    if (!ProcessManager::isRoot()) return;
+
+    // write the file under a temporary name and rename it when complete, so that concurrent simulations
+    // never see a partially written file
+    string tempPath = path + "." + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tmp";
+    {
+        std::ofstream out = System::ofstream(tempPath);
+        uint64_t header[3] = {magic, key, arrays.size()};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (const Array& a : arrays)
+        {
+            uint64_t size = a.size();
+            out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        }
+        for (const Array& a : arrays) out.write(reinterpret_cast<const char*>(begin(a)), a.size() * sizeof(double));
+    }
+    std::rename(tempPath.c_str(), path.c_str());
+}
+
+////////////////////////////////////////////////////////////////////
+
 int DustMix::indexForLambda(double lambda) const
 {
-    return NR::locateClip(_lambdav, lambda);
+    return NR::locateClip(_p->lambdav, lambda);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -221,35 +547,35 @@ MaterialMix::MaterialType DustMix::materialType() const
 
 double DustMix::mass() const
 {
-    return _mu;
+    return _p->mu;
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double DustMix::sectionAbs(double lambda) const
 {
-    return _sigmaabsv[indexForLambda(lambda)];
+    return _p->sigmaabsv[indexForLambda(lambda)];
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double DustMix::sectionSca(double lambda) const
 {
-    return _sigmascav[indexForLambda(lambda)];
+    return _p->sigmascav[indexForLambda(lambda)];
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double DustMix::sectionExt(double lambda) const
 {
-    return _sigmaextv[indexForLambda(lambda)];
+    return _p->sigmaextv[indexForLambda(lambda)];
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double DustMix::asymmpar(double lambda) const
 {
-    return _asymmparv[indexForLambda(lambda)];
+    return _p->asymmparv[indexForLambda(lambda)];
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -258,14 +584,14 @@ double DustMix::phaseFunctionValueForCosine(double lambda, double costheta) cons
 {
     int ell = indexForLambda(lambda);
     int t = indexForTheta(acos(costheta));
-    return _pfnormv[ell] * _S11vv(ell, t);
+    return _p->pfnormv[ell] * _p->S11vv(ell, t);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double DustMix::generateCosineFromPhaseFunction(double lambda) const
 {
-    return cos(random()->cdfLinLin(_thetav, _thetaXvv[indexForLambda(lambda)]));
+    return cos(random()->cdfLinLin(_p->thetav, _p->thetaXvv[indexForLambda(lambda)]));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -276,7 +602,7 @@ double DustMix::phaseFunctionValue(double lambda, double theta, double phi, cons
     int t = indexForTheta(theta);
     double polDegree = sv->linearPolarizationDegree();
     double polAngle = sv->polarizationAngle();
-    return _pfnormv[ell] * (_S11vv(ell, t) + polDegree * _S12vv(ell, t) * cos(2. * (phi - polAngle)));
+    return _p->pfnormv[ell] * (_p->S11vv(ell, t) + polDegree * _p->S12vv(ell, t) * cos(2. * (phi - polAngle)));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -286,16 +612,16 @@ std::pair<double, double> DustMix::generateAnglesFromPhaseFunction(double lambda
     int ell = indexForLambda(lambda);
 
     // sample from the normalized cumulative distribution of theta for this wavelength
-    double theta = random()->cdfLinLin(_thetav, _thetaXvv[ell]);
+    double theta = random()->cdfLinLin(_p->thetav, _p->thetaXvv[ell]);
     int t = indexForTheta(theta);
 
     // construct and sample from the normalized cumulative distribution of phi for this wavelength and theta angle
     double polDegree = sv->linearPolarizationDegree();
     double polAngle = sv->polarizationAngle();
-    double PF = polDegree * _S12vv(ell, t) / _S11vv(ell, t) / (4 * M_PI);
+    double PF = polDegree * _p->S12vv(ell, t) / _p->S11vv(ell, t) / (4 * M_PI);
     double cos2polAngle = cos(2 * polAngle) * PF;
     double sin2polAngle = sin(2 * polAngle) * PF;
-    double phi = random()->cdfLinLin(_phiv, _phi1v + cos2polAngle * _phisv + sin2polAngle * _phicv);
+    double phi = random()->cdfLinLin(_p->phiv, _p->phi1v + cos2polAngle * _p->phisv + sin2polAngle * _p->phicv);
 
     // return the result
     return std::make_pair(theta, phi);
@@ -307,14 +633,14 @@ void DustMix::applyMueller(double lambda, double theta, StokesVector* sv) const
 {
     int ell = indexForLambda(lambda);
     int t = indexForTheta(theta);
-    sv->applyMueller(_S11vv(ell, t), _S12vv(ell, t), _S33vv(ell, t), _S34vv(ell, t));
+    sv->applyMueller(_p->S11vv(ell, t), _p->S12vv(ell, t), _p->S33vv(ell, t), _p->S34vv(ell, t));
 }
 
 ////////////////////////////////////////////////////////////////////
 
 const Array& DustMix::thetaGrid() const
 {
-    return _thetav;
+    return _p->thetav;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -322,7 +648,7 @@ const Array& DustMix::thetaGrid() const
 const Array& DustMix::sectionsAbs(double lambda) const
 {
     int ell = indexForLambda(lambda);
-    return _sigmaabsvv[ell];
+    return _p->sigmaabsvv[ell];
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -330,21 +656,38 @@ const Array& DustMix::sectionsAbs(double lambda) const
 const Array& DustMix::sectionsAbspol(double lambda) const
 {
     int ell = indexForLambda(lambda);
-    return _sigmaabspolvv[ell];
+    return _p->sigmaabspolvv[ell];
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double DustMix::equilibriumTemperature(const Array& Jv) const
 {
-    return _calc.equilibriumTemperature(0, Jv);
+    return _p->calc.equilibriumTemperature(0, Jv);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Array DustMix::emissivity(const Array& Jv) const
 {
-    return _calc.emissivity(Jv);
+    return _p->calc.emissivity(Jv);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DustMix::equilibriumTemperatures(const Table<2>& Jvv, Array& Tv) const
+{
+    // the calculator handles a single bin, so the temperature table has a single column
+    Table<2> Tvv;
+    _p->calc.equilibriumTemperatures(Jvv, Tvv);
+    Tv = Tvv.data();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DustMix::emissivities(const Table<2>& Jvv, Table<2>& evv) const
+{
+    _p->calc.emissivities(Jvv, evv);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -66,7 +66,29 @@ protected:
         Furthermore, if the simulation tracks the radiation field, this function precalculates the
         Planck-integrated absorption cross sections on an appropriate temperature grid. This
         information is used to obtain the equilibrium temperature of the material mix (or rather,
-        of its representative grain population) in a given embedding radiation field. */
+        of its representative grain population) in a given embedding radiation field.
+
+        If a cache path has been specified for the simulation (see the FilePaths class), the
+        optical properties obtained from the subclass, together with any additional information
+        offered by the subclass through the storeCachedProperties() function, are stored in a
+        binary file in the cache directory. The file name includes a hash key derived from the
+        complete configuration of the dust mix (including its children in the simulation
+        hierarchy), the path, status and contents of any input files read by the dust mix, the
+        path and status of all resource files, the wavelength grid on which the properties are
+        tabulated, the scattering mode, and the type of dust emission calculation. Subsequent
+        simulations with an identical dust mix configuration memory-map this file and copy its
+        contents rather than asking the subclass to calculate the properties. When running with
+        multiple processes, the cached properties are used only if all processes can load them.
+
+        Finally, the properties precalculated by this function, together with the extra properties
+        precalculated by the subclass (see the extraProperties() function), are shared between all
+        dust mix instances in the process that have an identical configuration and that are used
+        in simulations with the same relevant options. This includes dust mixes in different media
+        of the same simulation and in different simulations performed by the same process (e.g.,
+        multiple ski files in a single command line). The properties are kept in a process-wide
+        registry as long as they are used by at least one dust mix instance. If an identically
+        configured dust mix is found in the registry, this function adopts its properties without
+        calling any of the functions implemented by the subclass. */
     void setupSelfAfter() override;
 
     /** This function must be implemented in each subclass to obtain the representative grain
@@ -110,6 +132,55 @@ protected:
         returns zero. */
     virtual size_t initializeExtraProperties(const Array& lambdav);
 
+    /** ExtraProperties is the base class for the data structures in which a subclass holds the
+        additional properties precalculated by its initializeExtraProperties() function, so that
+        these properties can be shared between dust mix instances with an identical
+        configuration. The data structure must not be modified after setup. */
+    class ExtraProperties
+    {
+    public:
+        virtual ~ExtraProperties() = default;
+    };
+
+    /** This function can be implemented in a subclass to return a pointer to the data structure
+        holding the additional properties precalculated by its initializeExtraProperties()
+        function. It is called by the DustMix class at the end of setup so that these properties
+        can be shared with other dust mix instances that have an identical configuration. The
+        default implementation of this function returns a null pointer. */
+    virtual std::shared_ptr<ExtraProperties> extraProperties() const;
+
+    /** This function can be implemented in a subclass to adopt the additional properties
+        precalculated by an identically configured dust mix instance, as returned by the
+        extraProperties() function of that instance. It is called by the DustMix class during setup
+        instead of the getOpticalProperties() and initializeExtraProperties() functions. The
+        default implementation of this function does nothing. */
+    virtual void shareExtraProperties(std::shared_ptr<ExtraProperties> extra);
+
+    /** This function can be implemented in a subclass that needs information beyond the optical
+        properties returned by getOpticalProperties() to initialize its extra properties, so that
+        this information can be stored in the cache along with the optical properties. The
+        function is called by the DustMix class during setup after the initializeExtraProperties()
+        function, and only if the properties are being cached and were not loaded from the cache.
+        The function should append the information to the specified list of arrays. It may move
+        the information out of its data members if it is no longer needed. The default
+        implementation of this function does nothing. */
+    virtual void storeCachedProperties(vector<Array>& arrays);
+
+    /** This function can be implemented in a subclass to restore the information stored by the
+        storeCachedProperties() function. The function is called by the DustMix class during setup
+        instead of the getOpticalProperties() function when the properties are loaded from the
+        cache, and thus before the initializeExtraProperties() function. The specified list holds
+        the arrays appended by the storeCachedProperties() function, in the same order. The
+        function may move the information out of these arrays. The default implementation of this
+        function does nothing. */
+    virtual void restoreCachedProperties(vector<Array>& arrays);
+
+    /** This function returns true if the properties of the dust mix will be stored in the cache
+        during setup, and false otherwise (i.e. if there is no cache or if the properties have been
+        loaded from the cache). A subclass can use this information to decide whether it should
+        retain information for the storeCachedProperties() function. */
+    bool cachesProperties() const { return _cachesProperties; }
+
     //======== Private support functions =======
 
 protected:
@@ -123,6 +194,19 @@ protected:
         appropriate index are built-in constants. */
     int indexForTheta(double theta) const;
 
+private:
+    /** This function loads the optical properties and the additional subclass information from
+        the specified cache file, verifying that the file has the specified key and that the
+        arrays have the expected sizes. If successful in all processes, the function passes the
+        additional information to the subclass and returns true. Otherwise it leaves the optical
+        properties untouched and returns false. Because the processes agree on the outcome through
+        collective communication, all processes must call this function. */
+    bool loadCachedProperties(string path, uint64_t key);
+
+    /** This function saves the optical properties and the additional information obtained from
+        the subclass to the specified cache file. */
+    void saveCachedProperties(string path, uint64_t key);
+
     //======== Material type =======
 
 public:
@@ -303,44 +387,28 @@ public:
         relies. */
     Array emissivity(const Array& Jv) const override;
 
+    /** This function returns the equilibrium temperature of the representative grain population
+        corresponding to the dust mix for each of the radiation fields specified by the mean
+        intensities in the table \em Jvv, as described for the equilibriumTemperature() function.
+        It uses the batched calculation offered by the EquilibriumDustEmissionCalculator class. */
+    void equilibriumTemperatures(const Table<2>& Jvv, Array& Tv) const override;
+
+    /** This function returns the emissivity spectrum per hydrogen atom of the representative grain
+        population corresponding to the dust mix for each of the radiation fields specified by the
+        mean intensities in the table \em Jvv, as described for the emissivity() function. It uses
+        the batched calculation offered by the EquilibriumDustEmissionCalculator class. */
+    void emissivities(const Table<2>& Jvv, Table<2>& evv) const override;
+
     //======================== Data Members ========================
 
 private:
-    // all data members are precalculated in setupSelfAfter()
-
-    // wavelength grid (shifted to the left of the actually sampled points to approximate rounding)
-    Array _lambdav;  // indexed on ell
-
-    // scattering angle grid
-    Array _thetav;  // indexed on t
-
-    // basic optical properties
-    double _mu{0.};
-    Array _sigmaabsv;  // indexed on ell
-    Array _sigmascav;  // indexed on ell
-    Array _sigmaextv;  // indexed on ell
-    Array _asymmparv;  // indexed on ell
-
-    // Mueller matrix coefficients
-    Table<2> _S11vv;  // indexed on ell,t
-    Table<2> _S12vv;  // indexed on ell,t
-    Table<2> _S33vv;  // indexed on ell,t
-    Table<2> _S34vv;  // indexed on ell,t
-
-    // precalculated discretizations of (functions of) the scattering angles
-    ArrayTable<2> _thetaXvv;  // indexed on ell and t
-    Array _pfnormv;           // indexed on ell
-    Array _phiv;              // indexed on f
-    Array _phi1v;             // indexed on f
-    Array _phisv;             // indexed on f
-    Array _phicv;             // indexed on f
-
-    // precalculated discretizations for spheroidal grains as a function of the emission angle
-    ArrayTable<2> _sigmaabsvv;     // indexed on ell and t
-    ArrayTable<2> _sigmaabspolvv;  // indexed on ell and t
-
-    // equilibrium temperature and emission calculator
-    EquilibriumDustEmissionCalculator _calc;
+    // all precalculated data members are held in a separate data structure (defined in the source file),
+    // which may be shared with other dust mix instances that have an identical configuration
+    struct Properties;
+    std::shared_ptr<Properties> _p;
+
+    // true during setup if the properties will be stored in the cache
+    bool _cachesProperties{false};
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -29,11 +29,16 @@ void DustTemperaturePerCellProbe::probeRun()
         file.addColumn("spatial cell index", "", 'd');
         file.addColumn("indicative dust temperature", units->utemperature(), 'g');
 
-        // write a line for each cell
+        // calculate the indicative temperature for all cells in a single batched pass
         int numCells = ms->numCells();
+        vector<int> mv(numCells);
+        for (int m = 0; m != numCells; ++m) mv[m] = m;
+        Array Tv = ms->indicativeDustTemperatures(mv);
+
+        // write a line for each cell
         for (int m = 0; m != numCells; ++m)
         {
-            file.writeRow(m, units->otemperature(ms->indicativeDustTemperature(m)));
+            file.writeRow(m, units->otemperature(Tv[m]));
         }
     }
 }
@@ -123,6 +123,13 @@ double EquilibriumDustEmissionCalculator::equilibriumTemperature(int b, const Ar
     double inputabs = (_rfsigmaabsvv[b] * (Jv + _Bcmbv) * _rfdlambdav).sum();
 
     // find the temperature corresponding to this amount of emission on the output side of the equation
+    return temperatureForInput(b, inputabs);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double EquilibriumDustEmissionCalculator::temperatureForInput(int b, double inputabs) const
+{
     if (inputabs > 0.)
         return NR::clampedValue<NR::interpolateLinLin>(inputabs, _planckabsvv[b], _Tv);
     else
@@ -136,10 +143,13 @@ Array EquilibriumDustEmissionCalculator::emissivity(const Array& Jv) const
     int numWavelengths = _emlambdav.size();
     int numBins = _rfsigmaabsvv.size();
 
+    // weigh the radiation field once for all bins
+    Array wv = (Jv + _Bcmbv) * _rfdlambdav;
+
     Array ev(numWavelengths);
     for (int b = 0; b != numBins; ++b)
     {
-        double T = equilibriumTemperature(b, Jv);
+        double T = temperatureForInput(b, (_rfsigmaabsvv[b] * wv).sum());
         PlanckFunction B(T);
         for (int ell = 0; ell < numWavelengths; ell++)
         {
@@ -150,3 +160,62 @@ Array EquilibriumDustEmissionCalculator::emissivity(const Array& Jv) const
 }
 
 ////////////////////////////////////////////////////////////////////
+
+void EquilibriumDustEmissionCalculator::equilibriumTemperatures(const Table<2>& Jvv, Table<2>& Tvv) const
+{
+    size_t numFields = Jvv.size(0);
+    size_t numWavelengths = _rflambdav.size();
+    int numBins = _rfsigmaabsvv.size();
+
+    // weigh the radiation fields and transpose them so that the values for a given wavelength are contiguous
+    Table<2> wvv(numWavelengths, numFields);
+    for (size_t i = 0; i != numFields; ++i)
+        for (size_t k = 0; k != numWavelengths; ++k) wvv(k, i) = (Jvv(i, k) + _Bcmbv[k]) * _rfdlambdav[k];
+
+    // integrate the input side of the energy balance equation for each bin, accumulating the contributions
+    // of each wavelength to all radiation fields at once in a loop that can be vectorized,
+    // and then find the corresponding temperatures
+    Tvv.resize(numFields, numBins);
+    Array inputabsv(numFields);
+    double* inputabs = begin(inputabsv);
+    for (int b = 0; b != numBins; ++b)
+    {
+        inputabsv = 0.;
+        const Array& sigmaabsv = _rfsigmaabsvv[b];
+        for (size_t k = 0; k != numWavelengths; ++k)
+        {
+            double sigmaabs = sigmaabsv[k];
+            const double* wv = begin(wvv.data()) + k * numFields;
+            for (size_t i = 0; i != numFields; ++i) inputabs[i] += sigmaabs * wv[i];
+        }
+        for (size_t i = 0; i != numFields; ++i) Tvv(i, b) = temperatureForInput(b, inputabs[i]);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void EquilibriumDustEmissionCalculator::emissivities(const Table<2>& Jvv, Table<2>& evv) const
+{
+    size_t numFields = Jvv.size(0);
+    size_t numWavelengths = _emlambdav.size();
+    int numBins = _rfsigmaabsvv.size();
+
+    // obtain the equilibrium temperatures for all radiation fields and bins
+    Table<2> Tvv;
+    equilibriumTemperatures(Jvv, Tvv);
+
+    // accumulate the emissivity spectra
+    evv.resize(numFields, numWavelengths);
+    for (size_t i = 0; i != numFields; ++i)
+    {
+        double* ev = begin(evv.data()) + i * numWavelengths;
+        for (int b = 0; b != numBins; ++b)
+        {
+            PlanckFunction B(Tvv(i, b));
+            const Array& sigmaabsv = _emsigmaabsvv[b];
+            for (size_t ell = 0; ell != numWavelengths; ++ell) ev[ell] += sigmaabsv[ell] * B(_emlambdav[ell]);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
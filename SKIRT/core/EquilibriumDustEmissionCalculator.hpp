@@ -6,7 +6,7 @@
 #ifndef EQUILIBRIUMDUSTEMISSIONCALCULATOR_HPP
 #define EQUILIBRIUMDUSTEMISSIONCALCULATOR_HPP
 
-#include "Array.hpp"
+#include "Table.hpp"
 class SimulationItem;
 
 ////////////////////////////////////////////////////////////////////
@@ -47,6 +47,14 @@ class SimulationItem;
     {\text{d}}\lambda \f] where \f$z\f$ is the redshift at which the simulated model resides and
     \f$T_\mathrm{CMB}^{z=0} = 2.725\,\mathrm{K}\f$.
 
+    In addition to functions handling a single radiation field, the class offers batched versions
+    that handle the radiation fields for many spatial cells at once. These functions first
+    transpose the weighted input fields so that the integrations for a given bin run over the cells
+    in contiguous memory, allowing the compiler to process multiple cells in parallel SIMD lanes.
+    Because the right-hand side of the energy balance equation has been tabulated as a function of
+    temperature for each bin, solving for the equilibrium temperature then requires just a table
+    lookup for each cell and bin.
+
     The equilibrium emissivity spectrum of all bins combined embedded in a radiation field
     \f$J_\lambda\f$ can then be written as \f[ \varepsilon_\lambda = \sum_{b=0}^{N_{\text{bins}}-1}
     \varsigma_{\lambda,b}^{\text{abs}}\, B_\lambda(T_{\text{eq},b}) \f] with
@@ -98,6 +106,33 @@ public:
         behavior of this function is undefined. */
     Array emissivity(const Array& Jv) const;
 
+    /** This function returns the equilibrium temperatures \f$T_{\text{eq},b}\f$ of the
+        representative grains corresponding to all bins for each of the radiation fields specified
+        by the mean intensities in the table \em Jvv, indexed on \f$i,k\f$ where \f$i\f$ is the
+        index of the radiation field (usually corresponding to a spatial cell) and \f$k\f$ is the
+        wavelength index in the simulation's radiation field wavelength grid. Upon return, the
+        table \em Tvv has been resized and filled with the temperatures, indexed on \f$i,b\f$. The
+        results are equal (up to rounding errors) to those obtained by calling the
+        equilibriumTemperature() function for each bin and radiation field, but the calculation is
+        substantially faster for large numbers of radiation fields. */
+    void equilibriumTemperatures(const Table<2>& Jvv, Table<2>& Tvv) const;
+
+    /** This function returns the emissivity spectrum per hydrogen atom for each of the radiation
+        fields specified by the mean intensities in the table \em Jvv, indexed on \f$i,k\f$ as
+        described for the equilibriumTemperatures() function. Upon return, the table \em evv has
+        been resized and filled with the emissivity spectra, indexed on \f$i,\ell\f$ where
+        \f$\ell\f$ is the wavelength index in the simulation's dust emission wavelength grid. The
+        results are equal (up to rounding errors) to those obtained by calling the emissivity()
+        function for each radiation field. */
+    void emissivities(const Table<2>& Jvv, Table<2>& evv) const;
+
+private:
+    /** This function returns the equilibrium temperature for the bin with specified index \f$b\f$
+        given the integrated input side of the energy balance equation, by looking up the
+        corresponding temperature in the precalculated Planck-integrated absorption cross
+        sections. */
+    double temperatureForInput(int b, double inputabs) const;
+
     //======================== Data Members ========================
 
 private:
@@ -4,7 +4,10 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "FilePaths.hpp"
+#include "CacheKey.hpp"
 #include "FatalError.hpp"
+#include "ItemUtils.hpp"
+#include "SimulationItemRegistry.hpp"
 #include "StringUtils.hpp"
 #include "System.hpp"
 #include <mutex>
@@ -29,6 +32,12 @@ namespace
     // the installed resource pack version numbers:  <packname, version>
     std::unordered_map<string, int> _installedPackVersions;
 
+    // flag becomes true if the resource key has been calculated
+    std::once_flag _resourceKeyCalculated;
+
+    // the hash key identifying the paths, sizes and modification times of all resource files
+    uint64_t _resourceKey{0};
+
     // relative paths to check for presence of built-in resources
     const char* _intpaths[] = {"../../../git/SKIRT/resources", "../../../../git/SKIRT/resources"};
     const int _Nintpaths = sizeof(_intpaths) / sizeof(const char*);
@@ -203,6 +212,20 @@ string FilePaths::input(string name) const
 
 ////////////////////////////////////////////////////////////////////
 
+void FilePaths::setReadInputOnRoot(bool value)
+{
+    _readInputOnRoot = value;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool FilePaths::readInputOnRoot() const
+{
+    return _readInputOnRoot;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void FilePaths::setOutputPath(string value)
 {
     if (!System::isDir(value)) throw FATALERROR("Output path does not exist or is not a directory: " + value);
@@ -239,6 +262,66 @@ string FilePaths::output(string name) const
 
 ////////////////////////////////////////////////////////////////////
 
+void FilePaths::setCachePath(string value)
+{
+    if (!System::isDir(value)) throw FATALERROR("Cache path does not exist or is not a directory: " + value);
+    _cachePath = System::canonicalPath(value) + "/";
+}
+
+////////////////////////////////////////////////////////////////////
+
+string FilePaths::cachePath() const
+{
+    return _cachePath;
+}
+
+////////////////////////////////////////////////////////////////////
+
+string FilePaths::cache(string name) const
+{
+    return _cachePath + name;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FilePaths::addInputFiles(CacheKey& key, SimulationItem* root) const
+{
+    for (string name : ItemUtils::hierarchyStringValues(SimulationItemRegistry::getSchemaDef(), root, "filename"))
+    {
+        if (name.empty()) continue;
+        string path = input(name);
+        if (!System::isFile(path) && System::isFile(path + ".stab")) path += ".stab";
+        key.add(path);
+        key.addFile(path);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FilePaths::addResources(CacheKey& key)
+{
+    std::call_once(_initialized, findResources);
+    std::call_once(_resourceKeyCalculated, [] {
+        // process the resource files in a fixed order, and include just the file status to keep the cost low
+        vector<string> names;
+        for (const auto& pair : _resourcePaths) names.push_back(pair.first);
+        std::sort(names.begin(), names.end());
+        CacheKey resourceKey;
+        for (const string& name : names)
+        {
+            const string& path = _resourcePaths.at(name);
+            auto sizeAndTime = System::fileSizeAndTime(path);
+            resourceKey.add(path);
+            resourceKey.addValue(sizeAndTime.first);
+            resourceKey.addValue(sizeAndTime.second);
+        }
+        _resourceKey = resourceKey.value();
+    });
+    key.addValue(_resourceKey);
+}
+
+////////////////////////////////////////////////////////////////////
+
 string FilePaths::resource(string name)
 {
     std::call_once(_initialized, findResources);
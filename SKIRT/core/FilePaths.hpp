@@ -7,6 +7,7 @@
 #define FILEPATHS_HPP
 
 #include "SimulationItem.hpp"
+class CacheKey;
 
 ////////////////////////////////////////////////////////////////////
 
@@ -96,6 +97,17 @@ public:
         name, relative to the input path returned by inputPath(). */
     string input(string name) const;
 
+    /** Sets whether the data rows in column input files (e.g., imported snapshots) are read and
+        parsed by the root process only and then broadcast to the other processes (true), or read
+        and parsed independently by each process (false, the default). This setting matters only
+        when running with multiple processes. */
+    void setReadInputOnRoot(bool value);
+
+    /** Returns true if the data rows in column input files are read by the root process only and
+        then broadcast to the other processes, or false if each process reads these data rows
+        independently. */
+    bool readInputOnRoot() const;
+
     /** Sets the (absolute or relative) path for output files. An empty string (the default value)
         means the current directory. */
     void setOutputPath(string value);
@@ -115,6 +127,27 @@ public:
         filename are separated by an underscore. */
     string output(string name) const;
 
+    /** Sets the (absolute or relative) path of the directory for caching precomputed data across
+        simulation runs. An empty string (the default value) means that no such data is cached. */
+    void setCachePath(string value);
+
+    /** Returns the (absolute or relative) path of the directory for caching precomputed data, or
+        the empty string if no such data should be cached. */
+    string cachePath() const;
+
+    /** This function returns the absolute canonical path for a cache file with the specified name,
+        relative to the cache path returned by cachePath(). The behavior is undefined if the cache
+        path is empty. */
+    string cache(string name) const;
+
+    /** This function adds the path, the status and (part of) the contents of the input file named
+        by each \em filename property in the configuration hierarchy of the specified simulation
+        item to the specified cache key, using the CacheKey::addFile() function. Stored table files
+        may be named without their filename extension. Including this information in the key of
+        cached data derived from these input files ensures that the cached data is not used after
+        an input file has been edited, or when the input path refers to another directory. */
+    void addInputFiles(CacheKey& key, SimulationItem* root) const;
+
     //======================== Resource files =======================
 
 public:
@@ -136,6 +169,13 @@ public:
         function returns its filename. */
     static string resourceName(string type, const vector<string>& segments);
 
+    /** This function adds the path, the size and the modification time of each available resource
+        file to the specified cache key. Including this information in the key of cached data
+        derived from resource files ensures that the cached data is not used after the resource
+        packs have been updated. The information is gathered only once per run; the contents of
+        the resource files is not inspected. */
+    static void addResources(CacheKey& key);
+
     //======================== Resource packs =======================
 
 public:
@@ -156,8 +196,10 @@ public:
 
 private:
     string _inputPath;
+    bool _readInputOnRoot{false};
     string _outputPath;
     string _outputPrefix;
+    string _cachePath;
 };
 
 ////////////////////////////////////////////////////////////////////
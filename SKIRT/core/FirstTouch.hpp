@@ -0,0 +1,75 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef FIRSTTOUCH_HPP
+#define FIRSTTOUCH_HPP
+
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "System.hpp"
+#include "Table.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** This namespace contains functions to redistribute the physical memory pages of large, freshly
+    allocated data structures over the NUMA nodes (memory domains) of a multi-socket computer.
+
+    On most operating systems, a physical memory page is allocated in the memory domain local to
+    the processor that first touches (i.e. writes to) the page. Data structures that are allocated
+    and zero-initialized by the main thread therefore end up entirely in the memory domain of the
+    main thread, so that parallel threads running on other sockets suffer from remote memory
+    accesses and contention. The functions in this namespace release the physical pages of a data
+    structure and then touch them again from all parallel threads of the current process, so that
+    the pages are spread over the memory domains of these threads.
+
+    The functions do nothing unless the specified parallel factory has been configured to pin its
+    threads to specific processors (because otherwise the placement of the threads, and thus of
+    the memory pages, is unpredictable), the factory offers multiple threads, and the data
+    structure is sufficiently large to warrant the effort. The data structure must have just been
+    initialized to its default state; its contents are reset to that default state. All
+    implementations are provided inline in the header. */
+namespace FirstTouch
+{
+    /** This function redistributes the physical pages of the memory holding the specified number
+        of items of type T starting at the specified address, and sets each of the items to its
+        default value T(). */
+    template<typename T> void distribute(ParallelFactory* parfac, T* data, size_t size)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "First-touch item type must be trivially copyable");
+
+        // only redistribute data structures of at least 4 MiB when threads are pinned
+        const size_t minBytes = 4 * 1024 * 1024;
+        if (parfac->threadPlacement() == ParallelFactory::ThreadPlacement::None) return;
+        if (parfac->maxThreadCount() < 2 || size * sizeof(T) < minBytes) return;
+
+        // release the physical pages and touch them again from all threads in this process
+        System::releasePhysicalPages(data, size * sizeof(T));
+        parfac->parallelProcessOnly()->call(size, [data](size_t firstIndex, size_t numIndices) {
+            std::fill(data + firstIndex, data + firstIndex + numIndices, T());
+        });
+    }
+
+    /** This function redistributes the physical pages of the specified array, which should
+        contain only zeros. */
+    inline void distribute(ParallelFactory* parfac, Array& array)
+    {
+        if (array.size()) distribute(parfac, &array[0], array.size());
+    }
+
+    /** This function redistributes the physical pages of the specified table, which should contain
+        only zeros. */
+    template<size_t N> void distribute(ParallelFactory* parfac, Table<N>& table) { distribute(parfac, table.data()); }
+
+    /** This function redistributes the physical pages of the specified vector, which should contain
+        only default-constructed items. */
+    template<typename T> void distribute(ParallelFactory* parfac, vector<T>& items)
+    {
+        if (!items.empty()) distribute(parfac, items.data(), items.size());
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+#endif
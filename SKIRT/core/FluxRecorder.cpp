@@ -5,9 +5,11 @@
 
 #include "FluxRecorder.hpp"
 #include "FITSInOut.hpp"
+#include "FirstTouch.hpp"
 #include "LockFree.hpp"
 #include "Log.hpp"
 #include "MediumSystem.hpp"
+#include "PerformanceCounters.hpp"
 #include "PhotonPacket.hpp"
 #include "ProcessManager.hpp"
 #include "StringUtils.hpp"
@@ -173,6 +175,13 @@ void FluxRecorder::finalizeConfiguration()
         for (auto& array : _wifu) array.resize(lenIFU);
     }
 
+    // if threads are pinned, spread the memory pages of the (possibly large) arrays over the NUMA nodes
+    auto parfac = _parentItem->find<ParallelFactory>();
+    for (auto& array : _sed) FirstTouch::distribute(parfac, array);
+    for (auto& array : _ifu) FirstTouch::distribute(parfac, array);
+    for (auto& array : _wsed) FirstTouch::distribute(parfac, array);
+    for (auto& array : _wifu) FirstTouch::distribute(parfac, array);
+
     // calculate and log allocated memory size
     size_t allocatedSize = 0;
     for (const auto& array : _sed) allocatedSize += array.size();
@@ -219,11 +228,13 @@ void FluxRecorder::detect(PhotonPacket* pp, int l, double distance)
             if (pp->hasObservedOpticalDepth())
             {
                 tau = pp->observedOpticalDepth();
+                PerformanceCounters::add(PerformanceCounters::Counter::PeelOffPathsAvoided);
             }
             else
             {
                 tau = _ms->opticalDepth(pp, distance);
                 pp->setObservedOpticalDepth(tau);
+                PerformanceCounters::add(PerformanceCounters::Counter::PeelOffPaths);
             }
             Lext *= exp(-tau);
         }
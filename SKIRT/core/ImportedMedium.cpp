@@ -171,6 +171,31 @@ double ImportedMedium::mass() const
 
 ////////////////////////////////////////////////////////////////////
 
+bool ImportedMedium::hasMassInBox() const
+{
+    return _snapshot->hasMassInBox();
+}
+
+////////////////////////////////////////////////////////////////////
+
+double ImportedMedium::massInBox(const Box& box) const
+{
+    double result = _snapshot->massInBox(box);
+    if (_snapshot->holdsNumber()) result *= mix()->mass();
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double ImportedMedium::numberInBox(const Box& box) const
+{
+    double result = _snapshot->massInBox(box);
+    if (!_snapshot->holdsNumber()) result /= mix()->mass();
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
 double ImportedMedium::opticalDepthX(double lambda) const
 {
     double result = _snapshot->SigmaX() * mix()->sectionExt(lambda);
@@ -18,7 +18,9 @@ class Snapshot;
     density distribution (and, optionally, related properties such as the bulk velocity) is
     imported from an input file. The input data is usually derived from a hydrodynamical simulation
     snapshot. Various types of snapshots are supported by subclasses of this class. Refer to the
-    subclass documentation for information on the file format. */
+    subclass documentation for information on the file format. Instead of a column text file, the
+    input file can be a binary column file with the ".scol" filename extension, which is much faster
+    to load for large snapshots (see the TextInFile class for more information). */
 class ImportedMedium : public Medium, public SiteListInterface
 {
     ITEM_ABSTRACT(ImportedMedium, Medium, "a transfer medium imported from snapshot data")
@@ -157,6 +159,22 @@ public:
         importVariableMixParams flag is enabled, this is an approximation. */
     double mass() const override;
 
+    /** This function returns true if the snapshot can efficiently determine the mass inside an
+        arbitrary box, and false otherwise. It simply calls the corresponding function in the
+        snapshot object. */
+    bool hasMassInBox() const override;
+
+    /** This function returns the mass of the medium inside the specified box. The function uses
+        the default material mix (the one at the origin) to convert from number to mass, if
+        needed; if the \em importVariableMixParams flag is enabled, this is an approximation. */
+    double massInBox(const Box& box) const override;
+
+    /** This function returns the number of material entities of the medium inside the specified
+        box. The function uses the default material mix (the one at the origin) to convert from
+        mass to number, if needed; if the \em importVariableMixParams flag is enabled, this is an
+        approximation. */
+    double numberInBox(const Box& box) const override;
+
     /** This function returns the optical depth of the medium at wavelength \f$\lambda\f$ along the
         full X axis of the model coordinate system. The function uses the default material mix (the
         one at the origin) throughout the complete spatial domain; if the \em
@@ -18,7 +18,9 @@ class Snapshot;
     spectral luminosity distribution imported from an input file. The input data is usually derived
     from a hydrodynamical simulation snapshot. Various types of snapshots are supported by
     subclasses of this class. Refer to the subclass documentation for information on the file
-    format.
+    format. Instead of a column text file, the input file can be a binary column file with the
+    ".scol" filename extension, which is much faster to load for large snapshots (see the TextInFile
+    class for more information).
 
     Usually, the input file defines a spatial distribution through smoothed particles, which must
     be interpolated and summed, or through adjacent cells that partition the spatial domain. At the
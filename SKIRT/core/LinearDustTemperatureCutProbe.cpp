@@ -40,18 +40,24 @@ void LinearDustTemperatureCutProbe::probeRun()
         file.addColumn("distance from starting point", units->ulength());
         file.addColumn("indicative dust temperature", units->utemperature(), 'g');
 
-        // write a line for each sample
+        // determine the sample positions and the corresponding cell indices
+        vector<Position> pv(_numSamples);
+        vector<int> mv(_numSamples);
         for (int i = 0; i != _numSamples; ++i)
         {
-            // determine the sample position and the distance along the line
             double fraction = static_cast<double>(i) / static_cast<double>(_numSamples - 1);
-            Position p(p1 + fraction * (p2 - p1));
-            double distance = (p - p1).norm();
+            pv[i] = Position(p1 + fraction * (p2 - p1));
+            mv[i] = grid->cellIndex(pv[i]);
+        }
+
+        // calculate the corresponding indicative dust temperatures in a single batched pass
+        Array Tv = ms->indicativeDustTemperatures(mv);
 
-            // calculate the corresponding indicative dust temperature and write the row
-            int m = grid->cellIndex(p);
-            double T = m >= 0 ? ms->indicativeDustTemperature(m) : 0.;
-            file.writeRow(units->olength(distance), units->otemperature(T));
+        // write a line for each sample
+        for (int i = 0; i != _numSamples; ++i)
+        {
+            double distance = (pv[i] - p1).norm();
+            file.writeRow(units->olength(distance), units->otemperature(Tv[i]));
         }
     }
 }
@@ -11,7 +11,31 @@
 ////////////////////////////////////////////////////////////////////
 
 /** The LyaOptions class simply offers a number of configuration options related to the treatment
-    of Lyman-alpha line transfer, if this is enabled in the simulation. */
+    of Lyman-alpha line transfer, if this is enabled in the simulation.
+
+    The \em useTabulatedVoigtProfile option causes the simulation to evaluate the Lyman-alpha
+    scattering cross section and to sample the atom velocity parallel to the incoming photon
+    direction from precomputed tables rather than through direct evaluation and a rejection loop.
+    This speeds up the photon cycle for models with many Lyman-alpha scattering events, at the cost
+    of a few MB of memory and a small, statistically insignificant deviation from the direct
+    calculation. See the tabulatedValue() and tabulatedSample() functions in the VoigtProfile
+    namespace for more information. The direct calculation remains the default so that results
+    obtained with the tables can be validated against it.
+
+    The \em analyticEscapeOpticalDepth option enables a hybrid transfer scheme for extremely thick
+    spatial cells. When set to a nonzero value \f$\tau_\mathrm{thr}\f$, a photon packet that is
+    about to scatter in a cell with a line-center optical depth \f$\tau_0 > \tau_\mathrm{thr}\f$
+    (measured from the center to the edge of a sphere with the same volume as the cell) while being
+    trapped in the line core is not scattered event by event. Instead, it is moved in a single step
+    to the cell boundary along a random direction, with a wavelength drawn from the analytic
+    solution for the spectrum emerging from a uniform sphere and with its luminosity reduced by the
+    analytic escape fraction for any dust mixed with the gas. The peel-off contributions of the
+    skipped scattering events are replaced by a single peel-off from the exit point. See
+    the LyaUtils namespace for more information. The analytic solutions are valid only in the limit
+    \f$a_\mathrm{v}\tau_0 \gtrsim 10^3\f$, so that the threshold should be set to at least
+    \f$10^6\f$ or so. The scheme ignores the internal structure and bulk velocity gradients of the
+    cell, and the radiation field contributions of the skipped paths are not recorded. The default
+    value of zero disables the hybrid scheme. */
 class LyaOptions : public SimulationItem
 {
     /** The enumeration type indicating the supported Lyman-alpha acceleration schemes.
@@ -95,6 +119,17 @@ class LyaOptions : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(includeHubbleFlow, "false")
         ATTRIBUTE_DISPLAYED_IF(includeHubbleFlow, "Level2")
 
+        PROPERTY_BOOL(useTabulatedVoigtProfile,
+                      "use precomputed tables for the Lyman-alpha cross section and atom velocity sampling")
+        ATTRIBUTE_DEFAULT_VALUE(useTabulatedVoigtProfile, "false")
+        ATTRIBUTE_DISPLAYED_IF(useTabulatedVoigtProfile, "Level3")
+
+        PROPERTY_DOUBLE(analyticEscapeOpticalDepth,
+                        "the line-center cell optical depth above which trapped photon packets escape analytically")
+        ATTRIBUTE_MIN_VALUE(analyticEscapeOpticalDepth, "[0")
+        ATTRIBUTE_DEFAULT_VALUE(analyticEscapeOpticalDepth, "0")
+        ATTRIBUTE_DISPLAYED_IF(analyticEscapeOpticalDepth, "Level3")
+
     ITEM_END()
 };
 
@@ -22,13 +22,16 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
-double LyaUtils::section(double lambda, double T)
+double LyaUtils::section(double lambda, double T, bool tabulated)
 {
     double vth = sqrt(2. * kB / mp * T);                 // thermal velocity for T
     double a = Aa * la / 4. / M_PI / vth;                // Voigt parameter
     double x = (la - lambda) / lambda * c / vth;         // dimensionless frequency
     double sigma0 = 3. * la * la * M_2_SQRTPI / 4. * a;  // cross section at line center
-    return sigma0 * VoigtProfile::value(a, x);           // cross section at given x
+
+    // cross section at given x, optionally using the tabulated Voigt function
+    if (tabulated) return sigma0 * VoigtProfile::tabulatedValue(a, x);
+    return sigma0 * VoigtProfile::value(a, x);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -72,7 +75,8 @@ std::pair<Vec, bool> LyaUtils::sampleAtomVelocity(double lambda, double T, doubl
 
     // draw values for the components of the dimensionless atom velocity
     // parallel and orthogonal to the incoming photon packet
-    double upar = VoigtProfile::sample(a, x, random);
+    double upar = config->lyaUseTabulatedVoigtProfile() ? VoigtProfile::tabulatedSample(a, x, random)
+                                                        : VoigtProfile::sample(a, x, random);
     double radius = sqrt(xcrit * xcrit - std::log(random->uniform()));
     double angle = 2. * M_PI * random->uniform();
     double u1 = radius * cos(angle);
@@ -106,3 +110,52 @@ double LyaUtils::shiftWavelength(double lambda, const Vec& vatom, const Directio
 }
 
 ////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // returns the Voigt parameter for the given temperature
+    double voigtParameter(double T)
+    {
+        double vth = sqrt(2. * kB / mp * T);  // thermal velocity for T
+        return Aa * la / 4. / M_PI / vth;     // Voigt parameter
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool LyaUtils::isCoreTrapped(double lambda, double T, double tau0)
+{
+    double vth = sqrt(2. * kB / mp * T);          // thermal velocity for T
+    double x = (la - lambda) / lambda * c / vth;  // dimensionless frequency
+    double xp = cbrt(voigtParameter(T) * tau0);   // approximate peak of the emerging spectrum
+    return abs(x) < xp;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double LyaUtils::sampleEscapeWavelength(double T, double tau0, Random* random)
+{
+    // sample the logistic distribution for y
+    double X = random->uniform();
+    double y = std::log(X / (1. - X));
+
+    // solve for the dimensionless frequency x
+    const double K = sqrt(2. * M_PI * M_PI * M_PI / 27.);
+    double x = cbrt(y * voigtParameter(T) * tau0 / K);
+
+    // convert to wavelength
+    double vth = sqrt(2. * kB / mp * T);  // thermal velocity for T
+    return la / (1. + x * vth / c);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double LyaUtils::escapeFraction(double T, double tau0, double taua)
+{
+    if (taua <= 0.) return 1.;
+    const double zeta = 0.525;
+    double factor = sqrt(sqrt(3.) / (zeta * pow(M_PI, 5. / 12.)));
+    return 1. / cosh(factor * sqrt(cbrt(voigtParameter(T) * tau0) * taua));
+}
+
+////////////////////////////////////////////////////////////////////
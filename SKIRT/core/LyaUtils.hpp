@@ -106,8 +106,10 @@ namespace LyaUtils
 {
     /** This function returns the Lyman-alpha scattering cross section per hydrogen atom
         \f$\sigma_\alpha(\lambda, T)\f$ at the given photon wavelength and gas temperature, using
-        the definition given in the class header. */
-    double section(double lambda, double T);
+        the definition given in the class header. If the \em tabulated flag is true, the Voigt
+        function is interpolated from a precomputed table rather than evaluated directly; see
+        VoigtProfile::tabulatedValue(). */
+    double section(double lambda, double T, bool tabulated = false);
 
     /** This function draws a random hydrogen atom velocity as seen by an incoming photon from the
         appropriate probability distributions, reflecting the preference for photons to be
@@ -127,7 +129,8 @@ namespace LyaUtils
 
         - Draw values for the components of the dimensionless atom velocity parallel and orthogonal
         to the incoming photon packet from the probability distribution described in the class
-        header and from Gaussian distributions, respectively.
+        header and from Gaussian distributions, respectively. Depending on the configuration, the
+        parallel component is drawn using VoigtProfile::sample() or VoigtProfile::tabulatedSample().
 
         - Transform the dimensionless frequency into the rest frame of the atom as described in the
         class header.
@@ -149,6 +152,43 @@ namespace LyaUtils
         velocity of the interacting atom, and the incoming and outgoing photon packet directions.
         */
     double shiftWavelength(double lambda, const Vec& vatom, const Direction& kin, const Direction& kout);
+
+    /** This function returns true if a photon packet with the given wavelength, as perceived in
+        the local gas frame, is trapped in the core of the Lyman-alpha line for a spatial cell with
+        the given gas temperature \f$T\f$ and line-center optical depth \f$\tau_0\f$, and false
+        otherwise. A photon packet is considered to be trapped if its dimensionless frequency
+        satisfies \f$|x| < (a_\mathrm{v}\tau_0)^{1/3}\f$, i.e. if it is closer to the line center
+        than the peaks of the spectrum emerging from the cell (see sampleEscapeWavelength()). Such a
+        photon packet can escape the cell only after a very large number of scattering events that
+        gradually diffuse its frequency into the wings of the line. */
+    bool isCoreTrapped(double lambda, double T, double tau0);
+
+    /** This function draws a random wavelength, in the local gas frame, for a photon packet
+        escaping from a static, uniform sphere of gas with the given temperature \f$T\f$ and
+        line-center optical depth \f$\tau_0\f$ from its center to its surface, after having been
+        trapped in the core of the Lyman-alpha line.
+
+        In the limit of very high optical depths, \f$a_\mathrm{v}\tau_0 \gtrsim 10^3\f$, the
+        spectrum emerging from such a sphere for a central source at the line center is given by
+        the analytic solution of Dijkstra et al. 2006 (ApJ, 649, 14), extending the slab solution
+        of Harrington 1973 (MNRAS, 162, 43) and Neufeld 1990 (ApJ, 350, 216): \f[ J(x) \propto
+        \frac{x^2}{1+\cosh\left(\sqrt{2\pi^3/27}\;|x|^3/(a_\mathrm{v}\tau_0)\right)}. \f]
+        With the substitution \f$y = \sqrt{2\pi^3/27}\;x^3/(a_\mathrm{v}\tau_0)\f$, this becomes
+        the logistic distribution \f$P(y) = \frac{1}{2}\left[1+\cosh(y)\right]^{-1}\f$, which can
+        be sampled by the transformation method as \f$y = \ln[\mathcal{X}/(1-\mathcal{X})]\f$
+        with \f$\mathcal{X}\f$ a uniform deviate. The function then solves for \f$x\f$ and
+        converts the result to a wavelength. */
+    double sampleEscapeWavelength(double T, double tau0, Random* random);
+
+    /** This function returns the fraction of the photon packet luminosity that escapes from a
+        static, uniform cloud of gas with the given temperature \f$T\f$ and line-center optical
+        depth \f$\tau_0\f$, mixed with dust with absorption optical depth \f$\tau_\mathrm{a}\f$
+        over the same distance, in the limit of very high Lyman-alpha optical depths. We use the
+        approximation derived by Neufeld 1990 (ApJ, 350, 216) and recalibrated by Laursen et al.
+        2009 (ApJ, 704, 1640), \f[ f_\mathrm{esc} = \frac{1}{\cosh\left(
+        \sqrt{\sqrt{3}/(\zeta\pi^{5/12})}\; \sqrt{(a_\mathrm{v}\tau_0)^{1/3} \tau_\mathrm{a}}
+        \right)} \f] with \f$\zeta=0.525\f$. */
+    double escapeFraction(double T, double tau0, double taua);
 }
 
 ////////////////////////////////////////////////////////////////////
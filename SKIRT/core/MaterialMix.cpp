@@ -89,3 +89,34 @@ const Array& MaterialMix::sectionsAbspol(double /*lambda*/) const
 }
 
 ////////////////////////////////////////////////////////////////////
+
+void MaterialMix::equilibriumTemperatures(const Table<2>& Jvv, Array& Tv) const
+{
+    size_t numFields = Jvv.size(0);
+    size_t numWavelengths = Jvv.size(1);
+    Tv.resize(numFields);
+    Array Jv(numWavelengths);
+    for (size_t i = 0; i != numFields; ++i)
+    {
+        std::copy(begin(Jvv.data()) + i * numWavelengths, begin(Jvv.data()) + (i + 1) * numWavelengths, begin(Jv));
+        Tv[i] = equilibriumTemperature(Jv);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MaterialMix::emissivities(const Table<2>& Jvv, Table<2>& evv) const
+{
+    size_t numFields = Jvv.size(0);
+    size_t numWavelengths = Jvv.size(1);
+    Array Jv(numWavelengths);
+    for (size_t i = 0; i != numFields; ++i)
+    {
+        std::copy(begin(Jvv.data()) + i * numWavelengths, begin(Jvv.data()) + (i + 1) * numWavelengths, begin(Jv));
+        Array ev = emissivity(Jv);
+        if (!i) evv.resize(numFields, ev.size());
+        std::copy(begin(ev), end(ev), begin(evv.data()) + i * ev.size());
+    }
+}
+
+////////////////////////////////////////////////////////////////////
@@ -6,8 +6,8 @@
 #ifndef MATERIALMIX_HPP
 #define MATERIALMIX_HPP
 
-#include "Array.hpp"
 #include "SimulationItem.hpp"
+#include "Table.hpp"
 class Random;
 class StokesVector;
 class WavelengthGrid;
@@ -295,6 +295,26 @@ public:
         each material type. */
     virtual Array emissivity(const Array& Jv) const = 0;
 
+    /** This function returns the equilibrium temperature \f$T_{\text{eq}}\f$ of the material mix
+        for each of the radiation fields specified by the mean intensities in the table \em Jvv,
+        indexed on \f$i,\ell\f$ where \f$i\f$ is the index of the radiation field (usually
+        corresponding to a spatial cell) and \f$\ell\f$ is the wavelength index in the simulation's
+        radiation field wavelength grid. Upon return, the array \em Tv has been resized and filled
+        with the temperatures, indexed on \f$i\f$. The default implementation in this base class
+        calls the equilibriumTemperature() function for each radiation field. Subclasses can
+        override this function to process many radiation fields at once in a more efficient
+        manner. */
+    virtual void equilibriumTemperatures(const Table<2>& Jvv, Array& Tv) const;
+
+    /** This function returns the emissivity spectrum of the material mix for each of the
+        radiation fields specified by the mean intensities in the table \em Jvv, indexed on
+        \f$i,\ell\f$ as described for the equilibriumTemperatures() function. Upon return, the
+        table \em evv has been resized and filled with the emissivity spectra, indexed on
+        \f$i,\ell'\f$. The default implementation in this base class calls the emissivity()
+        function for each radiation field. Subclasses can override this function to process many
+        radiation fields at once in a more efficient manner. */
+    virtual void emissivities(const Table<2>& Jvv, Table<2>& evv) const;
+
     //======================== Other Functions =======================
 
 protected:
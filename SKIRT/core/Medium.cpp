@@ -0,0 +1,29 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "Medium.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+bool Medium::hasMassInBox() const
+{
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double Medium::massInBox(const Box& /*box*/) const
+{
+    return 0.;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double Medium::numberInBox(const Box& /*box*/) const
+{
+    return 0.;
+}
+
+////////////////////////////////////////////////////////////////////
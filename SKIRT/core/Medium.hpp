@@ -6,6 +6,7 @@
 #ifndef MEDIUM_HPP
 #define MEDIUM_HPP
 
+#include "Box.hpp"
 #include "Position.hpp"
 #include "SimulationItem.hpp"
 class MaterialMix;
@@ -114,6 +115,24 @@ public:
     /** This function returns the total mass in the medium. */
     virtual double mass() const = 0;
 
+    /** This function returns true if the medium can efficiently determine the mass and the number
+        of material entities contained in an arbitrary box through the massInBox() and
+        numberInBox() functions, and false otherwise. The default implementation returns false.
+        Media backed by a data structure offering a spatial index can override these functions,
+        for example to avoid sampling the density at many random positions during the
+        construction of a spatial grid. */
+    virtual bool hasMassInBox() const;
+
+    /** This function returns the mass of the medium inside the specified box, i.e. a cuboid lined
+        up with the coordinate axes. If the hasMassInBox() function returns false, the behavior is
+        undefined; the default implementation returns zero. */
+    virtual double massInBox(const Box& box) const;
+
+    /** This function returns the number of material entities of the medium inside the specified
+        box. If the hasMassInBox() function returns false, the behavior is undefined; the default
+        implementation returns zero. */
+    virtual double numberInBox(const Box& box) const;
+
     /** This function returns the optical depth of the medium at wavelength \f$\lambda\f$
         along the full X axis of the model coordinate system. */
     virtual double opticalDepthX(double lambda) const = 0;
@@ -9,6 +9,7 @@
 #include "DensityInCellInterface.hpp"
 #include "DisjointWavelengthGrid.hpp"
 #include "FatalError.hpp"
+#include "FirstTouch.hpp"
 #include "LockFree.hpp"
 #include "Log.hpp"
 #include "LyaUtils.hpp"
@@ -16,6 +17,7 @@
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
+#include "PerformanceCounters.hpp"
 #include "PhotonPacket.hpp"
 #include "ProcessManager.hpp"
 #include "Random.hpp"
@@ -67,6 +69,13 @@ void MediumSystem::setupSelfAfter()
         }
     }
 
+    // if threads are pinned, spread the memory pages over the NUMA nodes
+    FirstTouch::distribute(parfac, _state1v);
+    FirstTouch::distribute(parfac, _state2vv);
+    FirstTouch::distribute(parfac, _rf1);
+    FirstTouch::distribute(parfac, _rf2);
+    FirstTouch::distribute(parfac, _rf2c);
+
     // inform user
     log->info(typeAndName() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory");
 
@@ -315,7 +324,7 @@ double MediumSystem::opacitySca(double lambda, int m, int h) const
     if (n <= 0.)
         return 0.;
     else if (h == _config->lyaMediumIndex())
-        return n * LyaUtils::section(lambda, state(m).T);
+        return n * LyaUtils::section(lambda, state(m).T, _config->lyaUseTabulatedVoigtProfile());
     else
         return n * state(m, h).mix->sectionSca(lambda);
 }
@@ -350,7 +359,7 @@ double MediumSystem::opacityExt(double lambda, int m, int h) const
     if (n <= 0.)
         return 0.;
     else if (h == _config->lyaMediumIndex())
-        return n * LyaUtils::section(lambda, state(m).T);
+        return n * LyaUtils::section(lambda, state(m).T, _config->lyaUseTabulatedVoigtProfile());
     else
         return n * state(m, h).mix->sectionExt(lambda);
 }
@@ -420,6 +429,8 @@ void MediumSystem::opticalDepth(PhotonPacket* pp)
 {
     // determine the geometric details of the path
     _grid->path(pp);
+    PerformanceCounters::add(PerformanceCounters::Counter::Paths);
+    PerformanceCounters::add(PerformanceCounters::Counter::PathSegments, pp->segments().size());
 
     // calculate the cumulative optical depth and store it in the photon packet for each path segment;
     // because this function is at the heart of the photon life cycle, we implement various optimized versions
@@ -635,6 +646,87 @@ double MediumSystem::indicativeDustTemperature(int m) const
 
 ////////////////////////////////////////////////////////////////////
 
+Array MediumSystem::indicativeDustTemperatures(const vector<int>& mv) const
+{
+    size_t numCells = mv.size();
+    Array Tv(numCells);
+    find<ParallelFactory>()->parallelDistributed()->call(numCells, [this, &mv, &Tv](size_t firstIndex,
+                                                                                    size_t numIndices) {
+        // process the cells in batches so that the radiation fields for a batch comfortably fit in the cache
+        const size_t maxBatchSize = 256;
+        int numWavelengths = _wavelengthGrid->numBins();
+        Table<2> Jvv, runJvv;
+        Array runTv;
+        for (size_t first = firstIndex; first != firstIndex + numIndices;)
+        {
+            size_t num = min(maxBatchSize, firstIndex + numIndices - first);
+            const int* batchmv = mv.data() + first;
+
+            // gather the radiation fields for the cells in the batch, leaving zeroes for negative cell indices
+            Jvv.resize(num, numWavelengths);
+            for (size_t i = 0; i != num; ++i)
+            {
+                if (batchmv[i] >= 0)
+                {
+                    Array Jv = meanIntensity(batchmv[i]);
+                    std::copy(begin(Jv), end(Jv), begin(Jvv.data()) + i * numWavelengths);
+                }
+            }
+
+            // accumulate the density-weighted temperatures for each dust medium
+            Array sumRhoTv(num);
+            Array sumRhov(num);
+            for (int h = 0; h != _numMedia; ++h)
+            {
+                if (!isDust(h)) continue;
+
+                // the material mix may vary between cells, so process runs of consecutive cells with the same mix
+                auto cellMix = [this, batchmv, h](size_t i) { return batchmv[i] >= 0 ? mix(batchmv[i], h) : nullptr; };
+                for (size_t i = 0; i != num;)
+                {
+                    const MaterialMix* runMix = cellMix(i);
+                    size_t j = i + 1;
+                    while (j != num && cellMix(j) == runMix) ++j;
+                    if (runMix)
+                    {
+                        // avoid copying the radiation fields if the run covers the complete batch
+                        if (j - i == num)
+                        {
+                            runMix->equilibriumTemperatures(Jvv, runTv);
+                        }
+                        else
+                        {
+                            runJvv.resize(j - i, numWavelengths);
+                            std::copy(begin(Jvv.data()) + i * numWavelengths, begin(Jvv.data()) + j * numWavelengths,
+                                      begin(runJvv.data()));
+                            runMix->equilibriumTemperatures(runJvv, runTv);
+                        }
+                        for (size_t r = i; r != j; ++r)
+                        {
+                            double rho = massDensity(batchmv[r], h);
+                            if (rho > 0.)
+                            {
+                                sumRhoTv[r] += rho * runTv[r - i];
+                                sumRhov[r] += rho;
+                            }
+                        }
+                    }
+                    i = j;
+                }
+            }
+
+            // store the indicative temperatures
+            for (size_t i = 0; i != num; ++i)
+                if (sumRhov[i] > 0.) Tv[first + i] = sumRhoTv[i] / sumRhov[i];
+            first += num;
+        }
+    });
+    ProcessManager::sumToAll(Tv);
+    return Tv;
+}
+
+////////////////////////////////////////////////////////////////////
+
 double MediumSystem::absorbedLuminosity(int m, MaterialMix::MaterialType type) const
 {
     double Labs = 0.;
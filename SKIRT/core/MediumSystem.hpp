@@ -388,6 +388,15 @@ public:
         interpretation. */
     double indicativeDustTemperature(int m) const;
 
+    /** This function returns the indicative dust temperature, as described for the
+        indicativeDustTemperature() function, for each of the spatial cells with the indices
+        specified in the list \em mv. The value returned for a negative cell index is zero. The
+        calculation is performed in parallel, distributed over all processes, so this function must
+        be called from all processes. Moreover, the radiation fields for a batch of cells are
+        passed to the material mix at once, allowing the equilibrium temperatures to be calculated
+        for many cells in a single pass. */
+    Array indicativeDustTemperatures(const vector<int>& mv) const;
+
     /** This function returns the bolometric luminosity \f$L^\text{abs}_{\text{bol},m}\f$ that has
         been absorbed by media of the specified type in the spatial cell with index \f$m\f$.
 
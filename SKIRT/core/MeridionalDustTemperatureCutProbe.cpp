@@ -31,18 +31,23 @@ void MeridionalDustTemperatureCutProbe::probeRun()
         file.addColumn("inclination", units->uposangle());
         file.addColumn("indicative dust temperature", units->utemperature(), 'g');
 
-        // write a line for each sample
+        // determine the sample inclinations and the cell indices for the corresponding positions
+        Array inclinationv(_numSamples);
+        vector<int> mv(_numSamples);
         for (int i = 0; i != _numSamples; ++i)
         {
-            // determine the sample inclination and position
             double fraction = static_cast<double>(i) / static_cast<double>(_numSamples - 1);
-            double inclination = fraction * M_PI;
-            Position p(_radius * Direction(inclination, _azimuth));
+            inclinationv[i] = fraction * M_PI;
+            mv[i] = grid->cellIndex(Position(_radius * Direction(inclinationv[i], _azimuth)));
+        }
+
+        // calculate the corresponding indicative dust temperatures in a single batched pass
+        Array Tv = ms->indicativeDustTemperatures(mv);
 
-            // calculate the corresponding indicative dust temperature and write the row
-            int m = grid->cellIndex(p);
-            double T = m >= 0 ? ms->indicativeDustTemperature(m) : 0.;
-            file.writeRow(units->oposangle(inclination), units->otemperature(T));
+        // write a line for each sample
+        for (int i = 0; i != _numSamples; ++i)
+        {
+            file.writeRow(units->oposangle(inclinationv[i]), units->otemperature(Tv[i]));
         }
     }
 }
@@ -4,6 +4,7 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "MonteCarloSimulation.hpp"
+#include "Constants.hpp"
 #include "DisjointWavelengthGrid.hpp"
 #include "FatalError.hpp"
 #include "Log.hpp"
@@ -11,6 +12,7 @@
 #include "MaterialMix.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
+#include "PerformanceCounters.hpp"
 #include "PhotonPacket.hpp"
 #include "ProcessManager.hpp"
 #include "SecondarySourceSystem.hpp"
@@ -18,7 +20,9 @@
 #include "SpatialGrid.hpp"
 #include "SpecialFunctions.hpp"
 #include "StringUtils.hpp"
+#include "System.hpp"
 #include "TimeLogger.hpp"
+#include "TraceRecorder.hpp"
 #include "VoigtProfile.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -38,6 +42,7 @@ void MonteCarloSimulation::setupSimulation()
         TimeLogger logger(log(), "setup output");
 
         // notify the probe system
+        TraceRecorder::Scope scope("output", "probe setup output");
         probeSystem()->probeSetup();
     }
 }
@@ -66,6 +71,13 @@ Configuration* MonteCarloSimulation::config() const
 
 void MonteCarloSimulation::runSimulation()
 {
+    // discard any counts accumulated during setup
+    if (PerformanceCounters::isEnabled())
+    {
+        PerformanceCounters::harvest();
+        _phaseStarted = std::chrono::steady_clock::now();
+    }
+
     // run the simulation
     {
         TimeLogger logger(log(), "the run");
@@ -85,11 +97,20 @@ void MonteCarloSimulation::runSimulation()
         TimeLogger logger(log(), "final output");
 
         // notify the probe system
-        probeSystem()->probeRun();
+        {
+            TraceRecorder::Scope scope("output", "probe run output");
+            probeSystem()->probeRun();
+        }
 
         // write instrument output
-        instrumentSystem()->flush();
-        instrumentSystem()->write();
+        {
+            TraceRecorder::Scope scope("output", "instrument output");
+            instrumentSystem()->flush();
+            instrumentSystem()->write();
+        }
+
+        // write the performance report
+        writePerformanceReport();
     }
 }
 
@@ -126,6 +147,7 @@ void MonteCarloSimulation::runPrimaryEmission()
     // wait for all processes to finish and synchronize the radiation field
     wait(segment);
     if (_config->hasRadiationField()) mediumSystem()->communicateRadiationField(true);
+    recordPerformancePhase(segment);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -180,6 +202,7 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
             // wait for all processes to finish and synchronize the radiation field
             wait(segment);
             mediumSystem()->communicateRadiationField(false);
+            recordPerformancePhase(segment);
         }
 
         // determine and log the total absorbed luminosity
@@ -270,6 +293,7 @@ void MonteCarloSimulation::runSecondaryEmission()
     // wait for all processes to finish and synchronize the radiation field if needed
     wait(segment);
     if (storeRF) mediumSystem()->communicateRadiationField(false);
+    recordPerformancePhase(segment);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -285,6 +309,64 @@ void MonteCarloSimulation::wait(std::string scope)
 
 ////////////////////////////////////////////////////////////////////
 
+void MonteCarloSimulation::recordPerformancePhase(string phase)
+{
+    if (!PerformanceCounters::isEnabled()) return;
+
+    // aggregate the counters across threads and processes
+    auto counters = PerformanceCounters::harvest();
+    Array values(counters.size());
+    for (size_t i = 0; i != counters.size(); ++i) values[i] = counters[i];
+    ProcessManager::sumToRoot(values);
+
+    // remember the results and the elapsed wall time for this phase
+    auto now = std::chrono::steady_clock::now();
+    _phases.emplace_back(phase, std::chrono::duration<double>(now - _phaseStarted).count(), values);
+    _phaseStarted = now;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::writePerformanceReport()
+{
+    if (!PerformanceCounters::isEnabled() || !ProcessManager::isRoot()) return;
+
+    // helper functions to format a count and a floating point value
+    auto count = [](double value) { return StringUtils::toString(value, 'f', 0); };
+    auto number = [](double value) { return StringUtils::toString(value, 'g', 6); };
+
+    string filepath = filePaths()->output("perf.json");
+    log()->info("Writing performance report to " + filepath + "...");
+    std::ofstream out = System::ofstream(filepath);
+    out << "{\n\"processes\": " << ProcessManager::size()
+        << ",\n\"threads\": " << parallelFactory()->maxThreadCount() << ",\n\"phases\": [\n";
+    for (size_t p = 0; p != _phases.size(); ++p)
+    {
+        const auto& phase = _phases[p];
+        const Array& v = phase.values;
+        auto value = [&v](PerformanceCounters::Counter counter) { return v[static_cast<int>(counter)]; };
+        using Counter = PerformanceCounters::Counter;
+
+        out << "{\"phase\": \"" << phase.name << "\", \"wallTime\": " << number(phase.wallTime);
+        for (int i = 0; i != PerformanceCounters::numCounters(); ++i)
+        {
+            auto counter = static_cast<Counter>(i);
+            if (counter == Counter::EmissivityTime) continue;
+            out << ", \"" << PerformanceCounters::name(counter) << "\": " << count(value(counter));
+        }
+        double paths = value(Counter::Paths);
+        double packets = value(Counter::LaunchedPackets);
+        out << ", \"meanSegmentsPerPath\": " << number(paths > 0 ? value(Counter::PathSegments) / paths : 0.);
+        out << ", \"scatteringsPerPacket\": " << number(packets > 0 ? value(Counter::Scatterings) / packets : 0.);
+        out << ", \"" << PerformanceCounters::name(Counter::EmissivityTime)
+            << "\": " << number(value(Counter::EmissivityTime) * 1e-9) << "}";
+        out << (p + 1 != _phases.size() ? ",\n" : "\n");
+    }
+    out << "]\n}\n";
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MonteCarloSimulation::initProgress(string segment, size_t numTotal)
 {
     _segment = segment;
@@ -320,6 +402,7 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
     while (numIndices)
     {
         size_t currentChunkSize = min(logProgressChunkSize, numIndices);
+        PerformanceCounters::add(PerformanceCounters::Counter::LaunchedPackets, currentChunkSize);
         for (size_t historyIndex = firstIndex; historyIndex != firstIndex + currentChunkSize; ++historyIndex)
         {
             // launch a photon packet from the requested source
@@ -343,6 +426,8 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
                         simulatePropagation(&pp);
                         if (pp.luminosity() <= 0 || (pp.luminosity() <= Lthreshold && pp.numScatt() >= minScattEvents))
                             break;
+                        if (_config->lyaAnalyticEscapeOpticalDepth() > 0. && simulateLyaCellEscape(&pp, &ppp, peel))
+                            continue;
                         if (peel) peelOffScattering(&pp, &ppp);
                         simulateScattering(&pp);
                     }
@@ -367,6 +452,7 @@ void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket*
         {
             const Direction bfkobs = instrument->bfkobs(pp->position());
             ppp->launchEmissionPeelOff(pp, bfkobs);
+            PerformanceCounters::add(PerformanceCounters::Counter::PeelOffs);
 
             // if the photon packet is polarised, we have to rotate the Stokes vector into the frame of the instrument
             if (ppp->isPolarized())
@@ -490,8 +576,9 @@ void MonteCarloSimulation::simulatePropagation(PhotonPacket* pp)
     // adjust the weight by the scattered fraction
     pp->applyBias(-expm1(-taupath) * albedo);
 
-    // advance the position
+    // advance the position, remembering the cell containing the interaction point
     pp->propagate(pp->interactionDistance());
+    pp->setCellHint(m);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -713,6 +800,7 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
 
             // pass the result to the peel-off photon packet and have it detected
             ppp->launchScatteringPeelOff(pp, bfkobs, emissionLambda, I);
+            PerformanceCounters::add(PerformanceCounters::Counter::PeelOffs);
             if (_config->hasPolarization()) ppp->setPolarized(I, Q, U, V, pp->normal());
         }
         instr->detect(ppp);
@@ -723,6 +811,8 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
 
 void MonteCarloSimulation::simulateScattering(PhotonPacket* pp)
 {
+    PerformanceCounters::add(PerformanceCounters::Counter::Scatterings);
+
     // locate the cell hosting the scattering event
     int m = pp->interactionCellIndex();
 
@@ -871,3 +961,95 @@ void MonteCarloSimulation::simulateScattering(PhotonPacket* pp)
 }
 
 ////////////////////////////////////////////////////////////////////
+
+bool MonteCarloSimulation::simulateLyaCellEscape(PhotonPacket* pp, PhotonPacket* ppp, bool peel)
+{
+    // get the cell hosting the scattering event and its Lyman-alpha gas properties
+    int m = pp->interactionCellIndex();
+    int hLya = _config->lyaMediumIndex();
+    double nH = mediumSystem()->numberDensity(m, hLya);
+    if (nH <= 0.) return false;
+    double T = mediumSystem()->gasTemperature(m);
+
+    // get the bulk velocity of the material in that cell and determine the perceived wavelength
+    Vec bfv;
+    double lambda;
+    if (!_config->hasMovingMedia())
+    {
+        lambda = pp->wavelength();
+    }
+    else
+    {
+        bfv = mediumSystem()->bulkVelocity(m);
+        lambda = pp->perceivedWavelength(bfv, _config->lyaExpansionRate() * pp->interactionDistance());
+    }
+
+    // calculate the line-center optical depth from the center to the edge of a sphere with the cell's volume
+    double R = cbrt(0.75 / M_PI * mediumSystem()->volume(m));
+    double sigma0 = LyaUtils::section(Constants::lambdaLya(), T, _config->lyaUseTabulatedVoigtProfile());
+    double tau0 = nH * sigma0 * R;
+
+    // skip the analytic escape unless the cell is sufficiently thick and the photon packet is trapped in the core
+    if (tau0 < _config->lyaAnalyticEscapeOpticalDepth() || !LyaUtils::isCoreTrapped(lambda, T, tau0)) return false;
+
+    // draw an isotropic outgoing direction and determine the distance to the cell boundary along that direction
+    Direction bfknew = random()->direction();
+    SpatialGridPath path(pp->position(), bfknew);
+    path.setCellHint(m);
+    mediumSystem()->grid()->path(&path);
+    double distance = 0.;
+    for (const auto& segment : path.segments())
+    {
+        if (segment.m == m)
+        {
+            distance = segment.s;
+            break;
+        }
+    }
+
+    // perform a regular scattering event if the path does not cross the cell, e.g. due to round-off errors
+    if (distance <= 0.) return false;
+    PerformanceCounters::add(PerformanceCounters::Counter::LyaCellEscapes);
+
+    // determine the dust absorption optical depth over the same distance
+    double taua = 0.;
+    int numMedia = mediumSystem()->numMedia();
+    for (int h = 0; h != numMedia; ++h)
+        if (h != hLya) taua += mediumSystem()->opacityAbs(lambda, m, h) * R;
+
+    // draw the outgoing wavelength in the gas frame
+    double localLambda = LyaUtils::sampleEscapeWavelength(T, tau0, random());
+    double newLambda =
+        bfv.isNull() ? localLambda : PhotonPacket::shiftedEmissionWavelength(localLambda, bfknew, bfv);
+
+    // move the photon packet to the exit point and apply the escape fraction
+    pp->setPosition(Position(pp->position() + bfknew * distance));
+    pp->setCellHint(m);
+    pp->applyBias(LyaUtils::escapeFraction(T, tau0, taua));
+
+    // peel off towards each instrument from the exit point, treating the cell surface as a Lambertian emitter
+    // with the outgoing direction as its normal; the weight is normalized to unity over the unit sphere
+    if (peel)
+    {
+        for (Instrument* instr : _instrumentSystem->instruments())
+        {
+            if (!instr->isSameObserverAsPreceding())
+            {
+                Direction bfkobs = instr->bfkobs(pp->position());
+                double w = 4. * max(0., Vec::dot(bfkobs, bfknew));
+                double emissionLambda =
+                    bfv.isNull() ? localLambda : PhotonPacket::shiftedEmissionWavelength(localLambda, bfkobs, bfv);
+                ppp->launchScatteringPeelOff(pp, bfkobs, emissionLambda, w);
+                PerformanceCounters::add(PerformanceCounters::Counter::PeelOffs);
+            }
+            instr->detect(ppp);
+        }
+    }
+
+    // update the propagation direction and wavelength of the photon packet
+    if (_config->hasPolarization()) pp->setUnpolarized();
+    pp->scatter(bfknew, newLambda);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -15,6 +15,7 @@
 #include "Simulation.hpp"
 #include "SourceSystem.hpp"
 #include <atomic>
+#include <chrono>
 class SecondarySourceSystem;
 
 //////////////////////////////////////////////////////////////////////
@@ -204,6 +205,21 @@ private:
         process, the function does nothing. */
     void wait(string scope);
 
+    /** If performance counters are enabled (see the PerformanceCounters class), this function
+        aggregates the counters across threads and processes, stores the result together with the
+        wall time elapsed since the previous phase under the specified phase name, and resets the
+        counters. Because the function communicates between processes, it must be called by all
+        processes. If performance counters are disabled, the function does nothing. */
+    void recordPerformancePhase(string phase);
+
+    /** If performance counters are enabled, this function writes the results stored by
+        recordPerformancePhase() to a JSON file named <tt>prefix_perf.json</tt> next to the log
+        file. In addition to the raw counters, the report lists the mean number of segments per path
+        and the number of scattering events per launched photon packet for each phase. If
+        performance counters are disabled, or if this is not the root process, the function does
+        nothing. */
+    void writePerformanceReport();
+
     /** This function initializes the progress counter used in logprogress() for the specified
         segment and logs the number of photon packets to be processed. */
     void initProgress(string segment, size_t numTotal);
@@ -457,6 +473,35 @@ private:
         sampled \f$\theta\f$ and \f$\phi\f$ angles. */
     void simulateScattering(PhotonPacket* pp);
 
+    /** This function implements the hybrid Lyman-alpha transfer scheme for extremely thick
+        spatial cells, if enabled through the Configuration::lyaAnalyticEscapeOpticalDepth()
+        option. It is called for a photon packet that is about to scatter, and returns false
+        without changing anything if the scheme does not apply. Otherwise, it handles the complete
+        sequence of scattering events in the cell and returns true.
+
+        The scheme applies if the line-center optical depth \f$\tau_0\f$ of the cell hosting the
+        interaction point, measured from the center to the edge of a sphere with the same volume as
+        the cell, exceeds the configured threshold, and the photon packet is trapped in the line
+        core as determined by LyaUtils::isCoreTrapped(). In that case, the function draws a new
+        isotropic propagation direction and moves the photon packet along that direction to the
+        boundary of the cell. It draws the outgoing wavelength from the analytic solution for the
+        spectrum emerging from a uniform sphere using LyaUtils::sampleEscapeWavelength(), and
+        reduces the luminosity by the escape fraction given by LyaUtils::escapeFraction() for the
+        dust absorption optical depth of the other medium components in the cell. If the path
+        along the new direction does not cross the cell (e.g., because of round-off errors near
+        the cell boundary), the function returns false so that a regular scattering event is
+        performed instead.
+
+        If the \em peel flag is true, the peel-off contributions of the skipped scattering events
+        are replaced by a single peel-off photon packet for each instrument, launched from the exit
+        point with the outgoing wavelength Doppler-shifted for the bulk velocity of the cell. The
+        cell surface is treated as a Lambertian emitter with the outgoing direction
+        \f${\bf{k}}\f$ as its normal, so that the peel-off is weighted by \f$4\max(0, {\bf{k}}
+        \cdot {\bf{k}}_\mathrm{obs})\f$. Averaged over the isotropic distribution of outgoing
+        directions, this corresponds to isotropic emission from the cell as a whole. The second
+        argument provides a placeholder peel off photon packet for use by the function. */
+    bool simulateLyaCellEscape(PhotonPacket* pp, PhotonPacket* ppp, bool peel);
+
     //======================== Data Members ========================
 
 private:
@@ -469,6 +514,17 @@ private:
 
     // the dipole phase function used for Lyman-alpha scattering - initialized during setup if needed
     DipolePhaseFunction _dpf;
+
+    // data members used by the performance report functions in this class
+    struct Phase
+    {
+        Phase(string name, double wallTime, const Array& values) : name(name), wallTime(wallTime), values(values) {}
+        string name;      // the name of the phase
+        double wallTime;  // the wall time elapsed during the phase, in seconds
+        Array values;     // the aggregated value for each performance counter
+    };
+    vector<Phase> _phases;                               // the results for each phase recorded so far
+    std::chrono::steady_clock::time_point _phaseStarted;  // the time at which the current phase started
 };
 
 ////////////////////////////////////////////////////////////////////
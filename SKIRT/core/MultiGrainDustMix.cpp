@@ -123,12 +123,12 @@ double MultiGrainDustMix::getOpticalProperties(const Array& lambdav, const Array
         if (!mupop)
             throw FATALERROR("Dust grain population of type " + population->composition()->name()
                              + " has zero dust mass");
-        _mupopv.push_back(mupop);
+        _extra->mupopv.push_back(mupop);
         mu += mupop;
 
         // remember the size distribution normalization factor for this population
         // and adjust the integration weight for further calculations
-        _normv.push_back(mupop / baremupop);
+        _extra->normv.push_back(mupop / baremupop);
         weightv *= mupop / baremupop;
 
         // open the stored tables for the basic optical properties
@@ -305,11 +305,11 @@ size_t MultiGrainDustMix::initializeExtraProperties(const Array& lambdav)
 {
     // determine which type(s) of emission we need to support
     auto config = find<Configuration>();
-    _multigrain = config->hasDustEmission();
-    _stochastic = config->hasStochasticDustEmission();
+    _extra->multigrain = config->hasDustEmission();
+    _extra->stochastic = config->hasStochasticDustEmission();
 
     // perform only if extra properties are required
-    if (_multigrain)
+    if (_extra->multigrain)
     {
         // get the number of wavelength grid points
         size_t numLambda = lambdav.size();
@@ -328,7 +328,7 @@ size_t MultiGrainDustMix::initializeExtraProperties(const Array& lambdav)
 
             // if applicable, open the enthalpy stored table for this population
             StoredTable<1> enthalpy;
-            if (_stochastic)
+            if (_extra->stochastic)
             {
                 string enthalpyName = population->composition()->resourceNameForEnthalpies();
                 enthalpy.open(this, enthalpyName, "T(K)", "h(J/m3)");
@@ -359,35 +359,41 @@ size_t MultiGrainDustMix::initializeExtraProperties(const Array& lambdav)
                         av[i] = pow(10, logamin + i * dloga);
                         dav[i] = av[i] * M_LN10 * dloga;
                         dndav[i] = population->sizeDistribution()->dnda(av[i]);
-                        weightv[i] = _normv[c];
+                        weightv[i] = _extra->normv[c];
                     }
                     weightv[0] *= 0.5;
                     weightv[numSizes - 1] *= 0.5;
                 }
 
-                // size-integrate the absorption cross sections for this bin
+                // size-integrate the absorption cross sections for this bin, unless they were loaded from the cache;
                 // this can take a few seconds for all populations/size bins combined,
                 // so we parallelize the loop but there is no reason to log progress
-                sigmaabsv = 0;  // clear array in case calculation is distributed over multiple processes
-                find<ParallelFactory>()->parallelDistributed()->call(
-                    numLambda,
-                    [&lambdav, &av, &dav, &dndav, &weightv, &Qabs, &sigmaabsv](size_t firstIndex, size_t numIndices) {
-                        size_t numSizes = av.size();
-                        for (size_t ell = firstIndex; ell != firstIndex + numIndices; ++ell)
-                        {
-                            double sum = 0.;
-                            for (size_t i = 0; i != numSizes; ++i)
+                if (static_cast<size_t>(b) < _extra->sigmaabsbvv.size())
+                    sigmaabsv = _extra->sigmaabsbvv[b];
+                else
+                {
+                    sigmaabsv = 0;  // clear array in case calculation is distributed over multiple processes
+                    find<ParallelFactory>()->parallelDistributed()->call(
+                        numLambda, [&lambdav, &av, &dav, &dndav, &weightv, &Qabs, &sigmaabsv](size_t firstIndex,
+                                                                                               size_t numIndices) {
+                            size_t numSizes = av.size();
+                            for (size_t ell = firstIndex; ell != firstIndex + numIndices; ++ell)
                             {
-                                double area = M_PI * av[i] * av[i];
-                                sum += weightv[i] * dndav[i] * area * Qabs(av[i], lambdav[ell]) * dav[i];
+                                double sum = 0.;
+                                for (size_t i = 0; i != numSizes; ++i)
+                                {
+                                    double area = M_PI * av[i] * av[i];
+                                    sum += weightv[i] * dndav[i] * area * Qabs(av[i], lambdav[ell]) * dav[i];
+                                }
+                                sigmaabsv[ell] = sum;
                             }
-                            sigmaabsv[ell] = sum;
-                        }
-                    });
-                ProcessManager::sumToAll(sigmaabsv);
+                        });
+                    ProcessManager::sumToAll(sigmaabsv);
+                    if (cachesProperties()) _extra->sigmaabsbvv.push_back(sigmaabsv);
+                }
 
                 // setup the appropriate emissivity calculator for this bin
-                if (_stochastic)
+                if (_extra->stochastic)
                 {
                     // calculate the mean grain mass for this bin
                     double sum1 = 0.;
@@ -405,11 +411,11 @@ size_t MultiGrainDustMix::initializeExtraProperties(const Array& lambdav)
                     string grainType = population->composition()->name();
 
                     // setup the calculator for this bin
-                    _calcSt.precalculate(this, lambdav, sigmaabsv, grainType, bulkDensity, meanMass, enthalpy);
+                    _extra->calcSt.precalculate(this, lambdav, sigmaabsv, grainType, bulkDensity, meanMass, enthalpy);
                 }
                 else
                 {
-                    _calcEq.precalculate(this, lambdav, sigmaabsv);
+                    _extra->calcEq.precalculate(this, lambdav, sigmaabsv);
                 }
 
                 // increment the running bin index
@@ -419,27 +425,122 @@ size_t MultiGrainDustMix::initializeExtraProperties(const Array& lambdav)
             // increment the population index
             c++;
         }
+
+        // release the cross sections loaded from the cache; if they are being stored in the cache, they are
+        // released by storeCachedProperties()
+        if (!cachesProperties()) _extra->sigmaabsbvv = vector<Array>();
+
+        // if requested, tabulate the equilibrium cutoffs for the stochastic calculation
+        if (_extra->stochastic && config->precalculateEquilibriumCutoffs())
+        {
+            find<Log>()->info(type() + " precalculating equilibrium cutoffs for stochastic emission...");
+            _extra->calcSt.precalculateEquilibriumCutoffs(this);
+        }
+
+        // if requested, tabulate the emissivity as a function of radiation field strength and hardness
+        double tolerance = config->emissivityTableTolerance();
+        if (tolerance > 0.)
+        {
+            find<Log>()->info(type() + " building emissivity table...");
+            _extra->table.build(
+                this, type(),
+                [this](const Array& Jv) {
+                    return _extra->stochastic ? _extra->calcSt.emissivity(Jv) : _extra->calcEq.emissivity(Jv);
+                },
+                tolerance, config->cacheEmissivityTable());
+        }
     }
 
     // determine the allocated number of bytes
     size_t allocatedBytes = 0;
     allocatedBytes += _populations.size() * sizeof(_populations[0]);
-    allocatedBytes += _mupopv.size() * sizeof(_mupopv[0]);
-    allocatedBytes += _normv.size() * sizeof(_normv[0]);
-    allocatedBytes += _calcEq.allocatedBytes();
-    allocatedBytes += _calcSt.allocatedBytes();
+    allocatedBytes += _extra->mupopv.size() * sizeof(_extra->mupopv[0]);
+    allocatedBytes += _extra->normv.size() * sizeof(_extra->normv[0]);
+    allocatedBytes += _extra->calcEq.allocatedBytes();
+    allocatedBytes += _extra->calcSt.allocatedBytes();
+    allocatedBytes += _extra->table.allocatedBytes();
     return allocatedBytes;
 }
 
 ////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<DustMix::ExtraProperties> MultiGrainDustMix::extraProperties() const
+{
+    return _extra;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MultiGrainDustMix::shareExtraProperties(std::shared_ptr<ExtraProperties> extra)
+{
+    _extra = std::static_pointer_cast<Extra>(extra);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MultiGrainDustMix::storeCachedProperties(vector<Array>& arrays)
+{
+    arrays.push_back(NR::array(_extra->mupopv));
+    arrays.push_back(NR::array(_extra->normv));
+    for (auto& sigmaabsv : _extra->sigmaabsbvv) arrays.push_back(std::move(sigmaabsv));
+    _extra->sigmaabsbvv = vector<Array>();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MultiGrainDustMix::restoreCachedProperties(vector<Array>& arrays)
+{
+    if (arrays.size() < 2) throw FATALERROR("Cached dust mix properties are incomplete");
+    _extra->mupopv.assign(begin(arrays[0]), end(arrays[0]));
+    _extra->normv.assign(begin(arrays[1]), end(arrays[1]));
+    _extra->sigmaabsbvv.clear();
+    for (size_t i = 2; i < arrays.size(); ++i) _extra->sigmaabsbvv.push_back(std::move(arrays[i]));
+}
+
+////////////////////////////////////////////////////////////////////
+
 Array MultiGrainDustMix::emissivity(const Array& Jv) const
 {
-    // use the appropriate emissivity calculator
-    if (_stochastic)
-        return _calcSt.emissivity(Jv);
+    // interpolate from the table if possible
+    Array ev;
+    if (_extra->table.interpolate(Jv, ev)) return ev;
+
+    // otherwise use the appropriate emissivity calculator
+    if (_extra->stochastic)
+        return _extra->calcSt.emissivity(Jv);
+    else
+        return _extra->calcEq.emissivity(Jv);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MultiGrainDustMix::emissivities(const Table<2>& Jvv, Table<2>& evv) const
+{
+    // interpolate from the table if possible, otherwise use the appropriate emissivity calculator
+    if (_extra->stochastic || _extra->table.isBuilt())
+    {
+        // reuse the input and output arrays across radiation fields
+        size_t numFields = Jvv.size(0);
+        size_t numWavelengths = Jvv.size(1);
+        Array Jv(numWavelengths);
+        Array ev;
+        for (size_t i = 0; i != numFields; ++i)
+        {
+            std::copy(begin(Jvv.data()) + i * numWavelengths, begin(Jvv.data()) + (i + 1) * numWavelengths,
+                      begin(Jv));
+            if (!_extra->table.interpolate(Jv, ev))
+            {
+                if (_extra->stochastic)
+                    _extra->calcSt.emissivity(Jv, ev);
+                else
+                    ev = _extra->calcEq.emissivity(Jv);
+            }
+            if (!i) evv.resize(numFields, ev.size());
+            std::copy(begin(ev), end(ev), begin(evv.data()) + i * ev.size());
+        }
+    }
     else
-        return _calcEq.emissivity(Jv);
+        _extra->calcEq.emissivities(Jvv, evv);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -475,7 +576,7 @@ const GrainSizeDistribution* MultiGrainDustMix::populationSizeDistribution(int c
 
 double MultiGrainDustMix::populationMass(int c) const
 {
-    return _mupopv[c];
+    return _extra->mupopv[c];
 }
 
 ////////////////////////////////////////////////////////////////////
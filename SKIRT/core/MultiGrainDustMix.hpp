@@ -7,6 +7,7 @@
 #define MULTIGRAINDUSTMIX_HPP
 
 #include "ArrayTable.hpp"
+#include "DustEmissivityTable.hpp"
 #include "DustMix.hpp"
 #include "GrainPopulation.hpp"
 #include "Range.hpp"
@@ -172,9 +173,29 @@ protected:
         Depending on the type of emission calculation configured by the user, this function creates
         an instance of the EquilibriumDustEmissionCalculator or StochasticDustEmissionCalculator to
         store the relevant properties (and to actually calculate the emission spectra when
-        requested). */
+        requested). If the configuration specifies a nonzero emissivity table tolerance, the
+        function also builds (or loads from the cache) a DustEmissivityTable for this dust mix. */
     size_t initializeExtraProperties(const Array& lambdav) override;
 
+    /** This function returns a pointer to the data structure holding the properties
+        precalculated by this class, so that they can be shared with identically configured dust
+        mix instances. */
+    std::shared_ptr<ExtraProperties> extraProperties() const override;
+
+    /** This function adopts the properties precalculated by an identically configured dust mix
+        instance. */
+    void shareExtraProperties(std::shared_ptr<ExtraProperties> extra) override;
+
+    /** This function appends the information needed by initializeExtraProperties() in addition to
+        the optical properties to the specified list of arrays, so that it can be stored in the
+        cache. This includes the dust mass and the size distribution normalization for each
+        population and, if dust emission is enabled, the size-integrated absorption cross sections
+        for each size bin. */
+    void storeCachedProperties(vector<Array>& arrays) override;
+
+    /** This function restores the information stored by the storeCachedProperties() function. */
+    void restoreCachedProperties(vector<Array>& arrays) override;
+
     //======== Emission =======
 
 public:
@@ -187,13 +208,23 @@ public:
 
         Depending on the type of emission calculation configured by the user, this function uses an
         instance of the EquilibriumDustEmissionCalculator or StochasticDustEmissionCalculator to to
-        calculate the emission spectrum. Refer to these classes for more information.
+        calculate the emission spectrum. Refer to these classes for more information. If an
+        emissivity table has been built during setup, the emission spectrum is interpolated from
+        that table instead, unless the radiation field lies outside of the tabulated range.
 
         The behavior of this function is undefined if the simulation does not track the radiation
         field, because in that case setup does not precalculate the information on which this
         function relies. */
     Array emissivity(const Array& Jv) const override;
 
+    /** This function returns the emissivity spectrum per hydrogen atom of the dust mix for each
+        of the radiation fields specified by the mean intensities in the table \em Jvv, as
+        described for the emissivity() function. For equilibrium emission, it uses the batched
+        calculation offered by the EquilibriumDustEmissionCalculator class. For stochastic
+        emission, or if an emissivity table has been built, it obtains the emissivity for each
+        radiation field in turn, reusing the same arrays across radiation fields. */
+    void emissivities(const Table<2>& Jvv, Table<2>& evv) const override;
+
     //=============== Exposing multiple grain populations ==============
 
 public:
@@ -227,15 +258,27 @@ private:
     // list created by addPopulation()
     vector<const GrainPopulation*> _populations;
 
-    // info per population -- initialized by getOpticalProperties()
-    vector<double> _mupopv;  // mass per hydrogen atom for population - indexed on c
-    vector<double> _normv;   // size distribution normalization for population - indexed on c
-
-    // multi-grain emission calculators -- initialized by initializeExtraProperties()
-    bool _multigrain{false};  // true if one of the calculators is intialized, false if not
-    bool _stochastic{false};  // true for stochastic; false for equilibrium
-    EquilibriumDustEmissionCalculator _calcEq;
-    StochasticDustEmissionCalculator _calcSt;
+    // precalculated information, which may be shared with other dust mix instances that have an identical
+    // configuration (see DustMix::extraProperties())
+    struct Extra : public ExtraProperties
+    {
+        // info per population -- initialized by getOpticalProperties()
+        vector<double> mupopv;  // mass per hydrogen atom for population - indexed on c
+        vector<double> normv;   // size distribution normalization for population - indexed on c
+
+        // size-integrated absorption cross sections per size bin, retained for or loaded from the cache
+        vector<Array> sigmaabsbvv;  // indexed on b and ell
+
+        // multi-grain emission calculators -- initialized by initializeExtraProperties()
+        bool multigrain{false};  // true if one of the calculators is intialized, false if not
+        bool stochastic{false};  // true for stochastic; false for equilibrium
+        EquilibriumDustEmissionCalculator calcEq;
+        StochasticDustEmissionCalculator calcSt;
+
+        // emissivity table -- initialized by initializeExtraProperties() if requested
+        DustEmissivityTable table;
+    };
+    std::shared_ptr<Extra> _extra{std::make_shared<Extra>()};
 };
 
 ////////////////////////////////////////////////////////////////////
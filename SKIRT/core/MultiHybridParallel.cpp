@@ -6,12 +6,13 @@
 #include "MultiHybridParallel.hpp"
 #include "FatalError.hpp"
 #include "ProcessManager.hpp"
+#include "TraceRecorder.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
-MultiHybridParallel::MultiHybridParallel(int threadCount)
+MultiHybridParallel::MultiHybridParallel(int threadCount, const vector<int>& cpus)
 {
-    constructThreads(threadCount);
+    constructThreads(threadCount, cpus);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -25,6 +26,8 @@ MultiHybridParallel::~MultiHybridParallel()
 
 void MultiHybridParallel::call(size_t maxIndex, std::function<void(size_t, size_t)> target)
 {
+    TraceRecorder::Scope scope("parallel", "call", 0, maxIndex);
+
     // Copy the target function so it can be invoked from the child threads
     _target = target;
 
@@ -138,6 +141,7 @@ bool MultiHybridParallel::doSomeWork()
         _conditionParent.notify_all();
 
         // Invoke the target function
+        TraceRecorder::Scope scope("parallel", "chunk", firstIndex, numIndices);
         _target(firstIndex, numIndices);
         return true;
     }
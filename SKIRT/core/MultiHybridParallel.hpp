@@ -31,9 +31,10 @@ private:
     /** Constructs a HybridParallel instance using the specified number of execution threads. The
         number of processes is retrieved from the ProcessManager. In each process, the specified
         number of child threads is created (and put on hold) so that the parent thread can be used
-        to communicate with the other processes. This constructor is private; use the
-        ParallelFactory::parallel() function instead. */
-    explicit MultiHybridParallel(int threadCount);
+        to communicate with the other processes. If the list of logical processor indices is
+        nonempty, the child threads are pinned to these processors. This constructor is private;
+        use the ParallelFactory::parallel() function instead. */
+    MultiHybridParallel(int threadCount, const vector<int>& cpus);
 
 public:
     /** Destructs the instance and its parallel child threads. */
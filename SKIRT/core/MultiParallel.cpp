@@ -5,13 +5,15 @@
 
 #include "MultiParallel.hpp"
 #include "FatalError.hpp"
+#include "System.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
-void MultiParallel::constructThreads(int numThreads)
+void MultiParallel::constructThreads(int numThreads, const vector<int>& cpus)
 {
-    // Remember the number of threads
+    // Remember the number of threads and the processor placement
     _numThreads = numThreads;
+    _cpus = cpus;
 
     // Launch the child threads in a critical section
     {
@@ -74,6 +76,9 @@ void MultiParallel::waitForThreads()
 
 void MultiParallel::run(int threadIndex)
 {
+    // Pin this thread to its logical processor, if requested
+    if (!_cpus.empty()) System::pinCurrentThread(_cpus[threadIndex % _cpus.size()]);
+
     while (true)
     {
         // Wait for new work in a critical section
@@ -39,8 +39,11 @@ class MultiParallel : public Parallel
 
 protected:
     /** This function constructs the specified number of parallel child threads (not including the
-        parent thread) and waits for them to become ready (in the inactive state). */
-    void constructThreads(int numThreads);
+        parent thread) and waits for them to become ready (in the inactive state). If the optional
+        list of logical processor indices is nonempty, each child thread pins itself to the
+        processor at the corresponding index in the list (wrapping around if needed) before
+        becoming ready. */
+    void constructThreads(int numThreads, const vector<int>& cpus = vector<int>());
 
     /** This function destructs the child threads constucted with the constructThreads() function.
         */
@@ -83,6 +86,7 @@ private:
     // the threads
     int _numThreads{0};                 // the number of child threads (not including the parent thread)
     std::vector<std::thread> _threads;  // the child threads
+    vector<int> _cpus;                  // the logical processor for each child thread, or empty if not pinned
 
     // synchronization
     std::mutex _mutex;                           // the mutex to synchronize the threads
@@ -4,12 +4,13 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "MultiThreadParallel.hpp"
+#include "TraceRecorder.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
-MultiThreadParallel::MultiThreadParallel(int threadCount)
+MultiThreadParallel::MultiThreadParallel(int threadCount, const vector<int>& cpus)
 {
-    constructThreads(threadCount);
+    constructThreads(threadCount, cpus);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -23,6 +24,8 @@ MultiThreadParallel::~MultiThreadParallel()
 
 void MultiThreadParallel::call(size_t maxIndex, std::function<void(size_t, size_t)> target)
 {
+    TraceRecorder::Scope scope("parallel", "call", 0, maxIndex);
+
     // Copy the target function so it can be invoked from any of the threads
     _target = target;
 
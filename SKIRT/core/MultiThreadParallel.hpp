@@ -21,8 +21,10 @@ class MultiThreadParallel : public MultiParallel
 
 private:
     /** Constructs a MultiThreadParallel instance with the specified number of execution threads.
-        The constructor is private; use the ParallelFactory::parallel() function instead. */
-    explicit MultiThreadParallel(int threadCount);
+        If the list of logical processor indices is nonempty, the threads are pinned to these
+        processors. The constructor is private; use the ParallelFactory::parallel() function
+        instead. */
+    MultiThreadParallel(int threadCount, const vector<int>& cpus);
 
 public:
     /** Destructs the instance and its parallel threads. */
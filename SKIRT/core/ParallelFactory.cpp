@@ -10,6 +10,7 @@
 #include "NullParallel.hpp"
 #include "ProcessManager.hpp"
 #include "SerialParallel.hpp"
+#include "System.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -52,6 +53,93 @@ int ParallelFactory::defaultThreadCount()
 
 ////////////////////////////////////////////////////////////////////
 
+void ParallelFactory::setThreadPlacement(ThreadPlacement value)
+{
+    _threadPlacement = value;
+}
+
+////////////////////////////////////////////////////////////////////
+
+ParallelFactory::ThreadPlacement ParallelFactory::threadPlacement() const
+{
+    return _threadPlacement;
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<int> ParallelFactory::threadProcessors(int numThreads) const
+{
+    vector<int> cpus;
+    if (_threadPlacement == ThreadPlacement::None) return cpus;
+
+    auto nodes = System::processorTopology();
+    if (nodes.empty()) return cpus;
+
+    switch (_threadPlacement)
+    {
+        case ThreadPlacement::None: break;
+        case ThreadPlacement::Compact:
+        {
+            // fill each node before moving on to the next one, wrapping around if there are too many threads
+            vector<int> all;
+            for (const auto& node : nodes) all.insert(all.end(), node.begin(), node.end());
+            for (int t = 0; t != numThreads; ++t) cpus.push_back(all[t % all.size()]);
+            break;
+        }
+        case ThreadPlacement::Scatter:
+        {
+            // distribute threads round-robin over the nodes, wrapping around within each node if needed
+            int numNodes = nodes.size();
+            for (int t = 0; t != numThreads; ++t)
+            {
+                const auto& node = nodes[t % numNodes];
+                cpus.push_back(node[(t / numNodes) % node.size()]);
+            }
+            break;
+        }
+    }
+    return cpus;
+}
+
+////////////////////////////////////////////////////////////////////
+
+string ParallelFactory::threadPlacementInfo() const
+{
+    if (_threadPlacement == ThreadPlacement::None) return "Threads are not pinned to specific processors";
+
+    auto nodes = System::processorTopology();
+    auto cpus = threadProcessors(_maxThreadCount);
+    if (cpus.empty()) return "Thread pinning is not supported on this system; threads are not pinned";
+
+    // count the number of threads pinned to each node
+    vector<int> counts(nodes.size());
+    for (int cpu : cpus)
+        for (size_t n = 0; n != nodes.size(); ++n)
+            if (std::find(nodes[n].begin(), nodes[n].end(), cpu) != nodes[n].end()) counts[n]++;
+
+    string info = "Threads pinned using ";
+    info += _threadPlacement == ThreadPlacement::Compact ? "compact" : "scatter";
+    info += " placement over " + std::to_string(nodes.size()) + " NUMA node" + (nodes.size() > 1 ? "s" : "") + ":";
+    for (size_t n = 0; n != nodes.size(); ++n)
+    {
+        info += (n ? ", " : " ") + std::to_string(counts[n]) + " on node " + std::to_string(n) + " ("
+                + std::to_string(nodes[n].size()) + " processor" + (nodes[n].size() > 1 ? "s" : "") + ")";
+    }
+    return info;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool ParallelFactory::hasRestrictedProcessorSet()
+{
+    size_t numAllowed = 0;
+    for (const auto& node : System::processorTopology()) numAllowed += node.size();
+    size_t numOnline = System::processorCount();
+    return numAllowed > 0 && numAllowed < numOnline;
+}
+
+////////////////////////////////////////////////////////////////////
+
 Parallel* ParallelFactory::parallel(TaskMode mode, int maxThreadCount)
 {
     // Verify that we're being called from our parent thread
@@ -81,9 +169,13 @@ Parallel* ParallelFactory::parallel(TaskMode mode, int maxThreadCount)
         {
             case ParallelType::Null: child.reset(new NullParallel(numThreads)); break;
             case ParallelType::Serial: child.reset(new SerialParallel(numThreads)); break;
-            case ParallelType::MultiThread: child.reset(new MultiThreadParallel(numThreads)); break;
-            case ParallelType::MultiProcess: child.reset(new MultiHybridParallel(1)); break;
-            case ParallelType::MultiHybrid: child.reset(new MultiHybridParallel(numThreads)); break;
+            case ParallelType::MultiThread:
+                child.reset(new MultiThreadParallel(numThreads, threadProcessors(numThreads)));
+                break;
+            case ParallelType::MultiProcess: child.reset(new MultiHybridParallel(1, threadProcessors(1))); break;
+            case ParallelType::MultiHybrid:
+                child.reset(new MultiHybridParallel(numThreads, threadProcessors(numThreads)));
+                break;
         }
     }
     return child.get();
@@ -30,13 +30,14 @@ class Parallel;
     have a single ParallelFactory instance per simulation, and to use yet another ParallelFactory
     instance to run multiple simulations at the same time.
 
-    ParallelFactory clients can request a Parallel instance for one of the two task allocation
+    ParallelFactory clients can request a Parallel instance for one of the three task allocation
     modes described in the table below.
 
     Task mode | Description
     ----------|------------
     Distributed | All threads in all processes perform the tasks in parallel
     RootOnly | All threads in the root process perform the tasks in parallel; the other processes ignore the tasks
+    ProcessOnly | All threads in the current process perform the tasks in parallel, isolated from any other processes
 
     In support of these task modes, the Parallel class has several subclasses, each implementing
     a specific parallelization scheme as described in the table below.
@@ -57,7 +58,24 @@ class Parallel;
     -------------|-------|-------|-------|-------|
     Distributed  |  S    |  MT   |  MP   |  MTP  |
     RootOnly     |  S    |  MT   |  S/0  |  MT/0 |
+    ProcessOnly  |  S    |  MT   |  S    |  MT   |
 
+    A factory object can also be configured to pin the parallel child threads of its children to
+    specific logical processors, according to one of the thread placement policies described in
+    the table below. The placement is based on the processors available to the current process, as
+    reported by the operating system, grouped per NUMA node (memory domain). Pinning is supported
+    only on Linux; on other systems the placement policy is ignored. The parent thread of a
+    Parallel instance is never pinned because it is used only for coordination and communication.
+
+    Placement | Description
+    ----------|------------
+    None | Threads are not pinned; the operating system decides where they run (the default)
+    Compact | Threads fill the processors of the first NUMA node before moving on to the next node
+    Scatter | Threads are distributed round-robin over the NUMA nodes
+
+    In combination with thread pinning, large data structures can be initialized in parallel so
+    that their memory pages are allocated in the memory domain of the threads that will access them
+    (first-touch placement); see the FirstTouch namespace.
 */
 class ParallelFactory : public SimulationItem
 {
@@ -94,9 +112,41 @@ public:
         performance). */
     static int defaultThreadCount();
 
+    /** This enumeration includes a constant for each thread placement policy supported by
+        ParallelFactory. */
+    enum class ThreadPlacement { None, Compact, Scatter };
+
+    /** Sets the thread placement policy for the child threads of Parallel objects manufactured by
+        this factory object. The policy should not be changed after any children have been
+        requested. */
+    void setThreadPlacement(ThreadPlacement value);
+
+    /** Returns the thread placement policy for the child threads of Parallel objects manufactured
+        by this factory object. */
+    ThreadPlacement threadPlacement() const;
+
+    /** Returns a human-readable description of the thread placement for Parallel objects
+        manufactured by this factory object with the maximum number of threads, listing the number
+        of threads pinned to each NUMA node. */
+    string threadPlacementInfo() const;
+
+    /** Returns true if the set of logical processors on which the current process is allowed to
+        run is a proper subset of the processors on the computer, and false if the process may run
+        on all processors or if this cannot be determined. When multiple processes on the same
+        computer are not restricted to disjoint processor sets (e.g., by the MPI launcher), their
+        threads are pinned to the same processors by the thread placement policies. */
+    static bool hasRestrictedProcessorSet();
+
+private:
+    /** Returns the list of logical processor indices to which the child threads of a Parallel
+        object with the specified number of threads should be pinned, in order of thread index, or
+        the empty list if threads should not be pinned. */
+    vector<int> threadProcessors(int numThreads) const;
+
+public:
     /** This enumeration includes a constant for each task allocation mode supported by ParallelFactory
      * and the Parallel subclasses. */
-    enum class TaskMode { Distributed, RootOnly };
+    enum class TaskMode { Distributed, RootOnly, ProcessOnly };
 
     /** This function returns a Parallel subclass instance of the appropriate type and with an
         appropriate number of execution threads, depending on the requested task allocation mode,
@@ -115,12 +165,21 @@ public:
     /** This function calls the parallel() function for the RootOnly task allocation mode. */
     Parallel* parallelRootOnly(int maxThreadCount = 0) { return parallel(TaskMode::RootOnly, maxThreadCount); }
 
+    /** This function calls the parallel() function for the ProcessOnly task allocation mode. */
+    Parallel* parallelProcessOnly(int maxThreadCount = 0)
+    {
+        return parallel(TaskMode::ProcessOnly, maxThreadCount);
+    }
+
     //======================== Data Members ========================
 
 private:
     // The maximum thread count for the factory, initialized to the default maximum number of threads
     int _maxThreadCount{defaultThreadCount()};
 
+    // The thread placement policy for the child threads, initialized to no pinning
+    ThreadPlacement _threadPlacement{ThreadPlacement::None};
+
     // The thread that invoked our constructor, initialized - obviously - upon construction
     std::thread::id _parentThread{std::this_thread::get_id()};
 
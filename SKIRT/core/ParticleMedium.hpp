@@ -31,6 +31,13 @@
     The first three columns are the \f$x\f$, \f$y\f$ and \f$z\f$ coordinates of the particle, the
     fourth column is the particle smoothing length \f$h\f$.
 
+    If the \em clipToDomain option is enabled, particles of which the smoothing kernel does not
+    overlap the cuboidal domain specified by the \em minX, \em maxX, \em minY, \em maxY, \em
+    minZ and \em maxZ options are ignored while the input file is being read. This is useful for
+    importing a small portion of a large snapshot, because the memory required during the import
+    then reflects the retained particles rather than the size of the input file. Note that the
+    mass of the ignored particles is simply removed from the model.
+
     The fifth column is the mass \f$M\f$ of the particle, which is multiplied by the value of the
     \em massFraction option. If the \em importMetallicity option is enabled, the next column
     specifies a "metallicity" fraction, which is multiplied with the mass column to obtain the
@@ -63,15 +70,43 @@ class ParticleMedium : public ImportedMedium
         ATTRIBUTE_DEFAULT_VALUE(smoothingKernel, "CubicSplineSmoothingKernel")
         ATTRIBUTE_DISPLAYED_IF(smoothingKernel, "Level2")
 
+        PROPERTY_BOOL(clipToDomain, "ignore particles that do not overlap a given cuboidal domain")
+        ATTRIBUTE_DEFAULT_VALUE(clipToDomain, "false")
+        ATTRIBUTE_DISPLAYED_IF(clipToDomain, "Level3")
+
+        PROPERTY_DOUBLE(minX, "the start point of the domain in the X direction")
+        ATTRIBUTE_QUANTITY(minX, "length")
+        ATTRIBUTE_RELEVANT_IF(minX, "clipToDomain")
+
+        PROPERTY_DOUBLE(maxX, "the end point of the domain in the X direction")
+        ATTRIBUTE_QUANTITY(maxX, "length")
+        ATTRIBUTE_RELEVANT_IF(maxX, "clipToDomain")
+
+        PROPERTY_DOUBLE(minY, "the start point of the domain in the Y direction")
+        ATTRIBUTE_QUANTITY(minY, "length")
+        ATTRIBUTE_RELEVANT_IF(minY, "clipToDomain")
+
+        PROPERTY_DOUBLE(maxY, "the end point of the domain in the Y direction")
+        ATTRIBUTE_QUANTITY(maxY, "length")
+        ATTRIBUTE_RELEVANT_IF(maxY, "clipToDomain")
+
+        PROPERTY_DOUBLE(minZ, "the start point of the domain in the Z direction")
+        ATTRIBUTE_QUANTITY(minZ, "length")
+        ATTRIBUTE_RELEVANT_IF(minZ, "clipToDomain")
+
+        PROPERTY_DOUBLE(maxZ, "the end point of the domain in the Z direction")
+        ATTRIBUTE_QUANTITY(maxZ, "length")
+        ATTRIBUTE_RELEVANT_IF(maxZ, "clipToDomain")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
 
 protected:
     /** This function constructs a new ParticleSnapshot object, calls its open() function,
-        configures it to import a mass column, passes the smoothing kernel selected by the user to
-        it, and finally returns a pointer to the object. Ownership of the Snapshot object is
-        transferred to the caller. */
+        configures it to import a mass column, passes the smoothing kernel and, if applicable, the
+        clipping domain selected by the user to it, and finally returns a pointer to the object.
+        Ownership of the Snapshot object is transferred to the caller. */
     Snapshot* createAndOpenSnapshot() override;
 };
 
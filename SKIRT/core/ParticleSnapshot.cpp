@@ -7,6 +7,7 @@
 #include "Log.hpp"
 #include "NR.hpp"
 #include "Random.hpp"
+#include "SmoothedParticle.hpp"
 #include "SmoothedParticleGrid.hpp"
 #include "SmoothingKernel.hpp"
 #include "StringUtils.hpp"
@@ -15,6 +16,26 @@
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // number of bins in the tabulated cumulative distribution of the projected smoothing kernel
+    const int numKernelBins = 200;
+
+    // number of integration steps for calculating the projected smoothing kernel in each bin
+    const int numKernelSteps = 100;
+
+    // returns true if the sphere with the specified center and radius overlaps the specified box
+    bool overlaps(const Box& box, double x, double y, double z, double h)
+    {
+        double dx = x - max(box.xmin(), min(x, box.xmax()));
+        double dy = y - max(box.ymin(), min(y, box.ymax()));
+        double dz = z - max(box.zmin(), min(z, box.zmax()));
+        return dx * dx + dy * dy + dz * dz < h * h;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 ParticleSnapshot::~ParticleSnapshot()
 {
     delete _grid;
@@ -25,35 +46,43 @@ ParticleSnapshot::~ParticleSnapshot()
 void ParticleSnapshot::readAndClose()
 {
     // read the particle info into memory
+    // if the user configured a clip box, we skip particles that do not overlap it
     // if the user configured a temperature cutoff, we skip high-temperature particles
     // if the user configured a mass-density policy, we skip zero-mass particles
+    int numOutsideIgnored = 0;
     int numTempIgnored = 0;
     int numMassIgnored = 0;
     Array row;
     while (infile()->readRow(row))
     {
-        if (useTemperatureCutoff() && row[temperatureIndex()] > maxTemperature())
+        if (_hasClipBox
+            && !overlaps(_clipBox, row[positionIndex() + 0], row[positionIndex() + 1], row[positionIndex() + 2],
+                         row[sizeIndex()]))
+            numOutsideIgnored++;
+        else if (useTemperatureCutoff() && row[temperatureIndex()] > maxTemperature())
             numTempIgnored++;
         else if (hasMassDensityPolicy() && row[massIndex()] == 0)
             numMassIgnored++;
         else
-            _propv.push_back(row);
+            storeProperties(row);
     }
 
     // close the file
     Snapshot::readAndClose();
 
     // log the number of particles
-    if (!numTempIgnored && !numMassIgnored)
+    if (!numOutsideIgnored && !numTempIgnored && !numMassIgnored)
     {
-        log()->info("  Number of particles: " + std::to_string(_propv.size()));
+        log()->info("  Number of particles: " + std::to_string(numStoredEntities()));
     }
     else
     {
+        if (numOutsideIgnored)
+            log()->info("  Number of particles outside domain ignored: " + std::to_string(numOutsideIgnored));
         if (numTempIgnored)
             log()->info("  Number of high-temperature particles ignored: " + std::to_string(numTempIgnored));
         if (numMassIgnored) log()->info("  Number of zero-mass particles ignored: " + std::to_string(numMassIgnored));
-        log()->info("  Number of particles retained: " + std::to_string(_propv.size()));
+        log()->info("  Number of particles retained: " + std::to_string(numStoredEntities()));
     }
 
     // we can calculate mass and densities only if a policy has been set
@@ -63,18 +92,17 @@ void ParticleSnapshot::readAndClose()
     double totalOriginalMass = 0;
     double totalMetallicMass = 0;
     double totalEffectiveMass = 0;
-    int numParticles = _propv.size();
-    _pv.reserve(numParticles);
+    int numParticles = numStoredEntities();
+    vector<SmoothedParticle> pv;
+    pv.reserve(numParticles);
     for (int m = 0; m != numParticles; ++m)
     {
-        const Array& prop = _propv[m];
-
-        double originalMass = prop[massIndex()];
-        double metallicMass = originalMass * (useMetallicity() ? prop[metallicityIndex()] : 1.);
+        double originalMass = storedProperty(m, massIndex());
+        double metallicMass = originalMass * (useMetallicity() ? storedProperty(m, metallicityIndex()) : 1.);
         double effectiveMass = metallicMass * multiplier();
 
-        _pv.emplace_back(m, prop[positionIndex() + 0], prop[positionIndex() + 1], prop[positionIndex() + 2],
-                         prop[sizeIndex()], effectiveMass);
+        pv.emplace_back(m, storedProperty(m, positionIndex() + 0), storedProperty(m, positionIndex() + 1),
+                        storedProperty(m, positionIndex() + 2), storedProperty(m, sizeIndex()), effectiveMass);
 
         totalOriginalMass += originalMass;
         totalMetallicMass += metallicMass;
@@ -94,29 +122,53 @@ void ParticleSnapshot::readAndClose()
     if (totalOriginalMass < 0 || totalMetallicMass < 0 || totalEffectiveMass < 0)
     {
         log()->warning("  Total imported mass is negative; suppressing the complete mass distribution");
-        _propv.clear();
-        _pv.clear();
+        clearStoredProperties();
         return;  // abort
     }
 
     // remember the effective mass
     _mass = totalEffectiveMass;
 
+    // release the imported properties that are now held by the particle objects or are no longer needed
+    releaseStoredProperties(positionIndex(), 3);
+    releaseStoredProperties(sizeIndex());
+    releaseStoredProperties(massIndex());
+    releaseStoredProperties(metallicityIndex());
+
     // if there are no particles, do not build the special structures for optimizing operations
-    if (_pv.empty()) return;
+    if (pv.empty()) return;
 
-    // construct a 3D-grid over the particle space, and create a list of particles that overlap each grid cell
-    int gridsize = max(20, static_cast<int>(pow(_pv.size(), 1. / 3.) / 5));
+    // construct an adaptive 3D-grid over the particle space, and create a list of particles that overlap each cell;
+    // the grid holds its own copy of the particle properties, so we can release the particle objects afterwards
+    int gridsize = max(20, static_cast<int>(pow(pv.size(), 1. / 3.) / 5));
     string size = std::to_string(gridsize);
-    log()->info("Constructing intermediate " + size + "x" + size + "x" + size + " grid for particles...");
-    _grid = new SmoothedParticleGrid(_pv, gridsize);
+    log()->info("Constructing intermediate " + size + "x" + size + "x" + size + " adaptive grid for particles...");
+    _grid = new SmoothedParticleGrid(pv, gridsize);
+    vector<SmoothedParticle>().swap(pv);
+    log()->info("  Number of cells after adaptive subdivision: " + std::to_string(_grid->numCells()));
     log()->info("  Smallest number of particles per cell: " + std::to_string(_grid->minParticlesPerCell()));
     log()->info("  Largest  number of particles per cell: " + std::to_string(_grid->maxParticlesPerCell()));
     log()->info("  Average  number of particles per cell: "
-                + StringUtils::toString(_grid->totalParticles() / double(gridsize * gridsize * gridsize), 'f', 1));
+                + StringUtils::toString(_grid->totalParticles() / double(_grid->numCells()), 'f', 1));
 
     // construct a vector with the normalized cumulative particle densities
-    NR::cdf(_cumrhov, _pv.size(), [this](int i) { return _pv[i].mass(); });
+    NR::cdf(_cumrhov, _grid->numParticles(), [this](int i) { return _grid->mass(i); });
+
+    // construct a vector with the normalized cumulative distribution of the smoothing kernel projected on
+    // a coordinate axis, over a regular grid on the normalized coordinate range [-1,1]; the projected
+    // kernel at normalized coordinate x is proportional to the integral of u W(u) du from |x| to 1
+    Array projv(numKernelBins);
+    for (int k = 0; k != numKernelBins; ++k)
+    {
+        double x = std::abs(-1. + (k + 0.5) * 2. / numKernelBins);
+        double du = (1. - x) / numKernelSteps;
+        for (int i = 0; i != numKernelSteps; ++i)
+        {
+            double u = x + (i + 0.5) * du;
+            projv[k] += u * _kernel->density(u) * du;
+        }
+    }
+    NR::cdf(_cumkernelv, numKernelBins, [&projv](int k) { return projv[k]; });
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -128,10 +180,18 @@ void ParticleSnapshot::setSmoothingKernel(const SmoothingKernel* kernel)
 
 ////////////////////////////////////////////////////////////////////
 
+void ParticleSnapshot::setClipBox(const Box& box)
+{
+    _hasClipBox = true;
+    _clipBox = box;
+}
+
+////////////////////////////////////////////////////////////////////
+
 Box ParticleSnapshot::extent() const
 {
     // if there are no particles, return an empty box
-    if (_propv.empty()) return Box();
+    if (!numStoredEntities()) return Box();
 
     // if there is a particle grid, ask it to return the extent (it is already calculated)
     if (_grid) return _grid->extent();
@@ -143,14 +203,17 @@ Box ParticleSnapshot::extent() const
     double ymax = -std::numeric_limits<double>::infinity();
     double zmin = +std::numeric_limits<double>::infinity();
     double zmax = -std::numeric_limits<double>::infinity();
-    for (const Array& prop : _propv)
+    int numParticles = numStoredEntities();
+    for (int m = 0; m != numParticles; ++m)
     {
-        xmin = min(xmin, prop[positionIndex() + 0] - prop[sizeIndex()]);
-        xmax = max(xmax, prop[positionIndex() + 0] + prop[sizeIndex()]);
-        ymin = min(ymin, prop[positionIndex() + 1] - prop[sizeIndex()]);
-        ymax = max(ymax, prop[positionIndex() + 1] + prop[sizeIndex()]);
-        zmin = min(zmin, prop[positionIndex() + 2] - prop[sizeIndex()]);
-        zmax = max(zmax, prop[positionIndex() + 2] + prop[sizeIndex()]);
+        Vec rc = position(m);
+        double h = storedProperty(m, sizeIndex());
+        xmin = min(xmin, rc.x() - h);
+        xmax = max(xmax, rc.x() + h);
+        ymin = min(ymin, rc.y() - h);
+        ymax = max(ymax, rc.y() + h);
+        zmin = min(zmin, rc.z() - h);
+        zmax = max(zmax, rc.z() + h);
     }
     return Box(xmin, ymin, zmin, xmax, ymax, zmax);
 }
@@ -159,75 +222,78 @@ Box ParticleSnapshot::extent() const
 
 int ParticleSnapshot::numEntities() const
 {
-    return _propv.size();
+    return numStoredEntities();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position ParticleSnapshot::position(int m) const
 {
-    return Position(_propv[m][positionIndex() + 0], _propv[m][positionIndex() + 1], _propv[m][positionIndex() + 2]);
+    if (_grid) return Position(_grid->center(m));
+    return Position(storedProperty(m, positionIndex() + 0), storedProperty(m, positionIndex() + 1),
+                    storedProperty(m, positionIndex() + 2));
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double ParticleSnapshot::temperature(int m) const
 {
-    return _propv[m][temperatureIndex()];
+    return storedProperty(m, temperatureIndex());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double ParticleSnapshot::temperature(Position bfr) const
 {
-    const SmoothedParticle* nearestParticle = _grid ? _grid->nearestParticle(bfr) : nullptr;
-    return nearestParticle ? temperature(nearestParticle->index()) : 0.;
+    int nearestParticle = _grid ? _grid->nearestParticle(bfr) : -1;
+    return nearestParticle >= 0 ? temperature(nearestParticle) : 0.;
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Vec ParticleSnapshot::velocity(int m) const
 {
-    return Vec(_propv[m][velocityIndex() + 0], _propv[m][velocityIndex() + 1], _propv[m][velocityIndex() + 2]);
+    return Vec(storedProperty(m, velocityIndex() + 0), storedProperty(m, velocityIndex() + 1),
+               storedProperty(m, velocityIndex() + 2));
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Vec ParticleSnapshot::velocity(Position bfr) const
 {
-    const SmoothedParticle* nearestParticle = _grid ? _grid->nearestParticle(bfr) : nullptr;
-    return nearestParticle ? velocity(nearestParticle->index()) : Vec();
+    int nearestParticle = _grid ? _grid->nearestParticle(bfr) : -1;
+    return nearestParticle >= 0 ? velocity(nearestParticle) : Vec();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double ParticleSnapshot::velocityDispersion(int m) const
 {
-    return _propv[m][velocityDispersionIndex()];
+    return storedProperty(m, velocityDispersionIndex());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double ParticleSnapshot::velocityDispersion(Position bfr) const
 {
-    const SmoothedParticle* nearestParticle = _grid ? _grid->nearestParticle(bfr) : nullptr;
-    return nearestParticle ? velocityDispersion(nearestParticle->index()) : 0.;
+    int nearestParticle = _grid ? _grid->nearestParticle(bfr) : -1;
+    return nearestParticle >= 0 ? velocityDispersion(nearestParticle) : 0.;
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Vec ParticleSnapshot::magneticField(int m) const
 {
-    return Vec(_propv[m][magneticFieldIndex() + 0], _propv[m][magneticFieldIndex() + 1],
-               _propv[m][magneticFieldIndex() + 2]);
+    return Vec(storedProperty(m, magneticFieldIndex() + 0), storedProperty(m, magneticFieldIndex() + 1),
+               storedProperty(m, magneticFieldIndex() + 2));
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Vec ParticleSnapshot::magneticField(Position bfr) const
 {
-    const SmoothedParticle* nearestParticle = _grid ? _grid->nearestParticle(bfr) : nullptr;
-    return nearestParticle ? magneticField(nearestParticle->index()) : Vec();
+    int nearestParticle = _grid ? _grid->nearestParticle(bfr) : -1;
+    return nearestParticle >= 0 ? magneticField(nearestParticle) : Vec();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -236,16 +302,16 @@ void ParticleSnapshot::parameters(int m, Array& params) const
 {
     int n = numParameters();
     params.resize(n);
-    for (int i = 0; i != n; ++i) params[i] = _propv[m][parametersIndex() + i];
+    for (int i = 0; i != n; ++i) params[i] = storedProperty(m, parametersIndex() + i);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void ParticleSnapshot::parameters(Position bfr, Array& params) const
 {
-    const SmoothedParticle* nearestParticle = _grid ? _grid->nearestParticle(bfr) : nullptr;
-    if (nearestParticle)
-        parameters(nearestParticle->index(), params);
+    int nearestParticle = _grid ? _grid->nearestParticle(bfr) : -1;
+    if (nearestParticle >= 0)
+        parameters(nearestParticle, params);
     else
         params.resize(numParameters());
 }
@@ -256,12 +322,7 @@ double ParticleSnapshot::density(Position bfr) const
 {
     double sum = 0.;
     if (_grid)
-        for (const SmoothedParticle* p : _grid->particlesFor(bfr))
-        {
-            double h = p->radius();
-            double u = (bfr - p->center()).norm() / h;
-            sum += _kernel->density(u) * p->mass() / (h * h * h);
-        }
+        sum = _grid->density(bfr, [this](int n, const double* uv, double* Wv) { _kernel->densities(n, uv, Wv); });
     return sum > 0. ? sum : 0.;  // guard against negative densities
 }
 
@@ -274,11 +335,55 @@ double ParticleSnapshot::mass() const
 
 ////////////////////////////////////////////////////////////////////
 
+bool ParticleSnapshot::hasMassInBox() const
+{
+    return hasMassDensityPolicy();
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // returns the fraction of the projected smoothing kernel inside the normalized coordinate range [x1,x2],
+    // interpolating linearly in the specified cumulative distribution tabulated over the range [-1,1]
+    double kernelFraction(const Array& cumkernelv, double x1, double x2)
+    {
+        auto cumulative = [&cumkernelv](double x) {
+            if (x <= -1.) return 0.;
+            if (x >= 1.) return 1.;
+            int n = cumkernelv.size() - 1;
+            double t = 0.5 * (x + 1.) * n;
+            int k = min(static_cast<int>(t), n - 1);
+            return cumkernelv[k] + (t - k) * (cumkernelv[k + 1] - cumkernelv[k]);
+        };
+        return cumulative(x2) - cumulative(x1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+double ParticleSnapshot::massInBox(const Box& box) const
+{
+    double sum = 0.;
+    if (_grid)
+        _grid->visitParticlesFor(box, [this, &box, &sum](int m) {
+            double h = _grid->radius(m);
+            Vec rc = _grid->center(m);
+            double fx = kernelFraction(_cumkernelv, (box.xmin() - rc.x()) / h, (box.xmax() - rc.x()) / h);
+            double fy = kernelFraction(_cumkernelv, (box.ymin() - rc.y()) / h, (box.ymax() - rc.y()) / h);
+            double fz = kernelFraction(_cumkernelv, (box.zmin() - rc.z()) / h, (box.zmax() - rc.z()) / h);
+            sum += _grid->mass(m) * fx * fy * fz;
+        });
+    return sum > 0. ? sum : 0.;  // guard against negative masses
+}
+
+////////////////////////////////////////////////////////////////////
+
 Position ParticleSnapshot::generatePosition(int m) const
 {
     // get center position and size for this particle
-    Position rc(_propv[m][positionIndex() + 0], _propv[m][positionIndex() + 1], _propv[m][positionIndex() + 2]);
-    double h = _propv[m][sizeIndex()];
+    Position rc = position(m);
+    double h = _grid ? _grid->radius(m) : storedProperty(m, sizeIndex());
 
     // sample random position inside the smoothed unit volume
     double u = _kernel->generateRadius();
@@ -292,7 +397,7 @@ Position ParticleSnapshot::generatePosition(int m) const
 Position ParticleSnapshot::generatePosition() const
 {
     // if there are no particles, return the origin
-    if (_propv.empty()) return Position();
+    if (!numStoredEntities()) return Position();
 
     // select a particle according to its mass contribution
     int m = NR::locateClip(_cumrhov, random()->uniform());
@@ -7,7 +7,6 @@
 #define PARTICLESNAPSHOT_HPP
 
 #include "Array.hpp"
-#include "SmoothedParticle.hpp"
 #include "Snapshot.hpp"
 class SmoothedParticleGrid;
 class SmoothingKernel;
@@ -52,6 +51,13 @@ public:
         smoothing kernel results in undefined behavior. */
     void setSmoothingKernel(const SmoothingKernel* kernel);
 
+    /** This function sets a spatial domain to which the import is restricted. Particles of which the
+        smoothing kernel (assumed to have finite support) does not overlap the specified box are
+        ignored while reading the input file, so that they are never stored. This function is
+        optional and must be called during configuration, after importSize() has been called. By
+        default, all particles are imported regardless of their position. */
+    void setClipBox(const Box& box);
+
     //=========== Interrogation ==========
 
 public:
@@ -141,19 +147,34 @@ public:
         behavior is undefined. */
     Position generatePosition() const override;
 
+    /** This function returns true if a density policy has been set, indicating that the particles
+        have been organized in a spatial grid that can be used to calculate the mass inside a box.
+        */
+    bool hasMassInBox() const override;
+
+    /** This function returns the mass represented by the snapshot inside the specified box. It
+        uses the smart particle grid to visit only the particles that may overlap the box. Each
+        particle contributes its mass multiplied by the fraction of its smoothing kernel inside the
+        box. That fraction is approximated by the product of the fractions of the kernel, projected
+        on each of the coordinate axes, inside the box extent along that axis. As a result, the
+        masses for a set of boxes tiling the domain add up to the total mass. If no density policy
+        has been set or no mass information is being imported, the behavior is undefined. */
+    double massInBox(const Box& box) const override;
+
     //======================== Data Members ========================
 
 private:
     // data members initialized during configuration
     const SmoothingKernel* _kernel{nullptr};
+    bool _hasClipBox{false};
+    Box _clipBox;
 
-    // data members initialized when reading the input file
-    vector<Array> _propv;  // particle properties as imported
-
-    // data members initialized when reading the input file, but only if a density policy has been set
-    vector<SmoothedParticle> _pv;          // compact particle objects in the same order
-    SmoothedParticleGrid* _grid{nullptr};  // smart grid for locating smoothed particles
+    // data members initialized when reading the input file, but only if a density policy has been set;
+    // the particle properties as imported are held in the property storage of the base class, except for
+    // the position, size, mass and metallicity columns, which are released once the particle grid is built
+    SmoothedParticleGrid* _grid{nullptr};  // smart grid for locating smoothed particles, holding their properties
     Array _cumrhov;                        // cumulative density distribution for particles
+    Array _cumkernelv;                     // cumulative kernel distribution projected on a coordinate axis
     double _mass{0.};                      // total effective mass
 };
 
@@ -4,12 +4,22 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "ParticleSource.hpp"
+#include "FatalError.hpp"
 #include "ParticleSnapshot.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
 Snapshot* ParticleSource::createAndOpenSnapshot()
 {
+    // verify the volume of the domain, if configured
+    Box domain(minX(), minY(), minZ(), maxX(), maxY(), maxZ());
+    if (clipToDomain())
+    {
+        if (domain.xwidth() <= 0) throw FATALERROR("The extent of the domain should be positive in the X direction");
+        if (domain.ywidth() <= 0) throw FATALERROR("The extent of the domain should be positive in the Y direction");
+        if (domain.zwidth() <= 0) throw FATALERROR("The extent of the domain should be positive in the Z direction");
+    }
+
     // create and open the snapshot
     auto snapshot = new ParticleSnapshot;
     snapshot->open(this, filename(), "smoothed source particles");
@@ -23,6 +33,9 @@ Snapshot* ParticleSource::createAndOpenSnapshot()
 
     // set the smoothing kernel
     snapshot->setSmoothingKernel(smoothingKernel());
+
+    // if requested, restrict the import to the configured domain
+    if (clipToDomain()) snapshot->setClipBox(domain);
     return snapshot;
 }
 
@@ -34,6 +34,13 @@
     \f$\sigma_v\f$, adjusting the velocity for each photon packet launch with a random offset
     sampled from a spherically symmetric Gaussian distribution.
 
+    If the \em clipToDomain option is enabled, particles of which the smoothing kernel does not
+    overlap the cuboidal domain specified by the \em minX, \em maxX, \em minY, \em maxY, \em
+    minZ and \em maxZ options are ignored while the input file is being read. This is useful for
+    importing a small portion of a large snapshot, because the memory required during the import
+    then reflects the retained particles rather than the size of the input file. Note that the
+    luminosity of the ignored particles is simply removed from the model.
+
     The remaining columns specify the parameters required by the configured %SED family to select
     and scale the appropriate %SED. For example for the Bruzual-Charlot %SED family, the remaining
     columns provide the initial mass, the metallicity, and the age of the stellar population
@@ -47,14 +54,43 @@ class ParticleSource : public ImportedSource
         ATTRIBUTE_DEFAULT_VALUE(smoothingKernel, "CubicSplineSmoothingKernel")
         ATTRIBUTE_DISPLAYED_IF(smoothingKernel, "Level2")
 
+        PROPERTY_BOOL(clipToDomain, "ignore particles that do not overlap a given cuboidal domain")
+        ATTRIBUTE_DEFAULT_VALUE(clipToDomain, "false")
+        ATTRIBUTE_DISPLAYED_IF(clipToDomain, "Level3")
+
+        PROPERTY_DOUBLE(minX, "the start point of the domain in the X direction")
+        ATTRIBUTE_QUANTITY(minX, "length")
+        ATTRIBUTE_RELEVANT_IF(minX, "clipToDomain")
+
+        PROPERTY_DOUBLE(maxX, "the end point of the domain in the X direction")
+        ATTRIBUTE_QUANTITY(maxX, "length")
+        ATTRIBUTE_RELEVANT_IF(maxX, "clipToDomain")
+
+        PROPERTY_DOUBLE(minY, "the start point of the domain in the Y direction")
+        ATTRIBUTE_QUANTITY(minY, "length")
+        ATTRIBUTE_RELEVANT_IF(minY, "clipToDomain")
+
+        PROPERTY_DOUBLE(maxY, "the end point of the domain in the Y direction")
+        ATTRIBUTE_QUANTITY(maxY, "length")
+        ATTRIBUTE_RELEVANT_IF(maxY, "clipToDomain")
+
+        PROPERTY_DOUBLE(minZ, "the start point of the domain in the Z direction")
+        ATTRIBUTE_QUANTITY(minZ, "length")
+        ATTRIBUTE_RELEVANT_IF(minZ, "clipToDomain")
+
+        PROPERTY_DOUBLE(maxZ, "the end point of the domain in the Z direction")
+        ATTRIBUTE_QUANTITY(maxZ, "length")
+        ATTRIBUTE_RELEVANT_IF(maxZ, "clipToDomain")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
 
 protected:
     /** This function constructs a new ParticleSnapshot object, calls its open() function, passes
-        the smoothing kernel selected by the user to it, and returns a pointer to the object.
-        Ownership of the Snapshot object is transferred to the caller. */
+        the smoothing kernel and, if applicable, the clipping domain selected by the user to it,
+        and returns a pointer to the object. Ownership of the Snapshot object is transferred to the
+        caller. */
     Snapshot* createAndOpenSnapshot() override;
 };
 
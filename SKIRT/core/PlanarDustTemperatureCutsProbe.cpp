@@ -38,12 +38,10 @@ void PlanarDustTemperatureCutsProbe::writeDustTemperatureCut(Probe* probe, bool
     int Ni = xd ? Nx : Ny;
     int Nj = zd ? Nz : Ny;
 
-    // allocate result array with the appropriate size
-    Array Tv(Ni * Nj);
-
-    // calculate the results in parallel; perform only at the root processs
-    auto parallel = probe->find<ParallelFactory>()->parallelRootOnly();
-    parallel->call(Nj, [&Tv, ms, grid, units, xpsize, ypsize, zpsize, xbase, ybase, zbase, xd, yd, zd, xc, yc, zc,
+    // determine the cell index for each pixel in parallel; perform at every process
+    vector<int> mv(Ni * Nj);
+    auto parallel = probe->find<ParallelFactory>()->parallelProcessOnly();
+    parallel->call(Nj, [&mv, grid, xpsize, ypsize, zpsize, xbase, ybase, zbase, xd, yd, zd, xc, yc, zc,
                         Ni](size_t firstIndex, size_t numIndices) {
         for (size_t j = firstIndex; j != firstIndex + numIndices; ++j)
         {
@@ -54,12 +52,15 @@ void PlanarDustTemperatureCutsProbe::writeDustTemperatureCut(Probe* probe, bool
                 double y = yd ? (ybase + (zd ? i : j) * ypsize) : yc;
                 int l = i + Ni * j;
 
-                int m = grid->cellIndex(Position(x, y, z));
-                if (m >= 0) Tv[l] = units->otemperature(ms->indicativeDustTemperature(m));
+                mv[l] = grid->cellIndex(Position(x, y, z));
             }
         }
     });
 
+    // calculate the indicative dust temperatures for all pixels in a single batched pass, and convert to output units
+    Array Tv = ms->indicativeDustTemperatures(mv);
+    for (auto& T : Tv) T = units->otemperature(T);
+
     // get the name of the coordinate plane (xy, xz, or yz)
     string plane;
     if (xd) plane += "x";
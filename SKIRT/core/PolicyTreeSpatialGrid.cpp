@@ -5,22 +5,177 @@
 
 #include "PolicyTreeSpatialGrid.hpp"
 #include "BinTreeNode.hpp"
+#include "CacheKey.hpp"
+#include "Configuration.hpp"
+#include "FilePaths.hpp"
+#include "ItemUtils.hpp"
+#include "Log.hpp"
+#include "MediumSystem.hpp"
 #include "OctTreeNode.hpp"
+#include "ProcessManager.hpp"
+#include "Random.hpp"
+#include "SimulationItemRegistry.hpp"
+#include "System.hpp"
+#include <cstdio>
+#include <fstream>
+
+////////////////////////////////////////////////////////////////////
+
+// helpers for caching the tree topology
+namespace
+{
+    // the identifier at the start of a cache file
+    const uint64_t magic = 0x3130505452544B53;  // "SKTRTP01" in little-endian byte order
+}
 
 ////////////////////////////////////////////////////////////////////
 
 vector<TreeNode*> PolicyTreeSpatialGrid::constructTree()
 {
-    // create the root node using the requested type
-    TreeNode* root = nullptr;
-    switch (_treeType)
+    // creates a new root node using the requested type
+    auto newRoot = [this]() -> TreeNode* {
+        switch (_treeType)
+        {
+            case TreeType::OctTree: return new OctTreeNode(extent());
+            case TreeType::BinTree: return new BinTreeNode(extent());
+        }
+        return nullptr;
+    };
+
+    // if a cache path has been specified, try to load the tree topology from the cache;
+    // when running with multiple processes, use the cache only if all processes have access to it,
+    // because constructing the tree involves collective communication
+    string cacheFile;
+    uint64_t cacheKey = 0;
+    auto paths = find<FilePaths>();
+    if (!paths->cachePath().empty())
     {
-        case TreeType::OctTree: root = new OctTreeNode(extent()); break;
-        case TreeType::BinTree: root = new BinTreeNode(extent()); break;
+        CacheKey key = topologyKey();
+        cacheKey = key.value();
+        cacheFile = paths->cache(type() + "_" + key.hexString() + ".bin");
+        vector<TreeNode*> nodev{newRoot()};
+        bool loaded = loadTopology(cacheFile, cacheKey, nodev);
+        if (ProcessManager::isTrueForAll(loaded))
+        {
+            find<Log>()->info(type() + " loaded tree topology from " + cacheFile);
+            return nodev;
+        }
+        for (auto node : nodev) delete node;
     }
 
-    // tell policy to construct the tree
-    return _policy->constructTree(root);
+    // otherwise tell policy to construct the tree
+    vector<TreeNode*> nodev = _policy->constructTree(newRoot());
+
+    // if requested, save the newly constructed topology to the cache
+    if (!cacheFile.empty())
+    {
+        saveTopology(cacheFile, cacheKey, nodev);
+        find<Log>()->info(type() + " saved tree topology to " + cacheFile);
+    }
+    return nodev;
+}
+
+////////////////////////////////////////////////////////////////////
+
+CacheKey PolicyTreeSpatialGrid::topologyKey()
+{
+    auto schema = SimulationItemRegistry::getSchemaDef();
+    CacheKey key;
+
+    auto paths = find<FilePaths>();
+
+    // the configuration of the grid and its policy, and of the random generator
+    key.add(ItemUtils::hierarchyRepresentation(schema, this));
+    paths->addInputFiles(key, this);
+    key.add(ItemUtils::hierarchyRepresentation(schema, find<Random>(false)));
+    int numSamples = find<Configuration>()->numDensitySamples();
+    key.addValue(numSamples);
+
+    // the configuration of the media, all input files read by the media, including snapshots, geometries
+    // and material mixes, and the resource files from which material mixes obtain their properties
+    auto ms = find<MediumSystem>(false);  // don't setup the medium system because we are part of it
+    if (ms)
+    {
+        FilePaths::addResources(key);
+        for (auto medium : ms->media())
+        {
+            key.add(ItemUtils::hierarchyRepresentation(schema, medium));
+            paths->addInputFiles(key, medium);
+        }
+    }
+    return key;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool PolicyTreeSpatialGrid::loadTopology(string path, uint64_t key, vector<TreeNode*>& nodev)
+{
+    // map the file into memory
+    if (!System::isFile(path)) return false;
+    auto map = System::acquireMemoryMap(path);
+    if (!map.first) return false;
+    const char* start = static_cast<const char*>(map.first);
+
+    // verify the header and the file size
+    uint64_t header[4];
+    bool ok = map.second >= sizeof(header);
+    if (ok)
+    {
+        std::copy(start, start + sizeof(header), reinterpret_cast<char*>(header));
+        ok = header[0] == magic && header[1] == key && map.second == sizeof(header) + header[3] * sizeof(int32_t);
+    }
+
+    // replay the subdivisions in the recorded order
+    if (ok)
+    {
+        size_t numSubdivisions = header[3];
+        vector<int32_t> idv(numSubdivisions);
+        std::copy(start + sizeof(header), start + map.second, reinterpret_cast<char*>(idv.data()));
+        for (int32_t id : idv)
+        {
+            if (id < 0 || static_cast<size_t>(id) >= nodev.size() || !nodev[id]->isChildless())
+            {
+                ok = false;
+                break;
+            }
+            nodev[id]->subdivide(nodev);
+        }
+        ok = ok && nodev.size() == header[2];
+    }
+    System::releaseMemoryMap(path);
+
+    // if the file has improper contents, leave it to the caller to discard the partially subdivided tree
+    if (!ok) return false;
+
+    // sort the neighbors for all nodes
+    for (auto node : nodev) node->sortNeighbors();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PolicyTreeSpatialGrid::saveTopology(string path, uint64_t key, const vector<TreeNode*>& nodev)
+{
+    if (!ProcessManager::isRoot()) return;
+
+    // list the nonleaf nodes in the order in which they were subdivided; because subdividing a node
+    // appends its children to the node list, this is the order of the identifiers of their first child
+    size_t numNodes = nodev.size();
+    vector<int32_t> idv(numNodes, -1);
+    for (auto node : nodev)
+        if (!node->isChildless()) idv[node->children()[0]->id()] = node->id();
+    idv.erase(std::remove(idv.begin(), idv.end(), -1), idv.end());
+
+    // write the file under a temporary name and rename it when complete, so that concurrent simulations
+    // never see a partially written file
+    string tempPath = path + "." + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tmp";
+    {
+        std::ofstream out = System::ofstream(tempPath);
+        uint64_t header[4] = {magic, key, numNodes, idv.size()};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(idv.data()), idv.size() * sizeof(int32_t));
+    }
+    std::rename(tempPath.c_str(), path.c_str());
 }
 
 ////////////////////////////////////////////////////////////////////
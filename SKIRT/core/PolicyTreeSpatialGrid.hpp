@@ -6,6 +6,7 @@
 #ifndef POLICYTREESPATIALGRID_HPP
 #define POLICYTREESPATIALGRID_HPP
 
+#include "CacheKey.hpp"
 #include "TreePolicy.hpp"
 #include "TreeSpatialGrid.hpp"
 
@@ -26,7 +27,21 @@
     user-configurable \em policy instance. Encapsulating the configurable options and the
     corresponding implementation mechanisms for constructing spatial tree grids in a separate class
     hierarchy allows offering and possibly combining different policies without complicating the
-    TreeSpatialGrid class hierarchy. */
+    TreeSpatialGrid class hierarchy.
+
+    If a cache path has been specified for the simulation (see the FilePaths class), the topology
+    of the constructed tree is stored in a binary file in the cache directory. The file lists the
+    nodes in the order in which they were subdivided, so that replaying these subdivisions
+    reproduces the tree including the ordering of its nodes and cells. The file name includes a
+    hash key derived from the complete configuration of the grid (including the policy), the
+    configuration of each medium component and of the random number generator, the number of
+    density samples, and, for each input file read by the grid or by any of the media (such as an
+    imported snapshot, a geometry or a material mix loaded from file), the path, size and
+    modification time of the file and a hash of its first and last megabyte. Because material
+    mixes may obtain their properties from resource files, the key also includes the path, size
+    and modification time of each resource file. Subsequent simulations with a matching key read
+    the topology from this file rather than asking the policy to construct the tree. When running
+    with multiple processes, the cached topology is used only if all processes can load it. */
 class PolicyTreeSpatialGrid : public TreeSpatialGrid
 {
     /** The enumeration type indicating the type of tree to be constructed: an octtree (8 children
@@ -57,6 +72,22 @@ protected:
         configured by the user, and then invokes the constructTree() function of the \em policy
         configured by the user. */
     vector<TreeNode*> constructTree() override;
+
+private:
+    /** This function returns the hash key identifying the tree topology in the cache, as described
+        in the class header. */
+    CacheKey topologyKey();
+
+    /** This function reads the tree topology from the specified cache file, verifying that the
+        file has the specified key, and subdivides the nodes in the specified node list, which
+        initially contains just the root node, accordingly. If the file does not exist or has
+        improper contents, the function returns false. In that case, the node list may contain a
+        partially subdivided tree, which must be discarded by the caller. */
+    bool loadTopology(string path, uint64_t key, vector<TreeNode*>& nodev);
+
+    /** This function saves the topology of the tree represented by the specified node list to the
+        specified cache file. */
+    void saveTopology(string path, uint64_t key, const vector<TreeNode*>& nodev);
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -13,6 +13,7 @@
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
+#include "PerformanceCounters.hpp"
 #include "PhotonPacket.hpp"
 #include "PolarizationProfileInterface.hpp"
 #include "ProbePhotonPacketInterface.hpp"
@@ -160,6 +161,10 @@ bool SecondarySourceSystem::prepareForLaunch(size_t numPackets)
                   + StringUtils::toString(static_cast<double>(totMappedCells) / usedEntries, 'f', 1));
     }
 
+    // --------- emission spectra ---------
+
+    precalculateSpectra();
+
     // report success
     return true;
 }
@@ -176,7 +181,7 @@ namespace
     class DustCellEmission : public VelocityInterface
     {
     private:
-        // information initialized once, during the first call to calculateIfNeeded()
+        // information initialized once, during the first call to calculateIfNeeded() or retrieveIfNeeded()
         MediumSystem* _ms{nullptr};  // the medium system
         Array _wavelengthGrid;       // the dust emission wavelength grid
         Range _wavelengthRange;      // the range of the dust emission wavelength grid
@@ -185,9 +190,11 @@ namespace
         int _numMedia{0};            // the number of dust media in the system (and thus the size of hv)
         int _numCells{0};            // the number of cells in the spatial grid (and thus the size of mv and nv)
 
-        // information on a particular spatial cell, initialized by calculateIfNeeded()
+        // information on a particular spatial cell, initialized by calculateIfNeeded() or retrieveIfNeeded()
+        int _segment{-1};          // serial number of the launch segment
         int _p{-1};                // spatial cell launch-order index
         int _n{-1};                // library entry index
+        bool _perMedium{false};    // true if the library entry uses an emissivity spectrum for each medium component
         vector<Array> _evv;        // emissivity spectrum for each medium component, if applicable
         Array _lambdav, _pv, _Pv;  // normalized emission spectrum
         Vec _bfv;                  // bulk velocity
@@ -196,39 +203,33 @@ namespace
         DustCellEmission() {}
 
         // calculates the emission information for the given cell if it is different from what's already stored
+        //   segment: serial number of the launch segment (information cached for another segment is discarded)
         //   p:  launch-order cell index (cells mapped to a given library entry have consecutive p indices)
         //   mv: map from launch-order cell index p to regular cell index m
         //   nv: map from regular cell index m to library entry index n
         //   ms: medium system
         //   config: configuration object
-        void calculateIfNeeded(int p, const vector<int>& mv, const vector<int>& nv, MediumSystem* ms,
+        void calculateIfNeeded(int segment, int p, const vector<int>& mv, const vector<int>& nv, MediumSystem* ms,
                                Configuration* config)
         {
             // if this photon packet is launched from the same cell as the previous one, we don't need to do anything
-            if (p == _p) return;
+            if (segment == _segment && p == _p) return;
+
+            // time the emissivity calculations for the performance report, if enabled
+            PerformanceCounters::Timer timer(PerformanceCounters::Counter::EmissivityTime);
 
             // when called for the first time, construct a list of dust media and cache some other info
-            if (_p == -1)
-            {
-                _ms = ms;
-                auto wavelengthGrid = config->dustEmissionWLG();
-                _wavelengthGrid = wavelengthGrid->extlambdav();
-                _wavelengthRange = wavelengthGrid->wavelengthRange();
-                _numWavelengths = _wavelengthGrid.size();
-                for (int h = 0; h != ms->numMedia(); ++h)
-                    if (ms->isDust(h)) _hv.push_back(h);
-                _numMedia = _hv.size();
-                _numCells = ms->numCells();
-                _evv.resize(ms->numMedia());
-            }
+            initializeIfNeeded(ms, config);
 
             // remember the new cell index and map to the other indices
+            bool newEntry = segment != _segment;
+            _segment = segment;
             _p = p;
             int m = mv[p];
             int n = nv[m];
 
             // if this new cell maps to a new library entry, we need to process the library entry
-            if (n != _n)
+            if (newEntry || n != _n)
             {
                 // remember the new library entry index
                 _n = n;
@@ -240,6 +241,7 @@ namespace
                 int numMappedCells = pp - p;
 
                 // if only a single cell maps to the library entry, we can simply calculate its emission
+                _perMedium = numMappedCells > 1 && _numMedia != 1;
                 if (numMappedCells == 1)
                 {
                     calculateSingleSpectrum(_ms->meanIntensity(m), m);
@@ -278,7 +280,7 @@ namespace
                 // if there is a single dust medium we can use the already calculated emission spectrum;
                 // otherwise, we need to apply the relative density weights for this cell to the calculated
                 // emission spectra for each dust medium, and renormalize the resulting spectrum
-                if (_numMedia != 1)
+                if (_perMedium)
                 {
                     calculateWeightedSpectrum(m);
                 }
@@ -288,7 +290,88 @@ namespace
             _bfv = ms->bulkVelocity(m);
         }
 
+        // retrieves the emission information for the given cell from the information precalculated for its
+        // library entry, if it is different from what's already stored
+        //   segment: serial number of the launch segment (information cached for another segment is discarded)
+        //   p:  launch-order cell index (cells mapped to a given library entry have consecutive p indices)
+        //   mv: map from launch-order cell index p to regular cell index m
+        //   nv: map from regular cell index m to library entry index n
+        //   lambdav: wavelength grid for the normalized emission spectra
+        //   source: the information for the library entry, as stored by storeEntry()
+        //   perMedium: true if the information consists of an emissivity spectrum for each dust medium component
+        //   ms: medium system
+        //   config: configuration object
+        template<typename T>
+        void retrieveIfNeeded(int segment, int p, const vector<int>& mv, const vector<int>& nv, const Array& lambdav,
+                              const T* source, bool perMedium, MediumSystem* ms, Configuration* config)
+        {
+            // if this photon packet is launched from the same cell as the previous one, we don't need to do anything
+            if (segment == _segment && p == _p) return;
+
+            // time the emissivity calculations for the performance report, if enabled
+            PerformanceCounters::Timer timer(PerformanceCounters::Counter::EmissivityTime);
+
+            // when called for the first time, construct a list of dust media and cache some other info
+            initializeIfNeeded(ms, config);
+
+            // remember the new cell index and map to the other indices
+            bool newEntry = segment != _segment;
+            _segment = segment;
+            _p = p;
+            int m = mv[p];
+            int n = nv[m];
+
+            // if this new cell maps to a new library entry, copy the precalculated information
+            if (newEntry || n != _n)
+            {
+                _n = n;
+                _perMedium = perMedium;
+                if (_perMedium)
+                {
+                    for (int h : _hv)
+                    {
+                        _evv[h].resize(_numWavelengths);
+                        std::copy(source, source + _numWavelengths, begin(_evv[h]));
+                        source += _numWavelengths;
+                    }
+                }
+                else
+                {
+                    size_t numValues = lambdav.size();
+                    _lambdav = lambdav;
+                    _pv.resize(numValues);
+                    _Pv.resize(numValues);
+                    std::copy(source, source + numValues, begin(_pv));
+                    std::copy(source + numValues, source + 2 * numValues, begin(_Pv));
+                }
+            }
+
+            // apply the relative density weights for this cell, if applicable
+            if (_perMedium) calculateWeightedSpectrum(m);
+
+            // remember the average bulk velocity for this cell
+            _bfv = ms->bulkVelocity(m);
+        }
+
     private:
+        // when called for the first time, construct a list of dust media and cache some other info
+        void initializeIfNeeded(MediumSystem* ms, Configuration* config)
+        {
+            if (!_ms)
+            {
+                _ms = ms;
+                auto wavelengthGrid = config->dustEmissionWLG();
+                _wavelengthGrid = wavelengthGrid->extlambdav();
+                _wavelengthRange = wavelengthGrid->wavelengthRange();
+                _numWavelengths = _wavelengthGrid.size();
+                for (int h = 0; h != ms->numMedia(); ++h)
+                    if (ms->isDust(h)) _hv.push_back(h);
+                _numMedia = _hv.size();
+                _numCells = ms->numCells();
+                _evv.resize(ms->numMedia());
+            }
+        }
+
         // calculate the emission spectrum for the specified radiation field and the dust mixes of the specified cell,
         // and store the result in the data members _lambdav, _pv, _Pv
         void calculateSingleSpectrum(const Array& Jv, int m)
@@ -524,14 +607,222 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
+void SecondarySourceSystem::precalculateSpectra()
+{
+    int numCells = _ms->numCells();
+    int numEntries = _config->cellLibrary()->numEntries();
+
+    // advance the segment serial number so that the launch() function discards any cached information
+    _segment++;
+
+    // release the spectra precalculated for the previous segment, if any
+    _hasSpectra = false;
+    _spectrav.resize(0);
+    _spectrafv.clear();
+    _spectrafv.shrink_to_fit();
+
+    // the wavelength grid for the normalized emission spectra depends only on the dust emission wavelength grid
+    auto wavelengthGrid = _config->dustEmissionWLG();
+    Array extlambdav = wavelengthGrid->extlambdav();
+    Array unitv(extlambdav.size());
+    unitv = 1.;
+    Array pv, Pv;
+    NR::cdf<NR::interpolateLogLog>(_lambdav, pv, Pv, extlambdav, unitv, wavelengthGrid->wavelengthRange());
+
+    // determine the number of values stored for a library entry in each of the two formats
+    int numDustMedia = 0;
+    for (int h = 0; h != _ms->numMedia(); ++h)
+        if (_ms->isDust(h)) numDustMedia++;
+    size_t numSpectrumValues = 2 * _lambdav.size();                 // normalized regular and cumulative spectrum
+    size_t numEmissivityValues = numDustMedia * extlambdav.size();  // emissivity spectrum for each dust medium
+
+    // determine the library entries from which photon packets will be launched, the first launch-order cell index
+    // for each of these entries, and the offset and format of the corresponding values in the stored spectra
+    vector<int> firstv;  // first launch-order cell index for each entry
+    vector<int> endv;    // launch-order cell index beyond the last cell for each entry
+    _offsetv.assign(numEntries, 0);
+    _perMediumv.assign(numEntries, 0);
+    size_t numValues = 0;
+    for (int p = 0; p != numCells;)
+    {
+        int n = _nv[_mv[p]];
+        int pp = p + 1;
+        while (pp != numCells && _nv[_mv[pp]] == n) ++pp;
+        if (n >= 0 && _Iv[pp] > _Iv[p])
+        {
+            firstv.push_back(p);
+            endv.push_back(pp);
+            _offsetv[n] = numValues;
+            _perMediumv[n] = pp - p > 1 && numDustMedia != 1;
+            numValues += _perMediumv[n] ? numEmissivityValues : numSpectrumValues;
+        }
+        p = pp;
+    }
+
+    // precalculate the spectra only if they fit in the configured memory budget
+    auto log = find<Log>();
+    bool singlePrecision = _config->storeSecondarySpectraInSinglePrecision();
+    size_t numBytes = numValues * (singlePrecision ? sizeof(float) : sizeof(double));
+    if (numBytes > _config->maxSecondarySpectraBytes())
+    {
+        log->info("  Calculating emission spectra during launch because storing them would require "
+                  + StringUtils::toMemSizeString(numBytes));
+        return;
+    }
+    log->info("  Precalculating emission spectra for " + std::to_string(firstv.size()) + " library entries ("
+              + StringUtils::toMemSizeString(numBytes) + ")");
+
+    // allocate the buffer for the requested precision, so that the double precision values are never stored in full
+    if (singlePrecision)
+        _spectrafv.assign(numValues, 0.f);
+    else
+        _spectrav.resize(numValues);
+
+    // stores a range of values at the specified offset, converting them to single precision if so requested
+    auto store = [this, singlePrecision](const double* first, const double* last, size_t offset) {
+        if (singlePrecision)
+            std::copy(first, last, _spectrafv.begin() + offset);
+        else
+            std::copy(first, last, begin(_spectrav) + offset);
+    };
+
+    // calculate the information for each library entry exactly once, in parallel across threads and processes
+    find<ParallelFactory>()->parallelDistributed()->call(
+        firstv.size(), [this, &firstv, &endv, &extlambdav, &store](size_t firstIndex, size_t numIndices) {
+            // time the emissivity calculations for the performance report, if enabled
+            PerformanceCounters::Timer timer(PerformanceCounters::Counter::EmissivityTime);
+
+            // process the entries in batches so that the emissivities can be calculated for many entries at once
+            const size_t maxBatchSize = 64;
+            size_t numFieldWavelengths = _config->radiationFieldWLG()->numBins();
+            size_t numWavelengths = extlambdav.size();
+            Range wavelengthRange = _config->dustEmissionWLG()->wavelengthRange();
+            Table<2> Jvv, runJvv, evv, svv;
+            Array ev, lambdav, pv, Pv;
+            for (size_t first = firstIndex; first != firstIndex + numIndices;)
+            {
+                size_t num = min(maxBatchSize, firstIndex + numIndices - first);
+
+                // determine the average radiation field for the cells mapped to each entry in the batch
+                Jvv.resize(num, numFieldWavelengths);
+                for (size_t i = 0; i != num; ++i)
+                {
+                    int p = firstv[first + i];
+                    int numMappedCells = endv[first + i] - p;
+                    Array Jv = _ms->meanIntensity(_mv[p]);
+                    for (int j = 1; j != numMappedCells; ++j) Jv += _ms->meanIntensity(_mv[p + j]);
+                    if (numMappedCells > 1) Jv /= numMappedCells;
+                    std::copy(begin(Jv), end(Jv), begin(Jvv.data()) + i * numFieldWavelengths);
+                }
+
+                // calculate the emissivities for each dust medium and either store them directly or accumulate
+                // them weighted by density; the dust mix may vary between entries, so process runs of consecutive
+                // entries with the same mix
+                svv.resize(num, numWavelengths);
+                int dustIndex = 0;
+                for (int h = 0; h != _ms->numMedia(); ++h)
+                {
+                    if (!_ms->isDust(h)) continue;
+                    auto entryMix = [this, &firstv, first, h](size_t i) { return _ms->mix(_mv[firstv[first + i]], h); };
+                    for (size_t i = 0; i != num;)
+                    {
+                        const MaterialMix* runMix = entryMix(i);
+                        size_t j = i + 1;
+                        while (j != num && entryMix(j) == runMix) ++j;
+                        if (j - i == num)
+                        {
+                            runMix->emissivities(Jvv, evv);
+                        }
+                        else
+                        {
+                            runJvv.resize(j - i, numFieldWavelengths);
+                            std::copy(begin(Jvv.data()) + i * numFieldWavelengths,
+                                      begin(Jvv.data()) + j * numFieldWavelengths, begin(runJvv.data()));
+                            runMix->emissivities(runJvv, evv);
+                        }
+                        for (size_t r = i; r != j; ++r)
+                        {
+                            int m = _mv[firstv[first + r]];
+                            int n = _nv[m];
+                            const double* erv = begin(evv.data()) + (r - i) * numWavelengths;
+                            if (_perMediumv[n])
+                            {
+                                store(erv, erv + numWavelengths, _offsetv[n] + dustIndex * numWavelengths);
+                            }
+                            else
+                            {
+                                double numberDensity = _ms->numberDensity(m, h);
+                                double* srv = begin(svv.data()) + r * numWavelengths;
+                                for (size_t ell = 0; ell != numWavelengths; ++ell) srv[ell] += numberDensity * erv[ell];
+                            }
+                        }
+                        i = j;
+                    }
+                    dustIndex++;
+                }
+
+                // calculate and store the normalized regular and cumulative emission spectra, if applicable
+                ev.resize(numWavelengths);
+                for (size_t i = 0; i != num; ++i)
+                {
+                    int n = _nv[_mv[firstv[first + i]]];
+                    if (!_perMediumv[n])
+                    {
+                        std::copy(begin(svv.data()) + i * numWavelengths, begin(svv.data()) + (i + 1) * numWavelengths,
+                                  begin(ev));
+                        NR::cdf<NR::interpolateLogLog>(lambdav, pv, Pv, extlambdav, ev, wavelengthRange);
+                        store(begin(pv), end(pv), _offsetv[n]);
+                        store(begin(Pv), end(Pv), _offsetv[n] + pv.size());
+                    }
+                }
+                first += num;
+            }
+        });
+
+    // combine the values calculated by each process; single precision values are communicated in limited chunks
+    if (!singlePrecision)
+    {
+        ProcessManager::sumToAll(_spectrav);
+    }
+    else if (ProcessManager::isMultiProc())
+    {
+        const size_t maxChunkSize = 1 << 20;
+        Array chunkv;
+        for (size_t first = 0; first < numValues; first += maxChunkSize)
+        {
+            size_t num = min(maxChunkSize, numValues - first);
+            chunkv.resize(num);
+            std::copy(_spectrafv.begin() + first, _spectrafv.begin() + first + num, begin(chunkv));
+            ProcessManager::sumToAll(chunkv);
+            std::copy(begin(chunkv), end(chunkv), _spectrafv.begin() + first);
+        }
+    }
+    _hasSpectra = true;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void SecondarySourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
 {
     // select the spatial cell from which to launch based on the history index of this photon packet
     auto p = std::upper_bound(_Iv.cbegin(), _Iv.cend(), historyIndex) - _Iv.cbegin() - 1;
     auto m = _mv[p];
 
-    // calculate the emission spectrum and bulk velocity for this cell, if not already available
-    t_dustcell.calculateIfNeeded(p, _mv, _nv, _ms, _config);
+    // calculate or retrieve the emission spectrum and bulk velocity for this cell, if not already available
+    if (!_hasSpectra)
+    {
+        t_dustcell.calculateIfNeeded(_segment, p, _mv, _nv, _ms, _config);
+    }
+    else
+    {
+        int n = _nv[m];
+        if (_spectrafv.empty())
+            t_dustcell.retrieveIfNeeded(_segment, p, _mv, _nv, _lambdav, begin(_spectrav) + _offsetv[n],
+                                        _perMediumv[n], _ms, _config);
+        else
+            t_dustcell.retrieveIfNeeded(_segment, p, _mv, _nv, _lambdav, _spectrafv.data() + _offsetv[n],
+                                        _perMediumv[n], _ms, _config);
+    }
     t_dustcellpol.calculateIfNeeded(m, _ms, _config);
 
     // generate a random wavelength from the emission spectrum for the cell and/or from the bias distribution
@@ -595,6 +886,7 @@ void SecondarySourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
     }
 
     pp->launch(historyIndex, lambda, L * w, bfr, bfk, bvi, dpe, dpe);
+    pp->setCellHint(m);
 
     // add origin info (we combine all medium components, so we cannot differentiate them here)
     pp->setSecondaryOrigin(0);
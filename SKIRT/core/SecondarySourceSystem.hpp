@@ -121,7 +121,25 @@ class Random;
     result must be calculated and stored for each cell separately. If the medium system has only a
     single dust component, the above formula reduces to \f$j_{m,\ell} =\rho_m\,
     \varepsilon_{n,\ell}\f$, so that the normalized emission spectrum is identical for all spatial
-    cells that map to a certain library entry. */
+    cells that map to a certain library entry.
+
+    Precalculating emission spectra
+    -------------------------------
+
+    When each spatial cell receives only a few photon packets, which is common for spatial grids
+    with many cells, the procedure described above performs an emissivity calculation for nearly
+    every launched photon packet. Moreover, a library entry with cells in multiple chunks of the
+    history index range is processed separately by each execution thread handling one of these
+    chunks. Therefore, if the required memory does not exceed the budget configured by the user, the
+    prepareForLaunch() function precalculates the information for each library entry from which
+    photon packets will be launched, in parallel and exactly once across all execution threads and
+    processes, passing the radiation fields for a batch of library entries to the material mix at
+    once (see MaterialMix::emissivities()). This information consists of the normalized regular and
+    cumulative emission spectra or, for library entries that map multiple cells in a system with
+    multiple dust components, of the emissivity spectrum \f$\varepsilon_{n,h,\ell}\f$ for each
+    component. The results are optionally stored in single precision to save memory, and are shared
+    by all execution threads during launch. The DustCellEmission object for each thread then simply
+    copies the information for the current library entry rather than calculating it. */
 class SecondarySourceSystem : public SimulationItem
 {
     //============= Construction - Setup - Destruction =============
@@ -154,6 +172,16 @@ public:
         launched), and true otherwise. */
     bool prepareForLaunch(size_t numPackets);
 
+private:
+    /** This function precalculates the emission information for each library entry from which
+        photon packets will be launched during the upcoming segment, provided the required memory
+        does not exceed the configured budget; see the description in the class header for more
+        information. It is called from prepareForLaunch() after the mapping of history indices to
+        spatial cells has been established. */
+    void precalculateSpectra();
+
+public:
+
     /** This function causes the photon packet \em pp to be launched from one of the cells in the
         spatial grid using the given history index; see the description in the class header for
         more information. The photon packet's contents is fully (re-)initialized so that it is
@@ -173,7 +201,10 @@ public:
         information calculated for the "current" cell from one invocation to the next in a helper
         object allocated with thread-local storage scope. As a result, memory requirements are
         limited to storing the information for only a single cell per execution thread, and the
-        calculation is still performed only once per cell.
+        calculation is still performed only once per cell. If the information for each library
+        entry has been precalculated by the prepareForLaunch() function, the helper object simply
+        copies the information for the current library entry, applying the relative density
+        weights for the cell if needed.
 
         Once the emission spectrum for the current cell is known, the function randomly generates a
         wavelength either from this emission spectrum or from the configured bias wavelength
@@ -202,6 +233,15 @@ private:
     vector<int> _nv;     // the library entry index corresponding to each spatial cell (i.e. map from cells to entries)
     vector<int> _mv;     // the spatial cell indices sorted so that cells belonging to the same entry are consecutive
     vector<size_t> _Iv;  // first history index allocated to each spatial cell (with extra entry at the end)
+
+    // initialized by precalculateSpectra()
+    int _segment{0};           // serial number of the current launch segment, used to invalidate cached information
+    bool _hasSpectra{false};   // true if the emission information has been precalculated for the current segment
+    Array _lambdav;            // the wavelength grid for the normalized emission spectra
+    vector<size_t> _offsetv;   // offset of the precalculated information for each library entry
+    vector<char> _perMediumv;  // true if the information for a library entry holds an emissivity spectrum per medium
+    Array _spectrav;           // the precalculated information in double precision, if applicable
+    vector<float> _spectrafv;  // the precalculated information in single precision, if applicable
 };
 
 ////////////////////////////////////////////////////////////////
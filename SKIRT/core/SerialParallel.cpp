@@ -4,6 +4,7 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "SerialParallel.hpp"
+#include "TraceRecorder.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -13,8 +14,14 @@ SerialParallel::SerialParallel(int /*threadCount*/) {}
 
 void SerialParallel::call(size_t maxIndex, std::function<void(size_t, size_t)> target)
 {
+    TraceRecorder::Scope scope("parallel", "call", 0, maxIndex);
+
     // Invoke the target function in a single chunk
-    if (maxIndex) target(0, maxIndex);
+    if (maxIndex)
+    {
+        TraceRecorder::Scope chunkScope("parallel", "chunk", 0, maxIndex);
+        target(0, maxIndex);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -31,6 +31,15 @@ void Simulation::setupAndRun()
     _log->setup();
     TimeLogger logger(_log, "simulation " + _paths->outputPrefix() + processInfo);
 
+    // log the thread placement, if requested
+    if (_factory->threadPlacement() != ParallelFactory::ThreadPlacement::None)
+    {
+        _log->info(_factory->threadPlacementInfo());
+        if (ProcessManager::isMultiProc() && !ParallelFactory::hasRestrictedProcessorSet())
+            _log->warning("Processes are not bound to separate processor sets; "
+                          "threads of processes on the same node may be pinned to the same processors");
+    }
+
     // setup and run the simulation
     setupSimulation();
     runSimulation();
@@ -81,3 +90,10 @@ ParallelFactory* Simulation::parallelFactory() const
 }
 
 ////////////////////////////////////////////////////////////////////
+
+SnapshotRegistry* Simulation::snapshotRegistry() const
+{
+    return _snapshots;
+}
+
+////////////////////////////////////////////////////////////////////
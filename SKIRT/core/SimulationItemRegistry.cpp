@@ -112,6 +112,8 @@
 #include "LyaDoublePeakedSEDFamily.hpp"
 #include "LyaGaussianSED.hpp"
 #include "LyaGaussianSEDFamily.hpp"
+#include "LyaNeutralHydrogenMaterialMix.hpp"
+#include "LyaOptions.hpp"
 #include "LyaSEDDecorator.hpp"
 #include "LyaSEDFamilyDecorator.hpp"
 #include "MRNDustMix.hpp"
@@ -187,6 +189,7 @@
 #include "ShellGeometry.hpp"
 #include "SineSquarePolarizationProfile.hpp"
 #include "SingleGrainSizeDistribution.hpp"
+#include "SingleWavelengthSED.hpp"
 #include "SiteListTreePolicy.hpp"
 #include "SourceSystem.hpp"
 #include "SpatialCellPropertiesProbe.hpp"
@@ -298,6 +301,7 @@ SimulationItemRegistry::SimulationItemRegistry(string version, string format)
     ItemRegistry::add<TabulatedSED>();
     ItemRegistry::add<FileSED>();
     ItemRegistry::add<ListSED>();
+    ItemRegistry::add<SingleWavelengthSED>();
     ItemRegistry::add<LyaGaussianSED>();
     ItemRegistry::add<LyaDoublePeakedSED>();
     ItemRegistry::add<LyaSEDDecorator>();
@@ -453,6 +457,7 @@ SimulationItemRegistry::SimulationItemRegistry(string version, string format)
     ItemRegistry::add<ExtinctionOnlyOptions>();
     ItemRegistry::add<DustEmissionOptions>();
     ItemRegistry::add<DustSelfAbsorptionOptions>();
+    ItemRegistry::add<LyaOptions>();
 
     // material normalizations
     ItemRegistry::add<MaterialNormalization>();
@@ -486,6 +491,7 @@ SimulationItemRegistry::SimulationItemRegistry(string version, string format)
     ItemRegistry::add<ConfigurableDustMix>();
 
     ItemRegistry::add<ElectronMix>();
+    ItemRegistry::add<LyaNeutralHydrogenMaterialMix>();
 
     // material mix families
     ItemRegistry::add<MaterialMixFamily>();
@@ -16,3 +16,10 @@ void SmoothingKernel::setupSelfBefore()
 }
 
 //////////////////////////////////////////////////////////////////////
+
+void SmoothingKernel::densities(int n, const double* uv, double* Wv) const
+{
+    for (int k = 0; k < n; ++k) Wv[k] = density(uv[k]);
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -34,6 +34,13 @@ public:
         normalized radius \f$u\f$. Subclasses must implement this function appropriately. */
     virtual double density(double u) const = 0;
 
+    /** This function stores the density \f$W(u)\f$ of the smoothing kernel for each of the \em n
+        normalized radii in the array \em uv into the corresponding element of the array \em Wv.
+        The default implementation calls the density() function for each element. Subclasses may
+        override this function with an implementation that allows the compiler to vectorize the
+        loop over the elements, for use in performance-critical loops over many particles. */
+    virtual void densities(int n, const double* uv, double* Wv) const;
+
     /** This pure virtual function generates a random normalized radius \f$u\f$ from the smoothing
         kernel, by drawing a number from the one-dimensional probability density \f$
         p(u)\,{\text{d}}u = 4\pi\,W(u)\,u^2\, {\text{d}}u \f$. Subclasses must implement this
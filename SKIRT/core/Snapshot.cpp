@@ -4,8 +4,10 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "Snapshot.hpp"
+#include "FilePaths.hpp"
 #include "Log.hpp"
 #include "Random.hpp"
+#include "SnapshotRegistry.hpp"
 #include "TextInFile.hpp"
 #include "Units.hpp"
 
@@ -34,6 +36,8 @@ void Snapshot::readAndClose()
 {
     delete _infile;
     _infile = nullptr;
+
+    for (auto& column : _propv) column.shrink_to_fit();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -43,6 +47,8 @@ void Snapshot::setContext(const SimulationItem* item)
     _log = item->find<Log>();
     _units = item->find<Units>();
     _random = item->find<Random>();
+    _registry = item->find<SnapshotRegistry>();
+    _paths = item->find<FilePaths>();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -169,6 +175,20 @@ void Snapshot::setMassDensityPolicy(double multiplier, double maxTemperature, bo
 
 ////////////////////////////////////////////////////////////////////
 
+bool Snapshot::hasMassInBox() const
+{
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double Snapshot::massInBox(const Box& /*box*/) const
+{
+    return 0.;
+}
+
+////////////////////////////////////////////////////////////////////
+
 double Snapshot::volume() const
 {
     return extent().volume();
@@ -237,3 +257,55 @@ double Snapshot::SigmaZ() const
 }
 
 ////////////////////////////////////////////////////////////////////
+
+void Snapshot::storeProperties(const Array& row)
+{
+    if (_propv.empty()) _propv.resize(row.size());
+    for (size_t i = 0; i != _propv.size(); ++i) _propv[i].push_back(row[i]);
+    _numStoredEntities++;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Snapshot::reorderStoredProperties(const vector<int>& indices)
+{
+    for (auto& column : _propv)
+    {
+        if (!column.empty())
+        {
+            vector<double> reordered;
+            reordered.reserve(indices.size());
+            for (int m : indices) reordered.push_back(column[m]);
+            column.swap(reordered);
+        }
+    }
+    _numStoredEntities = indices.size();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Snapshot::releaseStoredProperties(int i, int count)
+{
+    int numColumns = _propv.size();
+    if (i >= 0)
+        for (int k = i; k < i + count && k < numColumns; ++k) vector<double>().swap(_propv[k]);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Snapshot::setStoredProperties(vector<vector<double>>& columns)
+{
+    _propv.clear();
+    _propv.swap(columns);
+    _numStoredEntities = _propv.empty() ? 0 : _propv[0].size();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Snapshot::clearStoredProperties()
+{
+    _propv.clear();
+    _numStoredEntities = 0;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -10,9 +10,11 @@
 #include "Box.hpp"
 #include "Position.hpp"
 #include "SnapshotParameter.hpp"
+class FilePaths;
 class Log;
 class Random;
 class SimulationItem;
+class SnapshotRegistry;
 class TextInFile;
 class Units;
 
@@ -72,9 +74,10 @@ public:
     /** This function reads the snapshot data from the input file, honoring the options set through
         the configuration functions, stores the data for later use, and closes the file.
 
-        The implementation in this base class simply closes the file and deletes the corresponding
-        file object. Subclasses must override the function to actually read the data and then call
-        the implementation in this base class. */
+        The implementation in this base class closes the file, deletes the corresponding file
+        object, and trims the memory allocated for the property storage to fit the number of
+        stored entities. Subclasses must override the function to actually read the data and then
+        call the implementation in this base class. */
     virtual void readAndClose();
 
 protected:
@@ -99,6 +102,14 @@ protected:
         in subclasses. */
     Random* random() const { return _random; }
 
+    /** This function returns a pointer to the registry for data structures shared between
+        snapshots in the simulation. It is intended for use in subclasses. */
+    SnapshotRegistry* registry() const { return _registry; }
+
+    /** This function returns a pointer to an appropriate file paths object. It is intended for use
+        in subclasses. */
+    FilePaths* paths() const { return _paths; }
+
     //========== Configuration ==========
 
 public:
@@ -238,6 +249,10 @@ protected:
         by subclasses. */
     int numParameters() const { return _numParameters; }
 
+    /** This function returns the total number of columns being imported, i.e. the number of
+        values in each row read from the input file, for use by subclasses. */
+    int numColumns() const { return _nextIndex; }
+
     /** This function returns the mass or mass density multiplier configured by the user, or zero
         if the user did not configure the mass or mass density policy, for use by subclasses. */
     double multiplier() const { return _multiplier; }
@@ -352,6 +367,19 @@ public:
         been set or no mass/density information is being imported, the behavior is undefined. */
     virtual Position generatePosition() const = 0;
 
+    /** This function returns true if the snapshot can efficiently determine the mass contained in
+        an arbitrary box through the massInBox() function, and false otherwise. The default
+        implementation returns false. Subclasses that offer a spatial index over their entities
+        can override this function and the massInBox() function. */
+    virtual bool hasMassInBox() const;
+
+    /** This function returns the mass represented by the snapshot inside the specified box, i.e.
+        a cuboid lined up with the coordinate axes. Entities that partially overlap the box may be
+        handled approximately, as long as the masses returned for a set of boxes tiling the domain
+        add up to the total mass. If the hasMassInBox() function returns false, the behavior is
+        undefined; the default implementation returns zero. */
+    virtual double massInBox(const Box& box) const;
+
     //============== Interrogation implemented here =============
 
     /** This function returns the volume of the complete domain of the snapshot, taken to be a box
@@ -379,6 +407,53 @@ public:
         been set or no mass/density information is being imported, the behavior is undefined. */
     double SigmaZ() const;
 
+    //========== Property storage ==========
+
+protected:
+    /** This function appends the property values in the specified row, as read from the input
+        file, to the property storage maintained by this class on behalf of subclasses. The values
+        must be in the column order defined by the configuration functions. The property storage is
+        column-major: the values of each property (i.e. column) for all entities are kept in a
+        separate contiguous array, so that there is no per-entity memory allocation and so that
+        columns that are no longer needed can be released individually. */
+    void storeProperties(const Array& row);
+
+    /** This function returns the number of entities in the property storage. */
+    int numStoredEntities() const { return _numStoredEntities; }
+
+    /** This function returns the stored value of the property with column index \em i for the
+        entity with index \em m. If either index is out of range, or if the column has been
+        released, the behavior is undefined. */
+    double storedProperty(int m, int i) const { return _propv[i][m]; }
+
+    /** This function rearranges the entities in the property storage so that the entity with
+        index \em m receives the properties previously stored for the entity with index \em
+        indices[m]. The number of entities becomes the number of elements in the \em indices list,
+        so that this function can also be used to remove entities from the storage. */
+    void reorderStoredProperties(const vector<int>& indices);
+
+    /** This function releases the memory held for the \em count property columns starting at
+        column index \em i. The values in these columns can no longer be retrieved. This allows
+        subclasses to discard properties that are used during setup only, for example the mass of
+        each entity once the corresponding density has been calculated. If \em i is negative, the
+        function does nothing. */
+    void releaseStoredProperties(int i, int count = 1);
+
+    /** This function returns a read-only reference to the array holding the stored values of the
+        property with column index \em i for all entities. If the index is out of range, the
+        behavior is undefined. This allows subclasses, for example, to save the property storage to
+        a cache file. */
+    const vector<double>& storedProperties(int i) const { return _propv[i]; }
+
+    /** This function replaces the property storage by the specified columns, each of which must
+        hold the values of the corresponding property for the same number of entities. The
+        function takes ownership of the column data, leaving the argument empty. This allows
+        subclasses, for example, to restore the property storage from a cache file. */
+    void setStoredProperties(vector<vector<double>>& columns);
+
+    /** This function removes all entities from the property storage and releases the memory. */
+    void clearStoredProperties();
+
     //======================== Data Members ========================
 
 private:
@@ -387,6 +462,8 @@ private:
     Log* _log{nullptr};
     Units* _units{nullptr};
     Random* _random{nullptr};
+    SnapshotRegistry* _registry{nullptr};
+    FilePaths* _paths{nullptr};
 
     // column indices
     int _nextIndex{0};
@@ -408,6 +485,10 @@ private:
     bool _useMetallicity{false};
     bool _hasDensityPolicy{false};
     bool _holdsNumber{false};  // true if snapshot holds number (density); false if it holds mass (density)
+
+    // property storage: one array with the values for all entities for each column
+    vector<vector<double>> _propv;
+    int _numStoredEntities{0};
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -0,0 +1,32 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "SnapshotRegistry.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+SnapshotRegistry::SnapshotRegistry(SimulationItem* parent)
+{
+    parent->addChild(this);
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<void> SnapshotRegistry::lookupObject(string key)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto it = _objectMap.find(key);
+    return it != _objectMap.end() ? it->second.lock() : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SnapshotRegistry::addObject(string key, std::shared_ptr<void> object)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _objectMap[key] = object;
+}
+
+////////////////////////////////////////////////////////////////////
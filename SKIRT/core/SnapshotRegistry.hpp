@@ -0,0 +1,73 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef SNAPSHOTREGISTRY_HPP
+#define SNAPSHOTREGISTRY_HPP
+
+#include "SimulationItem.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////
+
+/** A SnapshotRegistry object allows the Snapshot objects in a simulation hierarchy to share data
+    structures that are expensive to construct and/or to store, such as a Voronoi tessellation and
+    the search structures built on top of it. A typical hydrodynamical post-processing simulation
+    imports the same snapshot file for a medium, a source, and possibly a spatial grid. Because
+    each of these clients imports a different set of columns, each client still constructs its own
+    Snapshot object holding the imported properties. The snapshot geometry, however, depends only
+    on the file, the columns providing the entity positions, and the spatial domain, so that it can
+    be constructed once and shared by all clients.
+
+    Each simulation holds a single instance of this class, created by the Simulation instance at
+    the top of the hierarchy, so that any snapshot can locate it through its simulation item
+    context. Shared objects are identified by a key string that must uniquely specify all
+    information determining the contents of the object, including its type. The registry does not
+    own the shared objects; instead it holds a weak pointer so that a shared object is released as
+    soon as the last snapshot using it is destroyed. */
+class SnapshotRegistry : public SimulationItem
+{
+    //============= Construction - Setup - Destruction =============
+
+public:
+    /** This constructor creates a snapshot registry that is hooked up as a child to the specified
+        parent in the simulation hierarchy, so that it will automatically be deleted. The setup()
+        function is \em not called by this constructor. */
+    explicit SnapshotRegistry(SimulationItem* parent);
+
+    //====================== Other Functions =======================
+
+public:
+    /** This function returns the shared object registered with the specified key, or the null
+        pointer if no object has been registered with that key or if the registered object has
+        already been released by all its users. The template argument must specify the type of the
+        object that was registered with the key. */
+    template<class T> std::shared_ptr<T> lookup(string key)
+    {
+        return std::static_pointer_cast<T>(lookupObject(key));
+    }
+
+    /** This function registers the specified shared object with the specified key, replacing any
+        object previously registered with that key. */
+    template<class T> void add(string key, std::shared_ptr<T> object) { addObject(key, object); }
+
+private:
+    /** This function implements the lookup() template function for a type-erased object. */
+    std::shared_ptr<void> lookupObject(string key);
+
+    /** This function implements the add() template function for a type-erased object. */
+    void addObject(string key, std::shared_ptr<void> object);
+
+    //======================== Data Members ========================
+
+private:
+    std::mutex _mutex;                                 // mutex to guard access to the map
+    std::map<string, std::weak_ptr<void>> _objectMap;  // the registered objects, indexed on key
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
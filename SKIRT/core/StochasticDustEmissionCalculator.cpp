@@ -13,7 +13,6 @@
 #include "ParallelFactory.hpp"
 #include "PlanckFunction.hpp"
 #include "ProcessManager.hpp"
-#include <unordered_map>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -24,15 +23,27 @@ namespace
     template<typename T> class Square
     {
     private:
-        size_t _n;
-        T* _v;
+        size_t _n{0};
+        size_t _capacity{0};
+        T* _v{nullptr};
 
     public:
-        // constructor sets maximum size and logical size
-        Square(size_t n) : _n(n), _v(new T[n * n]) {}
+        // constructor creates an empty matrix; reserve() must be called before use
+        Square() {}
         ~Square() { delete[] _v; }
 
-        // sets logical size, which must not be larger than maximum size set in constructor (is not checked)
+        // sets maximum size; does not preserve values; does not shrink underlying memory
+        void reserve(size_t n)
+        {
+            if (n * n > _capacity)
+            {
+                delete[] _v;
+                _capacity = n * n;
+                _v = new T[_capacity];
+            }
+        }
+
+        // sets logical size, which must not be larger than maximum size set by reserve() (is not checked)
         // does not clear values; does not resize underlying memory
         void resize(size_t n) { _n = n; }
 
@@ -228,13 +239,13 @@ public:
     }
 
     // calculate the probabilities
-    // Pv: the calculated probabilities (out)
+    // Pv: the calculated probabilities, with room for at least one value per grid point (out)
     // ioff: the index offset in the temperature grid used for this calculation (out)
-    // Am: scratch memory for the calculation (internal only)
+    // Am: scratch memory for the calculation, reserved for at least the grid size (internal only)
     // Tmin/Tmax: temperature range in which to perform the calculation (in), and
     //            temperature range where the calculated probabilities are above a certain fraction of maximum (out)
     // Jv: the radiation field discretized on the input wavelength grid (in)
-    void calcProbs(Array& Pv, int& ioff, Square<double>& Am, double& Tmin, double& Tmax, const Array& Jv) const
+    void calcProbs(double* Pv, int& ioff, Square<double>& Am, double& Tmin, double& Tmax, const Array& Jv) const
     {
         ioff = NR::locateClip(_grid->_Tv, Tmin);
         int NT = NR::locateClip(_grid->_Tv, Tmax) - ioff + 2;
@@ -266,7 +277,6 @@ public:
         }
 
         // calculate the probabilities
-        Pv.resize(NT);
         Pv[0] = 1.;
         for (int i = 1; i < NT; i++)
         {
@@ -280,10 +290,12 @@ public:
         }
 
         // normalize probabilities to unity
-        Pv /= Pv.sum();
+        double sum = 0.;
+        for (int i = 0; i < NT; i++) sum += Pv[i];
+        for (int i = 0; i < NT; i++) Pv[i] /= sum;
 
         // determine the temperature range where the probabability is above a given fraction of its maximum
-        double frac = 1e-20 * Pv.max();
+        double frac = 1e-20 * *std::max_element(Pv, Pv + NT);
         int k;
         for (k = 0; k != NT - 2; k++)
             if (Pv[k] > frac) break;
@@ -298,7 +310,7 @@ public:
     // Tmin/Tmax: temperature range in which to add radiation (in)
     // Pv: the probabilities calculated previously by this calculator (in)
     // ioff: the index offset in the temperature grid used for that previous calculation (in)
-    void addStochastic(Array& ev, double Tmin, double Tmax, const Array& Pv, int ioff) const
+    void addStochastic(Array& ev, double Tmin, double Tmax, const double* Pv, int ioff) const
     {
         int imin = NR::locateClip(_grid->_Tv, Tmin);
         int imax = NR::locateClip(_grid->_Tv, Tmax);
@@ -333,6 +345,40 @@ namespace
     // - the temperature range is smaller than a given delta-T (i.e. it resembles a delta function)
     // - the equilibrium temperature lies outside of the temperature range
     const double deltaTeq = 10.;  // the cutoff width of the temperature range
+
+    // the optional equilibrium cutoff table is built from diluted black-body radiation fields:
+    // - the strength grid is specified as the log10 of the wavelength-integrated mean intensity (in W/m2/sr)
+    // - the hardness grid is specified as the temperature of the black body (in K)
+    const double logStrengthMin = -12.;  // the smallest strength in the table
+    const double logStrengthMax = 2.;    // the largest strength in the table
+    const int numStrengths = 29;         // the number of strength grid points
+    const double hardnessTmin = 300.;    // the temperature of the softest black body in the table
+    const double hardnessTmax = 3e4;     // the temperature of the hardest black body in the table
+    const int numHardnesses = 9;         // the number of hardness grid points
+
+    // scratch memory for the emissivity calculation, allocated once for each execution thread and reused for
+    // all subsequent calls by any calculator instance (which all use temperature grids of the same size)
+    struct Workspace
+    {
+        Array Jv;                // radiation field including the CMB, if needed (indexed on k)
+        vector<double> Pv;       // probabilities (indexed on temperature grid index)
+        Square<double> Am;       // transition matrix (indexed on temperature grid indices)
+        vector<double> eqMassv;  // equilibrium cutoff mass (indexed on grain type index)
+    };
+    thread_local Workspace t_workspace;
+
+    // returns the wavelength-integrated mean intensity of the specified radiation field
+    double fieldStrength(const Array& Jv, const Array& dlambdav)
+    {
+        return (Jv * dlambdav).sum();
+    }
+
+    // returns the mean photon energy of the specified radiation field, or zero if the field is empty
+    double fieldHardness(const Array& Jv, const Array& lambdav, const Array& dlambdav)
+    {
+        double photons = (Jv * lambdav * dlambdav).sum();
+        return photons > 0. ? Constants::h() * Constants::c() * fieldStrength(Jv, dlambdav) / photons : 0.;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -402,9 +448,11 @@ void StochasticDustEmissionCalculator::precalculate(SimulationItem* item, const
     _calculatorsC.push_back(new SDE_Calculator(item, _gridC, radiationFieldWLG, _rflambdav, _rfdlambdav, _emlambdav,
                                                lambdav, sigmaabsv, bulkDensity, meanMass, enthalpy));
 
-    // remember some other properties for this bin
+    // remember some other properties for this bin, converting the grain type identifier to an index
     _meanMasses.push_back(meanMass);
-    _grainTypes.push_back(grainType);
+    auto it = std::find(_grainTypeNames.begin(), _grainTypeNames.end(), grainType);
+    _grainTypes.push_back(it - _grainTypeNames.begin());
+    if (it == _grainTypeNames.end()) _grainTypeNames.push_back(grainType);
     _maxEnthalpyTemps.push_back(enthalpy.axisRange<0>().max());
 }
 
@@ -428,49 +476,156 @@ size_t StochasticDustEmissionCalculator::allocatedBytes() const
     allocatedBytes += _meanMasses.size() * sizeof(_meanMasses[0]);
     allocatedBytes += _grainTypes.size() * sizeof(_grainTypes[0]);
     allocatedBytes += _maxEnthalpyTemps.size() * sizeof(_maxEnthalpyTemps[0]);
+    allocatedBytes += _grainTypeNames.size() * sizeof(_grainTypeNames[0]);
+
+    allocatedBytes += _cutStrengthv.size() * sizeof(_cutStrengthv[0]);
+    allocatedBytes += _cutHardnessv.size() * sizeof(_cutHardnessv[0]);
+    allocatedBytes += _cutMassvvv.size() * sizeof(double);
     return allocatedBytes;
 }
 
 ////////////////////////////////////////////////////////////////////
 
+void StochasticDustEmissionCalculator::precalculateEquilibriumCutoffs(SimulationItem* item)
+{
+    // build the strength and hardness grids; the hardness is determined from the discretized black body
+    // so that it matches the value calculated for a radiation field at run time
+    Array Tv;
+    NR::buildLogGrid(Tv, hardnessTmin, hardnessTmax, numHardnesses - 1);
+    NR::buildLinearGrid(_cutStrengthv, logStrengthMin, logStrengthMax, numStrengths - 1);
+    _cutHardnessv.resize(numHardnesses);
+    vector<Array> Bvv(numHardnesses);
+    for (int j = 0; j != numHardnesses; ++j)
+    {
+        PlanckFunction B(Tv[j]);
+        Bvv[j].resize(_rflambdav.size());
+        for (size_t k = 0; k != _rflambdav.size(); ++k) Bvv[j][k] = B(_rflambdav[k]);
+        Bvv[j] /= fieldStrength(Bvv[j], _rfdlambdav);
+        _cutHardnessv[j] = fieldHardness(Bvv[j], _rflambdav, _rfdlambdav);
+
+        // if the radiation field wavelength grid cannot distinguish the hardness of these fields, give up
+        if (j && !(_cutHardnessv[j] > _cutHardnessv[j - 1]))
+        {
+            _cutStrengthv.resize(0);
+            _cutHardnessv.resize(0);
+            return;
+        }
+    }
+
+    // calculate the cutoff masses for all grid points;
+    // cutoff masses that remain infinite survive the summation across processes because the other values are zero
+    int numTypes = _grainTypeNames.size();
+    _cutMassvvv.resize(numStrengths, numHardnesses, numTypes);
+    item->find<ParallelFactory>()->parallelDistributed()->call(
+        numStrengths * numHardnesses, [this, &Bvv, numTypes](size_t firstIndex, size_t numIndices) {
+            Array Jv, Jcmbv, ev(_emlambdav.size());
+            vector<double> eqMassv;
+            for (size_t index = firstIndex; index != firstIndex + numIndices; ++index)
+            {
+                int i = index / numHardnesses;
+                int j = index % numHardnesses;
+                Jv = Bvv[j] * pow(10., _cutStrengthv[i]);
+                if (_Bcmbv.size()) Jcmbv = Jv + _Bcmbv;
+                ev = 0.;
+                eqMassv.assign(numTypes, std::numeric_limits<double>::infinity());
+                addEmissivity(_Bcmbv.size() ? Jcmbv : Jv, ev, eqMassv);
+                for (int t = 0; t != numTypes; ++t) _cutMassvvv(i, j, t) = eqMassv[t];
+            }
+        });
+    ProcessManager::sumToAll(_cutMassvvv.data());
+}
+
+////////////////////////////////////////////////////////////////////
+
+void StochasticDustEmissionCalculator::lookupEquilibriumCutoffs(const Array& Jv, vector<double>& eqMassv) const
+{
+    if (!_cutStrengthv.size()) return;
+
+    // locate the radiation field in the table
+    double strength = fieldStrength(Jv, _rfdlambdav);
+    if (strength <= 0.) return;
+    int i = NR::locateFail(_cutStrengthv, log10(strength));
+    if (i < 0) return;
+    int j = NR::locateFail(_cutHardnessv, fieldHardness(Jv, _rflambdav, _rfdlambdav));
+    if (j < 0) return;
+
+    // use the largest cutoff mass at the surrounding grid points
+    int numTypes = eqMassv.size();
+    for (int t = 0; t != numTypes; ++t)
+    {
+        eqMassv[t] = max({_cutMassvvv(i, j, t), _cutMassvvv(i + 1, j, t), _cutMassvvv(i, j + 1, t),
+                          _cutMassvvv(i + 1, j + 1, t)});
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 Array StochasticDustEmissionCalculator::emissivity(const Array& Jv) const
 {
-    // if requested, create a local copy of the input radiation field that includes the CMB;
-    // constructing a reference to either the input or this local copy avoids copying the input if there is no CMB
-    Array Jcmbv;
-    if (_Bcmbv.size()) Jcmbv = Jv + _Bcmbv;
-    const Array& myJv = _Bcmbv.size() ? Jcmbv : Jv;
+    Array ev;
+    emissivity(Jv, ev);
+    return ev;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void StochasticDustEmissionCalculator::emissivity(const Array& Jv, Array& ev) const
+{
+    Workspace& ws = t_workspace;
 
-    // accumulate the emissivities in this array
-    Array ev(_emlambdav.size());
+    // if requested, copy the input radiation field into the workspace and add the CMB;
+    // constructing a reference to either the input or this copy avoids copying the input if there is no CMB
+    if (_Bcmbv.size())
+    {
+        if (ws.Jv.size() != Jv.size()) ws.Jv.resize(Jv.size());
+        ws.Jv = Jv + _Bcmbv;
+    }
+    const Array& myJv = _Bcmbv.size() ? ws.Jv : Jv;
+
+    // initialize the cutoff masses from the precalculated table, if available
+    ws.eqMassv.assign(_grainTypeNames.size(), std::numeric_limits<double>::infinity());
+    lookupEquilibriumCutoffs(Jv, ws.eqMassv);
+
+    // accumulate the emissivities in the output array
+    if (ev.size() != _emlambdav.size())
+        ev.resize(_emlambdav.size());
+    else
+        ev = 0.;
+    addEmissivity(myJv, ev, ws.eqMassv);
+}
 
-    // this dictionary is updated as the loop over all bins in the mix proceeds;
-    // for each type of grain composition, it keeps track of the grain mass above which
-    // the representative grain is most certainly in equilibrium
-    std::unordered_map<string, double> eqMass;
+////////////////////////////////////////////////////////////////////
 
+void StochasticDustEmissionCalculator::addEmissivity(const Array& Jv, Array& ev, vector<double>& eqMassv) const
+{
     // provide room for the probabilities calculated over each of the temperature grids
-    Array Pv;
-    Square<double> Am(static_cast<size_t>(ceil(Tuppermax)) + 1);
-
-    // loop over all representative grains (size bins) in the dust mix
+    size_t maxNT = max({_gridA->_Tv.size(), _gridB->_Tv.size(), _gridC->_Tv.size()});
+    Workspace& ws = t_workspace;
+    if (ws.Pv.size() < maxNT) ws.Pv.resize(maxNT);
+    ws.Am.reserve(maxNT);
+    double* Pv = ws.Pv.data();
+    Square<double>& Am = ws.Am;
+
+    // loop over all representative grains (size bins) in the dust mix;
+    // the cutoff masses are updated as the loop proceeds: for each type of grain composition,
+    // it keeps track of the grain mass above which the representative grain is most certainly in equilibrium
     int numBins = _calculatorsA.size();
     for (int b = 0; b != numBins; ++b)
     {
         // determine the equilibrium temperature for this bin using the calculator with a fine temperature grid
-        double Teq = _calculatorsC[b]->equilibriumTemperature(myJv);
+        double Teq = _calculatorsC[b]->equilibriumTemperature(Jv);
 
         // consider stochastic calculation only if the mean mass for this bin is below the cutoff mass
-        string grainType = _grainTypes[b];
+        int grainType = _grainTypes[b];
         double meanmass = _meanMasses[b];
-        if (!eqMass.count(grainType) || meanmass < eqMass.at(grainType))
+        if (meanmass < eqMassv[grainType])
         {
             // calculate the probabilities over the coarse temperature grid
             double Tmin = 0;
             double Tmax = min(Tuppermax, _maxEnthalpyTemps[b]);
 
             int ioff = 0;
-            _calculatorsA[b]->calcProbs(Pv, ioff, Am, Tmin, Tmax, myJv);
+            _calculatorsA[b]->calcProbs(Pv, ioff, Am, Tmin, Tmax, Jv);
 
             // if the population might be stochastic...
             if (Tmax - Tmin > deltaTeq && Teq < Tmax)
@@ -479,7 +634,7 @@ Array StochasticDustEmissionCalculator::emissivity(const Array& Jv) const
                 const SDE_Calculator* calculator = (Tmax - Tmin > deltaTmedium) ? _calculatorsB[b] : _calculatorsC[b];
 
                 // calculate the probabilities over this grid, in the range determined by the coarse calculation
-                calculator->calcProbs(Pv, ioff, Am, Tmin, Tmax, myJv);
+                calculator->calcProbs(Pv, ioff, Am, Tmin, Tmax, Jv);
 
                 // if the population indeed is stochastic...
                 if (Tmax - Tmin > deltaTeq && Teq < Tmax)
@@ -491,13 +646,12 @@ Array StochasticDustEmissionCalculator::emissivity(const Array& Jv) const
             }
 
             // remember that all grains above this mass will be in equilibrium
-            eqMass[grainType] = meanmass;
+            eqMassv[grainType] = meanmass;
         }
 
         // otherwise, add the equilibrium emissivity of this population to the running total
         _calculatorsC[b]->addEquilibrium(ev, Teq);
     }
-    return ev;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -8,6 +8,7 @@
 
 #include "Array.hpp"
 #include "StoredTable.hpp"
+#include "Table.hpp"
 class SimulationItem;
 class SDE_Calculator;
 class SDE_TemperatureGrid;
@@ -83,7 +84,36 @@ class SDE_TemperatureGrid;
     \frac{\sum_{j=0}^{i-1}B_{i,j}X_j}{A_{i-1,i}} & i=1,\ldots,N-1 \\ P_i &=
     \frac{X_i}{\sum_{j=0}^{N-1}X_j} & i=0,\ldots,N-1 \f}
 
-    */
+    <b>Equilibrium cutoff</b>
+
+    The calculation is performed for each of the bins in turn. As soon as the probability
+    distribution for a bin turns out to resemble a delta function (or the equilibrium temperature
+    lies outside of the range where the probability is nonzero), the representative grain is
+    considered to be in equilibrium. Because heavier grains of the same material are even closer to
+    equilibrium, the mass of such a bin serves as a cutoff: the equilibrium emission is used for
+    all subsequent bins of the same grain material with a mean mass at or above this cutoff,
+    without calculating any probabilities.
+
+    Optionally, the precalculateEquilibriumCutoffs() function tabulates these cutoff masses for
+    each grain material as a function of the strength and the hardness of the radiation field,
+    using a set of diluted black-body radiation fields. The strength is defined as the mean
+    intensity integrated over wavelength, and the hardness is defined as the mean photon energy.
+    The emissivity() function then starts from the largest cutoff mass tabulated at the grid
+    points surrounding the input radiation field, so that heavy bins can be recognized as being in
+    equilibrium before calculating any probabilities. The result is unaffected as long as the
+    tabulated value is not smaller than the cutoff mass that would be found for the actual
+    radiation field. Because this is not guaranteed for radiation fields with a spectral shape that
+    differs substantially from a black body, the option trades some accuracy for speed. Radiation
+    fields outside of the tabulated range are handled without a precalculated cutoff.
+
+    <b>Workspace</b>
+
+    The emissivity() function uses scratch memory for the transition matrix, the probabilities and
+    the cutoff masses. This memory is allocated once for each execution thread and reused for all
+    subsequent calls, regardless of the calculator instance, so that the calculation does not
+    allocate any memory beyond the returned emissivity spectrum. To avoid string comparisons, the
+    grain type identifiers are converted to consecutive integer indices by the precalculate()
+    function. */
 class StochasticDustEmissionCalculator
 {
 public:
@@ -120,6 +150,14 @@ public:
         function so far. This information can be used for logging purposes. */
     size_t allocatedBytes() const;
 
+    /** This function tabulates the equilibrium cutoff mass for each grain material as a function
+        of the strength and the hardness of the embedding radiation field, as described in the
+        class header. It must be called after the precalculate() function has been called for all
+        bins. If this function is not called, or if the radiation field wavelength grid is too
+        coarse to distinguish the hardness of the tabulated radiation fields, the emissivity()
+        function performs the full calculation for each radiation field. */
+    void precalculateEquilibriumCutoffs(SimulationItem* item);
+
     /** This function returns the emissivity spectrum per hydrogen atom
         \f$(\varepsilon_\lambda)_\ell\f$ of the dust mix (or rather of the corresponding mixture of
         representative grain populations) when embedded in the radiation field specified by the
@@ -130,6 +168,26 @@ public:
         not been called for at least one bin, the behavior of this function is undefined. */
     Array emissivity(const Array& Jv) const;
 
+    /** This function stores the emissivity spectrum per hydrogen atom of the dust mix for the
+        radiation field specified by the mean intensities \f$(J_\lambda)_k\f$ in the output array,
+        as described for the other version of this function. The output array is resized only if
+        it does not have the appropriate size, so that its memory can be reused across calls. */
+    void emissivity(const Array& Jv, Array& ev) const;
+
+private:
+    /** This function adds the emissivity spectrum for the radiation field \f$(J_\lambda)_k\f$,
+        which should include the CMB if needed, to the output array. The array \em eqMassv
+        specifies the initial equilibrium cutoff mass for each grain material and it is updated
+        with the cutoff masses found during the calculation. */
+    void addEmissivity(const Array& Jv, Array& ev, vector<double>& eqMassv) const;
+
+    /** This function replaces the equilibrium cutoff masses in the specified array by the largest
+        of the values tabulated by the precalculateEquilibriumCutoffs() function at the grid points
+        surrounding the radiation field \f$(J_\lambda)_k\f$, if the table is available and the
+        radiation field lies inside of its range. Otherwise, the function leaves the array
+        untouched. */
+    void lookupEquilibriumCutoffs(const Array& Jv, vector<double>& eqMassv) const;
+
     //======================== Data Members ========================
 
 private:
@@ -150,9 +208,17 @@ private:
     vector<const SDE_Calculator*> _calculatorsC;  // fine grid
 
     // other properties for each representative dust grain (size bin) -- indexed on b
-    vector<string> _grainTypes;        // the grain type identifier
+    vector<int> _grainTypes;           // the index of the grain type in _grainTypeNames
     vector<double> _meanMasses;        // mean mass of a grain
     vector<double> _maxEnthalpyTemps;  // maximum temperature for the enthalpy data
+
+    // the distinct grain type identifiers -- indexed on grain type index
+    vector<string> _grainTypeNames;
+
+    // optional equilibrium cutoff table -- initialized by precalculateEquilibriumCutoffs()
+    Array _cutStrengthv;   // log10 of the wavelength-integrated mean intensity at the grid points
+    Array _cutHardnessv;   // mean photon energy at the grid points
+    Table<3> _cutMassvvv;  // cutoff mass (indexed on strength, hardness, and grain type index)
 };
 
 ////////////////////////////////////////////////////////////////////
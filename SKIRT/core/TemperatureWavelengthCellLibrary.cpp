@@ -61,12 +61,18 @@ vector<int> TemperatureWavelengthCellLibrary::mapping(const Array& bv) const
     double lambdamax = 0.0;
     Array Tv(numCells);
     Array lambdav(numCells);
+
+    // obtain the indicative temperatures in a single batched pass, skipping cells that won't be used by the caller
+    vector<int> mv(numCells);
+    for (int m = 0; m != numCells; ++m) mv[m] = bv[m] ? m : -1;
+    Array indicativeTv = ms->indicativeDustTemperatures(mv);
+
     for (int m = 0; m != numCells; ++m)
     {
         // ignore cells that won't be used by the caller
         if (bv[m])
         {
-            double T = ms->indicativeDustTemperature(m);
+            double T = indicativeTv[m];
             double lambda = indicativeDustWavelength(m, ms, wavelengthGrid);
 
             // ignore cells with meaningless property values
@@ -7,9 +7,14 @@
 #include "FatalError.hpp"
 #include "FilePaths.hpp"
 #include "Log.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "ProcessManager.hpp"
 #include "StringUtils.hpp"
 #include "System.hpp"
 #include "Units.hpp"
+#include <cstdint>
+#include <cstring>
 #include <exception>
 #include <regex>
 #include <sstream>
@@ -60,15 +65,25 @@ namespace
 
 TextInFile::TextInFile(const SimulationItem* item, string filename, string description)
 {
-    // open the file
+    // remember the simulation item, the units system and the logger
+    _item = item;
+    _units = item->find<Units>();
+    _log = item->find<Log>();
+
+    // open a binary column file
     string filepath = item->find<FilePaths>()->input(filename);
+    _filepath = filepath;
+    if (StringUtils::endsWith(filename, ".scol"))
+    {
+        _log->info(item->typeAndName() + " reads " + description + " from binary column file " + filepath + "...");
+        openBinary(filepath);
+        return;
+    }
+
+    // open the text file
     _in = System::ifstream(filepath);
     if (!_in) throw FATALERROR("Could not open the " + description + " text file " + filepath);
 
-    // remember the units system and the logger
-    _units = item->find<Units>();
-    _log = item->find<Log>();
-
     // log "reading file" message
     _log->info(item->typeAndName() + " reads " + description + " from text file " + filepath + "...");
 
@@ -95,9 +110,15 @@ TextInFile::TextInFile(const SimulationItem* item, string filename, string descr
 
 void TextInFile::close()
 {
-    if (_in.is_open())
+    if (_in.is_open() || !_binPath.empty())
     {
-        _in.close();
+        if (_in.is_open()) _in.close();
+        if (!_binPath.empty())
+        {
+            System::releaseMemoryMap(_binPath);
+            _binPath.clear();
+            _binColumns.clear();
+        }
 
         // log "done" message, except if an exception has been thrown
         if (!std::uncaught_exception()) _log->info("Done reading");
@@ -113,6 +134,106 @@ TextInFile::~TextInFile()
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // The tags and the size of the 8-byte data items in a binary column file
+    const char* const binaryStartTag = "SKIRT C\n";
+    const char* const binaryEndTag = "SCOLEND\n";
+    const uint64_t binaryEndianTag = 0x010203040A0BFEFF;
+    const size_t binaryItemSize = 8;
+
+    // This helper class reads consecutive data items from a memory-mapped binary column file, throwing a fatal error
+    // when attempting to read beyond the end of the mapped data
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const char* begin, size_t size, string filepath)
+            : _current(begin), _end(begin + size), _filepath(filepath)
+        {}
+
+        // returns a pointer to the requested number of bytes and advances to the next data item boundary
+        const char* bytes(size_t numBytes)
+        {
+            size_t numItems = (numBytes + binaryItemSize - 1) / binaryItemSize;
+            if (static_cast<size_t>(_end - _current) < numItems * binaryItemSize)
+                throw FATALERROR("Binary column file is truncated: " + _filepath);
+            const char* result = _current;
+            _current += numItems * binaryItemSize;
+            return result;
+        }
+
+        // returns the value of an unsigned integer data item
+        uint64_t integer()
+        {
+            uint64_t value;
+            memcpy(&value, bytes(binaryItemSize), binaryItemSize);
+            return value;
+        }
+
+        // returns the contents of a text field, i.e. a character count followed by the padded characters
+        string text()
+        {
+            size_t length = integer();
+            return StringUtils::squeeze(string(bytes(length), length));
+        }
+
+        // returns true if the next data item matches the given tag
+        bool tag(const char* tag) { return memcmp(bytes(binaryItemSize), tag, binaryItemSize) == 0; }
+
+        // returns true if all mapped data has been consumed
+        bool atEnd() const { return _current == _end; }
+
+    private:
+        const char* _current;
+        const char* _end;
+        string _filepath;
+    };
+}
+
+////////////////////////////////////////////////////////////////////
+
+void TextInFile::openBinary(string filepath)
+{
+    // acquire a memory map for the file; the function returns zeros if the memory map cannot be created
+    auto map = System::acquireMemoryMap(filepath);
+    if (!map.first) throw FATALERROR("Could not open the binary column file " + filepath);
+    _binPath = filepath;
+    BinaryReader reader(static_cast<const char*>(map.first), map.second, filepath);
+
+    // verify the name tag and the Endianness tag
+    if (!reader.tag(binaryStartTag) || reader.integer() != binaryEndianTag)
+        throw FATALERROR("File does not have binary column file format: " + filepath);
+
+    // read the header information for each column into a list of ColumnInfo records
+    size_t numColumns = reader.integer();
+    _binNumRows = reader.integer();
+    _hasFileInfo = reader.integer() != 0;
+    for (size_t index = 1; index <= numColumns; ++index)
+    {
+        size_t valueSize = reader.integer();
+        if (valueSize != 4 && valueSize != 8)
+            throw FATALERROR("Invalid value size in binary column file header for column " + std::to_string(index));
+        _binValueSizes.push_back(valueSize);
+
+        string title = reader.text();
+        string unit = reader.text();
+        if (_hasFileInfo)
+        {
+            _colv.emplace_back();
+            _colv.back().physColIndex = index;
+            _colv.back().unit = unit;
+            _colv.back().title = title;
+        }
+    }
+
+    // remember the start of each column and verify the end-of-file tag
+    for (size_t valueSize : _binValueSizes) _binColumns.push_back(reader.bytes(_binNumRows * valueSize));
+    if (!reader.tag(binaryEndTag) || !reader.atEnd())
+        throw FATALERROR("Binary column file does not have the expected size: " + filepath);
+}
+
+////////////////////////////////////////////////////////////////////
+
 namespace
 {
     // Error return values for the functions below
@@ -279,10 +400,40 @@ void TextInFile::addColumn(string description, string quantity, string defaultUn
 
 ////////////////////////////////////////////////////////////////////
 
+string TextInFile::columnSignature(size_t firstColumn, size_t numColumns) const
+{
+    if (firstColumn + numColumns > _numLogCols)
+        throw FATALERROR("Requesting signature for columns that have not been declared");
+
+    string signature = _filepath;
+    for (size_t i = firstColumn; i != firstColumn + numColumns; ++i)
+    {
+        const ColumnInfo& col = _colv[i];
+        signature += "|" + std::to_string(col.physColIndex) + ":" + StringUtils::toString(col.convFactor, 'e', 16)
+                     + ":" + std::to_string(col.waveExponent) + ":" + std::to_string(col.waveIndex);
+    }
+    return signature;
+}
+
+////////////////////////////////////////////////////////////////////
+
 bool TextInFile::readRow(Array& values)
 {
     if (!_hasProgInfo) throw FATALERROR("No columns were declared for column text file");
 
+    // hand out the next row from the current block, reading new blocks as needed
+    if (!_readLines)
+    {
+        if (_blockNextRow == _blockNumRows && !readBlock()) return false;
+
+        // resize result array if needed (we don't need it to be cleared)
+        if (values.size() != _numLogCols) values.resize(_numLogCols);
+
+        const double* rowValues = _blockValues.data() + _numLogCols * _blockNextRow++;
+        std::copy(rowValues, rowValues + _numLogCols, begin(values));
+        return true;
+    }
+
     // read new line until it is non-empty and non-comment
     string line;
     while (_in.good())
@@ -323,8 +474,227 @@ bool TextInFile::readRow(Array& values)
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // the number of bytes read from a column text file for each block, which is also used as the approximate size
+    // of the converted values for each block read from a binary column file
+    const size_t blockSize = 32 << 20;
+
+    // the approximate number of bytes in each chunk of a block parsed by a single thread
+    const size_t chunkSize = 1 << 20;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool TextInFile::readBlock()
+{
+    _readBlocks = true;
+    _blockNextRow = 0;
+    bool broadcast = _item->find<FilePaths>()->readInputOnRoot() && ProcessManager::isMultiProc();
+
+    // unless the block will be received from the root process, read blocks until there is a block containing
+    // at least one row or until the end of the file is reached
+    if (!broadcast || ProcessManager::isRoot())
+    {
+        while (true)
+        {
+            if (!(_binPath.empty() ? readTextBlock() : readBinaryBlock()))
+            {
+                _blockValues.clear();
+                _blockNumRows = 0;
+                break;
+            }
+            if (_blockNumRows) break;
+        }
+    }
+
+    // if requested, broadcast the block from the root process to the other processes
+    if (broadcast)
+    {
+        ProcessManager::broadcastFromRoot(_blockValues);
+        _blockNumRows = _blockValues.size() / _numLogCols;
+    }
+    return _blockNumRows != 0;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool TextInFile::readBinaryBlock()
+{
+    if (_logColIndices.size() > _binColumns.size())
+        throw FATALERROR("One or more required column(s) are missing in binary column file");
+    if (_binNextRow == _binNumRows) return false;
+
+    // convert values from each mapped column and store them in the block buffer
+    _blockNumRows = min(_binNumRows - _binNextRow, max(blockSize / (sizeof(double) * _numLogCols), size_t(1)));
+    _blockValues.resize(_numLogCols * _blockNumRows);
+    size_t numPhysCols = _logColIndices.size();
+    double* values = _blockValues.data();
+    for (size_t r = _binNextRow; r != _binNextRow + _blockNumRows; ++r)
+    {
+        for (size_t p = 0; p != numPhysCols; ++p)
+        {
+            size_t i = _logColIndices[p];  // i: zero-based logical index
+            if (i != ERROR_NO_INDEX)
+            {
+                double value;
+                if (_binValueSizes[p] == 8)
+                    memcpy(&value, _binColumns[p] + 8 * r, 8);
+                else
+                {
+                    float single;
+                    memcpy(&single, _binColumns[p] + 4 * r, 4);
+                    value = single;
+                }
+                const ColumnInfo& col = _colv[i];
+                values[i] = value * (col.waveExponent ? pow(values[col.waveIndex], col.waveExponent) : col.convFactor);
+            }
+        }
+        values += _numLogCols;
+    }
+    _binNextRow += _blockNumRows;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool TextInFile::readTextBlock()
+{
+    // start the new block with the incomplete last line of the previous block
+    _text.assign(_tail.begin(), _tail.end());
+    _tail.clear();
+
+    // append raw text until the block contains at least one complete line or the end of the file is reached
+    size_t numComplete = 0;  // number of characters in the block up to and including the last newline
+    while (!numComplete && _in.good())
+    {
+        size_t oldSize = _text.size();
+        _text.resize(oldSize + blockSize);
+        _in.read(_text.data() + oldSize, blockSize);
+        _text.resize(oldSize + _in.gcount());
+
+        for (size_t i = _text.size(); i > oldSize; --i)
+        {
+            if (_text[i - 1] == '\n')
+            {
+                numComplete = i;
+                break;
+            }
+        }
+    }
+
+    // hold back the incomplete last line for the next block, except at the end of the file
+    if (numComplete && _in.good())
+    {
+        _tail.assign(_text.begin() + numComplete, _text.end());
+        _text.resize(numComplete);
+    }
+    if (_text.empty()) return false;
+    if (_text.back() != '\n') _text.push_back('\n');
+
+    // split the block into newline-aligned chunks
+    vector<char*> boundaries(1, _text.data());
+    char* end = _text.data() + _text.size();
+    while (true)
+    {
+        char* next = boundaries.back() + chunkSize;
+        if (next >= end) break;
+        next = static_cast<char*>(memchr(next, '\n', end - next)) + 1;
+        if (next == end) break;
+        boundaries.push_back(next);
+    }
+    boundaries.push_back(end);
+    size_t numChunks = boundaries.size() - 1;
+
+    // count the number of rows in each chunk, and determine the offset of each chunk's first row
+    vector<size_t> rowOffsets(numChunks + 1, 0);
+    auto parseChunks = [this, &boundaries, &rowOffsets](size_t firstIndex, size_t numIndices, bool count) {
+        for (size_t c = firstIndex; c != firstIndex + numIndices; ++c)
+        {
+            if (count)
+                rowOffsets[c + 1] = parseLines(boundaries[c], boundaries[c + 1], nullptr);
+            else
+                parseLines(boundaries[c], boundaries[c + 1], _blockValues.data() + _numLogCols * rowOffsets[c]);
+        }
+    };
+    auto parallel = numChunks > 1 ? _item->find<ParallelFactory>()->parallelProcessOnly() : nullptr;
+    if (parallel)
+        parallel->call(numChunks, [&parseChunks](size_t first, size_t num) { parseChunks(first, num, true); });
+    else
+        parseChunks(0, numChunks, true);
+    for (size_t c = 0; c != numChunks; ++c) rowOffsets[c + 1] += rowOffsets[c];
+
+    // parse and convert the values for each chunk into the appropriate location in the block buffer
+    _blockNumRows = rowOffsets[numChunks];
+    _blockValues.resize(_numLogCols * _blockNumRows);
+    if (parallel)
+        parallel->call(numChunks, [&parseChunks](size_t first, size_t num) { parseChunks(first, num, false); });
+    else
+        parseChunks(0, numChunks, false);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t TextInFile::parseLines(char* begin, char* end, double* values)
+{
+    size_t numRows = 0;
+    while (begin != end)
+    {
+        // locate the end of the line and skip leading white space
+        char* eol = static_cast<char*>(memchr(begin, '\n', end - begin));
+        char* current = begin;
+        while (*current == ' ' || *current == '\t' || *current == '\r') ++current;
+
+        // process the line if it is non-empty and non-comment
+        if (current != eol && *current != '#')
+        {
+            if (values)
+            {
+                // terminate the line so that the conversions cannot extend beyond it
+                *eol = 0;
+
+                // convert values from line and store them in result array
+                for (size_t i : _logColIndices)  // i: zero-based logical index
+                {
+                    // read the value as floating point; strtod() depends on the C locale, but the System
+                    // constructor pins it to "C" at startup so that the decimal separator is always a period
+                    // (std::from_chars would avoid this dependency but requires C++17)
+                    char* next;
+                    double value = strtod(current, &next);
+                    if (next == current)
+                    {
+                        while (*next == ' ' || *next == '\t' || *next == '\r') ++next;
+                        if (!*next) throw FATALERROR("One or more required value(s) on text line are missing");
+                        throw FATALERROR("Input text is not formatted as a floating point number");
+                    }
+                    current = next;
+
+                    // if mapped to a logical column, convert from input units to internal units, and store the result
+                    if (i != ERROR_NO_INDEX)
+                    {
+                        const ColumnInfo& col = _colv[i];
+                        values[i] =
+                            value * (col.waveExponent ? pow(values[col.waveIndex], col.waveExponent) : col.convFactor);
+                    }
+                }
+                values += _numLogCols;
+            }
+            numRows++;
+        }
+        begin = eol + 1;
+    }
+    return numRows;
+}
+
+////////////////////////////////////////////////////////////////////
+
 bool TextInFile::readNonLeaf(int& nx, int& ny, int& nz)
 {
+    if (!_binPath.empty()) throw FATALERROR("Binary column files cannot hold nonleaf node specifications");
+    if (_readBlocks) throw FATALERROR("Cannot read nonleaf node specifications after reading rows in blocks");
+    _readLines = true;
+
     string line;
 
     while (true)
@@ -50,7 +50,61 @@ class Units;
     and after the column info lines.
 
     If there is no column information in the file (i.e. none of the header lines match the syntax
-    decribed above), the default units provided by the program are used. */
+    decribed above), the default units provided by the program are used.
+
+    Parallel parsing
+    ----------------
+
+    To speed up loading large column text files, the data lines are read in blocks of several
+    megabytes. Each block is split into newline-aligned chunks that are parsed and converted to
+    internal units concurrently by the threads of the current process, without allocating memory
+    for individual lines or values. The results are stored in row order and subsequently handed
+    out one row at a time by the readRow() function (and thus also by the other reading functions
+    based on it). This mechanism is transparent to the caller, except that the nonleaf node
+    specifications used for adaptive mesh snapshots are read line by line instead: once the
+    readNonLeaf() function has been called, all subsequent rows are read line by line as well.
+
+    When running with multiple processes, the data rows can optionally be read by the root process
+    only (see FilePaths::setReadInputOnRoot()). The root process then broadcasts each block of
+    converted rows (read from a text or binary column file) to the other processes, which read just
+    the header of the input file. This avoids loading the file system with identical requests from
+    all processes and avoids repeating the parsing effort. In this case, all processes must issue
+    the same sequence of reading operations on the file.
+
+    Binary column files
+    -------------------
+
+    As an alternative to the text format, an input file with the ".scol" filename extension is
+    interpreted as a binary column file. The file is memory-mapped and rows are retrieved directly
+    from the mapped data, avoiding the overhead of parsing text. This is especially relevant for
+    large imported snapshots. The column information (description and unit string for each column)
+    carries the same meaning as the header lines in a text file, so that column remapping with the
+    useColumns() function and unit conversion work identically for both formats. A binary column
+    file can be produced from a text column file with the \c skirtcol tool.
+
+    A binary column file is a sequence of 8-byte data items. The data items describing the file
+    layout can have one of the following types:
+        - string tag: 8 printable 7-bit ASCII characters;
+        - unsigned integer: 64-bit integer in little-endian byte order;
+        - text: an unsigned integer specifying the number of characters, followed by the ASCII
+          characters themselves padded with spaces to fill an integer number of data items.
+
+    The overall layout is as follows:
+        - SKIRT binary column file tag "SKIRT C\n"
+        - Endianness tag (the unsigned integer 0x010203040A0BFEFF)
+        - numColumns
+        - numRows
+        - hasColumnInfo (1 if the column descriptions and units are meaningful, 0 if not)
+        - [ valueSize  description  unit ] (x numColumns)
+        - [ value (x numRows) ] (x numColumns)
+        - end-of-file tag "SCOLEND\n"
+
+    The value size is 8 for 64-bit (double precision) or 4 for 32-bit (single precision) IEEE 754
+    floating point values in little-endian byte order. The values for each column are stored
+    contiguously in row order, and the block of values for each column is padded with zero bytes
+    to fill an integer number of data items. If \em hasColumnInfo is zero, the descriptions and
+    units are empty and the default units provided by the program are used. Binary column files
+    cannot hold the nonleaf node specifications used for adaptive mesh snapshots. */
 class TextInFile
 {
     //=============== Construction - Destruction  ==================
@@ -62,7 +116,10 @@ public:
         the input file path and an appropriate logger; (2) \em filename specifies the name of the
         file, including filename extension but excluding path and simulation prefix; (3) \em
         description describes the contents of the file for use in the log message issued after the
-        file is successfully opened. */
+        file is successfully opened.
+
+        If the filename has the ".scol" extension, the file is opened as a binary column file (see
+        the class header) and its header is verified. */
     TextInFile(const SimulationItem* item, string filename, string description);
 
     /** This function closes the file if it was not already closed. It is best to call close() or
@@ -137,6 +194,18 @@ public:
     */
     void addColumn(string description, string quantity = string(), string defaultUnit = string());
 
+    /** This function returns a string that identifies the file being read and, for each of the
+        specified range of logical columns, the corresponding physical column and the conversion
+        factor from input to internal units. The columns in the range must already have been
+        declared with the addColumn() function. If two TextInFile objects return the same string
+        for a given range of columns, the values read for these columns in each row will be
+        identical. This allows a client, for example, to detect that two snapshots import the same
+        entity positions. */
+    string columnSignature(size_t firstColumn, size_t numColumns) const;
+
+    /** This function returns the absolute path of the file being read. */
+    string filePath() const { return _filepath; }
+
     /** This function reads the next row from a column text file and stores the resulting values in
         the array passed to the function by reference. The function first skips empty lines and
         lines starting with a hash character, and then reads a single text line containing data
@@ -249,12 +318,44 @@ private:
     }
     static inline void assignColumns(size_t /*index*/, vector<Array>& /*result*/) {}
 
+    /** This function replaces the contents of the block buffer data members by the next block of
+        rows containing at least one row, and returns true. If there are no more rows, the function
+        returns false. Depending on the configuration, the function reads the block from the input
+        file (see readTextBlock() and readBinaryBlock()), or it receives the block read by the root
+        process. In the latter case, all processes must call this function in lockstep. */
+    bool readBlock();
+
+    /** This function reads the next block of data lines from a column text file, and parses the
+        lines into rows of values converted to internal units. The rows are stored in the block
+        buffer data members, replacing any previous contents. If there are no more data lines, the
+        function returns false. Otherwise it returns true, although the block may contain no rows
+        if it consists of comment lines only. */
+    bool readTextBlock();
+
+    /** This function converts the next block of rows from a binary column file to internal units,
+        and stores them in the block buffer data members, replacing any previous contents. If there
+        are no more rows, the function returns false. Otherwise it returns true. */
+    bool readBinaryBlock();
+
+    /** This function parses the data lines in the specified range of the text block buffer, and
+        stores the converted values for each row in consecutive locations starting at the specified
+        pointer. If \em values is the null pointer, the function just counts the data lines. In
+        both cases the function returns the number of data lines in the range. */
+    size_t parseLines(char* begin, char* end, double* values);
+
+    /** This function memory-maps the binary column file with the specified path and reads the
+        column information and the pointers to the column data from its header. If the file cannot
+        be mapped or does not have the binary column file format, a fatal error is thrown. */
+    void openBinary(string filepath);
+
     //======================== Data Members ========================
 
 private:
-    std::ifstream _in;       // the input stream
-    Units* _units{nullptr};  // the units system
-    Log* _log{nullptr};      // the logger
+    std::ifstream _in;                     // the input stream
+    string _filepath;                      // the path of the input file
+    const SimulationItem* _item{nullptr};  // the simulation item that opened the file
+    Units* _units{nullptr};                // the units system
+    Log* _log{nullptr};                    // the logger
 
     // private type to store column info
     class ColumnInfo
@@ -277,6 +378,22 @@ private:
     size_t _numLogCols{0};     // number of logical columns, or number of program columns added so far
 
     vector<size_t> _logColIndices;  // zero-based index into _colv for each physical column to be read
+
+    // block reading
+    bool _readLines{false};       // becomes true if rows are read line by line rather than in blocks
+    bool _readBlocks{false};      // becomes true when the first block has been read
+    vector<char> _text;           // the text of the current block, always ending with a newline character
+    string _tail;                 // the incomplete last line of the previous block
+    vector<double> _blockValues;  // the converted values of the rows in the current block, in row-major order
+    size_t _blockNumRows{0};      // the number of rows in the current block
+    size_t _blockNextRow{0};      // the index of the next row to be handed out from the current block
+
+    // binary column file data; the path is empty for text files
+    string _binPath;                  // the path of the memory-mapped binary column file
+    vector<const char*> _binColumns;  // pointer to the first value of each physical column
+    vector<size_t> _binValueSizes;    // value size in bytes (4 or 8) for each physical column
+    size_t _binNumRows{0};            // the number of rows in the binary column file
+    size_t _binNextRow{0};            // the index of the next row to be read from the binary column file
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -10,7 +10,8 @@
 
 ////////////////////////////////////////////////////////////////////
 
-TimeLogger::TimeLogger(Log* log, string scope) : _log(log), _scope(scope), _started(std::chrono::steady_clock::now())
+TimeLogger::TimeLogger(Log* log, string scope)
+    : _log(log), _scope(scope), _started(std::chrono::steady_clock::now()), _trace("phase", scope)
 {
     if (log) log->info("Starting " + scope + "...");
 }
@@ -7,6 +7,7 @@
 #define TIMELOGGER_HPP
 
 #include "Basics.hpp"
+#include "TraceRecorder.hpp"
 #include <chrono>
 class Log;
 
@@ -18,7 +19,8 @@ class Log;
     respectively. Typical use is to construct an instance at the beginning of a scope; the finish
     message is automatically generated by the destructor when the instance goes out of scope.
     Nested pairs of start/finish messages can easily be obtained by using TimeLogger in different
-    scopes. */
+    scopes. If the TraceRecorder is enabled, each TimeLogger scope is also recorded as a timeline
+    event. */
 class TimeLogger
 {
 public:
@@ -37,6 +39,7 @@ private:
     Log* _log;
     string _scope;
     std::chrono::steady_clock::time_point _started;
+    TraceRecorder::Scope _trace;
 };
 
 ////////////////////////////////////////////////////////////////////
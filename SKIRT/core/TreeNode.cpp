@@ -86,6 +86,18 @@ void TreeNode::subdivide(vector<TreeNode*>& nodev)
 
 ////////////////////////////////////////////////////////////////////
 
+void TreeNode::attachChildren(vector<TreeNode*>& nodev)
+{
+    for (auto child : _children)
+    {
+        child->_id = nodev.size();
+        nodev.push_back(child);
+    }
+    addNeighbors();
+}
+
+////////////////////////////////////////////////////////////////////
+
 void TreeNode::addChild(TreeNode* child)
 {
     _children.push_back(child);
@@ -82,6 +82,16 @@ public:
         updated (through the addNeighbors() function). */
     void subdivide(vector<TreeNode*>& nodev);
 
+    /** This function appends pointers to the children of the node, which must have been created
+        earlier through the createChildren() function, to the specified node list, adjusting the
+        node identifiers of the children so that they match their index in the node list, and
+        updates the neighbor lists (through the addNeighbors() function). Together with
+        createChildren(), this function thus performs the same operation as subdivide(). Because
+        createChildren() affects only the node itself, this allows creating the children of nodes
+        in independent subtrees concurrently, and then adding them to the tree in a well-defined
+        order. */
+    void attachChildren(vector<TreeNode*>& nodev);
+
     /** This function creates new nodes partitioning the node, and adds these new nodes as its own
         child nodes. Subdivision happens according to a fixed scheme determined by each subclass.
         The children are assigned consecutive integer identifiers, starting with the identifier
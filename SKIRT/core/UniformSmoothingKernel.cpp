@@ -16,6 +16,13 @@ double UniformSmoothingKernel::density(double u) const
 
 //////////////////////////////////////////////////////////////////////
 
+void UniformSmoothingKernel::densities(int n, const double* uv, double* Wv) const
+{
+    for (int k = 0; k < n; ++k) Wv[k] = (uv[k] < 0.0 || uv[k] > 1.0) ? 0.0 : 0.75 / M_PI;
+}
+
+//////////////////////////////////////////////////////////////////////
+
 double UniformSmoothingKernel::generateRadius() const
 {
     double X = random()->uniform();
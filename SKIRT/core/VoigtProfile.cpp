@@ -6,10 +6,11 @@
 #include "VoigtProfile.hpp"
 #include "FatalError.hpp"
 #include "Random.hpp"
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////
 
-double VoigtProfile::value(double a, double x)
+namespace
 {
     // coefficients for the approximation function (Table A1, Smith+15)
     constexpr double A0 = 15.75328153963877;
@@ -29,11 +30,78 @@ double VoigtProfile::value(double a, double x)
     constexpr double B7 = 23.7489999060;
     constexpr double B8 = 1.82106170570;
 
+    // returns the terms of the approximation (Appendix A1, Smith+15) that are independent of and linear in a,
+    // for the core and intermediate regions (z = x*x < 25)
+    std::pair<double, double> coreTerms(double z)
+    {
+        double ez = exp(-z);
+        if (z <= 3.0) return std::make_pair(ez, -ez * (A0 + A1 / (z - A2 + A3 / (z - A4 + A5 / (z - A6)))));
+        return std::make_pair(ez, B0 + B1 / (z - B2 + B3 / (z + B4 + B5 / (z - B6 + B7 / (z - B8)))));
+    }
+
+    // returns the approximation in the wings (Appendix A1, Smith+15) for z = x*x >= 25
+    double wingValue(double a, double z)
+    {
+        return 0.5 * M_2_SQRTPI * a / (z - 1.5 - 1.5 / (z - 3.5 - 5.0 / (z - 5.5)));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+double VoigtProfile::value(double a, double x)
+{
     // calculation of the approximation (Appendix A1, Smith+15)
     double z = x * x;
     if (z <= 3.0) return exp(-z) * (1.0 - a * (A0 + A1 / (z - A2 + A3 / (z - A4 + A5 / (z - A6)))));
     if (z < 25.0) return exp(-z) + a * (B0 + B1 / (z - B2 + B3 / (z + B4 + B5 / (z - B6 + B7 / (z - B8)))));
-    return 0.5 * M_2_SQRTPI * a / (z - 1.5 - 1.5 / (z - 3.5 - 5.0 / (z - 5.5)));
+    return wingValue(a, z);
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the table with the a-independent and a-linear terms of the Voigt function approximation on a regular grid
+    // in |x| covering the core and intermediate regions; the wings are evaluated analytically
+    class ValueTable
+    {
+    public:
+        static constexpr double xmax = 5.;
+        static constexpr int numIntervals = 4000;
+
+        ValueTable() : _hv(2 * (numIntervals + 1))
+        {
+            for (int i = 0; i <= numIntervals; ++i)
+            {
+                double x = i * xmax / numIntervals;
+                auto terms = coreTerms(x * x);
+                _hv[2 * i] = terms.first;
+                _hv[2 * i + 1] = terms.second;
+            }
+        }
+
+        double value(double a, double x) const
+        {
+            x = abs(x);
+            if (x >= xmax) return wingValue(a, x * x);
+            double f = x * (numIntervals / xmax);
+            int i = static_cast<int>(f);
+            f -= i;
+            const double* h = _hv.data() + 2 * i;
+            return (1. - f) * (h[0] + a * h[1]) + f * (h[2] + a * h[3]);
+        }
+
+    private:
+        std::vector<double> _hv;  // interleaved a-independent and a-linear terms for each grid point
+    };
+}
+
+////////////////////////////////////////////////////////////////////
+
+double VoigtProfile::tabulatedValue(double a, double x)
+{
+    static const ValueTable table;
+    return table.value(a, x);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -102,3 +170,208 @@ double VoigtProfile::sample(double a, double x, Random* random)
 }
 
 ////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the table supporting the sampling of the parallel atom velocity from precomputed distributions; the table is
+    // organized as a grid of nodes over log10(a) and x >= 0, and for each node it holds an alias table for a set of
+    // bins with a fixed width in w = u - x covering the range of u where the Gaussian factor is nonnegligible
+    class SampleTable
+    {
+    public:
+        static constexpr double zmin = -7.;        // log10 of the smallest tabulated Voigt parameter
+        static constexpr double zmax = -1.;        // log10 of the largest tabulated Voigt parameter
+        static constexpr double dz = 0.5;          // step in log10(a) between nodes
+        static constexpr double xmax = 8.;         // largest tabulated dimensionless frequency
+        static constexpr double dx = 0.05;         // step in x between nodes
+        static constexpr double umax = 6.;         // half-width of the tabulated atom velocity range
+        static constexpr double dw = 0.1;          // width of the velocity bins
+        static constexpr int numSubIntervals = 4;  // number of subintervals for integrating over a bin
+
+        SampleTable()
+        {
+            _numZ = static_cast<int>(std::lround((zmax - zmin) / dz)) + 1;
+            _numX = static_cast<int>(std::lround(xmax / dx)) + 1;
+            _numBins = static_cast<int>(std::lround(2. * umax / dw)) + 1;
+            _kminv.resize(_numZ * _numX);
+            _massv.resize(_numZ * _numX);
+            _probv.resize(_numZ * _numX * _numBins);
+            _aliasv.resize(_numZ * _numX * _numBins);
+
+            std::vector<double> mv(_numBins);
+            for (int i = 0; i != _numZ; ++i)
+            {
+                double a = pow(10., zmin + i * dz);
+                for (int j = 0; j != _numX; ++j)
+                {
+                    double x = j * dx;
+                    int n = i * _numX + j;
+                    int kmin = static_cast<int>(std::floor((-x - umax) / dw));
+                    _kminv[n] = kmin;
+
+                    // integrate the unnormalized distribution exp(-(x+w)^2) * a/(w^2+a^2) over each bin,
+                    // approximating the Gaussian factor as piecewise linear so that the Lorentzian factor
+                    // (which is sharply peaked for small a) is integrated analytically
+                    double total = 0.;
+                    for (int b = 0; b != _numBins; ++b)
+                    {
+                        double wl = (kmin + b) * dw;
+                        double tl = atan(wl / a);
+                        double gl = exp(-(x + wl) * (x + wl));
+                        double ll = log(wl * wl + a * a);
+                        double m = 0.;
+                        for (int q = 1; q <= numSubIntervals; ++q)
+                        {
+                            double wr = (kmin + b + static_cast<double>(q) / numSubIntervals) * dw;
+                            double tr = atan(wr / a);
+                            double gr = exp(-(x + wr) * (x + wr));
+                            double lr = log(wr * wr + a * a);
+                            double slope = (gr - gl) / (wr - wl);
+                            m += (gl - slope * wl) * (tr - tl) + slope * 0.5 * a * (lr - ll);
+                            wl = wr;
+                            tl = tr;
+                            gl = gr;
+                            ll = lr;
+                        }
+                        mv[b] = m;
+                        total += m;
+                    }
+                    _massv[n] = total;
+                    buildAlias(mv, total, _probv.data() + n * _numBins, _aliasv.data() + n * _numBins);
+                }
+            }
+        }
+
+        // returns true if the given Voigt parameter a and frequency x >= 0 are within the tabulated range
+        bool contains(double a, double x) const
+        {
+            double z = log10(a);
+            return z >= zmin && z <= zmax && x < xmax;
+        }
+
+        // returns a random sample for the given Voigt parameter a and frequency x >= 0 within the tabulated range
+        double sample(double a, double x, Random* random) const
+        {
+            double z = log10(a);
+
+            // determine the surrounding nodes and the interpolation weights, which are linear in a and linear in
+            // exp(-x^2) so that the dominant dependencies of the core and wing contributions are well represented
+            int i = std::min(static_cast<int>((z - zmin) / dz), _numZ - 2);
+            double a0 = pow(10., zmin + i * dz);
+            double a1 = pow(10., zmin + (i + 1) * dz);
+            double pa = (a - a0) / (a1 - a0);
+            int j = std::min(static_cast<int>(x / dx), _numX - 2);
+            double e0 = exp(-(j * dx) * (j * dx));
+            double e1 = exp(-((j + 1) * dx) * ((j + 1) * dx));
+            double px = (exp(-x * x) - e0) / (e1 - e0);
+
+            // select one of the nodes with a probability proportional to its weight times its total mass,
+            // which effectively interpolates the unnormalized bin masses between the nodes
+            int n00 = i * _numX + j;
+            int n01 = n00 + 1;
+            int n10 = n00 + _numX;
+            int n11 = n10 + 1;
+            double w00 = (1. - pa) * (1. - px) * _massv[n00];
+            double w01 = (1. - pa) * px * _massv[n01];
+            double w10 = pa * (1. - px) * _massv[n10];
+            double w11 = pa * px * _massv[n11];
+            double r = random->uniform() * (w00 + w01 + w10 + w11);
+            int n = r < w00 ? n00 : (r < w00 + w01 ? n01 : (r < w00 + w01 + w10 ? n10 : n11));
+
+            // select a bin using the alias table for the selected node
+            double y = random->uniform() * _numBins;
+            int b = std::min(static_cast<int>(y), _numBins - 1);
+            if (y - b >= _probv[n * _numBins + b]) b = _aliasv[n * _numBins + b];
+
+            // sample the exact distribution within the bin using the rejection technique, with the Lorentzian
+            // factor as the comparison function and the maximum of the Gaussian factor in the bin as the bound
+            double wl = (_kminv[n] + b) * dw;
+            double wr = wl + dw;
+            double tl = atan(wl / a);
+            double tr = atan(wr / a);
+            double ul = x + wl;
+            double ur = x + wr;
+            double umin = (ul <= 0. && ur >= 0.) ? 0. : std::min(abs(ul), abs(ur));
+            double umin2 = umin * umin;
+            int attempts = 10000;
+            while (attempts--)
+            {
+                double u = x + a * tan(tl + (tr - tl) * random->uniform());
+                if (random->uniform() < exp(umin2 - u * u)) return u;
+            }
+            throw FATALERROR("Sampling from tabulated Voigt profile has failed");
+        }
+
+    private:
+        // builds the alias table for the given bin masses using Vose's method
+        void buildAlias(const std::vector<double>& mv, double total, double* probv, int* aliasv) const
+        {
+            std::vector<double> pv(_numBins);
+            std::vector<int> small, large;
+            for (int b = 0; b != _numBins; ++b)
+            {
+                pv[b] = mv[b] / total * _numBins;
+                if (pv[b] < 1.)
+                    small.push_back(b);
+                else
+                    large.push_back(b);
+            }
+            while (!small.empty() && !large.empty())
+            {
+                int s = small.back();
+                small.pop_back();
+                int l = large.back();
+                probv[s] = pv[s];
+                aliasv[s] = l;
+                pv[l] += pv[s] - 1.;
+                if (pv[l] < 1.)
+                {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+            for (int b : large)
+            {
+                probv[b] = 1.;
+                aliasv[b] = b;
+            }
+            for (int b : small)
+            {
+                probv[b] = 1.;
+                aliasv[b] = b;
+            }
+        }
+
+        int _numZ{0};
+        int _numX{0};
+        int _numBins{0};
+        std::vector<int> _kminv;     // index of the first bin on the global velocity grid, for each node
+        std::vector<double> _massv;  // total unnormalized mass, for each node
+        std::vector<double> _probv;  // alias table probabilities, for each node and bin
+        std::vector<int> _aliasv;    // alias table aliases, for each node and bin
+    };
+}
+
+////////////////////////////////////////////////////////////////////
+
+double VoigtProfile::tabulatedSample(double a, double x, Random* random)
+{
+    static const SampleTable table;
+
+    // make x positive and remember the orginal sign
+    double sign = 1.;
+    if (x < 0.)
+    {
+        sign = -1.;
+        x = -x;
+    }
+
+    // when x is large, the distribution is essentially a Gaussian centered on 1/x
+    if (x >= 8.) return sign / x + M_SQRT1_2 * random->gauss();
+
+    // use the table if the parameters are within range, and otherwise use the regular sampling procedure
+    if (!table.contains(a, x)) return sign * sample(a, x, random);
+    return sign * table.sample(a, x, random);
+}
+
+////////////////////////////////////////////////////////////////////
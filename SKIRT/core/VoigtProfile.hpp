@@ -77,6 +77,42 @@ namespace VoigtProfile
         (MNRAS, 449, 4336–4362) and Michel-Dansac et al. 2020 (A\&A), we use this approximation
         for \f$x \ge 8\f$. */
     double sample(double a, double x, Random* random);
+
+    /** This function returns the same approximation to the Voigt function \f$H(a,x)\f$ as the
+        value() function, but obtained by interpolation from a precomputed table rather than by
+        direct evaluation. The Smith et al. 2015 approximation used by value() is of the form
+        \f$H(a,x) = H_0(x) + a\,H_1(x)\f$ for \f$|x|<5\f$, so that it suffices to tabulate the
+        functions \f$H_0\f$ and \f$H_1\f$ on a fine regular grid in \f$|x|\f$ to cover the complete
+        range of \f$a\f$ values. The table is constructed on first use and shared by all threads.
+        Linear interpolation between the 4000 grid intervals results in a relative deviation from
+        value() of at most \f$10^{-4}\f$, and typically much smaller. For \f$|x|\ge5\f$, the
+        function uses the inexpensive analytical wing approximation, as does value(). */
+    double tabulatedValue(double a, double x);
+
+    /** This function samples a random value from the same probability distribution \f$P(u)\f$
+        as the sample() function, but using precomputed tables rather than a rejection loop over
+        the complete domain. The rejection method used by sample() requires up to 10 or 20 attempts
+        per sample for dimensionless frequencies \f$x\f$ in the transition between the core and
+        the wings of the profile, which is where many Lyman-alpha scattering events take place.
+
+        The table is defined on a grid of nodes in \f$\log_{10}a\f$ and \f$x\ge0\f$. For each
+        node, the velocity offset \f$w=u-x\f$ is divided into bins of fixed width, and the table
+        holds an alias table (Vose's method) for the probability of each bin, obtained by
+        integrating \f$P(u)\f$ over the bin while treating the sharply peaked Lorentzian factor
+        analytically. To generate a sample, the function selects one of the four surrounding nodes
+        with a probability proportional to the node's interpolation weight and its unnormalized
+        total probability, selects a bin from the alias table of that node, and finally samples
+        the exact distribution within the bin using a rejection technique that almost always
+        accepts the first attempt. Because the bins are defined relative to \f$x\f$, the Lorentzian
+        peak at \f$u=x\f$ is always reproduced at the correct location. The interpolation weights
+        are linear in \f$a\f$ and in \f$\mathrm{e}^{-x^2}\f$, reflecting the dominant dependencies of
+        the wing and core contributions, so that the resulting distribution is statistically
+        indistinguishable from the one produced by sample() for practical sample sizes.
+
+        The table is constructed on first use and shared by all threads. If \f$a\f$ is outside of
+        the tabulated range \f$10^{-7}\le a\le 10^{-1}\f$, the function falls back to sample(). As
+        for sample(), the distribution is approximated by a Gaussian for \f$|x|\ge8\f$. */
+    double tabulatedSample(double a, double x, Random* random);
 }
 
 ////////////////////////////////////////////////////////////////////
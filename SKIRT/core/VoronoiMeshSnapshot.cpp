@@ -11,7 +11,9 @@
 #include "ParallelFactory.hpp"
 #include "ProcessManager.hpp"
 #include "Random.hpp"
+#include "ShortArray.hpp"
 #include "SiteListInterface.hpp"
+#include "SnapshotRegistry.hpp"
 #include "SpatialGridPath.hpp"
 #include "SpatialGridPlotFile.hpp"
 #include "StringUtils.hpp"
@@ -86,16 +88,16 @@ private:
     Vec _r;                  // site position
     Vec _c;                  // centroid position
     double _volume{0.};      // volume
-    vector<int> _neighbors;  // list of neighbor indices in _cells vector
-    Array _properties;       // user-defined properties, if any
+    vector<int> _neighbors;  // list of neighbor indices in cells vector
+    int _index{-1};          // index of the user-defined properties in the snapshot's property storage, if any
 
 public:
     // constructor stores the specified site position; the other data members are set to zero or empty
     Cell(Vec r) : _r(r) {}
 
-    // constructor derives the site position from the first three property values and stores the user properties;
-    // the other data members are set to zero or empty
-    Cell(const Array& prop) : _r(prop[0], prop[1], prop[2]), _properties{prop} {}
+    // constructor stores the specified site position and the index of the corresponding user properties in the
+    // snapshot's property storage; the other data members are set to zero or empty
+    Cell(Vec r, int index) : _r(r), _index(index) {}
 
     // adjusts the site position with the specified offset
     void relax(double cx, double cy, double cz) { _r += Vec(cx, cy, cz); }
@@ -154,8 +156,8 @@ public:
     // returns a list of neighboring cell/site ids
     const vector<int>& neighbors() { return _neighbors; }
 
-    // returns the cell/site user properties, if any
-    const Array& properties() { return _properties; }
+    // returns the index of the cell/site user properties in the snapshot's property storage, or -1 if there are none
+    int index() const { return _index; }
 
     // writes the Voronoi cell geometry to the serialized data buffer, preceded by the specified cell index,
     // if the cell geometry has been calculated for this cell; otherwise does nothing
@@ -223,7 +225,7 @@ namespace
 class VoronoiMeshSnapshot::Node
 {
 private:
-    int _m;        // index in _cells to the site defining the split at this node
+    int _m;        // index in cells vector to the site defining the split at this node
     int _axis;     // split axis for this node (0,1,2)
     Node* _up;     // ptr to the parent node
     Node* _left;   // ptr to the left child node
@@ -335,35 +337,133 @@ public:
 
 ////////////////////////////////////////////////////////////////////
 
-VoronoiMeshSnapshot::VoronoiMeshSnapshot() {}
+// class to hold the Voronoi tessellation and the search structures built on top of it
+class VoronoiMeshSnapshot::Mesh
+{
+public:
+    // destructor destroys the cells and the search trees
+    ~Mesh()
+    {
+        for (auto cell : cells) delete cell;
+        for (auto tree : blocktrees) delete tree;
+    }
+
+    vector<Cell*> cells;             // cell objects, indexed on m
+    vector<vector<int>> blocklists;  // list of cell indices per block, indexed on i*_nb2+j*_nb+k
+    vector<Node*> blocktrees;        // root node of search tree or null for each block, indexed on i*_nb2+j*_nb+k
+    int maxNeighbors{0};             // largest number of neighbors (including walls) for a single cell
+};
 
 ////////////////////////////////////////////////////////////////////
 
-VoronoiMeshSnapshot::~VoronoiMeshSnapshot()
+namespace
+{
+    // returns the number of blocks in each direction for the search structures given the number of cells
+    int numBlocksForCells(int numCells)
+    {
+        return max(3, min(250, static_cast<int>(cbrt(numCells))));
+    }
+
+    // the maximum number of steps in a walk from a hint cell before falling back to the search structures
+    const int maxWalkSteps = 32;
+}
+
+////////////////////////////////////////////////////////////////////
+
+// on x86-64 Linux systems with the GNU compiler, compile the function marked with this macro for multiple instruction
+// set extensions; the version matching the capabilities of the processor is selected when the program is loaded;
+// fused multiply-add instructions are disabled so that all versions produce the same results, and floating point
+// operations are assumed not to trap so that conditional divisions can be vectorized
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__INTEL_COMPILER) && defined(__x86_64__) && defined(__linux__)
+#    define VORONOI_TARGET_CLONES \
+        __attribute__((target_clones("avx512f", "avx2", "default"), optimize("fp-contract=off", "no-trapping-math")))
+#else
+#    define VORONOI_TARGET_CLONES
+#endif
+
+namespace
 {
-    for (auto cell : _cells) delete cell;
-    for (auto tree : _blocktrees) delete tree;
+    // calculates, for each of the n neighbor sites with coordinates in xv, yv, zv, the distance along the ray with
+    // starting point r and direction k to the plane bisecting the neighbor site and the site pr, and stores it in sv;
+    // stores zero if the ray does not approach the plane. The loop has no data-dependent branches so that it can be
+    // vectorized, and it evaluates the expressions in the same order as the equivalent calculation with Vec objects.
+    VORONOI_TARGET_CLONES void intersectBisectors(int n, const double* __restrict xv, const double* __restrict yv,
+                                                  const double* __restrict zv, Vec pr, Vec r, Vec k,
+                                                  double* __restrict sv)
+    {
+        const double prx = pr.x(), pry = pr.y(), prz = pr.z();
+        const double rx = r.x(), ry = r.y(), rz = r.z();
+        const double kx = k.x(), ky = k.y(), kz = k.z();
+        for (int i = 0; i < n; i++)
+        {
+            double nx = xv[i] - prx;
+            double ny = yv[i] - pry;
+            double nz = zv[i] - prz;
+            double px = 0.5 * (xv[i] + prx);
+            double py = 0.5 * (yv[i] + pry);
+            double pz = 0.5 * (zv[i] + prz);
+            double ndotk = nx * kx + ny * ky + nz * kz;
+            double ndotp = nx * (px - rx) + ny * (py - ry) + nz * (pz - rz);
+            sv[i] = ndotk > 0 ? ndotp / ndotk : 0.;
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
+VoronoiMeshSnapshot::VoronoiMeshSnapshot() {}
+
+////////////////////////////////////////////////////////////////////
+
+VoronoiMeshSnapshot::~VoronoiMeshSnapshot() {}
+
+////////////////////////////////////////////////////////////////////
+
 void VoronoiMeshSnapshot::readAndClose()
 {
-    // read the site info into memory
+    // look for a Voronoi mesh already built by another snapshot for the same sites and domain
+    string key = meshKey(infile()->columnSignature(positionIndex(), 3));
+    bool shared = findSharedMesh(key);
+    if (!shared) _mesh = std::make_shared<Mesh>();
+
+    // read the site info into memory, skipping sites outside of the domain so that they are never stored;
+    // the site position is given by the first three property values
+    int numOutside = 0;
     Array prop;
-    while (infile()->readRow(prop)) _cells.push_back(new Cell(prop));
+    while (infile()->readRow(prop))
+    {
+        Vec r(prop[0], prop[1], prop[2]);
+        if (!_extent.contains(r))
+        {
+            numOutside++;
+            continue;
+        }
+        if (!shared) _mesh->cells.push_back(new Cell(r, numStoredEntities()));
+        storeProperties(prop);
+    }
 
     // close the file
     Snapshot::readAndClose();
 
-    // calculate the Voronoi cells
-    buildMesh(false);
+    // calculate the Voronoi cells, unless the mesh is shared, and offer the mesh to other snapshots
+    if (!shared)
+    {
+        buildMesh(false, numOutside);
+        registry()->add(key, _mesh);
+    }
+
+    // bring the stored properties in the same order as the remaining cells, and release the site positions
+    vector<int> indices;
+    indices.reserve(_mesh->cells.size());
+    for (auto cell : _mesh->cells) indices.push_back(cell->index());
+    reorderStoredProperties(indices);
+    releaseStoredProperties(positionIndex(), 3);
 
     // if a mass density policy has been set, calculate masses and densities for all cells
     if (hasMassDensityPolicy())
     {
         // allocate vectors for mass and density
-        size_t n = _cells.size();
+        size_t n = _mesh->cells.size();
         Array Mv(n);
         _rhov.resize(n);
 
@@ -379,21 +479,20 @@ void VoronoiMeshSnapshot::readAndClose()
         int numIgnored = 0;
         for (size_t m = 0; m != n; ++m)
         {
-            const Array& prop = _cells[m]->properties();
-
             // original mass is zero if temperature is above cutoff or if imported mass/density is not positive
             double originalMass = 0.;
-            if (maxT && prop[temperatureIndex()] > maxT)
+            if (maxT && storedProperty(m, temperatureIndex()) > maxT)
                 numIgnored++;
             else
-                originalMass =
-                    max(0., massIndex() >= 0 ? prop[massIndex()] : prop[densityIndex()] * _cells[m]->volume());
+                originalMass = max(0., massIndex() >= 0
+                                           ? storedProperty(m, massIndex())
+                                           : storedProperty(m, densityIndex()) * _mesh->cells[m]->volume());
 
-            double metallicMass = originalMass * (useMetallicity() ? prop[metallicityIndex()] : 1.);
+            double metallicMass = originalMass * (useMetallicity() ? storedProperty(m, metallicityIndex()) : 1.);
             double effectiveMass = metallicMass * multiplier();
 
             Mv[m] = effectiveMass;
-            _rhov[m] = effectiveMass / _cells[m]->volume();
+            _rhov[m] = effectiveMass / _mesh->cells[m]->volume();
 
             totalOriginalMass += originalMass;
             totalMetallicMass += metallicMass;
@@ -413,11 +512,16 @@ void VoronoiMeshSnapshot::readAndClose()
         // remember the effective mass
         _mass = totalEffectiveMass;
 
+        // release the imported properties that are no longer needed now that the densities have been calculated
+        releaseStoredProperties(massIndex());
+        releaseStoredProperties(densityIndex());
+        releaseStoredProperties(metallicityIndex());
+
         // construct a vector with the normalized cumulative site densities
         if (n) NR::cdf(_cumrhov, Mv);
 
-        // build the search data structure
-        buildSearch();
+        // build the search data structure, unless a snapshot sharing the mesh already did so
+        if (_mesh->blocklists.empty()) buildSearch();
     }
 }
 
@@ -433,20 +537,43 @@ void VoronoiMeshSnapshot::setExtent(const Box& extent)
 
 VoronoiMeshSnapshot::VoronoiMeshSnapshot(const SimulationItem* item, const Box& extent, string filename, bool relax)
 {
-    // read the input file
+    // open the input file
     TextInFile in(item, filename, "Voronoi sites");
     in.addColumn("position x", "length", "pc");
     in.addColumn("position y", "length", "pc");
     in.addColumn("position z", "length", "pc");
+    setContext(item);
+    setExtent(extent);
+
+    // if the sites are not relaxed, look for a Voronoi mesh already built by another snapshot for the same sites
+    string key = meshKey(in.columnSignature(0, 3));
+    if (!relax && findSharedMesh(key))
+    {
+        in.close();
+        if (_mesh->blocklists.empty()) buildSearch();
+        return;
+    }
+
+    // read the input file, skipping sites outside of the domain and remembering the index of each retained site
+    // in the same way as readAndClose() so that the mesh can be shared with a snapshot importing the same sites
+    _mesh = std::make_shared<Mesh>();
+    int numOutside = 0;
     Array coords;
-    while (in.readRow(coords)) _cells.push_back(new Cell(Vec(coords[0], coords[1], coords[2])));
+    int index = 0;
+    while (in.readRow(coords))
+    {
+        Vec r(coords[0], coords[1], coords[2]);
+        if (extent.contains(r))
+            _mesh->cells.push_back(new Cell(r, index++));
+        else
+            numOutside++;
+    }
     in.close();
 
-    // calculate the Voronoi cells
-    setContext(item);
-    setExtent(extent);
-    buildMesh(relax);
+    // calculate the Voronoi cells, and offer the mesh to other snapshots if the sites were not relaxed
+    buildMesh(relax, numOutside);
     buildSearch();
+    if (!relax) registry()->add(key, _mesh);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -456,13 +583,14 @@ VoronoiMeshSnapshot::VoronoiMeshSnapshot(const SimulationItem* item, const Box&
 {
     // prepare the data
     int n = sli->numSites();
-    _cells.resize(n);
-    for (int m = 0; m != n; ++m) _cells[m] = new Cell(sli->sitePosition(m));
+    _mesh = std::make_shared<Mesh>();
+    _mesh->cells.resize(n);
+    for (int m = 0; m != n; ++m) _mesh->cells[m] = new Cell(sli->sitePosition(m));
 
     // calculate the Voronoi cells
     setContext(item);
     setExtent(extent);
-    buildMesh(relax);
+    buildMesh(relax, 0);
     buildSearch();
 }
 
@@ -473,13 +601,14 @@ VoronoiMeshSnapshot::VoronoiMeshSnapshot(const SimulationItem* item, const Box&
 {
     // prepare the data
     int n = sites.size();
-    _cells.resize(n);
-    for (int m = 0; m != n; ++m) _cells[m] = new Cell(sites[m]);
+    _mesh = std::make_shared<Mesh>();
+    _mesh->cells.resize(n);
+    for (int m = 0; m != n; ++m) _mesh->cells[m] = new Cell(sites[m]);
 
     // calculate the Voronoi cells
     setContext(item);
     setExtent(extent);
-    buildMesh(relax);
+    buildMesh(relax, 0);
     buildSearch();
 }
 
@@ -493,33 +622,64 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
-void VoronoiMeshSnapshot::buildMesh(bool relax)
+string VoronoiMeshSnapshot::meshKey(string positionSignature) const
 {
-    // remove sites that lie outside of the domain
-    int numOutside = 0;
-    for (int m = _cells.size() - 1; m >= 0; --m)
+    string key = "VoronoiMesh|" + positionSignature;
+    for (Vec corner : {_extent.rmin(), _extent.rmax()})
+        for (double value : {corner.x(), corner.y(), corner.z()}) key += "|" + StringUtils::toString(value, 'e', 16);
+    return key;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool VoronoiMeshSnapshot::findSharedMesh(string key)
+{
+    _mesh = registry()->lookup<Mesh>(key);
+    if (!_mesh) return false;
+
+    // initialize the number of blocks in the same way as buildMesh() does
+    int numCells = _mesh->cells.size();
+    log()->info("  Reusing Voronoi tessellation with " + std::to_string(numCells) + " cells built for the same sites");
+    if (numCells)
+    {
+        _nb = numBlocksForCells(numCells);
+        _nb2 = _nb * _nb;
+        _nb3 = _nb * _nb * _nb;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void VoronoiMeshSnapshot::buildMesh(bool relax, int numOutside)
+{
+    // remove sites that lie outside of the domain, preserving the order of the remaining sites
+    size_t numInside = 0;
+    for (Cell* cell : _mesh->cells)
     {
-        if (!_extent.contains(_cells[m]->position()))
+        if (_extent.contains(cell->position()))
+            _mesh->cells[numInside++] = cell;
+        else
         {
-            delete _cells[m];
-            _cells.erase(_cells.cbegin() + m);
+            delete cell;
             numOutside++;
         }
     }
+    _mesh->cells.resize(numInside);
 
     // sort sites in order of increasing x coordinate to accelerate search for nearby sites
-    std::sort(_cells.begin(), _cells.end(), [](Cell* c1, Cell* c2) { return c1->x() < c2->x(); });
+    std::sort(_mesh->cells.begin(), _mesh->cells.end(), [](Cell* c1, Cell* c2) { return c1->x() < c2->x(); });
 
     // remove sites that lie too nearby another site
     int numNearby = 0;
-    for (int m = _cells.size() - 1; m >= 0; --m)
+    for (int m = _mesh->cells.size() - 1; m >= 0; --m)
     {
-        for (int j = m - 1; j >= 0 && _cells[m]->x() - _cells[j]->x() < _eps; --j)
+        for (int j = m - 1; j >= 0 && _mesh->cells[m]->x() - _mesh->cells[j]->x() < _eps; --j)
         {
-            if ((_cells[m]->position() - _cells[j]->position()).norm2() < _eps * _eps)
+            if ((_mesh->cells[m]->position() - _mesh->cells[j]->position()).norm2() < _eps * _eps)
             {
-                delete _cells[m];
-                _cells.erase(_cells.cbegin() + m);
+                delete _mesh->cells[m];
+                _mesh->cells.erase(_mesh->cells.cbegin() + m);
                 numNearby++;
                 break;
             }
@@ -527,7 +687,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     }
 
     // log the number of sites
-    int numCells = _cells.size();
+    int numCells = _mesh->cells.size();
     if (!numOutside && !numNearby)
     {
         log()->info("  Number of sites: " + std::to_string(numCells));
@@ -543,7 +703,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     if (numCells <= 0) return;
 
     // calculate number of blocks in each direction based on number of cells
-    _nb = max(3, min(250, static_cast<int>(cbrt(numCells))));
+    _nb = numBlocksForCells(numCells);
     _nb2 = _nb * _nb;
     _nb3 = _nb * _nb * _nb;
 
@@ -559,7 +719,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
                              _extent.zmax(), _nb, _nb, _nb);
         for (int m = 0; m != numCells; ++m)
         {
-            Vec r = _cells[m]->position();
+            Vec r = _mesh->cells[m]->position();
             vcon.put(m, r.x(), r.y(), r.z());
         }
 
@@ -599,7 +759,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
 
         // communicate the calculated offsets between parallel processes, if needed, and apply them to the cells
         ProcessManager::sumToAll(offsets.data());
-        for (int m = 0; m != numCells; ++m) _cells[m]->relax(offsets(m, 0), offsets(m, 1), offsets(m, 2));
+        for (int m = 0; m != numCells; ++m) _mesh->cells[m]->relax(offsets(m, 0), offsets(m, 1), offsets(m, 2));
     }
 
     // add the final sites to a temporary Voronoi container, using the cell index m as ID
@@ -607,7 +767,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
                          _nb, _nb, _nb);
     for (int m = 0; m != numCells; ++m)
     {
-        Vec r = _cells[m]->position();
+        Vec r = _mesh->cells[m]->position();
         vcon.put(m, r.x(), r.y(), r.z());
     }
 
@@ -636,7 +796,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
                     if (!ok) throw FATALERROR("Can't compute Voronoi cell");
 
                     // copy all relevant information to the cell object that will stay around
-                    _cells[m]->init(vcell);
+                    _mesh->cells[m]->init(vcell);
 
                     // log message if the minimum time has elapsed
                     numDone = (numDone + 1) % logProgressChunkSize;
@@ -651,12 +811,12 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     {
         auto producer = [this](vector<double>& data) {
             SerializedWrite wdata(data);
-            int numCells = _cells.size();
-            for (int m = 0; m != numCells; ++m) _cells[m]->writeGeometryIfPresent(wdata, m);
+            int numCells = _mesh->cells.size();
+            for (int m = 0; m != numCells; ++m) _mesh->cells[m]->writeGeometryIfPresent(wdata, m);
         };
         auto consumer = [this](const vector<double>& data) {
             SerializedRead rdata(data);
-            while (!rdata.empty()) _cells[rdata.readInt()]->readGeometry(rdata);
+            while (!rdata.empty()) _mesh->cells[rdata.readInt()]->readGeometry(rdata);
         };
         ProcessManager::broadcastAllToAll(producer, consumer);
     }
@@ -667,7 +827,7 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     int64_t totNeighbors = 0;
     for (int m = 0; m < numCells; m++)
     {
-        int ns = _cells[m]->neighbors().size();
+        int ns = _mesh->cells[m]->neighbors().size();
         totNeighbors += ns;
         minNeighbors = min(minNeighbors, ns);
         maxNeighbors = max(maxNeighbors, ns);
@@ -679,6 +839,9 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     log()->info("  Average number of neighbors per cell: " + StringUtils::toString(avgNeighbors, 'f', 1));
     log()->info("  Minimum number of neighbors per cell: " + std::to_string(minNeighbors));
     log()->info("  Maximum number of neighbors per cell: " + std::to_string(maxNeighbors));
+
+    // remember the largest number of neighbors for sizing the buffers used when calculating paths
+    _mesh->maxNeighbors = maxNeighbors;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -691,7 +854,7 @@ VoronoiMeshSnapshot::Node* VoronoiMeshSnapshot::buildTree(vector<int>::iterator
     {
         auto median = length >> 1;
         std::nth_element(first, first + median, last, [this, depth](int m1, int m2) {
-            return m1 != m2 && lessthan(_cells[m1]->position(), _cells[m2]->position(), depth % 3);
+            return m1 != m2 && lessthan(_mesh->cells[m1]->position(), _mesh->cells[m2]->position(), depth % 3);
         });
         return new VoronoiMeshSnapshot::Node(*(first + median), depth, buildTree(first, first + median, depth + 1),
                                              buildTree(first + median + 1, last, depth + 1));
@@ -704,7 +867,7 @@ VoronoiMeshSnapshot::Node* VoronoiMeshSnapshot::buildTree(vector<int>::iterator
 void VoronoiMeshSnapshot::buildSearch()
 {
     // abort if there are no cells
-    int numCells = _cells.size();
+    int numCells = _mesh->cells.size();
     if (!numCells) return;
 
     log()->info("Building data structures to accelerate searching the Voronoi tesselation");
@@ -712,17 +875,17 @@ void VoronoiMeshSnapshot::buildSearch()
     // -------------  block lists  -------------
 
     // initialize a vector of nb x nb x nb lists, each containing the cells overlapping a certain block in the domain
-    _blocklists.resize(_nb3);
+    _mesh->blocklists.resize(_nb3);
 
     // add the cell object to the lists for all blocks it may overlap
     int i1, j1, k1, i2, j2, k2;
     for (int m = 0; m != numCells; ++m)
     {
-        _extent.cellIndices(i1, j1, k1, _cells[m]->rmin() - Vec(_eps, _eps, _eps), _nb, _nb, _nb);
-        _extent.cellIndices(i2, j2, k2, _cells[m]->rmax() + Vec(_eps, _eps, _eps), _nb, _nb, _nb);
+        _extent.cellIndices(i1, j1, k1, _mesh->cells[m]->rmin() - Vec(_eps, _eps, _eps), _nb, _nb, _nb);
+        _extent.cellIndices(i2, j2, k2, _mesh->cells[m]->rmax() + Vec(_eps, _eps, _eps), _nb, _nb, _nb);
         for (int i = i1; i <= i2; i++)
             for (int j = j1; j <= j2; j++)
-                for (int k = k1; k <= k2; k++) _blocklists[i * _nb2 + j * _nb + k].push_back(m);
+                for (int k = k1; k <= k2; k++) _mesh->blocklists[i * _nb2 + j * _nb + k].push_back(m);
     }
 
     // compile block list statistics
@@ -731,7 +894,7 @@ void VoronoiMeshSnapshot::buildSearch()
     int64_t totalBlockRefs = 0;
     for (int b = 0; b < _nb3; b++)
     {
-        int refs = _blocklists[b].size();
+        int refs = _mesh->blocklists[b].size();
         totalBlockRefs += refs;
         minRefsPerBlock = min(minRefsPerBlock, refs);
         maxRefsPerBlock = max(maxRefsPerBlock, refs);
@@ -748,17 +911,17 @@ void VoronoiMeshSnapshot::buildSearch()
 
     // for each block that contains more than a predefined number of cells,
     // construct a search tree on the site locations of the cells
-    _blocktrees.resize(_nb3);
+    _mesh->blocktrees.resize(_nb3);
     for (int b = 0; b < _nb3; b++)
     {
-        vector<int>& ids = _blocklists[b];
-        if (ids.size() > 9) _blocktrees[b] = buildTree(ids.begin(), ids.end(), 0);
+        vector<int>& ids = _mesh->blocklists[b];
+        if (ids.size() > 9) _mesh->blocktrees[b] = buildTree(ids.begin(), ids.end(), 0);
     }
 
     // compile and log search tree statistics
     int numTrees = 0;
     for (int b = 0; b < _nb3; b++)
-        if (_blocktrees[b]) numTrees++;
+        if (_mesh->blocktrees[b]) numTrees++;
     log()->info("  Number of search trees: " + std::to_string(numTrees) + " ("
                 + StringUtils::toString(100. * numTrees / _nb3, 'f', 1) + "% of blocks)");
 }
@@ -767,10 +930,10 @@ void VoronoiMeshSnapshot::buildSearch()
 
 bool VoronoiMeshSnapshot::isPointClosestTo(Vec r, int m, const vector<int>& ids) const
 {
-    double target = _cells[m]->squaredDistanceTo(r);
+    double target = _mesh->cells[m]->squaredDistanceTo(r);
     for (int id : ids)
     {
-        if (id >= 0 && _cells[id]->squaredDistanceTo(r) < target) return false;
+        if (id >= 0 && _mesh->cells[id]->squaredDistanceTo(r) < target) return false;
     }
     return true;
 }
@@ -786,12 +949,12 @@ void VoronoiMeshSnapshot::writeGridPlotFiles(const SimulationItem* probe) const
     SpatialGridPlotFile plotxyz(probe, probe->itemName() + "_grid_xyz");
 
     // load all sites in a Voro container
-    int numCells = _cells.size();
+    int numCells = _mesh->cells.size();
     voro::container vcon(_extent.xmin(), _extent.xmax(), _extent.ymin(), _extent.ymax(), _extent.zmin(), _extent.zmax(),
                          _nb, _nb, _nb);
     for (int m = 0; m != numCells; ++m)
     {
-        Vec r = _cells[m]->position();
+        Vec r = _mesh->cells[m]->position();
         vcon.put(m, r.x(), r.y(), r.z());
     }
 
@@ -816,7 +979,7 @@ void VoronoiMeshSnapshot::writeGridPlotFiles(const SimulationItem* probe) const
             vcell.face_vertices(indices);
 
             // write the edges of the cell to the plot files
-            Box bounds = _cells[vloop.pid()]->extent();
+            Box bounds = _mesh->cells[vloop.pid()]->extent();
             if (bounds.zmin() <= 0 && bounds.zmax() >= 0) plotxy.writePolyhedron(coords, indices);
             if (bounds.ymin() <= 0 && bounds.ymax() >= 0) plotxz.writePolyhedron(coords, indices);
             if (bounds.xmin() <= 0 && bounds.xmax() >= 0) plotyz.writePolyhedron(coords, indices);
@@ -839,43 +1002,42 @@ Box VoronoiMeshSnapshot::extent() const
 
 int VoronoiMeshSnapshot::numEntities() const
 {
-    return _cells.size();
+    return _mesh->cells.size();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position VoronoiMeshSnapshot::position(int m) const
 {
-    return Position(_cells[m]->position());
+    return Position(_mesh->cells[m]->position());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position VoronoiMeshSnapshot::centroidPosition(int m) const
 {
-    return Position(_cells[m]->centroid());
+    return Position(_mesh->cells[m]->centroid());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double VoronoiMeshSnapshot::volume(int m) const
 {
-    return _cells[m]->volume();
+    return _mesh->cells[m]->volume();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Box VoronoiMeshSnapshot::extent(int m) const
 {
-    return _cells[m]->extent();
+    return _mesh->cells[m]->extent();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double VoronoiMeshSnapshot::temperature(int m) const
 {
-    const Array& prop = _cells[m]->properties();
-    return prop[temperatureIndex()];
+    return storedProperty(m, temperatureIndex());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -890,8 +1052,8 @@ double VoronoiMeshSnapshot::temperature(Position bfr) const
 
 Vec VoronoiMeshSnapshot::velocity(int m) const
 {
-    const Array& prop = _cells[m]->properties();
-    return Vec(prop[velocityIndex() + 0], prop[velocityIndex() + 1], prop[velocityIndex() + 2]);
+    return Vec(storedProperty(m, velocityIndex() + 0), storedProperty(m, velocityIndex() + 1),
+               storedProperty(m, velocityIndex() + 2));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -906,8 +1068,7 @@ Vec VoronoiMeshSnapshot::velocity(Position bfr) const
 
 double VoronoiMeshSnapshot::velocityDispersion(int m) const
 {
-    const Array& prop = _cells[m]->properties();
-    return prop[velocityDispersionIndex()];
+    return storedProperty(m, velocityDispersionIndex());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -922,8 +1083,8 @@ double VoronoiMeshSnapshot::velocityDispersion(Position bfr) const
 
 Vec VoronoiMeshSnapshot::magneticField(int m) const
 {
-    const Array& prop = _cells[m]->properties();
-    return Vec(prop[magneticFieldIndex() + 0], prop[magneticFieldIndex() + 1], prop[magneticFieldIndex() + 2]);
+    return Vec(storedProperty(m, magneticFieldIndex() + 0), storedProperty(m, magneticFieldIndex() + 1),
+               storedProperty(m, magneticFieldIndex() + 2));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -940,8 +1101,7 @@ void VoronoiMeshSnapshot::parameters(int m, Array& params) const
 {
     int n = numParameters();
     params.resize(n);
-    const Array& prop = _cells[m]->properties();
-    for (int i = 0; i != n; ++i) params[i] = prop[parametersIndex() + i];
+    for (int i = 0; i != n; ++i) params[i] = storedProperty(m, parametersIndex() + i);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -979,11 +1139,54 @@ double VoronoiMeshSnapshot::mass() const
 
 ////////////////////////////////////////////////////////////////////
 
+bool VoronoiMeshSnapshot::hasMassInBox() const
+{
+    return hasMassDensityPolicy();
+}
+
+////////////////////////////////////////////////////////////////////
+
+double VoronoiMeshSnapshot::massInBox(const Box& box) const
+{
+    // abort if there are no cells
+    if (_mesh->blocklists.empty()) return 0.;
+
+    // find indices for first and last block possibly overlapping the box
+    int i1, j1, k1, i2, j2, k2;
+    _extent.cellIndices(i1, j1, k1, box.rmin(), _nb, _nb, _nb);
+    _extent.cellIndices(i2, j2, k2, box.rmax(), _nb, _nb, _nb);
+
+    double sum = 0.;
+    for (int i = i1; i <= i2; i++)
+        for (int j = j1; j <= j2; j++)
+            for (int k = k1; k <= k2; k++)
+            {
+                for (int m : _mesh->blocklists[i * _nb2 + j * _nb + k])
+                {
+                    // visit the cell only from the first block in the range that is overlapped by its bounding box
+                    const Box& bounds = _mesh->cells[m]->extent();
+                    int ci, cj, ck;
+                    _extent.cellIndices(ci, cj, ck, bounds.rmin() - Vec(_eps, _eps, _eps), _nb, _nb, _nb);
+                    if (max(ci, i1) != i || max(cj, j1) != j || max(ck, k1) != k) continue;
+
+                    // add the cell mass multiplied by the fraction of its bounding box inside the box
+                    double dx = min(bounds.xmax(), box.xmax()) - max(bounds.xmin(), box.xmin());
+                    double dy = min(bounds.ymax(), box.ymax()) - max(bounds.ymin(), box.ymin());
+                    double dz = min(bounds.zmax(), box.zmax()) - max(bounds.zmin(), box.zmin());
+                    if (dx > 0. && dy > 0. && dz > 0.)
+                        sum += _rhov[m] * _mesh->cells[m]->volume() * dx * dy * dz / bounds.volume();
+                }
+            }
+    return sum;
+}
+
+////////////////////////////////////////////////////////////////////
+
 Position VoronoiMeshSnapshot::generatePosition(int m) const
 {
     // get loop-invariant information about the cell
-    const Box& box = _cells[m]->extent();
-    const vector<int>& neighbors = _cells[m]->neighbors();
+    const Box& box = _mesh->cells[m]->extent();
+    const vector<int>& neighbors = _mesh->cells[m]->neighbors();
 
     // generate random points in the enclosing box until one happens to be inside the cell
     for (int i = 0; i < 10000; i++)
@@ -999,7 +1202,7 @@ Position VoronoiMeshSnapshot::generatePosition(int m) const
 Position VoronoiMeshSnapshot::generatePosition() const
 {
     // if there are no sites, return the origin
-    if (_cells.empty()) return Position();
+    if (_mesh->cells.empty()) return Position();
 
     // select a site according to its mass contribution
     int m = NR::locateClip(_cumrhov, random()->uniform());
@@ -1020,17 +1223,17 @@ int VoronoiMeshSnapshot::cellIndex(Position bfr) const
     int b = i * _nb2 + j * _nb + k;
 
     // look for the closest site in this block, using the search tree if there is one
-    Node* tree = _blocktrees[b];
-    if (tree) return tree->nearest(bfr, _cells)->m();
+    Node* tree = _mesh->blocktrees[b];
+    if (tree) return tree->nearest(bfr, _mesh->cells)->m();
 
     // if there is no search tree, simply loop over the index list
-    const vector<int>& ids = _blocklists[b];
+    const vector<int>& ids = _mesh->blocklists[b];
     int m = -1;
     double mdist = DBL_MAX;
     int n = ids.size();
     for (int i = 0; i < n; i++)
     {
-        double idist = _cells[ids[i]]->squaredDistanceTo(bfr);
+        double idist = _mesh->cells[ids[i]]->squaredDistanceTo(bfr);
         if (idist < mdist)
         {
             m = ids[i];
@@ -1042,6 +1245,43 @@ int VoronoiMeshSnapshot::cellIndex(Position bfr) const
 
 ////////////////////////////////////////////////////////////////////
 
+int VoronoiMeshSnapshot::cellIndex(Position bfr, int hintCell) const
+{
+    // make sure the position is inside the domain
+    if (!_extent.contains(bfr)) return -1;
+
+    // if there is no valid hint, use the search structures
+    int numCells = _mesh->cells.size();
+    if (hintCell < 0 || hintCell >= numCells) return cellIndex(bfr);
+
+    // walk to the neighbor with the site closest to the point until no neighbor is closer than the current site
+    int m = hintCell;
+    double mdist = _mesh->cells[m]->squaredDistanceTo(bfr);
+    for (int step = 0; step != maxWalkSteps; ++step)
+    {
+        int next = -1;
+        for (int i : _mesh->cells[m]->neighbors())
+        {
+            if (i >= 0)
+            {
+                double idist = _mesh->cells[i]->squaredDistanceTo(bfr);
+                if (idist < mdist)
+                {
+                    next = i;
+                    mdist = idist;
+                }
+            }
+        }
+        if (next < 0) return m;
+        m = next;
+    }
+
+    // if the walk did not end, use the search structures
+    return cellIndex(bfr);
+}
+
+////////////////////////////////////////////////////////////////////
+
 void VoronoiMeshSnapshot::path(SpatialGridPath* path) const
 {
     // Initialize the path
@@ -1050,75 +1290,79 @@ void VoronoiMeshSnapshot::path(SpatialGridPath* path) const
     // If the photon packet starts outside the dust grid, move it into the first grid cell that it will pass
     Position r = path->moveInside(_extent, _eps);
 
-    // Get the index of the cell containing the current position;
+    // Get the index of the cell containing the current position, using the cell hint if there is one;
     // if the position is not inside the grid, return an empty path
-    int mr = cellIndex(r);
+    int mr = cellIndex(r, path->cellHint());
     if (mr < 0) return path->clear();
 
+    // Allocate buffers for the neighbor site coordinates and the corresponding intersection distances
+    int maxNeighbors = _mesh->maxNeighbors;
+    ShortArray<4 * 64> buffer(4 * maxNeighbors);
+    double* xv = &buffer[0];
+    double* yv = xv + maxNeighbors;
+    double* zv = yv + maxNeighbors;
+    double* sv = zv + maxNeighbors;
+
     // Start the loop over cells/path segments until we leave the grid
     while (mr >= 0)
     {
         // get the site position for this cell
-        Vec pr = _cells[mr]->position();
+        Vec pr = _mesh->cells[mr]->position();
 
-        // initialize the smallest nonnegative intersection distance and corresponding index
-        double sq = DBL_MAX;       // very large, but not infinity (so that infinite si values are discarded)
-        const int NO_INDEX = -99;  // meaningless cell index
-        int mq = NO_INDEX;
-
-        // loop over the list of neighbor indices
-        const vector<int>& mv = _cells[mr]->neighbors();
+        // gather the site positions of the neighboring cells into the coordinate buffers, substituting the site
+        // position of this cell for domain walls
+        const vector<int>& mv = _mesh->cells[mr]->neighbors();
         int n = mv.size();
+        bool hasWalls = false;
         for (int i = 0; i < n; i++)
         {
             int mi = mv[i];
-
-            // declare the intersection distance for this neighbor (init to a value that will be rejected)
-            double si = 0;
-
-            // --- intersection with neighboring cell
+            Vec pi = pr;
             if (mi >= 0)
-            {
-                // get the site position for this neighbor
-                Vec pi = _cells[mi]->position();
-
-                // calculate the (unnormalized) normal on the bisecting plane
-                Vec n = pi - pr;
+                pi = _mesh->cells[mi]->position();
+            else
+                hasWalls = true;
+            xv[i] = pi.x();
+            yv[i] = pi.y();
+            zv[i] = pi.z();
+        }
 
-                // calculate the denominator of the intersection quotient
-                double ndotk = Vec::dot(n, bfk);
+        // calculate the intersection distances for all neighbors in one go
+        intersectBisectors(n, xv, yv, zv, pr, r, bfk, sv);
 
-                // if the denominator is negative the intersection distance is negative, so don't calculate it
-                if (ndotk > 0)
-                {
-                    // calculate a point on the bisecting plane
-                    Vec p = 0.5 * (pi + pr);
-
-                    // calculate the intersection distance
-                    si = Vec::dot(n, p - r) / ndotk;
-                }
-            }
-
-            // --- intersection with domain wall
-            else
+        // replace the intersection distances for domain walls
+        if (hasWalls)
+        {
+            for (int i = 0; i < n; i++)
             {
-                switch (mi)
+                int mi = mv[i];
+                if (mi < 0)
                 {
-                    case -1: si = (extent().xmin() - r.x()) / bfk.x(); break;
-                    case -2: si = (extent().xmax() - r.x()) / bfk.x(); break;
-                    case -3: si = (extent().ymin() - r.y()) / bfk.y(); break;
-                    case -4: si = (extent().ymax() - r.y()) / bfk.y(); break;
-                    case -5: si = (extent().zmin() - r.z()) / bfk.z(); break;
-                    case -6: si = (extent().zmax() - r.z()) / bfk.z(); break;
-                    default: throw FATALERROR("Invalid neighbor ID");
+                    switch (mi)
+                    {
+                        case -1: sv[i] = (extent().xmin() - r.x()) / bfk.x(); break;
+                        case -2: sv[i] = (extent().xmax() - r.x()) / bfk.x(); break;
+                        case -3: sv[i] = (extent().ymin() - r.y()) / bfk.y(); break;
+                        case -4: sv[i] = (extent().ymax() - r.y()) / bfk.y(); break;
+                        case -5: sv[i] = (extent().zmin() - r.z()) / bfk.z(); break;
+                        case -6: sv[i] = (extent().zmax() - r.z()) / bfk.z(); break;
+                        default: throw FATALERROR("Invalid neighbor ID");
+                    }
                 }
             }
+        }
 
-            // remember the smallest nonnegative intersection point
+        // determine the smallest nonnegative intersection distance and corresponding index
+        double sq = DBL_MAX;       // very large, but not infinity (so that infinite si values are discarded)
+        const int NO_INDEX = -99;  // meaningless cell index
+        int mq = NO_INDEX;
+        for (int i = 0; i < n; i++)
+        {
+            double si = sv[i];
             if (si > 0 && si < sq)
             {
                 sq = si;
-                mq = mi;
+                mq = mv[i];
             }
         }
 
@@ -1126,7 +1370,7 @@ void VoronoiMeshSnapshot::path(SpatialGridPath* path) const
         if (mq == NO_INDEX)
         {
             r += bfk * _eps;
-            mr = cellIndex(r);
+            mr = cellIndex(r, mr);
         }
         // otherwise add a path segment and set the current point to the exit point
         else
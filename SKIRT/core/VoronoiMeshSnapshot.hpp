@@ -8,6 +8,7 @@
 
 #include "Array.hpp"
 #include "Snapshot.hpp"
+#include <memory>
 class SiteListInterface;
 class SpatialGridPath;
 
@@ -41,6 +42,14 @@ class SpatialGridPath;
     configuration sequence of the object, so that the getters can be used immediately after
     construction.
 
+    The Voronoi tessellation and the search structures built on top of it are held in a private
+    data structure that can be shared between VoronoiMeshSnapshot objects. Snapshots that import
+    their sites from the same file columns into the same spatial domain (e.g., a medium and a source
+    importing the same hydrodynamical snapshot, or a spatial grid reading its sites from that same
+    file) locate each other's tessellation through the SnapshotRegistry of the simulation, so that
+    the tessellation is constructed and stored only once. Tessellations of relaxed site positions
+    are never shared.
+
     This class uses the Voro++ code written by Chris H. Rycroft (LBL / UC Berkeley) to build the
     Voronoi tesselation. Once an VoronoiMeshSnapshot object has been constructed and fully
     configured, its data is no longer modified. Consequently all getters are re-entrant. */
@@ -61,17 +70,19 @@ public:
 public:
     /** This function reads the snapshot data from the input file, honoring the options set through
         the configuration functions, stores the data for later use, and closes the file by calling
-        the base class Snapshot::readAndClose() function. Sites located outside of the domain and
-        sites that are too close to another site are discarded. Sites with an associated
+        the base class Snapshot::readAndClose() function. Sites located outside of the domain are
+        skipped while reading the file, so that their properties are never stored, and sites that
+        are too close to another site are discarded. Sites with an associated
         temperature above the cutoff temperature (if one has been configured) are assigned a
         density value of zero, so that the corresponding cell has zero mass (regardless of the
         imported mass/density properties).
 
         The function calls the private buildMesh() function to build the Voronoi mesh based on the
-        imported site positions. If the snapshot configuration requires the ability to determine
-        the density at a given spatial position, the function also calls the private buildSearch()
-        function to create a data structure that accelerates locating the cell containing a given
-        point.
+        imported site positions, unless another snapshot has already built the mesh for the same
+        site positions and domain, in which case that mesh is reused. If the snapshot configuration
+        requires the ability to determine the density at a given spatial position, the function
+        also calls the private buildSearch() function (if needed) to create a data structure that
+        accelerates locating the cell containing a given point.
 
         During its operation, the function logs some statistical information about the imported
         snapshot and the resulting data structures. */
@@ -142,6 +153,21 @@ private:
         and buildSearch() functions. */
     class Node;
 
+    /** Private class to hold the Voronoi tessellation and the search structures built on top of
+        it, so that they can be shared between snapshots through the snapshot registry. */
+    class Mesh;
+
+    /** This private function returns the key identifying the Voronoi tessellation for the sites
+        given by the specified position column signature (see TextInFile::columnSignature()) in
+        the configured spatial domain. */
+    string meshKey(string positionSignature) const;
+
+    /** This private function looks for a Voronoi mesh registered with the specified key by
+        another snapshot. If such a mesh exists, the function adopts it as the mesh for this
+        snapshot, initializes the corresponding search block counts, and returns true. Otherwise,
+        the function leaves the mesh for this snapshot undefined and returns false. */
+    bool findSharedMesh(string key);
+
     /** Given a list of generating sites (represented as partially initialized Cell
         objects), this private function builds the Voronoi tessellation and stores the
         corresponding cell information, including any properties relevant for supporting the
@@ -153,7 +179,9 @@ private:
 
         Before actually starting to build the Voronoi tessellation, the function discards sites
         (represented as Cell objects) outside of the domain and sites that are too close to
-        another site.
+        another site. The \em numOutside argument specifies the number of sites outside of the
+        domain that have already been discarded by the caller while reading the sites; it is used
+        only for logging the total number of discarded sites.
 
         If the \em relax argument is true, the function performs a single relaxation step on the
         site positions using Lloyd's algorithm (Lloyd 1982; Du, Faber and Gunzburger 1999, SIAM
@@ -163,7 +191,7 @@ private:
         constructed with these adjusted site positions, which are distributed more uniformly,
         thereby avoiding overly elongated cells in the Voronoi tessellation. Relaxation can be
         quite time-consuming because the Voronoi tessellation must be constructed twice. */
-    void buildMesh(bool relax);
+    void buildMesh(bool relax, int numOutside);
 
     /** Private function to recursively build a binary search tree (see
         en.wikipedia.org/wiki/Kd-tree) */
@@ -309,6 +337,19 @@ public:
         undefined. */
     Position generatePosition() const override;
 
+    /** This function returns true if a density policy has been set, indicating that the cell
+        masses and the search data structures are available to calculate the mass inside a box. */
+    bool hasMassInBox() const override;
+
+    /** This function returns the mass represented by the snapshot inside the specified box. It
+        uses the block lists of the search data structure to visit only the cells that may overlap
+        the box. Each cell contributes its mass multiplied by the fraction of the volume of its
+        bounding box inside the box. As a result, cells fully inside the box contribute their
+        complete mass, and the masses for a set of boxes tiling the domain add up to the total
+        mass. If no density policy has been set or no mass information is being imported, the
+        behavior is undefined. */
+    double massInBox(const Box& box) const override;
+
     /** This function returns the cell index \f$0\le m \le N_{cells}-1\f$ for the cell containing
         the specified point \f${\bf{r}}\f$. If the point is outside the domain, the function
         returns -1. By definition of a Voronoi tesselation, the closest site position determines
@@ -328,6 +369,21 @@ public:
         cellIndex() function causes undefined behavior. */
     int cellIndex(Position bfr) const;
 
+    /** This function returns the cell index \f$0\le m \le N_{cells}-1\f$ for the cell containing
+        the specified point \f${\bf{r}}\f$, given the index of a cell that is likely to contain
+        the point or to lie close to it. If the point is outside the domain, the function returns
+        -1. If the hint is not a valid cell index, the function calls the cellIndex() function
+        without hint.
+
+        Starting from the hint cell, the function repeatedly moves to the neighbor with the site
+        closest to the specified point, for as long as that site is closer to the point than the
+        site of the current cell. By the nature of a Voronoi tessellation, the walk ends in the
+        cell containing the point. For a hint cell that contains or borders the point, this
+        requires just one or two passes over the neighbor lists, which is much faster than a lookup
+        in the search data structures. If the walk does not end after a small number of steps, the
+        function falls back to calling the cellIndex() function without hint. */
+    int cellIndex(Position bfr, int hintCell) const;
+
     //====================== Path construction =====================
 
 public:
@@ -340,7 +396,8 @@ public:
         so, the current point is simply initialized to the start point. If not, the function
         computes the path segment to the first intersection with one of the domain walls and moves
         the current point inside the domain. Finally the function determines the current cell, i.e.
-        the cell containing the current point.
+        the cell containing the current point. If the path carries a cell hint, the function uses
+        it to locate the current cell through a walk over neighboring cells.
 
         In the second stage, the function loops over the algorithm that computes the exit point
         from the current cell, i.e. the intersection of the ray formed by the current point and
@@ -351,7 +408,7 @@ public:
         the path is complete and the loop is terminated. If no exit point is found, which shouldn't
         happen too often, this must be due to computational inaccuracies. In that case, no path
         segment is added, the current point is advanced by a small amount, and the new current cell
-        is determined by calling the function whichcell().
+        is determined by walking from the previous current cell.
 
         The algorithm that computes the exit point has the following input data:
         <TABLE>
@@ -407,6 +464,14 @@ public:
         position vectors for the wall plane in this last formula. For example, for the left wall
         with \f$m_i=-1\f$ one has \f$\mathbf{n}=(-1,0,0)\f$ and \f$\mathbf{p}=(x_\text{min},0,0)\f$
         so that \f[s_i=\frac{x_\text{min}-r_x}{k_x}.\f]
+
+        In the implementation, the site positions of the neighbors of the current cell are first
+        gathered into separate coordinate buffers, so that the intersection distances for all
+        neighbors can be calculated in a single loop without data-dependent branches. The compiler
+        can vectorize this loop, and on x86-64 Linux systems built with the GNU compiler, it is
+        compiled for the AVX-512 and AVX2 instruction set extensions in addition to the baseline
+        instruction set. The version matching the capabilities of the processor is selected at run
+        time. The intersection distances for domain walls are filled in afterwards.
     */
     void path(SpatialGridPath* path) const;
 
@@ -417,20 +482,17 @@ private:
     Box _extent;      // the spatial domain of the mesh
     double _eps{0.};  // small fraction of extent
 
-    // data members initialized when processing snapshot input and further completed by BuildMesh()
-    vector<Cell*> _cells;  // cell objects, indexed on m
+    // data members initialized when processing snapshot input and further completed by BuildMesh() and BuildSearch();
+    // the mesh may be shared with other snapshots
+    std::shared_ptr<Mesh> _mesh;  // cell objects and search structures
+    int _nb{0};                   // number of blocks in each dimension (limit for indices i,j,k)
+    int _nb2{0};                  // nb*nb
+    int _nb3{0};                  // nb*nb*nb
 
     // data members initialized when processing snapshot input, but only if a density policy has been set
     Array _rhov;       // density for each cell (not normalized)
     Array _cumrhov;    // normalized cumulative density distribution for cells
     double _mass{0.};  // total effective mass
-
-    // data members initialized by BuildSearch()
-    int _nb{0};                       // number of blocks in each dimension (limit for indices i,j,k)
-    int _nb2{0};                      // nb*nb
-    int _nb3{0};                      // nb*nb*nb
-    vector<vector<int>> _blocklists;  // list of cell indices per block, indexed on i*_nb2+j*_nb+k
-    vector<Node*> _blocktrees;        // root node of search tree or null for each block, indexed on i*_nb2+j*_nb+k
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -0,0 +1,70 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "CacheMissCounter.hpp"
+#include <cstring>
+
+#ifdef __linux__
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////
+
+CacheMissCounter::~CacheMissCounter()
+{
+#ifdef __linux__
+    if (_fd >= 0) close(_fd);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+
+void CacheMissCounter::start()
+{
+#ifdef __linux__
+    if (_fd >= 0) close(_fd);
+
+    // configure a hardware event counting cache misses for this process and its future threads
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    _fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    if (_fd >= 0)
+    {
+        ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+
+int64_t CacheMissCounter::stop()
+{
+    int64_t count = -1;
+#ifdef __linux__
+    if (_fd >= 0)
+    {
+        ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t value = 0;
+        if (read(_fd, &value, sizeof(value)) == sizeof(value)) count = static_cast<int64_t>(value);
+        close(_fd);
+        _fd = -1;
+    }
+#endif
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,45 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef CACHEMISSCOUNTER_HPP
+#define CACHEMISSCOUNTER_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** A CacheMissCounter instance counts the hardware cache misses (i.e. references to the last
+    level cache that could not be served from that cache) incurred by the current process between
+    the calls to start() and stop(). The count includes the cache misses incurred by any threads
+    that are created by the calling thread after the call to start(), provided these threads have
+    exited before the call to stop().
+
+    The counter relies on the Linux performance events interface. On other operating systems, and
+    on Linux systems where the interface is not accessible (e.g. because of the system's security
+    settings or because the process runs inside a virtual machine without access to the hardware
+    performance counters), the counter is not available and the stop() function returns -1. */
+class CacheMissCounter
+{
+public:
+    /** The constructor creates a counter that is not yet started. */
+    CacheMissCounter() {}
+
+    /** The destructor releases any operating system resources held by the counter. */
+    ~CacheMissCounter();
+
+    /** This function starts counting cache misses. */
+    void start();
+
+    /** This function stops counting and returns the number of cache misses since the call to
+        start(), or -1 if the counter is not available. */
+    int64_t stop();
+
+private:
+    int _fd{-1};
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
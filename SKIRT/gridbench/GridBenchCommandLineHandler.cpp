@@ -0,0 +1,417 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "GridBenchCommandLineHandler.hpp"
+#include "BenchmarkUtils.hpp"
+#include "BuildInfo.hpp"
+#include "CacheMissCounter.hpp"
+#include "CommandLineArguments.hpp"
+#include "Console.hpp"
+#include "FatalError.hpp"
+#include "FilePaths.hpp"
+#include "Log.hpp"
+#include "MonteCarloSimulation.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "SimulationItemRegistry.hpp"
+#include "SpatialGrid.hpp"
+#include "SpatialGridPath.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include "XmlHierarchyCreator.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the names of the supported grid types, in the order they are benchmarked by default
+    const vector<string> gridNames = {"Cylinder2D", "Sphere2D", "Cartesian", "OctTree",
+                                      "BinTree",    "Voronoi",  "AdaptiveMesh"};
+
+    // the name of the synthetic adaptive mesh file written to the output directory
+    const string meshFileName = "GridBenchAdaptiveMesh.txt";
+
+    // the name of the report file written to the output directory
+    const string reportFileName = "gridbench_report.json";
+
+    // the half-width of the spatial domain, in pc
+    const double domainSize = 4000.;
+
+    // the scale length of the Plummer distribution in the adaptive mesh file, in pc
+    const double plummerScale = 500.;
+
+    // recursively writes the nodes of an adaptive mesh for a Plummer distribution, refining each
+    // node until its mass drops below the specified value or the maximum level is reached
+    void writeMeshNode(std::ofstream& out, double xmin, double ymin, double zmin, double width, double maxMass,
+                       int level)
+    {
+        double x = xmin + 0.5 * width;
+        double y = ymin + 0.5 * width;
+        double z = zmin + 0.5 * width;
+        double density = pow(1. + (x * x + y * y + z * z) / (plummerScale * plummerScale), -2.5);
+        if (level < 10 && density * width * width * width > maxMass)
+        {
+            out << "! 2 2 2\n";
+            double half = 0.5 * width;
+            for (int k = 0; k != 2; ++k)
+                for (int j = 0; j != 2; ++j)
+                    for (int i = 0; i != 2; ++i)
+                        writeMeshNode(out, xmin + i * half, ymin + j * half, zmin + k * half, half, maxMass, level + 1);
+        }
+        else
+        {
+            out << density << '\n';
+        }
+    }
+
+    // writes a synthetic adaptive mesh file with approximately the specified number of cells
+    void writeMeshFile(string path, int numCells)
+    {
+        std::ofstream out = System::ofstream(path);
+        out << "# Synthetic adaptive mesh for the SKIRT grid benchmark\n";
+        out << "# column 1: number density (1/cm3)\n";
+
+        // the root node has 4x4x4 children
+        const int numRoot = 4;
+        double width = 2. * domainSize / numRoot;
+        double maxMass = 4. * M_PI / 3. * plummerScale * plummerScale * plummerScale / numCells;
+        out << "! " << numRoot << " " << numRoot << " " << numRoot << "\n";
+        for (int k = 0; k != numRoot; ++k)
+            for (int j = 0; j != numRoot; ++j)
+                for (int i = 0; i != numRoot; ++i)
+                    writeMeshNode(out, -domainSize + i * width, -domainSize + j * width, -domainSize + k * width,
+                                  width, maxMass, 1);
+    }
+
+    // returns the ski file contents for a simulation with the specified medium and grid
+    string skiContents(string medium, string grid)
+    {
+        return R"(<?xml version="1.0" encoding="UTF-8"?>
+<skirt-simulation-hierarchy type="MonteCarloSimulation" format="9" producer="gridbench" time="2020-01-01T00:00:00">
+    <MonteCarloSimulation userLevel="Expert" simulationMode="ExtinctionOnly" numPackets="0">
+        <units type="Units">
+            <ExtragalacticUnits/>
+        </units>
+        <sourceSystem type="SourceSystem">
+            <SourceSystem minWavelength="0.1 micron" maxWavelength="1 micron">
+                <sources type="Source">
+                    <PointSource positionX="0 pc" positionY="0 pc" positionZ="0 pc">
+                        <sed type="SED">
+                            <BlackBodySED temperature="6000 K"/>
+                        </sed>
+                        <normalization type="LuminosityNormalization">
+                            <IntegratedLuminosityNormalization wavelengthRange="Source" integratedLuminosity="1 Lsun"/>
+                        </normalization>
+                    </PointSource>
+                </sources>
+            </SourceSystem>
+        </sourceSystem>
+        <mediumSystem type="MediumSystem">
+            <MediumSystem>
+                <media type="Medium">
+)" + medium + R"(
+                </media>
+                <grid type="SpatialGrid">
+)" + grid + R"(
+                </grid>
+            </MediumSystem>
+        </mediumSystem>
+        <instrumentSystem type="InstrumentSystem">
+            <InstrumentSystem>
+                <defaultWavelengthGrid type="WavelengthGrid">
+                    <LogWavelengthGrid minWavelength="0.1 micron" maxWavelength="1 micron" numWavelengths="5"/>
+                </defaultWavelengthGrid>
+            </InstrumentSystem>
+        </instrumentSystem>
+    </MonteCarloSimulation>
+</skirt-simulation-hierarchy>
+)";
+    }
+
+    // returns the ski file contents for the specified grid type and approximate number of cells
+    string skiContents(string gridName, int numCells)
+    {
+        string box = "minX=\"-4 kpc\" maxX=\"4 kpc\" minY=\"-4 kpc\" maxY=\"4 kpc\" minZ=\"-4 kpc\" maxZ=\"4 kpc\"";
+        string linMesh2D = "<LinMesh numBins=\"" + std::to_string(max(1, static_cast<int>(sqrt(numCells)))) + "\"/>";
+        string linMesh3D = "<LinMesh numBins=\"" + std::to_string(max(1, static_cast<int>(cbrt(numCells)))) + "\"/>";
+        string fraction = StringUtils::toString(min(1e-2, 1. / numCells), 'e', 3);
+
+        string medium = R"(<GeometricMedium>
+    <geometry type="Geometry">
+        <ExpDiskGeometry scaleLength="1 kpc" scaleHeight="0.1 kpc"/>
+    </geometry>
+    <materialMix type="MaterialMix">
+        <ElectronMix/>
+    </materialMix>
+    <normalization type="MaterialNormalization">
+        <OpticalDepthMaterialNormalization axis="Z" wavelength="0.55 micron" opticalDepth="1"/>
+    </normalization>
+</GeometricMedium>)";
+
+        if (gridName == "Cylinder2D")
+            return skiContents(medium, "<Cylinder2DSpatialGrid maxRadius=\"4 kpc\" minZ=\"-4 kpc\" maxZ=\"4 kpc\">"
+                                       "<meshRadial type=\"Mesh\">"
+                                           + linMesh2D + "</meshRadial><meshZ type=\"MoveableMesh\">" + linMesh2D
+                                           + "</meshZ></Cylinder2DSpatialGrid>");
+        if (gridName == "Sphere2D")
+            return skiContents(medium, "<Sphere2DSpatialGrid maxRadius=\"4 kpc\"><meshRadial type=\"Mesh\">"
+                                           + linMesh2D + "</meshRadial><meshPolar type=\"Mesh\">" + linMesh2D
+                                           + "</meshPolar></Sphere2DSpatialGrid>");
+        if (gridName == "Cartesian")
+            return skiContents(medium, "<CartesianSpatialGrid " + box + "><meshX type=\"MoveableMesh\">" + linMesh3D
+                                           + "</meshX><meshY type=\"MoveableMesh\">" + linMesh3D
+                                           + "</meshY><meshZ type=\"MoveableMesh\">" + linMesh3D
+                                           + "</meshZ></CartesianSpatialGrid>");
+        if (gridName == "OctTree" || gridName == "BinTree")
+        {
+            bool oct = gridName == "OctTree";
+            return skiContents(medium, "<PolicyTreeSpatialGrid " + box + " treeType=\"" + gridName
+                                           + "\"><policy type=\"TreePolicy\"><DensityTreePolicy minLevel=\""
+                                           + (oct ? "3" : "9") + "\" maxLevel=\"" + (oct ? "12" : "36")
+                                           + "\" maxElectronFraction=\"" + fraction
+                                           + "\"/></policy></PolicyTreeSpatialGrid>");
+        }
+        if (gridName == "Voronoi")
+            return skiContents(medium, "<VoronoiMeshSpatialGrid " + box + " policy=\"ElectronDensity\" numSites=\""
+                                           + std::to_string(numCells) + "\"/>");
+        if (gridName == "AdaptiveMesh")
+            return skiContents("<AdaptiveMeshMedium filename=\"" + meshFileName + "\" " + box
+                                   + " massType=\"NumberDensity\"><materialMix type=\"MaterialMix\"><ElectronMix/>"
+                                     "</materialMix></AdaptiveMeshMedium>",
+                               "<AdaptiveMeshSpatialGrid/>");
+        throw FATALERROR("Unknown grid type: " + gridName);
+    }
+
+    // returns a random position inside the specified box and a random direction for the ray with the specified index;
+    // the values depend only on the index so that the same rays are used regardless of the number of threads;
+    // a splitmix64 generator is used because its seeding cost is negligible compared to the grid operations
+    void randomRay(const Box& box, size_t index, Position& bfr, Direction& bfk)
+    {
+        uint64_t state = index * 0x9E3779B97F4A7C15ULL;
+        auto uniform = [&state]() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            return (z >> 11) * (1. / 9007199254740992.);
+        };
+        bfr = Position(box.fracPos(uniform(), uniform(), uniform()));
+        double costheta = 2. * uniform() - 1.;
+        double sintheta = sqrt(max(0., 1. - costheta * costheta));
+        double phi = 2. * M_PI * uniform();
+        bfk = Direction(sintheta * cos(phi), sintheta * sin(phi), costheta);
+    }
+
+    // holds the results for a benchmark with a given grid and number of threads
+    struct Result
+    {
+        string grid;
+        int cells;
+        int threads;
+        double setupTime;
+        double nsPerSegment;
+        double segmentsPerRay;
+        double cacheMissesPerRay;
+        double cellIndexPerSecondPerThread;
+    };
+
+    // runs the benchmark for the specified grid and number of threads
+    Result benchmark(const SpatialGrid* grid, size_t numRays, int threads)
+    {
+        using namespace std::chrono;
+        Result result;
+        result.cells = grid->numCells();
+        result.threads = threads;
+        Box box = grid->boundingBox();
+
+        // trace the rays through the grid; the parallel factory is destroyed (and its threads are joined)
+        // before the cache miss counter is stopped so that the misses incurred by all threads are included
+        std::atomic<size_t> numSegments{0};
+        CacheMissCounter counter;
+        counter.start();
+        double pathTime = 0.;
+        {
+            ParallelFactory factory;
+            factory.setMaxThreadCount(threads);
+            auto started = steady_clock::now();
+            auto tracer = [grid, &box, &numSegments](size_t firstIndex, size_t numIndices) {
+                SpatialGridPath path;
+                size_t segments = 0;
+                for (size_t index = firstIndex; index != firstIndex + numIndices; ++index)
+                {
+                    Position bfr;
+                    Direction bfk;
+                    randomRay(box, index, bfr, bfk);
+                    path.setPosition(bfr);
+                    path.setDirection(bfk);
+                    grid->path(&path);
+                    segments += path.segments().size();
+                }
+                numSegments += segments;
+            };
+            factory.parallelProcessOnly()->call(numRays, tracer);
+            pathTime = duration_cast<nanoseconds>(steady_clock::now() - started).count();
+        }
+        int64_t cacheMisses = counter.stop();
+
+        // locate the cells containing the ray origins; the indices are accumulated so that the lookups are not
+        // optimized away
+        std::atomic<size_t> indexSum{0};
+        double lookupTime = 0.;
+        {
+            ParallelFactory factory;
+            factory.setMaxThreadCount(threads);
+            auto started = steady_clock::now();
+            auto locator = [grid, &box, &indexSum](size_t firstIndex, size_t numIndices) {
+                size_t sum = 0;
+                for (size_t index = firstIndex; index != firstIndex + numIndices; ++index)
+                {
+                    Position bfr;
+                    Direction bfk;
+                    randomRay(box, index, bfr, bfk);
+                    sum += grid->cellIndex(bfr);
+                }
+                indexSum += sum;
+            };
+            factory.parallelProcessOnly()->call(numRays, locator);
+            lookupTime = duration_cast<nanoseconds>(steady_clock::now() - started).count();
+        }
+
+        // the cost of generating the random rays is included in both timings; it is small compared to the cost of
+        // tracing a path or locating a cell
+        result.nsPerSegment = numSegments ? pathTime * threads / numSegments : 0.;
+        result.segmentsPerRay = static_cast<double>(numSegments) / numRays;
+        result.cacheMissesPerRay = cacheMisses >= 0 ? static_cast<double>(cacheMisses) / numRays : -1.;
+        result.cellIndexPerSecondPerThread = lookupTime > 0. ? numRays * 1e9 / lookupTime / threads : 0.;
+        return result;
+    }
+
+    // prints the usage synopsis
+    void printUsage()
+    {
+        Console::warning("gridbench [-g <grid_names>] [-c <num_cells>] [-r <num_rays>]");
+        Console::warning("          [-t <max_threads>] [-o <output_dirpath>]");
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+int GridBenchCommandLineHandler::perform()
+{
+    // Catch and properly report any exceptions
+    try
+    {
+        Console::warning("Welcome to the SKIRT spatial grid benchmark " + BuildInfo::projectVersion() + " "
+                         + BuildInfo::timestamp());
+
+        // Process and validate the command line arguments
+        CommandLineArguments args(System::arguments(), "-g* -c* -r* -t* -o*");
+        if (!args.isValid() || args.hasFilepaths())
+        {
+            Console::error("Invalid command line arguments. Usage synopsis:");
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        // Get the parameters, providing defaults where needed
+        vector<string> grids = args.isPresent("-g") ? StringUtils::split(args.value("-g"), ",") : gridNames;
+        for (string grid : grids)
+            if (!StringUtils::contains(gridNames, grid)) throw FATALERROR("Unknown grid type: " + grid);
+        int numCells = args.isPresent("-c") ? static_cast<int>(args.doubleValue("-c")) : 100000;
+        size_t numRays = args.isPresent("-r") ? static_cast<size_t>(args.doubleValue("-r")) : 1000000;
+        if (numCells < 1 || numRays < 1) throw FATALERROR("The number of cells and rays must be positive");
+        int maxThreads = args.intValue("-t");
+        if (maxThreads < 1) maxThreads = max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        string outPath = args.value("-o");
+        if (outPath.empty()) outPath = "gridbench";
+        if (!System::makeDir(outPath)) throw FATALERROR("Cannot create the output directory: " + outPath);
+        outPath = System::canonicalPath(outPath);
+
+        // Generate the synthetic adaptive mesh file, if needed
+        if (StringUtils::contains(grids, "AdaptiveMesh"))
+            writeMeshFile(StringUtils::joinPaths(outPath, meshFileName), numCells);
+
+        // Run the benchmarks
+        vector<Result> results;
+        auto schema = SimulationItemRegistry::getSchemaDef();
+        for (string gridName : grids)
+        {
+            Console::info("Constructing " + gridName + " grid...");
+
+            // construct and set up a simulation hierarchy that includes the grid
+            auto topitem = XmlHierarchyCreator::readString(schema, skiContents(gridName, numCells), gridName);
+            auto simulation = dynamic_cast<MonteCarloSimulation*>(topitem.get());
+            simulation->filePaths()->setOutputPrefix("gridbench_" + gridName);
+            simulation->filePaths()->setInputPath(outPath);
+            simulation->filePaths()->setOutputPath(outPath);
+            simulation->log()->setLowestLevel(Log::Level::Error);
+            simulation->parallelFactory()->setMaxThreadCount(maxThreads);
+            auto started = std::chrono::steady_clock::now();
+            simulation->setupAndRun();
+            double setupTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            const SpatialGrid* grid = simulation->mediumSystem()->grid();
+
+            // trace the rays for each number of threads
+            for (int threads : BenchmarkUtils::threadCounts(maxThreads))
+            {
+                Result result = benchmark(grid, numRays, threads);
+                result.grid = gridName;
+                result.setupTime = setupTime;
+                results.push_back(result);
+
+                Console::success(gridName + " (" + std::to_string(result.cells) + " cells) with "
+                                 + std::to_string(threads) + " thread(s): "
+                                 + StringUtils::toString(result.nsPerSegment, 'f', 1) + " ns/segment -- "
+                                 + StringUtils::toString(result.segmentsPerRay, 'f', 1) + " segments/ray -- "
+                                 + (result.cacheMissesPerRay >= 0.
+                                        ? StringUtils::toString(result.cacheMissesPerRay, 'f', 1)
+                                        : string("n/a"))
+                                 + " cache misses/ray -- "
+                                 + StringUtils::toString(result.cellIndexPerSecondPerThread, 'g', 3)
+                                 + " cellIndex/s/thread");
+            }
+        }
+
+        // Write the report
+        string reportPath = StringUtils::joinPaths(outPath, reportFileName);
+        {
+            std::ofstream out = System::ofstream(reportPath);
+            out << "{\n\"gridbench\": {\"version\": " << StringUtils::toJsonString(BuildInfo::projectVersion())
+                << ", \"host\": " << StringUtils::toJsonString(System::hostname())
+                << ", \"timestamp\": " << StringUtils::toJsonString(System::timestamp(true))
+                << ", \"rays\": " << numRays << "},\n\"results\": [\n";
+            for (size_t i = 0; i != results.size(); ++i)
+            {
+                const Result& r = results[i];
+                out << "{\"grid\": " << StringUtils::toJsonString(r.grid) << ", \"cells\": " << r.cells
+                    << ", \"threads\": " << r.threads
+                    << ", \"setupTime\": " << BenchmarkUtils::jsonNumber(r.setupTime)
+                    << ", \"nsPerSegment\": " << BenchmarkUtils::jsonNumber(r.nsPerSegment)
+                    << ", \"segmentsPerRay\": " << BenchmarkUtils::jsonNumber(r.segmentsPerRay)
+                    << ", \"cacheMissesPerRay\": " << BenchmarkUtils::jsonNumber(r.cacheMissesPerRay)
+                    << ", \"cellIndexPerSecondPerThread\": "
+                    << BenchmarkUtils::jsonNumber(r.cellIndexPerSecondPerThread) << "}"
+                    << (i + 1 != results.size() ? ",\n" : "\n");
+            }
+            out << "]\n}\n";
+        }
+        Console::success("Wrote benchmark report to " + reportPath);
+        return EXIT_SUCCESS;
+    }
+    catch (const FatalError& error)
+    {
+        for (auto line : error.message()) Console::error(line);
+    }
+    catch (const std::exception& except)
+    {
+        Console::error("Standard Library Exception: " + string(except.what()));
+    }
+    return EXIT_FAILURE;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,60 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef GRIDBENCHCOMMANDLINEHANDLER_HPP
+#define GRIDBENCHCOMMANDLINEHANDLER_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/**
+This class offers a static function to process the command line arguments for the gridbench
+utility and to run the spatial grid microbenchmark accordingly. The benchmark measures the cost of
+the SpatialGrid::path() and SpatialGrid::cellIndex() functions in isolation, so that the
+performance of the various spatial grid types can be compared, and the effect of traversal
+optimizations can be evaluated, without the noise caused by the other parts of a simulation. When
+invoked with invalid command line arguments, it prints a brief help message. The following
+command line arguments are supported; they are all optional:
+
+\verbatim
+    gridbench [-g <grid_names>] [-c <num_cells>] [-r <num_rays>]
+              [-t <max_threads>] [-o <output_dirpath>]
+\endverbatim
+
+The grid names (the -g option) are given as a comma-separated list selected from \c Cylinder2D,
+\c Sphere2D, \c Cartesian, \c OctTree, \c BinTree, \c Voronoi and \c AdaptiveMesh. By default,
+all grid types are benchmarked. Each grid is constructed by setting up a minimal simulation with
+a synthetic medium distribution, i.e. an exponential disk of electrons (for the adaptive mesh
+grid, a Plummer distribution imported from an adaptive mesh file generated by gridbench). The
+grid resolution is configured so that the number of cells approximates the requested number of
+cells (the -c option, with a default value of 100000).
+
+For each grid, the benchmark fires the requested number of rays (the -r option, with a default
+value of 1000000) through the grid, starting at random positions inside the grid's bounding box
+and propagating in random directions. The random positions are also used to measure the
+throughput of the cellIndex() function. The rays are traced with 1, 2, 4, ... threads up to the
+maximum number of threads (the -t option), which defaults to the number of logical cores on the
+computer. The maximum number of threads is always included, even if it is not a power of two.
+
+The benchmark reports the number of nanoseconds per path segment (in thread time, i.e. wall
+time multiplied by the number of threads), the average number of segments per ray, the number
+of cache misses per ray (only if the hardware performance counters are accessible, see the
+CacheMissCounter class), and the number of cellIndex() lookups per second per thread. The results
+are shown on the console and written to the file \c gridbench_report.json in the output directory
+(the -o option), which defaults to \c gridbench in the current directory. The output directory
+is also used for any synthetic input files.
+*/
+class GridBenchCommandLineHandler final
+{
+public:
+    /** This function processes the command line arguments and runs the benchmark accordingly. The
+        function returns an appropriate program exit value. */
+    static int perform();
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
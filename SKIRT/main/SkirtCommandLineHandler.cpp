@@ -13,6 +13,7 @@
 #include "MonteCarloSimulation.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
+#include "PerformanceCounters.hpp"
 #include "ProcessManager.hpp"
 #include "SchemaDef.hpp"
 #include "SimulationItemRegistry.hpp"
@@ -20,6 +21,7 @@
 #include "StringUtils.hpp"
 #include "System.hpp"
 #include "TimeLogger.hpp"
+#include "TraceRecorder.hpp"
 #include "XmlHierarchyCreator.hpp"
 #include "XmlHierarchyWriter.hpp"
 
@@ -28,7 +30,7 @@
 namespace
 {
     // the allowed options list, in the format consumed by the CommandLineArguments constructor
-    static const char* allowedOptions = "-t* -s* -d -b -v -m -e -k -i* -o* -r -x";
+    static const char* allowedOptions = "-t* -s* -d -f -p* -b -v -m -c -l -e -k -i* -o* -a* -r -x";
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -189,6 +191,10 @@ int SkirtCommandLineHandler::doBatch()
         // determine the number of parallel simulations
         _parallelSims = max(_args.intValue("-s"), 1);
 
+        // prevent the threads of simulations running in parallel from being pinned to the same processors
+        if (_parallelSims > 1 && _args.isPresent("-p"))
+            throw FATALERROR("Thread placement (-p option) cannot be used with parallel simulations (-s option)");
+
         // handle the serial case separately to avoid using MPI nested within a Parallel instance
         if (_parallelSims == 1)
         {
@@ -321,10 +327,31 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
         if (!StringUtils::isAbsolutePath(outpath)) outpath = StringUtils::joinPaths(base, outpath);
         simulation->filePaths()->setInputPath(inpath);
         simulation->filePaths()->setOutputPath(outpath);
+        if (_args.isPresent("-a"))
+        {
+            string cachepath = _args.value("-a");
+            if (!StringUtils::isAbsolutePath(cachepath)) cachepath = StringUtils::joinPaths(base, cachepath);
+            simulation->filePaths()->setCachePath(cachepath);
+        }
+
+        //  - the reading of input column files by the root process only
+        simulation->filePaths()->setReadInputOnRoot(_args.isPresent("-f"));
 
         //  - the number of parallel threads
         if (_args.intValue("-t") > 0) simulation->parallelFactory()->setMaxThreadCount(_args.intValue("-t"));
 
+        //  - the placement of the parallel threads
+        if (_args.isPresent("-p"))
+        {
+            string placement = _args.value("-p");
+            if (placement == "compact")
+                simulation->parallelFactory()->setThreadPlacement(ParallelFactory::ThreadPlacement::Compact);
+            else if (placement == "scatter")
+                simulation->parallelFactory()->setThreadPlacement(ParallelFactory::ThreadPlacement::Scatter);
+            else
+                throw FATALERROR("Thread placement (-p option) must be 'compact' or 'scatter'");
+        }
+
         //  - the activation of data parallelization
         if (_args.isPresent("-d") && ProcessManager::isMultiProc())
         {
@@ -336,6 +363,9 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
         simulation->log()->setLinkedLog(log);
         simulation->log()->setVerbose(_args.isPresent("-v"));
         simulation->log()->setMemoryLogging(_args.isPresent("-m"));
+
+        //  - the performance counters, which are global and thus supported only for a single simulation at a time
+        PerformanceCounters::setEnabled(_parallelSims == 1 && _args.isPresent("-c"));
         if (_parallelSims > 1 || _args.isPresent("-b")) simulation->log()->setLowestLevel(Log::Level::Success);
 
         // output a ski file reflecting this simulation for later reference
@@ -361,6 +391,12 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
         // log a warning about problems with the installed resource packs
         reportResourceIssues(simulation->log());
 
+        // enable the timeline recorder if requested; it is global and thus supported only for a single simulation at
+        // a time; the processes are synchronized first so that their time origins are approximately aligned
+        bool tracing = _parallelSims == 1 && _args.isPresent("-l");
+        if (tracing) ProcessManager::wait();
+        TraceRecorder::setEnabled(tracing);
+
         // run the simulation and catch and properly report any exceptions to the simulation log file
         try
         {
@@ -378,6 +414,13 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
             throw except;
         }
 
+        // write the recorded timeline, if any
+        if (tracing)
+        {
+            TraceRecorder::setEnabled(false);
+            writeTrace(simulation);
+        }
+
         // if this is the only or first simulation in the run, report memory statistics in the simulation's log file
         if (_parallelSims == 1 && index == 0) reportPeakMemory(_args.isPresent("-v") ? simulation->log() : log);
     }
@@ -417,6 +460,42 @@ void SkirtCommandLineHandler::logErrorToFile(const vector<string>& message, stri
 
 ////////////////////////////////////////////////////////////////////
 
+void SkirtCommandLineHandler::writeTrace(MonteCarloSimulation* simulation)
+{
+    string filepath = simulation->filePaths()->output("trace.json");
+    auto tempFilepath = [filepath](int rank) { return filepath + "." + std::to_string(rank); };
+
+    // each non-root process writes its events to a temporary file
+    if (!ProcessManager::isRoot())
+    {
+        std::ofstream out = System::ofstream(tempFilepath(ProcessManager::rank()));
+        TraceRecorder::writeEvents(out, ProcessManager::rank());
+    }
+    ProcessManager::wait();
+
+    // the root process merges the events of all processes into a single file and removes the temporary files;
+    // the initial element labels the trace with the simulation name so that the event fragments can simply be appended
+    if (ProcessManager::isRoot())
+    {
+        simulation->log()->info("Writing timeline trace to " + filepath + "...");
+        std::ofstream out = System::ofstream(filepath);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n{\"ph\": \"M\", \"name\": \"process_labels\", "
+               "\"pid\": 0, \"args\": {\"labels\": "
+            << StringUtils::toJsonString(simulation->filePaths()->outputPrefix()) << "}}";
+        TraceRecorder::writeEvents(out, 0);
+        for (int rank = 1; rank < ProcessManager::size(); ++rank)
+        {
+            std::ifstream in = System::ifstream(tempFilepath(rank));
+            out << in.rdbuf();
+            in.close();
+            System::removeFile(tempFilepath(rank));
+        }
+        out << "\n]}\n";
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 void SkirtCommandLineHandler::printHelp()
 {
     if (!ProcessManager::isRoot()) return;
@@ -425,21 +504,26 @@ void SkirtCommandLineHandler::printHelp()
     _console.warning("To create a new ski file interactively:    skirt");
     _console.warning("To run a simulation with default options:  skirt <ski-filename>");
     _console.warning("");
-    _console.warning("  skirt [-t <threads>] [-s <simulations>] [-d]");
-    _console.warning("        [-b] [-v] [-m] [-e]");
-    _console.warning("        [-k] [-i <dirpath>] [-o <dirpath>]");
+    _console.warning("  skirt [-t <threads>] [-s <simulations>] [-d] [-f] [-p <placement>]");
+    _console.warning("        [-b] [-v] [-m] [-c] [-l] [-e]");
+    _console.warning("        [-k] [-i <dirpath>] [-o <dirpath>] [-a <dirpath>]");
     _console.warning("        [-r] {<filepath>}*");
     _console.warning("");
     _console.warning("  -t <threads> : the number of parallel threads for each simulation");
     _console.warning("  -s <simulations> : the number of parallel simulations per process");
     _console.warning("  -d : enable data parallelization mode for multiple processes");
+    _console.warning("  -f : read input column files in the root process and broadcast them to other processes");
+    _console.warning("  -p <placement> : pin the threads to processors using 'compact' or 'scatter' placement");
     _console.warning("  -b : force brief console logging");
     _console.warning("  -v : force verbose logging for multiple processes");
     _console.warning("  -m : state the amount of used memory at the start of each log message");
+    _console.warning("  -c : collect performance counters and write a performance report for each simulation");
+    _console.warning("  -l : record a timeline of each simulation and write it as a Chrome trace file");
     _console.warning("  -e : run the simulation in emulation mode to get an estimate of the memory consumption");
     _console.warning("  -k : make the input/output paths relative to the ski file being processed");
     _console.warning("  -i <dirpath> : the relative or absolute path for simulation input files");
     _console.warning("  -o <dirpath> : the relative or absolute path for simulation output files");
+    _console.warning("  -a <dirpath> : the relative or absolute path for caching precomputed data");
     _console.warning("  -r : cause recursive directory descent for all specified ski file paths");
     _console.warning("  <filepath> : the relative or absolute file path for a ski file");
     _console.warning("               (the filename may contain ? and * wildcards)");
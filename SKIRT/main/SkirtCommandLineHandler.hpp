@@ -8,6 +8,7 @@
 
 #include "CommandLineArguments.hpp"
 #include "ConsoleLog.hpp"
+class MonteCarloSimulation;
 
 ////////////////////////////////////////////////////////////////////
 
@@ -20,9 +21,9 @@ result in a ski file, without actually performing the simulation. Otherwise, it
 simulations in the ski files specified on the command line according to the following syntax:
 
 \verbatim
- skirt [-t <threads>] [-s <simulations>] [-d]
-       [-b] [-v] [-m] [-e]
-       [-k] [-i <dirpath>] [-o <dirpath>]
+ skirt [-t <threads>] [-s <simulations>] [-d] [-f] [-p <placement>]
+       [-b] [-v] [-m] [-c] [-l] [-e]
+       [-k] [-i <dirpath>] [-o <dirpath>] [-a <dirpath>]
        [-r] {<filepath>}*
 \endverbatim
 
@@ -33,6 +34,20 @@ simulations in the ski files specified on the command line according to the foll
 
 - The -d option enables data parallelization mode for multiple processes.
 
+- The -f option causes the data rows in input column files, such as imported snapshots, to be read and parsed by the
+  root process only and then broadcast to the other processes, rather than being read by each process independently.
+  When running with many processes, this avoids overloading the file system and the parsing effort is not repeated.
+  The option has no effect when running with a single process.
+
+- The -p option pins the parallel threads of each simulation to specific logical processors according to the
+  specified placement policy: "compact" fills the processors of each NUMA node (memory domain) before moving on to the
+  next node, and "scatter" distributes the threads round-robin over the NUMA nodes. With thread pinning, large data
+  structures are also initialized in parallel so that their memory is spread over the NUMA nodes. Thread pinning is
+  supported only on Linux. By default, threads are not pinned. Because each simulation places its threads starting
+  from the first processor it is allowed to run on, the -p option cannot be combined with parallel simulations (-s
+  option). Similarly, when running multiple MPI processes on the same node, the MPI launcher should bind each process
+  to a separate set of processors; otherwise a warning is issued.
+
 - The -b option forces brief console logging, i.e. only success and error messages are shown rather than all progress
   messages. If there are multiple parallel simulations (see the -s option), the -b option is turned on automatically
   to avoid a plethora of randomly intermixing messages. If there is only one simulation at a time, the console shows
@@ -44,6 +59,18 @@ simulations in the ski files specified on the command line according to the foll
 
 - The -m option causes information on current memory usage to be included in each log message.
 
+- The -c option enables the performance counters (see the PerformanceCounters class), which track events in the hot
+  paths of the simulation such as the number of path segments traversed or the number of peel-off photon packets.
+  The counters are aggregated across threads and processes for each simulation phase and written to a JSON file named
+  <tt>prefix_perf.json</tt> next to the log file. The option is ignored if there are multiple parallel simulations
+  (see the -s option).
+
+- The -l option enables the timeline recorder (see the TraceRecorder class), which records begin and end events for
+  simulation phases, parallel calls, the chunks processed by each thread, collective operations between processes, and
+  the probe and instrument output phases. The timeline is written to a file named <tt>prefix_trace.json</tt> in the
+  Chrome trace event format, with a separate track for each process and thread, which can be opened by trace viewers
+  such as Perfetto. The option is ignored if there are multiple parallel simulations (see the -s option).
+
 - The -e option activates emulation mode, which can be used to estimate the amount of memory used by
   a given simulation without actually performing the simulation.
 
@@ -55,6 +82,14 @@ simulations in the ski files specified on the command line according to the foll
 
 - The -o option specifies the absolute or relative path for simulation output files.
 
+- The -a option specifies the absolute or relative path of a directory for caching the optical and calorimetric
+  properties precomputed by dust mixes (see the DustMix class). The cache files are keyed by a hash of the dust mix
+  configuration, the input files it reads, and the simulation's wavelength grids, so that subsequent simulations using
+  an identical dust mix load the properties from the cache rather than recalculating them. The same directory is used
+  for caching the topology of tree grids constructed according to a policy (see the PolicyTreeSpatialGrid class), and
+  for caching the tree structure and the properties imported from adaptive mesh snapshot files (see the
+  AdaptiveMeshSnapshot class). By default, nothing is cached.
+
 - The -r option causes recursive directory descent for all specified \<filepath\> arguments, in other words
   all directories inside the specified base paths are searched for the specified filename (or filename pattern).
 
@@ -118,6 +153,13 @@ private:
         with a name and location corresponding to the regular simulation log file. */
     void logErrorToFile(const vector<string>& message, string skipath);
 
+    /** This function writes the timeline events recorded by the TraceRecorder for the specified
+        simulation to a file in the Chrome trace event format. Each non-root process writes its
+        events to a temporary file, and the root process merges these events with its own into a
+        single trace file. Because the function synchronizes the processes, it must be called by
+        all processes. */
+    void writeTrace(MonteCarloSimulation* simulation);
+
     /** This function prints a brief help message to the console. */
     void printHelp();
 
@@ -5,6 +5,7 @@
 
 #include "ProcessManager.hpp"
 #include "FatalError.hpp"
+#include "TraceRecorder.hpp"
 #include <array>
 
 #ifdef BUILD_WITH_MPI
@@ -90,6 +91,7 @@ bool ProcessManager::requestChunk(size_t& firstIndex, size_t& numIndices)
 {
 #ifdef BUILD_WITH_MPI
     if (isRoot()) throwInvalidChunkInvocation();
+    TraceRecorder::Scope scope("mpi", "requestChunk");
 
     std::array<int, 1> sendbuf{{_rank}};  // we pass our rank so that the receiver can ignore MPI status
     std::array<size_t, 2> recvbuf{{0, 0}};
@@ -112,6 +114,7 @@ int ProcessManager::waitForChunkRequest()
 {
 #ifdef BUILD_WITH_MPI
     if (!isMultiProc() || !isRoot()) throwInvalidChunkInvocation();
+    TraceRecorder::Scope scope("mpi", "waitForChunkRequest");
 
     // avoid using CPU while waiting for a message
     while (true)
@@ -137,6 +140,7 @@ void ProcessManager::serveChunkRequest(int rank, size_t firstIndex, size_t numIn
 {
 #ifdef BUILD_WITH_MPI
     if (!isMultiProc() || !isRoot()) throwInvalidChunkInvocation();
+    TraceRecorder::Scope scope("mpi", "serveChunkRequest", firstIndex, numIndices);
 
     std::array<size_t, 2> sendbuf{{firstIndex, numIndices}};
     MPI_Send(sendbuf.begin(), sendbuf.size(), MPI_UNSIGNED_LONG, rank, 1, MPI_COMM_WORLD);
@@ -153,7 +157,11 @@ void ProcessManager::serveChunkRequest(int rank, size_t firstIndex, size_t numIn
 void ProcessManager::wait()
 {
 #ifdef BUILD_WITH_MPI
-    if (isMultiProc()) MPI_Barrier(MPI_COMM_WORLD);
+    if (isMultiProc())
+    {
+        TraceRecorder::Scope scope("mpi", "wait");
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
 #endif
 }
 
@@ -164,6 +172,7 @@ void ProcessManager::sumToAll(Array& arr)
 #ifdef BUILD_WITH_MPI
     if (isMultiProc())
     {
+        TraceRecorder::Scope scope("mpi", "sumToAll", 0, arr.size());
         double* data = begin(arr);
         size_t remaining = arr.size();
         while (remaining > maxMessageSize)
@@ -189,6 +198,7 @@ void ProcessManager::sumToRoot(Array& arr)
 #ifdef BUILD_WITH_MPI
     if (isMultiProc())
     {
+        TraceRecorder::Scope scope("mpi", "sumToRoot", 0, arr.size());
         double* data = begin(arr);
         size_t remaining = arr.size();
 
@@ -217,12 +227,59 @@ void ProcessManager::sumToRoot(Array& arr)
 
 //////////////////////////////////////////////////////////////////////
 
+bool ProcessManager::isTrueForAll(bool flag)
+{
+    if (!isMultiProc()) return flag;
+
+    Array numTrue(1);
+    numTrue[0] = flag ? 1. : 0.;
+    sumToAll(numTrue);
+    return numTrue[0] == size();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void ProcessManager::broadcastFromRoot(vector<double>& data)
+{
+#ifdef BUILD_WITH_MPI
+    if (isMultiProc())
+    {
+        TraceRecorder::Scope scope("mpi", "broadcastFromRoot", 0, data.size());
+
+        // communicate the size of the data
+        size_t datasize = data.size();
+        MPI_Bcast(&datasize, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+        if (!isRoot()) data.resize(datasize);
+
+        // communicate the data itself, splitting it in maxMessageSize chunks if needed
+        double* curdata = data.data();
+        size_t remaining = datasize;
+        while (remaining > maxMessageSize)
+        {
+            MPI_Bcast(curdata, maxMessageSize, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            remaining -= maxMessageSize;
+            curdata += maxMessageSize;
+        }
+        if (remaining)
+        {
+            MPI_Bcast(curdata, remaining, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        }
+    }
+#else
+    (void)data;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////
+
 void ProcessManager::broadcastAllToAll(std::function<void(vector<double>&)> producer,
                                        std::function<void(const vector<double>&)> consumer)
 {
 #ifdef BUILD_WITH_MPI
     if (isMultiProc())
     {
+        TraceRecorder::Scope scope("mpi", "broadcastAllToAll");
+
         // allocate room for data to be sent and received
         vector<double> data;
         size_t datasize = 0;
@@ -126,6 +126,22 @@ public:
         the array has zero size, the function does nothing. */
     static void sumToRoot(Array& arr);
 
+    /** This function returns true if the specified flag is true on all processes, and false
+        otherwise. It can be used to ensure that all processes make the same decision, for example
+        on whether to use information loaded from a cache file, before entering a code path that
+        involves collective communication. All processes must call this function for the
+        communication to proceed. If there is only one process, the function simply returns the
+        specified flag. */
+    static bool isTrueForAll(bool flag);
+
+    /** This function broadcasts a sequence of floating point values from the root process to all
+        other processes. On the root process, the vector passed to this function contains the data
+        to be sent, and it is left untouched. On the other processes, the vector is resized as
+        needed and its contents is replaced by the received data. All processes must call this
+        function for the communication to proceed. If there is only one process, the function does
+        nothing. */
+    static void broadcastFromRoot(vector<double>& data);
+
     /** This function broadcasts a separate sequence of floating point values from each process to
         the other processes. The chunk of data to be sent by the calling process must be generated
         by the provided call-back function \em producer. Similarly, the chunks of data reveived by
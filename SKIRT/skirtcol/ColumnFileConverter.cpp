@@ -0,0 +1,216 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "ColumnFileConverter.hpp"
+#include "FatalError.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <regex>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the tags and the size of the 8-byte data items in a binary column file (see TextInFile)
+    const char* const binaryStartTag = "SKIRT C\n";
+    const char* const binaryEndTag = "SCOLEND\n";
+    const uint64_t binaryEndianTag = 0x010203040A0BFEFF;
+    const size_t binaryItemSize = 8;
+
+    // the number of rows parsed and written as a block in the second pass
+    const size_t blockRows = 1 << 18;
+
+    // returns the number of data items needed to hold the given number of bytes
+    size_t numItems(size_t numBytes)
+    {
+        return (numBytes + binaryItemSize - 1) / binaryItemSize;
+    }
+
+    // writes an unsigned integer data item
+    void writeInteger(std::ofstream& out, uint64_t value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), binaryItemSize);
+    }
+
+    // writes a text field, i.e. a character count followed by the characters padded with spaces
+    void writeText(std::ofstream& out, string text)
+    {
+        writeInteger(out, text.size());
+        out << StringUtils::padRight(text, numItems(text.size()) * binaryItemSize);
+    }
+
+    // if the given line is a column information header line (see TextInFile), stores the column index,
+    // description and unit string in the arguments and returns true; otherwise returns false
+    bool parseInfoLine(const string& line, size_t& colIndex, string& description, string& unit)
+    {
+        static const std::regex syntax("\\s*#\\s*column\\s*(\\d+)\\s*:\\s*([^()]*)\\(\\s*([a-zA-Z0-9/]*)\\s*\\)\\s*",
+                                       std::regex::icase);
+        std::smatch matches;
+        if (!std::regex_match(line, matches, syntax) || matches.size() != 4) return false;
+        colIndex = std::stoul(matches[1].str());
+        description = StringUtils::squeeze(matches[2].str());
+        unit = matches[3].str();
+        return true;
+    }
+
+    // returns true if the given line is a data line, i.e. it is nonempty and does not start with a hash character;
+    // throws a fatal error if the line is a nonleaf node specification of an adaptive mesh file
+    bool isDataLine(const string& line)
+    {
+        auto pos = line.find_first_not_of(" \t\r");
+        if (pos == string::npos || line[pos] == '#') return false;
+        if (line[pos] == '!') throw FATALERROR("Binary column files cannot hold nonleaf node specifications");
+        return true;
+    }
+
+    // parses the given number of values from the given data line into the given buffer, throwing a fatal error if
+    // the line contains fewer values than expected or if a value is not formatted as a floating point number
+    void parseDataLine(const string& line, size_t numColumns, double* values)
+    {
+        const char* current = line.c_str();
+        for (size_t c = 0; c != numColumns; ++c)
+        {
+            char* end;
+            values[c] = strtod(current, &end);
+            if (end == current)
+            {
+                while (*end == ' ' || *end == '\t' || *end == '\r') ++end;
+                if (*end == 0) throw FATALERROR("One or more required value(s) on text line are missing");
+                throw FATALERROR("Input text is not formatted as a floating point number");
+            }
+            current = end;
+        }
+    }
+
+    // counts the number of values on the given data line
+    size_t countValues(const string& line)
+    {
+        size_t count = 0;
+        const char* current = line.c_str();
+        while (true)
+        {
+            char* end;
+            strtod(current, &end);
+            if (end == current) return count;
+            current = end;
+            count++;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::pair<size_t, size_t> ColumnFileConverter::convert(string inFilePath, string outFilePath, bool singlePrecision)
+{
+    // first pass: read the column info, and count the number of columns and rows
+    std::ifstream in = System::ifstream(inFilePath);
+    if (!in) throw FATALERROR("Could not open the text file " + inFilePath);
+    vector<string> descriptions;
+    vector<string> units;
+    size_t numColumns = 0;
+    size_t numRows = 0;
+    string line;
+    while (getline(in, line))
+    {
+        if (isDataLine(line))
+        {
+            if (!numRows) numColumns = descriptions.empty() ? countValues(line) : descriptions.size();
+            numRows++;
+        }
+        else if (!numRows)
+        {
+            size_t index;
+            string description, unit;
+            if (parseInfoLine(line, index, description, unit))
+            {
+                if (index != descriptions.size() + 1)
+                    throw FATALERROR("Incorrect column index in file header for column "
+                                     + std::to_string(descriptions.size() + 1));
+                descriptions.push_back(description);
+                units.push_back(unit);
+            }
+        }
+    }
+    if (!numColumns) throw FATALERROR("There are no columns in the text file " + inFilePath);
+    bool hasColumnInfo = !descriptions.empty();
+    descriptions.resize(numColumns);
+    units.resize(numColumns);
+
+    // open the output file and write the header
+    std::ofstream out = System::ofstream(outFilePath);
+    if (!out) throw FATALERROR("Could not open the binary column file " + outFilePath + " for writing");
+    size_t valueSize = singlePrecision ? 4 : 8;
+    out.write(binaryStartTag, binaryItemSize);
+    writeInteger(out, binaryEndianTag);
+    writeInteger(out, numColumns);
+    writeInteger(out, numRows);
+    writeInteger(out, hasColumnInfo ? 1 : 0);
+    for (size_t c = 0; c != numColumns; ++c)
+    {
+        writeInteger(out, valueSize);
+        writeText(out, descriptions[c]);
+        writeText(out, units[c]);
+    }
+
+    // determine the file offset of each column
+    size_t columnBytes = numItems(numRows * valueSize) * binaryItemSize;
+    size_t dataOffset = out.tellp();
+
+    // second pass: parse the values in blocks of rows and write each block to the appropriate location in each column
+    in.clear();
+    in.seekg(0);
+    vector<double> block(numColumns * blockRows);  // row-major
+    vector<char> buffer(blockRows * valueSize);
+    size_t rowsWritten = 0;
+    while (rowsWritten != numRows)
+    {
+        // parse the next block of rows
+        size_t numBlockRows = 0;
+        while (numBlockRows != blockRows && rowsWritten + numBlockRows != numRows && getline(in, line))
+        {
+            if (isDataLine(line)) parseDataLine(line, numColumns, &block[numColumns * numBlockRows++]);
+        }
+        if (!numBlockRows) throw FATALERROR("Text file changed while it was being converted: " + inFilePath);
+
+        // write the block to each column
+        for (size_t c = 0; c != numColumns; ++c)
+        {
+            for (size_t r = 0; r != numBlockRows; ++r)
+            {
+                double value = block[numColumns * r + c];
+                if (singlePrecision)
+                {
+                    float single = static_cast<float>(value);
+                    memcpy(&buffer[4 * r], &single, 4);
+                }
+                else
+                    memcpy(&buffer[8 * r], &value, 8);
+            }
+            out.seekp(dataOffset + c * columnBytes + rowsWritten * valueSize);
+            out.write(buffer.data(), numBlockRows * valueSize);
+        }
+        rowsWritten += numBlockRows;
+    }
+
+    // zero-fill the padding at the end of each column and write the end-of-file tag
+    size_t numPadding = columnBytes - numRows * valueSize;
+    for (size_t c = 0; c != numColumns; ++c)
+    {
+        out.seekp(dataOffset + (c + 1) * columnBytes - numPadding);
+        out.write("\0\0\0\0\0\0\0\0", numPadding);
+    }
+    out.seekp(dataOffset + numColumns * columnBytes);
+    out.write(binaryEndTag, binaryItemSize);
+    out.close();
+    if (!out) throw FATALERROR("Error while writing the binary column file " + outFilePath);
+
+    return std::make_pair(numColumns, numRows);
+}
+
+////////////////////////////////////////////////////////////////////
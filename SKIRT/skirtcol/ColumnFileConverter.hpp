@@ -0,0 +1,40 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef COLUMNFILECONVERTER_HPP
+#define COLUMNFILECONVERTER_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** This class offers a static function to convert a column text file into the equivalent binary
+    column file. The column text format and the binary column format are both described in the
+    documentation of the TextInFile class in the SKIRT core library.
+
+    The column information header lines in the text file, if present, are copied to the binary
+    file without interpretation, i.e. descriptions and unit strings are not verified or converted.
+    The number of columns is determined by the number of column information header lines or, in
+    the absence of such lines, by the number of values on the first data line. As is the case for
+    TextInFile, any values on a data line beyond the expected number of values are ignored.
+
+    The conversion proceeds in two passes over the text file. The first pass counts the number of
+    data lines, so that the location of each column in the output file is known in advance. The
+    second pass parses the values and writes them to the output file in blocks of rows, so that
+    the memory consumption does not depend on the size of the input file. */
+class ColumnFileConverter final
+{
+public:
+    /** This function converts the column text file at the specified input path into a binary
+        column file at the specified output path, storing the values in single or double precision
+        depending on the value of the \em singlePrecision flag. The function returns the number of
+        columns and the number of rows written. If the input file cannot be parsed or if one of the
+        files cannot be opened, the function throws a fatal error. */
+    static std::pair<size_t, size_t> convert(string inFilePath, string outFilePath, bool singlePrecision);
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
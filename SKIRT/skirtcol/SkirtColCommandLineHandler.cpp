@@ -0,0 +1,72 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "SkirtColCommandLineHandler.hpp"
+#include "BuildInfo.hpp"
+#include "ColumnFileConverter.hpp"
+#include "CommandLineArguments.hpp"
+#include "Console.hpp"
+#include "FatalError.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+int SkirtColCommandLineHandler::perform()
+{
+    // Catch and properly report any exceptions
+    try
+    {
+        Console::warning("Welcome to the SKIRT column file converter " + BuildInfo::projectVersion() + " "
+                         + BuildInfo::timestamp());
+
+        // Process and validate the command line arguments
+        CommandLineArguments args(System::arguments(), "-s -o*");
+        if (!args.isValid() || !args.hasFilepaths())
+        {
+            Console::error("Invalid command line arguments. Usage synopsis:");
+            Console::warning("skirtcol [-s] [-o <output_dirpath>] <input_filepath> ...");
+            return EXIT_FAILURE;
+        }
+
+        // Verify the output directory, if specified
+        string outDirPath = args.value("-o");
+        if (!outDirPath.empty() && !System::isDir(outDirPath))
+        {
+            Console::error("Output path does not exist or is not a directory: " + outDirPath);
+            return EXIT_FAILURE;
+        }
+
+        // Convert each of the input files in turn
+        for (string inFilePath : args.filepaths())
+        {
+            string name = StringUtils::filename(inFilePath);
+            if (StringUtils::endsWith(name, ".txt")) name.erase(name.size() - 4);
+            name += ".scol";
+            string outFilePath = StringUtils::joinPaths(
+                outDirPath.empty() ? StringUtils::dirPath(inFilePath) : outDirPath, name);
+
+            Console::info("Converting " + inFilePath + " to " + outFilePath + "...");
+            auto shape = ColumnFileConverter::convert(inFilePath, outFilePath, args.isPresent("-s"));
+            Console::info("Wrote " + std::to_string(shape.second) + " rows with " + std::to_string(shape.first)
+                          + " columns");
+        }
+
+        // Report successful completion
+        Console::success("Successful completion");
+        return EXIT_SUCCESS;
+    }
+    catch (const FatalError& error)
+    {
+        for (auto line : error.message()) Console::error(line);
+    }
+    catch (const std::exception& except)
+    {
+        Console::error("Standard Library Exception: " + string(except.what()));
+    }
+    return EXIT_FAILURE;
+}
+
+////////////////////////////////////////////////////////////////////
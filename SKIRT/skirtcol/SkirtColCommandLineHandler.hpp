@@ -0,0 +1,44 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef SKIRTCOLCOMMANDLINEHANDLER_HPP
+#define SKIRTCOLCOMMANDLINEHANDLER_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/**
+This class offers a static function to process the command line arguments for the skirtcol
+utility, which converts column text files as accepted by SKIRT (e.g., for imported snapshots) into
+the equivalent binary column files. The binary format is described in the documentation of the
+TextInFile class in the SKIRT core library. The following command line arguments are supported:
+
+\verbatim
+    skirtcol [-s] [-o <output_dirpath>] <input_filepath> ...
+\endverbatim
+
+Each input file is converted to a binary column file with the same name, except that the ".txt"
+filename extension (if present) is replaced by the ".scol" extension. The output file is placed in
+the directory specified by the -o option or, if this option is missing, in the directory of the
+input file. An existing file with the same name is overwritten without warning.
+
+By default, all values are stored in double precision (64-bit) floating point format. If the -s
+option is present, the values are stored in single precision (32-bit) format instead, halving the
+size of the output file. Because single precision offers only about seven significant digits, this
+option should be used with care, for example when converting particle positions in a large
+cosmological volume.
+*/
+class SkirtColCommandLineHandler final
+{
+public:
+    /** This function processes the command line arguments and invokes the converter for each of
+        the specified input files. The function returns an appropriate program exit value. */
+    static int perform();
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
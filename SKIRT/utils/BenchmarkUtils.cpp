@@ -0,0 +1,26 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "BenchmarkUtils.hpp"
+#include "StringUtils.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+vector<int> BenchmarkUtils::threadCounts(int maxThreads)
+{
+    vector<int> counts;
+    for (int count = 1; count < maxThreads; count *= 2) counts.push_back(count);
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+////////////////////////////////////////////////////////////////////
+
+string BenchmarkUtils::jsonNumber(double value)
+{
+    return StringUtils::toString(value, 'g', 6);
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,30 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef BENCHMARKUTILS_HPP
+#define BENCHMARKUTILS_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** This namespace contains a few helper functions shared by the benchmark tools (skirtbench and
+    gridbench) for running a benchmark with an increasing number of threads and for writing the
+    results to a JSON report. String values in the report are produced by
+    StringUtils::toJsonString(). */
+namespace BenchmarkUtils
+{
+    /** This function returns the list of thread counts 1, 2, 4, ... up to and including the
+        specified maximum. */
+    vector<int> threadCounts(int maxThreads);
+
+    /** This function returns the specified number formatted for a JSON report, i.e. with up to 6
+        significant digits. */
+    string jsonNumber(double value);
+}
+
+////////////////////////////////////////////////////////////////////
+
+#endif
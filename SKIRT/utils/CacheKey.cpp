@@ -0,0 +1,66 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "CacheKey.hpp"
+#include "System.hpp"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the number of bytes read from the start and from the end of an input file to calculate its hash
+    const size_t numHashedBytes = 1 << 20;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void CacheKey::add(const void* data, size_t size)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i != size; ++i)
+    {
+        _hash ^= bytes[i];
+        _hash *= 0x100000001B3;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void CacheKey::addFile(string path)
+{
+    auto sizeAndTime = System::fileSizeAndTime(path);
+    addValue(sizeAndTime.first);
+    addValue(sizeAndTime.second);
+
+    std::ifstream in = System::ifstream(path);
+    if (in)
+    {
+        uint64_t size = sizeAndTime.first;
+        vector<char> buffer(min(size, static_cast<uint64_t>(numHashedBytes)));
+        in.read(buffer.data(), buffer.size());
+        add(buffer.data(), in.gcount());
+        if (size > numHashedBytes)
+        {
+            in.clear();
+            in.seekg(size - buffer.size());
+            in.read(buffer.data(), buffer.size());
+            add(buffer.data(), in.gcount());
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+string CacheKey::hexString() const
+{
+    std::ostringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << _hash;
+    return out.str();
+}
+
+////////////////////////////////////////////////////////////////////
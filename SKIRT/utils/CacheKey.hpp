@@ -0,0 +1,50 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef CACHEKEY_HPP
+#define CACHEKEY_HPP
+
+#include "Basics.hpp"
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////
+
+/** A CacheKey object calculates a 64-bit hash key identifying a data structure stored in the cache
+    directory (see the FilePaths class). The client adds all information determining the contents
+    of the data structure, such as configuration strings, numerical values, and input files, and
+    then uses the resulting key in the cache file name and in the header of the cache file. The
+    key is calculated with the FNV-1a hash algorithm, which is fast and sufficiently robust for
+    this purpose. */
+class CacheKey
+{
+public:
+    /** This function adds the specified bytes to the hash key. */
+    void add(const void* data, size_t size);
+
+    /** This function adds the contents of the specified string to the hash key. */
+    void add(string text) { add(text.data(), text.size()); }
+
+    /** This function adds the specified numeric value to the hash key. */
+    template<typename T> void addValue(T value) { add(&value, sizeof(value)); }
+
+    /** This function adds the size and modification time of the specified file, and a hash of its
+        first and last megabyte, to the hash key. Reading just part of the file keeps the cost of
+        calculating the key low for large input files, while still detecting most changes even if
+        the modification time would somehow be preserved. */
+    void addFile(string path);
+
+    /** This function returns the hash key. */
+    uint64_t value() const { return _hash; }
+
+    /** This function returns the hash key as a string of 16 hexadecimal digits. */
+    string hexString() const;
+
+private:
+    uint64_t _hash{0xCBF29CE484222325};
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -4,6 +4,7 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "ChunkMaker.hpp"
+#include "TraceRecorder.hpp"
 
 //////////////////////////////////////////////////////////////////////
 
@@ -43,7 +44,9 @@ bool ChunkMaker::callForNext(const std::function<void(size_t, size_t)>& target)
     size_t first = _nextIndex.fetch_add(_chunkSize);
     if (first < _maxIndex)
     {
-        target(first, min(_chunkSize, _maxIndex - first));
+        size_t num = min(_chunkSize, _maxIndex - first);
+        TraceRecorder::Scope scope("parallel", "chunk", first, num);
+        target(first, num);
         return true;
     }
     return false;
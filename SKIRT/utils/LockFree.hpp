@@ -7,6 +7,7 @@
 #define LOCKFREE_HPP
 
 #include "Basics.hpp"
+#include "PerformanceCounters.hpp"
 #include <atomic>
 
 ////////////////////////////////////////////////////////////////////
@@ -33,6 +34,7 @@ namespace LockFree
         // - if the value of the target location did change, make a new local copy and try again
         while (!atom->compare_exchange_weak(old, old + value))
         {
+            PerformanceCounters::add(PerformanceCounters::Counter::CasRetries);
         }
     }
 }
@@ -0,0 +1,96 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "PerformanceCounters.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////
+
+bool PerformanceCounters::_enabled = false;
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const int N = PerformanceCounters::numCounters();
+
+    // a private copy of the counters for a single thread, padded to avoid false sharing with other blocks;
+    // the values are updated only by the owning thread, but they are declared atomic so that they can
+    // be safely read and reset by the harvesting thread (relaxed loads and stores add no overhead)
+    struct Block
+    {
+        std::atomic<uint64_t> values[N];
+        char padding[64];
+        Block()
+        {
+            for (auto& value : values) value.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    // the list of blocks for all threads that ever incremented a counter, guarded by a mutex;
+    // blocks are never removed so that the counts of threads that have exited are preserved
+    std::mutex _mutex;
+    vector<std::unique_ptr<Block>> _blocks;
+
+    // a pointer to the block of the current thread, or null if it has not yet been created
+    thread_local Block* t_block = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////
+
+string PerformanceCounters::name(Counter counter)
+{
+    switch (counter)
+    {
+        case Counter::LaunchedPackets: return "launchedPackets";
+        case Counter::Paths: return "paths";
+        case Counter::PathSegments: return "pathSegments";
+        case Counter::Scatterings: return "scatterings";
+        case Counter::LyaCellEscapes: return "lyaCellEscapes";
+        case Counter::PeelOffs: return "peelOffs";
+        case Counter::PeelOffPaths: return "peelOffPaths";
+        case Counter::PeelOffPathsAvoided: return "peelOffPathsAvoided";
+        case Counter::CasRetries: return "casRetries";
+        case Counter::EmissivityTime: return "emissivityTime";
+        case Counter::NumCounters: break;
+    }
+    return string();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PerformanceCounters::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PerformanceCounters::addToThread(Counter counter, uint64_t amount)
+{
+    if (!t_block)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _blocks.emplace_back(new Block);
+        t_block = _blocks.back().get();
+    }
+    auto& value = t_block->values[static_cast<int>(counter)];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<double> PerformanceCounters::harvest()
+{
+    vector<double> result(N, 0.);
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (const auto& block : _blocks)
+        for (int i = 0; i != N; ++i) result[i] += block->values[i].exchange(0, std::memory_order_relaxed);
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,127 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef PERFORMANCECOUNTERS_HPP
+#define PERFORMANCECOUNTERS_HPP
+
+#include "Basics.hpp"
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////
+
+/**
+This class offers a set of global (i.e. application-wide) counters for events that occur in the
+hot paths of a simulation, such as the number of photon packets launched, the number of path
+segments traversed, or the number of retries in the compare-and-swap loop of LockFree::add().
+These counters help to understand and tune the performance of a simulation beyond the plain
+wall-clock times reported by the TimeLogger class.
+
+The counters are always compiled in, but they are disabled by default. As long as the counters
+are disabled, a call to the add() function costs just a test on a global flag. When enabled
+through the setEnabled() function, each execution thread increments its own private copy of the
+counters, so that there is no contention between threads. The harvest() function sums the values
+over all threads that ever incremented a counter and resets all counters to zero. Aggregation
+across processes (if any) is left to the caller.
+
+Because the counters are global, they cannot distinguish between simulations that run in
+parallel within the same process. The caller should enable the counters only if a single
+simulation is running at a time.
+
+To time a code snippet, an instance of the nested Timer class can be constructed at the start of
+the scope to be timed; its destructor adds the elapsed time in nanoseconds to the specified
+counter. The clock is read only if the counters are enabled. For example:
+
+\code
+{
+    PerformanceCounters::Timer timer(PerformanceCounters::Counter::EmissivityTime);
+    ...
+}
+\endcode
+*/
+class PerformanceCounters
+{
+public:
+    /** This enumeration lists the available counters. The last item is not a counter but
+        represents the number of counters. */
+    enum class Counter : int {
+        LaunchedPackets,      // number of photon packets launched from primary or secondary sources
+        Paths,                // number of photon packet paths calculated
+        PathSegments,         // total number of segments in these paths
+        Scatterings,          // number of scattering events
+        LyaCellEscapes,       // number of analytic escapes from optically thick cells for Lyman-alpha
+        PeelOffs,             // number of peel-off photon packets launched towards instruments
+        PeelOffPaths,         // number of optical depths calculated for peel-off photon packets
+        PeelOffPathsAvoided,  // number of peel-off optical depth calculations avoided by reusing a stored value
+        CasRetries,           // number of retries in the compare-and-swap loop of LockFree::add()
+        EmissivityTime,       // thread time spent in secondary emissivity calculations, in nanoseconds
+        NumCounters
+    };
+
+    /** This function returns the number of counters. */
+    static constexpr int numCounters() { return static_cast<int>(Counter::NumCounters); }
+
+    /** This function returns a short name for the specified counter, suitable for use as a key in
+        a report. */
+    static string name(Counter counter);
+
+    /** This function enables or disables the counters. It should be called only while no
+        counters are being incremented. */
+    static void setEnabled(bool enabled);
+
+    /** This function returns true if the counters are enabled, false otherwise. */
+    static bool isEnabled() { return _enabled; }
+
+    /** This function adds the specified amount to the calling thread's copy of the specified
+        counter if the counters are enabled. Otherwise, it does nothing. */
+    static void add(Counter counter, uint64_t amount = 1)
+    {
+        if (_enabled) addToThread(counter, amount);
+    }
+
+    /** This function returns the value of each counter summed over all threads, and then resets
+        all counters to zero. The values are returned as floating point numbers in the order of the
+        Counter enumeration so that they can easily be aggregated across processes. This function
+        should be called only while no counters are being incremented. */
+    static vector<double> harvest();
+
+    /** An instance of this class adds the time elapsed between its construction and its
+        destruction, in nanoseconds, to the specified counter, provided the counters are enabled. */
+    class Timer
+    {
+    public:
+        /** The constructor remembers the counter and the current time, if the counters are
+            enabled. */
+        explicit Timer(Counter counter) : _counter(counter)
+        {
+            if (_enabled) _started = std::chrono::steady_clock::now();
+        }
+
+        /** The destructor adds the elapsed time to the counter, if the counters are enabled. */
+        ~Timer()
+        {
+            if (_enabled)
+            {
+                auto elapsed = std::chrono::steady_clock::now() - _started;
+                addToThread(_counter, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            }
+        }
+
+    private:
+        Counter _counter;
+        std::chrono::steady_clock::time_point _started;
+    };
+
+private:
+    /** This function adds the specified amount to the calling thread's copy of the specified
+        counter, creating that copy if needed. */
+    static void addToThread(Counter counter, uint64_t amount);
+
+    // true if the counters are enabled
+    static bool _enabled;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
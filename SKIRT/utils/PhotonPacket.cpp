@@ -63,6 +63,7 @@ void PhotonPacket::launchEmissionPeelOff(const PhotonPacket* pp, Direction bfk)
     _historyIndex = pp->_historyIndex;
     _nscatt = 0;
     setPosition(pp->position());
+    setCellHint(pp->cellHint());
     setDirection(bfk);
     if (pp->_bvi) _lambda = shiftedEmissionWavelength(_lambda0, bfk, pp->_bvi->velocity());
     if (pp->_adi) applyBias(pp->_adi->probabilityForDirection(bfk));
@@ -85,6 +86,7 @@ void PhotonPacket::launchScatteringPeelOff(const PhotonPacket* pp, Direction bfk
     _historyIndex = pp->_historyIndex;
     _nscatt = pp->_nscatt + 1;
     setPosition(pp->position());
+    setCellHint(pp->cellHint());
     setDirection(bfk);
     setUnpolarized();
     _hasObservedOpticalDepth = false;
@@ -6,12 +6,23 @@
 #include "SmoothedParticleGrid.hpp"
 #include "NR.hpp"
 #include "SmoothedParticle.hpp"
-#include <set>
 
 ////////////////////////////////////////////////////////////////////
 
 namespace
 {
+    // the number of particles overlapping a cell above which the cell is considered for subdivision
+    const int maxLeafParticles = 64;
+
+    // the maximum subdivision level below a top-level cell
+    const int maxLevel = 16;
+
+    // the maximum factor by which subdividing a cell may increase the total number of particle references
+    const int maxDuplication = 2;
+
+    // the number of candidate particles processed in a single batch when calculating the density
+    const int batchSize = 64;
+
     // returns the linear index for cell (i,j,k) in a m*m*m table
     inline int index(int m, int i, int j, int k) { return ((i * m) + j) * m + k; }
 
@@ -89,6 +100,22 @@ namespace
 
 SmoothedParticleGrid::SmoothedParticleGrid(const vector<SmoothedParticle>& pv, int gridsize) : _m(gridsize)
 {
+    // copy the particle properties into separate arrays
+    int n = pv.size();
+    _xv.resize(n);
+    _yv.resize(n);
+    _zv.resize(n);
+    _hv.resize(n);
+    _Mv.resize(n);
+    for (int i = 0; i != n; ++i)
+    {
+        _xv[i] = pv[i].center(1);
+        _yv[i] = pv[i].center(2);
+        _zv[i] = pv[i].center(3);
+        _hv[i] = pv[i].radius();
+        _Mv[i] = pv[i].mass();
+    }
+
     // build the grids in each spatial direction
     double xmin, ymin, zmin, xmax, ymax, zmax;
     makegrid(pv, 1, gridsize, _xgrid, xmin, xmax);
@@ -96,15 +123,16 @@ SmoothedParticleGrid::SmoothedParticleGrid(const vector<SmoothedParticle>& pv, i
     makegrid(pv, 3, gridsize, _zgrid, zmin, zmax);
     setExtent(xmin, ymin, zmin, xmax, ymax, zmax);
 
-    // make room for m*m*m cells
-    _listv.resize(gridsize * gridsize * gridsize);
+    // make room for m*m*m temporary lists
+    int numTopCells = gridsize * gridsize * gridsize;
+    vector<vector<int>> listv(numTopCells);
+    vector<vector<int>> homev(numTopCells);
 
     // add each particle to the list for every cell that it overlaps
-    int n = pv.size();
     for (int p = 0; p < n; p++)
     {
-        Vec rc = pv[p].center();
-        double h = pv[p].radius();
+        Vec rc = center(p);
+        double h = radius(p);
 
         // find indices for first and last cell possibly overlapped by particle, in each spatial direction
         int i1 = NR::locateClip(_xgrid, rc.x() - h);
@@ -122,21 +150,140 @@ SmoothedParticleGrid::SmoothedParticleGrid(const vector<SmoothedParticle>& pv, i
                     // add the particle to the list if it indeed overlaps the cell
                     if (intersects(_xgrid[i], _xgrid[i + 1], _ygrid[j], _ygrid[j + 1], _zgrid[k], _zgrid[k + 1], rc.x(),
                                    rc.y(), rc.z(), h))
-                        _listv[index(gridsize, i, j, k)].push_back(&pv[p]);
+                        listv[index(gridsize, i, j, k)].push_back(p);
                 }
+
+        // add the particle to the list for the cell containing its center
+        int i = NR::locateClip(_xgrid, rc.x());
+        int j = NR::locateClip(_ygrid, rc.y());
+        int k = NR::locateClip(_zgrid, rc.z());
+        homev[index(gridsize, i, j, k)].push_back(p);
     }
 
-    // calculate statistics
+    // subdivide the top-level cells where needed, and copy the lists for all leaf cells into the global lists
     _pmin = n;
-    _pmax = 0;
-    _ptotal = 0;
-    for (int index = 0; index < gridsize * gridsize * gridsize; index++)
+    _nodev.resize(numTopCells);
+    for (int i = 0; i != gridsize; ++i)
+        for (int j = 0; j != gridsize; ++j)
+            for (int k = 0; k != gridsize; ++k)
+            {
+                int m = index(gridsize, i, j, k);
+                Box cell(_xgrid[i], _ygrid[j], _zgrid[k], _xgrid[i + 1], _ygrid[j + 1], _zgrid[k + 1]);
+                buildNode(m, cell, 0, listv[m], homev[m]);
+            }
+    _nodev.shrink_to_fit();
+    _refv.shrink_to_fit();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SmoothedParticleGrid::buildNode(int n, const Box& cell, int level, vector<int>& listv, vector<int>& homev)
+{
+    int count = listv.size();
+
+    // consider subdividing a node that is overlapped by many particles
+    if (count > maxLeafParticles && level < maxLevel)
     {
-        int size = _listv[index].size();
-        _pmin = min(_pmin, size);
-        _pmax = max(_pmax, size);
-        _ptotal += size;
+        // place the split point in the middle of the portion of the node inside the grid extent, which is finite
+        // even for the outer top-level cells; however, do not split the node along a direction in which it is much
+        // thinner than in the other directions, because the particles overlapping the node are likely to overlap
+        // both halves; instead, place the split point at the upper border so that the upper children are empty
+        Box inner(max(cell.xmin(), xmin()), max(cell.ymin(), ymin()), max(cell.zmin(), zmin()),
+                  min(cell.xmax(), xmax()), min(cell.ymax(), ymax()), min(cell.zmax(), zmax()));
+        Vec width = inner.widths();
+        double threshold = 0.5 * max(width.x(), max(width.y(), width.z()));
+        bool splitx = width.x() >= threshold;
+        bool splity = width.y() >= threshold;
+        bool splitz = width.z() >= threshold;
+        Vec middle = inner.center();
+        _nodev[n].split = Vec(splitx ? middle.x() : cell.xmax(), splity ? middle.y() : cell.ymax(),
+                              splitz ? middle.z() : cell.zmax());
+
+        // distribute the overlapping particles over the children, aborting as soon as the subdivision
+        // duplicates too many particle references, indicating that the particles are too large compared
+        // to the node for the subdivision to be effective
+        Vec split = _nodev[n].split;
+        Box childv[8];
+        for (int l = 0; l != 8; ++l) childv[l] = childCell(n, cell, l);
+        vector<int> childListv[8];
+        size_t total = 0;
+        size_t limit = static_cast<size_t>(maxDuplication) * count;
+        for (int p : listv)
+        {
+            // loop over the children possibly overlapped by the particle
+            double x = _xv[p], y = _yv[p], z = _zv[p], h = _hv[p];
+            for (int i = x - h >= split.x() ? 1 : 0; i <= (splitx && x + h >= split.x() ? 1 : 0); ++i)
+                for (int j = y - h >= split.y() ? 1 : 0; j <= (splity && y + h >= split.y() ? 1 : 0); ++j)
+                    for (int k = z - h >= split.z() ? 1 : 0; k <= (splitz && z + h >= split.z() ? 1 : 0); ++k)
+                    {
+                        // add the particle to the list if it indeed overlaps the child
+                        int l = 4 * i + 2 * j + k;
+                        const Box& child = childv[l];
+                        if (intersects(child.xmin(), child.xmax(), child.ymin(), child.ymax(), child.zmin(),
+                                       child.zmax(), x, y, z, h))
+                        {
+                            childListv[l].push_back(p);
+                            total++;
+                        }
+                    }
+            if (total > limit) break;
+        }
+
+        // accept the subdivision only if the loop above was not aborted
+        if (total <= limit)
+        {
+            // distribute the particles centered in the node over the children
+            vector<int> childHomev[8];
+            for (int p : homev)
+            {
+                int l = (_xv[p] >= split.x() ? 4 : 0) + (_yv[p] >= split.y() ? 2 : 0) + (_zv[p] >= split.z() ? 1 : 0);
+                childHomev[l].push_back(p);
+            }
+            vector<int>().swap(listv);
+            vector<int>().swap(homev);
+
+            // create and recursively build the children
+            int child = _nodev.size();
+            _nodev.resize(child + 8);
+            _nodev[n].child = child;
+            for (int l = 0; l != 8; ++l) buildNode(child + l, childv[l], level + 1, childListv[l], childHomev[l]);
+            return;
+        }
     }
+
+    // turn the node into a leaf
+    Node& node = _nodev[n];
+    node.first = _refv.size();
+    node.count = count;
+    node.hfirst = _homev.size();
+    node.hcount = homev.size();
+    _refv.insert(_refv.end(), listv.begin(), listv.end());
+    _homev.insert(_homev.end(), homev.begin(), homev.end());
+    vector<int>().swap(listv);
+    vector<int>().swap(homev);
+
+    // update statistics, ignoring the empty leaves resulting from a node that was not split in all directions
+    if (cell.xmin() >= cell.xmax() || cell.ymin() >= cell.ymax() || cell.zmin() >= cell.zmax()) return;
+    _numLeaves++;
+    _pmin = min(_pmin, count);
+    _pmax = max(_pmax, count);
+    _ptotal += count;
+}
+
+////////////////////////////////////////////////////////////////////
+
+Box SmoothedParticleGrid::childCell(int n, const Box& cell, int l) const
+{
+    Vec split = _nodev[n].split;
+    return Box((l & 4) ? split.x() : cell.xmin(), (l & 2) ? split.y() : cell.ymin(), (l & 1) ? split.z() : cell.zmin(),
+               (l & 4) ? cell.xmax() : split.x(), (l & 2) ? cell.ymax() : split.y(), (l & 1) ? cell.zmax() : split.z());
+}
+
+////////////////////////////////////////////////////////////////////
+
+int SmoothedParticleGrid::numCells() const
+{
+    return _numLeaves;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -162,19 +309,64 @@ int SmoothedParticleGrid::totalParticles() const
 
 ////////////////////////////////////////////////////////////////////
 
-const vector<const SmoothedParticle*>& SmoothedParticleGrid::particlesFor(Vec r) const
+int SmoothedParticleGrid::leafFor(Vec r) const
 {
     int i = NR::locateClip(_xgrid, r.x());
     int j = NR::locateClip(_ygrid, r.y());
     int k = NR::locateClip(_zgrid, r.z());
-    return _listv[index(_m, i, j, k)];
+    int n = index(_m, i, j, k);
+    while (_nodev[n].child >= 0)
+    {
+        const Node& node = _nodev[n];
+        n = node.child + (r.x() >= node.split.x() ? 4 : 0) + (r.y() >= node.split.y() ? 2 : 0)
+            + (r.z() >= node.split.z() ? 1 : 0);
+    }
+    return n;
 }
 
 ////////////////////////////////////////////////////////////////////
 
-vector<const SmoothedParticle*> SmoothedParticleGrid::particlesFor(const Box& box) const
+double SmoothedParticleGrid::density(Vec r, const std::function<void(int, const double*, double*)>& kernel) const
 {
-    // find indices for first and last cell possibly overlapping the box
+    const Node& leaf = _nodev[leafFor(r)];
+    const int* candidates = _refv.data() + leaf.first;
+
+    double sum = 0.;
+    double uv[batchSize], Wv[batchSize];
+    for (int first = 0; first < leaf.count; first += batchSize)
+    {
+        const int* batch = candidates + first;
+        int n = min(batchSize, leaf.count - first);
+
+        // calculate the normalized distances without conditionals, so that the compiler can vectorize the loop
+        for (int k = 0; k < n; ++k)
+        {
+            int p = batch[k];
+            double dx = r.x() - _xv[p];
+            double dy = r.y() - _yv[p];
+            double dz = r.z() - _zv[p];
+            uv[k] = sqrt(dx * dx + dy * dy + dz * dz) / _hv[p];
+        }
+
+        // evaluate the kernel for the complete batch
+        kernel(n, uv, Wv);
+
+        // accumulate the contributions
+        for (int k = 0; k < n; ++k)
+        {
+            int p = batch[k];
+            double h = _hv[p];
+            sum += Wv[k] * _Mv[p] / (h * h * h);
+        }
+    }
+    return sum;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SmoothedParticleGrid::visitParticlesFor(const Box& box, const std::function<void(int)>& visit) const
+{
+    // find indices for first and last top-level cell possibly overlapping the box
     int i1 = NR::locateClip(_xgrid, box.xmin());
     int j1 = NR::locateClip(_ygrid, box.ymin());
     int k1 = NR::locateClip(_zgrid, box.zmin());
@@ -182,33 +374,67 @@ vector<const SmoothedParticle*> SmoothedParticleGrid::particlesFor(const Box& bo
     int j2 = NR::locateClip(_ygrid, box.ymax());
     int k2 = NR::locateClip(_zgrid, box.zmax());
 
-    // if the box is fully inside a single cell, just return the corresponding list
-    if (i1 == i2 && j1 == j2 && k1 == k2) return _listv[index(_m, i1, j1, k1)];
-
-    // otherwise join the lists for all the cells in the range
-    std::set<const SmoothedParticle*> joined;
     for (int i = i1; i <= i2; i++)
         for (int j = j1; j <= j2; j++)
             for (int k = k1; k <= k2; k++)
             {
-                // add the particles for this list to the result set (if not already present)
-                const vector<const SmoothedParticle*>& particles = _listv[index(_m, i, j, k)];
-                joined.insert(particles.begin(), particles.end());
+                Box cell(_xgrid[i], _ygrid[j], _zgrid[k], _xgrid[i + 1], _ygrid[j + 1], _zgrid[k + 1]);
+                visitNode(index(_m, i, j, k), cell, box, visit);
             }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SmoothedParticleGrid::visitNode(int n, const Box& cell, const Box& box,
+                                     const std::function<void(int)>& visit) const
+{
+    // skip a node that does not overlap the box; the lower node borders are inclusive and the upper ones exclusive
+    if (cell.xmin() > box.xmax() || cell.xmax() <= box.xmin() || cell.ymin() > box.ymax()
+        || cell.ymax() <= box.ymin() || cell.zmin() > box.zmax() || cell.zmax() <= box.zmin())
+        return;
+
+    // for a subdivided node, recursively visit the children
+    const Node& node = _nodev[n];
+    if (node.child >= 0)
+    {
+        for (int l = 0; l != 8; ++l) visitNode(node.child + l, childCell(n, cell, l), box, visit);
+        return;
+    }
+
+    // for a leaf completely inside the box, visit the particles centered in the leaf
+    if (box.xmin() <= cell.xmin() && cell.xmax() <= box.xmax() && box.ymin() <= cell.ymin()
+        && cell.ymax() <= box.ymax() && box.zmin() <= cell.zmin() && cell.zmax() <= box.zmax())
+    {
+        for (int k = 0; k != node.hcount; ++k) visit(_homev[node.hfirst + k]);
+        return;
+    }
 
-    // copy the result back into a vector
-    return vector<const SmoothedParticle*>(joined.begin(), joined.end());
+    // for a leaf on the border of the box, consider all particles overlapping the leaf
+    for (int k = 0; k != node.count; ++k)
+    {
+        // visit the particle only from the leaf containing the point in the box nearest to its center;
+        // if the particle overlaps the box, it also overlaps that leaf and thus occurs in its list
+        int p = _refv[node.first + k];
+        double x = max(box.xmin(), min(_xv[p], box.xmax()));
+        double y = max(box.ymin(), min(_yv[p], box.ymax()));
+        double z = max(box.zmin(), min(_zv[p], box.zmax()));
+        if (cell.xmin() <= x && x < cell.xmax() && cell.ymin() <= y && y < cell.ymax() && cell.zmin() <= z
+            && z < cell.zmax())
+            visit(p);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
-const SmoothedParticle* SmoothedParticleGrid::nearestParticle(Vec r) const
+int SmoothedParticleGrid::nearestParticle(Vec r) const
 {
-    const SmoothedParticle* nearestParticle = nullptr;
+    const Node& leaf = _nodev[leafFor(r)];
+    int nearestParticle = -1;
     double nearestSquaredDistance = std::numeric_limits<double>::infinity();
-    for (const SmoothedParticle* p : particlesFor(r))
+    for (int k = 0; k != leaf.count; ++k)
     {
-        double d2 = (r - p->center()).norm2();
+        int p = _refv[leaf.first + k];
+        double d2 = (r - center(p)).norm2();
         if (d2 < nearestSquaredDistance)
         {
             nearestParticle = p;
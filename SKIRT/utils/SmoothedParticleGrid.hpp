@@ -8,58 +8,136 @@
 
 #include "Array.hpp"
 #include "Box.hpp"
+#include <functional>
 class SmoothedParticle;
 
 ////////////////////////////////////////////////////////////////////
 
-/** SmoothedParticleGrid is a helper class for organizing SmoothedParticle instances in a smart
-    grid, so that it is easy to retrieve a list of all particles that may overlap a particular
-    point in space. The Box object on which this class is based specifies a cuboid guaranteed to
-    enclose all particles in the grid. */
+/** SmoothedParticleGrid is a helper class for organizing smoothed particles in a smart grid, so
+    that it is easy to retrieve a list of all particles that may overlap a particular point in
+    space. The Box object on which this class is based specifies a cuboid guaranteed to enclose all
+    particles in the grid.
+
+    The grid is constructed in two stages. A cuboidal top-level grid is placed so that the particle
+    centers are evenly distributed over the grid cells in each spatial direction. For strongly
+    clustered particle distributions, however, some of these cells may still be overlapped by a
+    substantial fraction of all particles. Therefore, each top-level cell overlapped by many
+    particles is adaptively subdivided as an octree, for as long as the subdivision substantially
+    reduces the number of particles overlapping each of the resulting cells. The cells that are not
+    subdivided any further are called leaf cells.
+
+    The grid holds its own copy of the particle properties in structure-of-arrays form, i.e. a
+    separate array for each coordinate, the smoothing length, and the mass, and the particle lists
+    for the leaf cells are stored as consecutive ranges of particle indices in a single array. As a
+    result, the source list of SmoothedParticle objects can be released after constructing the
+    grid, and loops over the candidate particles for a given position are amenable to vectorization
+    by the compiler. Particles are identified by their zero-based index in the list passed to the
+    constructor. */
 class SmoothedParticleGrid : public Box
 {
 public:
-    /** The constructor creates a cuboidal grid of the specified number of grid cells in each
-        spatial direction, and for each of the cells it builds a list of all particles (partially
-        or fully) overlapping the cell. In an attempt to distribute the particles evenly over the
-        cells, the sizes of the grid cells in each spatial direction are chosen so that the
-        particle centers are evenly distributed over the cells. The internal particle lists store
-        pointers to the particle objects contained in the provided list \em pv, so that list
-        must not be modified or deallocated as long as this grid instance exists. */
+    /** The constructor creates a cuboidal top-level grid of the specified number of grid cells in
+        each spatial direction, and for each of the cells it builds a list of all particles
+        (partially or fully) overlapping the cell. In an attempt to distribute the particles evenly
+        over the cells, the sizes of the grid cells in each spatial direction are chosen so that the
+        particle centers are evenly distributed over the cells. Cells overlapped by many particles
+        are then adaptively subdivided as described in the class header. The constructor copies the
+        relevant particle properties, so that the list \em pv may be released after the
+        constructor returns. */
     SmoothedParticleGrid(const vector<SmoothedParticle>& pv, int gridsize);
 
-    /** This function returns the smallest number of particles overlapping a single cell. */
+    /** This function returns the number of leaf cells in the grid, including the top-level cells
+        that have not been subdivided. */
+    int numCells() const;
+
+    /** This function returns the smallest number of particles overlapping a single leaf cell. */
     int minParticlesPerCell() const;
 
-    /** This function returns the largest number of particles overlapping a single cell. */
+    /** This function returns the largest number of particles overlapping a single leaf cell. */
     int maxParticlesPerCell() const;
 
-    /** This function returns the total number of particle references for all cells in the grid. */
+    /** This function returns the total number of particle references for all leaf cells in the
+        grid. */
     int totalParticles() const;
 
-    /** This function returns a list of all particles that may overlap the specified position. It
-        locates the cell containing the specified position and returns the list of particles
-        overlapping that cell. Thus the list may include particles that don't actually overlap the
-        specified position. The objective of this class is to make this function very fast, while
-        limiting the number of unnecessary particles in the returned list. */
-    const vector<const SmoothedParticle*>& particlesFor(Vec r) const;
+    /** This function returns the number of particles in the grid. */
+    int numParticles() const { return _xv.size(); }
+
+    /** This function returns the coordinates of the center of the particle with index \em i. */
+    Vec center(int i) const { return Vec(_xv[i], _yv[i], _zv[i]); }
+
+    /** This function returns the smoothing length of the particle with index \em i. */
+    double radius(int i) const { return _hv[i]; }
+
+    /** This function returns the mass of the particle with index \em i. */
+    double mass(int i) const { return _Mv[i]; }
 
-    /** This function returns a list containing all particles that may overlap a given box (i.e. a
-        cuboid lined up with the coordinate axes). Note that the list may include particles that
-        don't actually overlap the specified box. The function locates all grid cells overlapping
-        the box and calculates the union of the list of particles overlapping each of these cells
-        (i.e. removing any duplicates). */
-    vector<const SmoothedParticle*> particlesFor(const Box& box) const;
+    /** This function returns the sum \f[ \sum_i \frac{M_i}{h_i^3}\,W(u_i) \f] over all particles
+        \f$i\f$ that may overlap the specified position \f${\bf{r}}\f$, where \f$M_i\f$ and
+        \f$h_i\f$ are the mass and smoothing length of the particle, \f$u_i = |{\bf{r}} -
+        {\bf{r}}_i|/h_i\f$ is the normalized distance between the position and the particle
+        center, and \f$W(u)\f$ is the smoothing kernel density. The function locates the leaf cell
+        containing the specified position and processes the list of particles overlapping that
+        cell in batches. For each batch, it calculates the normalized distances in a loop over the
+        particle property arrays, and then invokes the specified \em kernel function, which must
+        store the kernel density \f$W(u)\f$ for each of the \em n normalized distances in \em uv
+        into the corresponding element of \em Wv. */
+    double density(Vec r, const std::function<void(int n, const double* uv, double* Wv)>& kernel) const;
 
-    /** This function returns a pointer to the particle centered nearest to the specified position,
-        or the null pointer if the specified position is outside of the grid. */
-    const SmoothedParticle* nearestParticle(Vec r) const;
+    /** This function calls the specified function exactly once for each particle that overlaps a
+        given box (i.e. a cuboid lined up with the coordinate axes), and at most once for other
+        particles that may overlap the box. The argument passed to the function is the index of the
+        particle. Each particle is visited only from the leaf cell containing the point in the box
+        nearest to the particle center. For leaf cells lying completely inside the box, this means
+        that only the particles centered in the cell need to be considered. Because this function
+        avoids building a joined list of particles, it remains efficient for large boxes
+        overlapping many grid cells. */
+    void visitParticlesFor(const Box& box, const std::function<void(int i)>& visit) const;
+
+    /** This function returns the index of the particle centered nearest to the specified position,
+        considering only the particles overlapping the leaf cell containing that position, or -1 if
+        there are no such particles. */
+    int nearestParticle(Vec r) const;
 
 private:
-    int _m;                                          // number of grid cells in each spatial direction
-    Array _xgrid, _ygrid, _zgrid;                    // the m+1 grid separation points for each spatial direction
-    vector<vector<const SmoothedParticle*>> _listv;  // the m*m*m lists of particles overlapping each grid cell
-    int _pmin, _pmax, _ptotal;  // minimum, maximum nr of particles in list; total nr of particles in listv
+    /** This function recursively subdivides the node with index \em n, which has the specified
+        extent and is overlapped by the particles in \em listv, of which those in \em homev are
+        centered in the node. If the node is not subdivided, it becomes a leaf and its particle
+        lists are appended to the global lists. The function releases the memory held by the
+        particle lists passed to it. */
+    void buildNode(int n, const Box& cell, int level, vector<int>& listv, vector<int>& homev);
+
+    /** This function returns the extent of the child with octant index \em l of the node with
+        index \em n, given the extent of that node. */
+    Box childCell(int n, const Box& cell, int l) const;
+
+    /** This function returns the index of the leaf node containing the specified position. */
+    int leafFor(Vec r) const;
+
+    /** This function implements visitParticlesFor() for the node with index \em n and the
+        specified extent. */
+    void visitNode(int n, const Box& cell, const Box& box, const std::function<void(int i)>& visit) const;
+
+    // a node in the grid; the first m*m*m nodes represent the top-level cells, in order of linear index;
+    // the nodes following these represent the children of subdivided cells, in groups of eight siblings
+    struct Node
+    {
+        int child{-1};  // index of the first of eight child nodes, or -1 for a leaf node
+        int first{0};   // for a leaf: index in _refv of the first particle overlapping the node
+        int count{0};   // for a leaf: number of particles overlapping the node
+        int hfirst{0};  // for a leaf: index in _homev of the first particle centered in the node
+        int hcount{0};  // for a leaf: number of particles centered in the node
+        Vec split;      // for a subdivided node: the point separating the eight children
+    };
+
+    int _m;                              // number of top-level grid cells in each spatial direction
+    Array _xgrid, _ygrid, _zgrid;        // the m+1 grid separation points for each spatial direction
+    Array _xv, _yv, _zv, _hv, _Mv;       // the particle center coordinates, smoothing lengths, and masses
+    vector<Node> _nodev;                 // the nodes of the grid
+    vector<int> _refv;                   // the lists of particles overlapping each leaf, concatenated
+    vector<int> _homev;                  // the lists of particles centered in each leaf, concatenated
+    int _numLeaves{0};                   // number of leaf nodes
+    int _pmin{0}, _pmax{0}, _ptotal{0};  // minimum, maximum nr of particles in leaf list; total nr in _refv
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -29,7 +29,13 @@ class Box;
 
     Updating the initial position and/or the direction of the path invalidates all segments in the
     path, but the segments are not automatically cleared. One should call the clear() function or
-    the moveInside() function to do so. */
+    the moveInside() function to do so.
+
+    Finally, a client that knows the spatial cell containing the initial position of the path (for
+    example, because the position was determined as an interaction point along a previous path)
+    can store the index of that cell as a hint. A spatial grid that needs to locate the cell
+    containing the initial position can use this hint to accelerate the search. Updating the
+    initial position clears the hint. */
 class SpatialGridPath
 {
 public:
@@ -44,15 +50,25 @@ public:
         setDirection() functions to set these properties to appropriate values. */
     SpatialGridPath();
 
-    /** This function sets the initial position of the path to a new value. */
-    void setPosition(const Position& bfr) { _bfr = bfr; }
+    /** This function sets the initial position of the path to a new value, and clears the cell
+        hint. */
+    void setPosition(const Position& bfr)
+    {
+        _bfr = bfr;
+        _cellHint = -1;
+    }
 
     /** This function sets the propagation direction along the path to a new value. */
     void setDirection(const Direction& bfk) { _bfk = bfk; }
 
     /** This function propagates the initial position of the path over a distance \f$s\f$. In other
-        words, it updates the position from \f${\bf{r}}\f$ to \f${\bf{r}}+s\,{\bf{k}}\f$. */
-    void propagatePosition(double s) { _bfr += s * _bfk; }
+        words, it updates the position from \f${\bf{r}}\f$ to \f${\bf{r}}+s\,{\bf{k}}\f$, and
+        clears the cell hint. */
+    void propagatePosition(double s)
+    {
+        _bfr += s * _bfk;
+        _cellHint = -1;
+    }
 
     /** This function returns the initial position of the path. */
     Position position() const { return _bfr; }
@@ -60,6 +76,15 @@ public:
     /** This function returns the propagation direction along the path. */
     Direction direction() const { return _bfk; }
 
+    /** This function sets the cell hint for the path, i.e. the index of the spatial cell that
+        contains (or lies very close to) the initial position of the path. The hint remains valid
+        until the initial position is updated. */
+    void setCellHint(int m) { _cellHint = m; }
+
+    /** This function returns the cell hint for the path, or -1 if no hint has been set since the
+        initial position was last updated. */
+    int cellHint() const { return _cellHint; }
+
     // ------- Adding path segments -------
 
     /** This function removes all path segments, resulting in an empty path with the original
@@ -156,6 +181,7 @@ public:
 private:
     Position _bfr;
     Direction _bfk;
+    int _cellHint{-1};
     vector<Segment> _segments;
     int _interactionCellIndex{-1};
     double _interactionDistance{0.};
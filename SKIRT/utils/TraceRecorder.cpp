@@ -0,0 +1,115 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "TraceRecorder.hpp"
+#include "StringUtils.hpp"
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+////////////////////////////////////////////////////////////////////
+
+bool TraceRecorder::_enabled = false;
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // a recorded event
+    struct Event
+    {
+        const char* category;
+        string name;
+        Clock::time_point begin;
+        Clock::time_point end;
+        size_t firstIndex;
+        size_t numIndices;
+    };
+
+    // the list of buffers for all threads that ever recorded an event, guarded by a mutex;
+    // buffers are never removed so that the events of threads that have exited are preserved,
+    // and the index of a buffer in the list serves as the thread identifier in the trace
+    std::mutex _mutex;
+    vector<std::unique_ptr<vector<Event>>> _buffers;
+
+    // the time origin for the trace
+    Clock::time_point _origin;
+
+    // a pointer to the buffer of the current thread, or null if it has not yet been created
+    thread_local vector<Event>* t_buffer = nullptr;
+
+    // returns the specified time point as the number of microseconds since the time origin
+    string microseconds(Clock::time_point time)
+    {
+        return StringUtils::toString(std::chrono::duration<double, std::micro>(time - _origin).count(), 'f', 3);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::setEnabled(bool enabled)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (enabled)
+    {
+        for (auto& buffer : _buffers) buffer->clear();
+        _origin = Clock::now();
+    }
+    _enabled = enabled;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::record(const char* category, const string& name, std::chrono::steady_clock::time_point started,
+                           size_t firstIndex, size_t numIndices)
+{
+    auto now = Clock::now();
+    if (!t_buffer)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _buffers.emplace_back(new vector<Event>);
+        t_buffer = _buffers.back().get();
+    }
+    t_buffer->push_back({category, name, started, now, firstIndex, numIndices});
+}
+
+////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::writeEvents(std::ostream& out, int processId)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    string pid = std::to_string(processId);
+
+    // name the process and each of its threads
+    out << ",\n{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": " << pid << ", \"args\": {\"name\": \"process "
+        << pid << "\"}}";
+    out << ",\n{\"ph\": \"M\", \"name\": \"process_sort_index\", \"pid\": " << pid
+        << ", \"args\": {\"sort_index\": " << pid << "}}";
+    for (size_t tid = 0; tid != _buffers.size(); ++tid)
+    {
+        out << ",\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": " << pid << ", \"tid\": " << tid
+            << ", \"args\": {\"name\": \"thread " << tid << "\"}}";
+    }
+
+    // write the complete events for each thread
+    for (size_t tid = 0; tid != _buffers.size(); ++tid)
+    {
+        for (const Event& event : *_buffers[tid])
+        {
+            out << ",\n{\"ph\": \"X\", \"cat\": \"" << event.category
+                << "\", \"name\": " << StringUtils::toJsonString(event.name) << ", \"pid\": " << pid
+                << ", \"tid\": " << tid << ", \"ts\": " << microseconds(event.begin) << ", \"dur\": "
+                << StringUtils::toString(std::chrono::duration<double, std::micro>(event.end - event.begin).count(),
+                                         'f', 3);
+            if (event.numIndices)
+                out << ", \"args\": {\"first\": " << event.firstIndex << ", \"count\": " << event.numIndices << "}";
+            out << "}";
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,126 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef TRACERECORDER_HPP
+#define TRACERECORDER_HPP
+
+#include "Basics.hpp"
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////
+
+/**
+This class offers a global (i.e. application-wide) recorder for timeline events, i.e. the
+begin and end times of relevant sections of code, such as simulation phases, parallel calls,
+the chunks processed by each parallel thread, and collective operations between processes. The
+recorded events can be written in the Chrome trace event format, which can be opened by trace
+viewers such as Perfetto (https://ui.perfetto.dev) to visualize the timeline of a simulation.
+This helps to understand why a run is slow, for example because of straggling threads or
+processes, or because of long serial sections.
+
+The recorder is disabled by default. As long as it is disabled, constructing a Scope instance
+costs just a test on a global flag. When enabled through the setEnabled() function, each
+execution thread appends the events it records to its own private buffer, so that there is no
+contention between threads. Each thread is represented by a separate track in the trace, in the
+order in which threads first recorded an event.
+
+To record an event, an instance of the nested Scope class is constructed at the start of the
+scope to be recorded; its destructor records the event with the begin and end times. For
+example:
+
+\code
+{
+    TraceRecorder::Scope scope("parallel", "chunk", firstIndex, numIndices);
+    ...
+}
+\endcode
+
+The recorder itself does not know about processes. In a multi-process environment, each process
+writes the events it recorded using the writeEvents() function, specifying its rank as the
+process identifier, and the resulting fragments are concatenated into a single trace file by the
+caller. Because the recorder is global, it cannot distinguish between simulations that run in
+parallel within the same process. The caller should enable the recorder only if a single
+simulation is running at a time.
+*/
+class TraceRecorder
+{
+public:
+    /** This function enables or disables the recorder. Enabling the recorder discards all
+        previously recorded events and sets the time origin for subsequent events to the current
+        time. Disabling the recorder preserves the recorded events so that they can be written.
+        This function should be called only while no events are being recorded. */
+    static void setEnabled(bool enabled);
+
+    /** This function returns true if the recorder is enabled, false otherwise. */
+    static bool isEnabled() { return _enabled; }
+
+    /** This function writes the events recorded by all threads in the Chrome trace event format
+        to the specified stream, using the specified process identifier (usually the process rank).
+        The output consists of a sequence of JSON objects, each on a separate line and preceded by
+        a comma, so that the fragments produced for multiple processes can be concatenated into a
+        JSON array after an initial element. The output includes metadata events naming the process
+        and its threads. This function should be called only while no events are being recorded. */
+    static void writeEvents(std::ostream& out, int processId);
+
+    /** An instance of this class records an event covering the time between its construction and
+        its destruction, provided the recorder is enabled. */
+    class Scope
+    {
+    public:
+        /** The constructor remembers the category and name of the event and the current time, if
+            the recorder is enabled. */
+        Scope(const char* category, const string& name) : _category(category)
+        {
+            if (_enabled)
+            {
+                _active = true;
+                _name = name;
+                _started = std::chrono::steady_clock::now();
+            }
+        }
+
+        /** The constructor remembers the category and name of the event, the range of indices
+            processed during the event, and the current time, if the recorder is enabled. */
+        Scope(const char* category, const string& name, size_t firstIndex, size_t numIndices)
+            : _category(category), _firstIndex(firstIndex), _numIndices(numIndices)
+        {
+            if (_enabled)
+            {
+                _active = true;
+                _name = name;
+                _started = std::chrono::steady_clock::now();
+            }
+        }
+
+        /** The destructor records the event in the buffer of the calling thread, if the recorder
+            was enabled at construction time and is still enabled. */
+        ~Scope()
+        {
+            if (_active && _enabled) record(_category, _name, _started, _firstIndex, _numIndices);
+        }
+
+    private:
+        const char* _category;
+        bool _active{false};
+        string _name;
+        size_t _firstIndex{0};
+        size_t _numIndices{0};
+        std::chrono::steady_clock::time_point _started;
+    };
+
+private:
+    /** This function records an event with the specified properties and with the current time as
+        the end time in the buffer of the calling thread, creating that buffer if needed. If the
+        number of indices is zero, the index range is not included in the event. */
+    static void record(const char* category, const string& name, std::chrono::steady_clock::time_point started,
+                       size_t firstIndex, size_t numIndices);
+
+    // true if the recorder is enabled
+    static bool _enabled;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -454,3 +454,34 @@ string StringUtils::toMemSizeString(size_t value)
 }
 
 ////////////////////////////////////////////////////////////////////
+
+string StringUtils::toJsonString(string text)
+{
+    string json = "\"";
+    for (char c : text)
+    {
+        switch (c)
+        {
+            case '"': json += "\\\""; break;
+            case '\\': json += "\\\\"; break;
+            case '\b': json += "\\b"; break;
+            case '\f': json += "\\f"; break;
+            case '\n': json += "\\n"; break;
+            case '\r': json += "\\r"; break;
+            case '\t': json += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    const char* hex = "0123456789abcdef";
+                    json += string("\\u00") + hex[c >> 4] + hex[c & 15];
+                }
+                else
+                {
+                    json += c;
+                }
+        }
+    }
+    return json + "\"";
+}
+
+////////////////////////////////////////////////////////////////////
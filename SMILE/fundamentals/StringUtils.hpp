@@ -172,6 +172,10 @@ public:
     /** Returns a user-friendly string representation of the specified memory size value with 3
         significant digits and the appropriate units (KB, MB, GB or TB). */
     static string toMemSizeString(size_t value);
+
+    /** Returns the specified text as a JSON string literal, i.e. enclosed in double quotes and
+        with double quotes, backslashes and control characters escaped. */
+    static string toJsonString(string text);
 };
 
 ////////////////////////////////////////////////////////////////////
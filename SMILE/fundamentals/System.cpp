@@ -7,11 +7,13 @@
 
 ////////////////////////////////////////////////////////////////////
 
+#include <cctype>
 #include <chrono>
 #include <clocale>
 #include <ctime>
 #include <locale>
 #include <mutex>
+#include <sstream>
 #include <unordered_map>
 
 #ifdef _WIN64
@@ -31,6 +33,10 @@
 #    include <iostream>
 #endif
 
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+#    include <sched.h>  // for processor affinity
+#endif
+
 #if defined(__APPLE__) && defined(__MACH__)
 #    include <CoreFoundation/CoreFoundation.h>
 #endif
@@ -478,6 +484,28 @@ bool System::isDir(string path)
 
 ////////////////////////////////////////////////////////////////////
 
+std::pair<uint64_t, int64_t> System::fileSizeAndTime(string path)
+{
+#ifdef _WIN64
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesExW(toUTF16(path).get(), GetFileExInfoStandard, &data)
+        && !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        uint64_t size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) + data.nFileSizeLow;
+        uint64_t ticks = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32)
+                         + data.ftLastWriteTime.dwLowDateTime;
+        return std::make_pair(size, static_cast<int64_t>(ticks / 10000000));
+    }
+#else
+    struct stat st;
+    if (!stat(path.c_str(), &st) && S_ISREG(st.st_mode))
+        return std::make_pair(static_cast<uint64_t>(st.st_size), static_cast<int64_t>(st.st_mtime));
+#endif
+    return std::make_pair(0, 0);
+}
+
+////////////////////////////////////////////////////////////////////
+
 bool System::makeDir(string directory)
 {
     if (isDir(directory)) return true;
@@ -1004,3 +1032,109 @@ size_t System::currentMemoryUsage()
 }
 
 ////////////////////////////////////////////////////////////////////
+
+void System::releasePhysicalPages(void* start, size_t length)
+{
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+    // determine the page-aligned subrange fully contained in the specified range
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t begin = (reinterpret_cast<size_t>(start) + pageSize - 1) / pageSize * pageSize;
+    size_t end = (reinterpret_cast<size_t>(start) + length) / pageSize * pageSize;
+
+    // for private anonymous memory, the pages are replaced by zero-fill-on-demand pages
+    if (end > begin) madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+#else
+    (void)start;
+    (void)length;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<vector<int>> System::processorTopology()
+{
+    vector<vector<int>> result;
+
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+    // get the set of processors on which the current process is allowed to run
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return result;
+
+    // parses a cpu list such as "0-3,8,10-11" and adds the allowed processors to the specified node
+    auto addProcessors = [&allowed](string cpulist, vector<int>& node) {
+        std::istringstream in(cpulist);
+        string range;
+        while (std::getline(in, range, ','))
+        {
+            if (range.empty() || !std::isdigit(range[0])) continue;
+            auto dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+                if (CPU_ISSET(cpu, &allowed)) node.push_back(cpu);
+        }
+    };
+
+    // get the processors for each NUMA node, in order of node index
+    const string nodeDir = "/sys/devices/system/node";
+    vector<int> nodeIndices;
+    for (const string& name : dirsInDirectory(nodeDir))
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 && std::isdigit(name[4]))
+            nodeIndices.push_back(std::stoi(name.substr(4)));
+    std::sort(nodeIndices.begin(), nodeIndices.end());
+    for (int index : nodeIndices)
+    {
+        std::ifstream in(nodeDir + "/node" + std::to_string(index) + "/cpulist");
+        string cpulist;
+        if (in && std::getline(in, cpulist))
+        {
+            vector<int> node;
+            addProcessors(cpulist, node);
+            std::sort(node.begin(), node.end());
+            if (!node.empty()) result.push_back(node);
+        }
+    }
+
+    // if the NUMA information is not available, return a single node with all allowed processors
+    if (result.empty())
+    {
+        vector<int> node;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &allowed)) node.push_back(cpu);
+        if (!node.empty()) result.push_back(node);
+    }
+#endif
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
+int System::processorCount()
+{
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<int>(count) : 0;
+#else
+    return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool System::pinCurrentThread(int cpu)
+{
+#if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    return sched_setaffinity(0, sizeof(mask), &mask) == 0;  // on Linux, pid 0 refers to the calling thread
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
@@ -122,6 +122,12 @@ public:
         slashes in the path by backward slashes. */
     static bool isDir(string path);
 
+    /** This function returns the size in bytes and the time of last modification (in seconds
+        since a platform-dependent epoch) of the specified regular file, or a pair of zero values
+        if the path does not refer to an existing regular file. On Windows the function replaces
+        forward slashes in the path by backward slashes. */
+    static std::pair<uint64_t, int64_t> fileSizeAndTime(string path);
+
     /** This function creates a new folder with the specified path, if it does not already exist.
         All path segments other than the last one should correspond to already existing
         directories. The function returns true if the directory already existed or was successfully
@@ -199,6 +205,36 @@ public:
     /** Returns the current physical memory use for the current process in bytes, or zero if the
         value cannot be determined. */
     static size_t currentMemoryUsage();
+
+    /** This function advises the operating system that the contents of the specified memory range
+        is no longer needed, so that the physical pages fully contained in the range can be
+        released. The virtual address range remains valid. On Linux, the released pages are filled
+        with zeros and physical memory is allocated again on first access, in the memory region
+        (NUMA node) local to the processor performing the access. As a result, the function should
+        be called only for memory ranges that contain zeros or whose contents are irrelevant. On
+        other operating systems, the function does nothing. */
+    static void releasePhysicalPages(void* start, size_t length);
+
+    // ================== Processors ==================
+
+    /** This function returns the logical processors (CPUs) available to the current process,
+        grouped per NUMA node. Each item in the returned list represents a NUMA node (memory
+        domain) and holds the indices of the logical processors in that node that the current
+        process is allowed to run on, in increasing order. Nodes that have no available processors
+        are omitted. If the topology cannot be determined (e.g., on operating systems other than
+        Linux), the function returns an empty list. */
+    static vector<vector<int>> processorTopology();
+
+    /** This function returns the number of logical processors (CPUs) that are online on the
+        computer, regardless of the processors the current process is allowed to run on, or zero if
+        the number cannot be determined (e.g., on operating systems other than Linux). */
+    static int processorCount();
+
+    /** This function restricts the execution of the calling thread to the logical processor with
+        the specified index, as listed by the processorTopology() function. The function returns
+        true if successful, and false if the thread could not be pinned (e.g., on operating systems
+        other than Linux). */
+    static bool pinCurrentThread(int cpu);
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -4,9 +4,128 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "ItemUtils.hpp"
+#include "BoolPropertyHandler.hpp"
+#include "DoubleListPropertyHandler.hpp"
+#include "DoublePropertyHandler.hpp"
+#include "EnumPropertyHandler.hpp"
 #include "FatalError.hpp"
+#include "IntPropertyHandler.hpp"
 #include "Item.hpp"
+#include "ItemListPropertyHandler.hpp"
+#include "ItemPropertyHandler.hpp"
+#include "PropertyHandlerVisitor.hpp"
 #include "SchemaDef.hpp"
+#include "StringPropertyHandler.hpp"
+#include "StringUtils.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Forward declaration; see function definition at the end of this anonymous namespace
+    void representProperties(Item* item, const SchemaDef* schema, string& text);
+
+    // ----------------------------------------------------------
+
+    // The functions in this class are part of the visitor pattern initiated by the representProperties() function.
+    // They append a representation of the specified property to the text.
+    class PropertyRepresenter : public PropertyHandlerVisitor
+    {
+    private:
+        const SchemaDef* _schema;
+        string& _text;
+
+        void add(PropertyHandler* handler, string value) { _text += " " + handler->name() + "=\"" + value + "\""; }
+
+    public:
+        PropertyRepresenter(const SchemaDef* schema, string& text) : _schema(schema), _text(text) {}
+
+        void visitPropertyHandler(StringPropertyHandler* handler) override { add(handler, handler->value()); }
+
+        void visitPropertyHandler(BoolPropertyHandler* handler) override
+        {
+            add(handler, StringUtils::toString(handler->value()));
+        }
+
+        void visitPropertyHandler(IntPropertyHandler* handler) override
+        {
+            add(handler, StringUtils::toString(handler->value()));
+        }
+
+        void visitPropertyHandler(EnumPropertyHandler* handler) override { add(handler, handler->value()); }
+
+        // use the maximum precision so that different values always have a different representation
+        void visitPropertyHandler(DoublePropertyHandler* handler) override
+        {
+            add(handler, StringUtils::toString(handler->value(), 'e', 17));
+        }
+
+        void visitPropertyHandler(DoubleListPropertyHandler* handler) override
+        {
+            vector<string> values;
+            for (double value : handler->value()) values.push_back(StringUtils::toString(value, 'e', 17));
+            add(handler, StringUtils::join(values, ","));
+        }
+
+        void visitPropertyHandler(ItemPropertyHandler* handler) override
+        {
+            _text += " " + handler->name() + "={";
+            if (handler->value()) representProperties(handler->value(), _schema, _text);
+            _text += "}";
+        }
+
+        void visitPropertyHandler(ItemListPropertyHandler* handler) override
+        {
+            _text += " " + handler->name() + "=[";
+            for (Item* item : handler->value())
+            {
+                _text += "{";
+                representProperties(item, _schema, _text);
+                _text += "}";
+            }
+            _text += "]";
+        }
+    };
+
+    // ----------------------------------------------------------
+
+    // This function recursively appends a representation of the properties of the specified item and its children.
+    void representProperties(Item* item, const SchemaDef* schema, string& text)
+    {
+        PropertyRepresenter representer(schema, text);
+
+        text += item->type();
+        for (const string& property : schema->properties(item->type()))
+        {
+            auto handler = schema->createPropertyHandler(item, property, nullptr);
+            handler->acceptVisitor(&representer);
+        }
+    }
+
+    // ----------------------------------------------------------
+
+    // This function recursively appends the values of the string properties with the specified name in the
+    // specified item and its children.
+    void collectStringValues(Item* item, const SchemaDef* schema, string property, vector<string>& values)
+    {
+        for (const string& name : schema->properties(item->type()))
+        {
+            auto handler = schema->createPropertyHandler(item, name, nullptr);
+            if (auto stringHandler = dynamic_cast<StringPropertyHandler*>(handler.get()))
+            {
+                if (name == property) values.push_back(stringHandler->value());
+            }
+            else if (auto itemHandler = dynamic_cast<ItemPropertyHandler*>(handler.get()))
+            {
+                if (itemHandler->value()) collectStringValues(itemHandler->value(), schema, property, values);
+            }
+            else if (auto itemListHandler = dynamic_cast<ItemListPropertyHandler*>(handler.get()))
+            {
+                for (Item* child : itemListHandler->value()) collectStringValues(child, schema, property, values);
+            }
+        }
+    }
+}
 
 ////////////////////////////////////////////////////////////////////
 
@@ -102,3 +221,21 @@ int ItemUtils::retrieveSelectedRow(Item* item, string property)
 }
 
 ////////////////////////////////////////////////////////////////////
+
+string ItemUtils::hierarchyRepresentation(const SchemaDef* schema, Item* root)
+{
+    string text;
+    representProperties(root, schema, text);
+    return text;
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<string> ItemUtils::hierarchyStringValues(const SchemaDef* schema, Item* root, string property)
+{
+    vector<string> values;
+    collectStringValues(root, schema, property, values);
+    return values;
+}
+
+////////////////////////////////////////////////////////////////////
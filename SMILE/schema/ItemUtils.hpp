@@ -58,6 +58,18 @@ public:
         specified item. If the selected row index has never been stored for this property and item,
         the function returns zero. */
     static int retrieveSelectedRow(Item* item, string property);
+
+    /** This function returns a string representation of the type and the property values of the
+        specified item and, recursively, of all items held by its item and item list properties.
+        Two hierarchies described by the same schema have the same representation if and only if
+        they are configured identically. The representation is intended for comparing and hashing
+        configurations; its format is not documented and it should not be parsed. */
+    static string hierarchyRepresentation(const SchemaDef* schema, Item* root);
+
+    /** This function returns the values of all string properties with the specified name in the
+        specified item and, recursively, in all items held by its item and item list properties, in
+        the order in which they are encountered. */
+    static vector<string> hierarchyStringValues(const SchemaDef* schema, Item* root, string property);
 };
 
 ////////////////////////////////////////////////////////////////////